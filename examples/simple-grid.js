@@ -84,76 +84,33 @@ const MyApplicationWindow = new Lang.Class({
         this._layout.pack(button3, 'child3');
         button3.show();
 
-        [
-            new Emeus.Constraint({ target_attribute: Emeus.ConstraintAttribute.START,
-                                   relation: Emeus.ConstraintRelation.EQ,
-                                   source_object: button1,
-                                   source_attribute: Emeus.ConstraintAttribute.START,
-                                   constant: -8.0 }),
-            new Emeus.Constraint({ target_object: button1,
-                                   target_attribute: Emeus.ConstraintAttribute.WIDTH,
-                                   relation: Emeus.ConstraintRelation.EQ,
-                                   source_object: button2,
-                                   source_attribute: Emeus.ConstraintAttribute.WIDTH }),
-            new Emeus.Constraint({ target_object: button1,
-                                   target_attribute: Emeus.ConstraintAttribute.END,
-                                   relation: Emeus.ConstraintRelation.EQ,
-                                   source_object: button2,
-                                   source_attribute: Emeus.ConstraintAttribute.START,
-                                   constant: -12.0 }),
-            new Emeus.Constraint({ target_object: button2,
-                                   target_attribute: Emeus.ConstraintAttribute.END,
-                                   relation: Emeus.ConstraintRelation.EQ,
-                                   source_attribute: Emeus.ConstraintAttribute.END,
-                                   constant: -8.0 }),
-            new Emeus.Constraint({ target_attribute: Emeus.ConstraintAttribute.START,
-                                   relation: Emeus.ConstraintRelation.EQ,
-                                   source_object: button3,
-                                   source_attribute: Emeus.ConstraintAttribute.START,
-                                   constant: -8.0 }),
-            new Emeus.Constraint({ target_object: button3,
-                                   target_attribute: Emeus.ConstraintAttribute.END,
-                                   relation: Emeus.ConstraintRelation.EQ,
-                                   source_attribute: Emeus.ConstraintAttribute.END,
-                                   constant: -8.0 }),
-            new Emeus.Constraint({ target_attribute: Emeus.ConstraintAttribute.TOP,
-                                   relation: Emeus.ConstraintRelation.EQ,
-                                   source_object: button1,
-                                   source_attribute: Emeus.ConstraintAttribute.TOP,
-                                   constant: -8.0 }),
-            new Emeus.Constraint({ target_attribute: Emeus.ConstraintAttribute.TOP,
-                                   relation: Emeus.ConstraintRelation.EQ,
-                                   source_object: button2,
-                                   source_attribute: Emeus.ConstraintAttribute.TOP,
-                                   constant: -8.0 }),
-            new Emeus.Constraint({ target_object: button1,
-                                   target_attribute: Emeus.ConstraintAttribute.BOTTOM,
-                                   relation: Emeus.ConstraintRelation.EQ,
-                                   source_object: button3,
-                                   source_attribute: Emeus.ConstraintAttribute.TOP,
-                                   constant: -12.0 }),
-            new Emeus.Constraint({ target_object: button2,
-                                   target_attribute: Emeus.ConstraintAttribute.BOTTOM,
-                                   relation: Emeus.ConstraintRelation.EQ,
-                                   source_object: button3,
-                                   source_attribute: Emeus.ConstraintAttribute.TOP,
-                                   constant: -12.0 }),
-            new Emeus.Constraint({ target_object: button3,
-                                   target_attribute: Emeus.ConstraintAttribute.HEIGHT,
-                                   relation: Emeus.ConstraintRelation.EQ,
-                                   source_object: button1,
-                                   source_attribute: Emeus.ConstraintAttribute.HEIGHT }),
-            new Emeus.Constraint({ target_object: button3,
-                                   target_attribute: Emeus.ConstraintAttribute.HEIGHT,
-                                   relation: Emeus.ConstraintRelation.EQ,
-                                   source_object: button2,
-                                   source_attribute: Emeus.ConstraintAttribute.HEIGHT }),
-            new Emeus.Constraint({ target_object: button3,
-                                   target_attribute: Emeus.ConstraintAttribute.BOTTOM,
-                                   relation: Emeus.ConstraintRelation.EQ,
-                                   source_attribute: Emeus.ConstraintAttribute.BOTTOM,
-                                   constant: -8.0 }),
-        ].forEach(this._layout.add_constraint, this._layout);
+        /* The constraints are added in a single call; each row refers to
+         * the widgets using their index in the objects array, or -1 for
+         * the layout itself
+         */
+        const Attr = Emeus.ConstraintAttribute;
+        const Rel = Emeus.ConstraintRelation;
+        const REQUIRED = Emeus.ConstraintStrength.REQUIRED;
+
+        let objects = [button1, button2, button3];
+        let data = [
+            /* target, attribute, relation, source, attribute, multiplier, constant, strength */
+            -1, Attr.START,  Rel.EQ,  0, Attr.START,  1.0,  -8.0, REQUIRED,
+             0, Attr.WIDTH,  Rel.EQ,  1, Attr.WIDTH,  1.0,   0.0, REQUIRED,
+             0, Attr.END,    Rel.EQ,  1, Attr.START,  1.0, -12.0, REQUIRED,
+             1, Attr.END,    Rel.EQ, -1, Attr.END,    1.0,  -8.0, REQUIRED,
+            -1, Attr.START,  Rel.EQ,  2, Attr.START,  1.0,  -8.0, REQUIRED,
+             2, Attr.END,    Rel.EQ, -1, Attr.END,    1.0,  -8.0, REQUIRED,
+            -1, Attr.TOP,    Rel.EQ,  0, Attr.TOP,    1.0,  -8.0, REQUIRED,
+            -1, Attr.TOP,    Rel.EQ,  1, Attr.TOP,    1.0,  -8.0, REQUIRED,
+             0, Attr.BOTTOM, Rel.EQ,  2, Attr.TOP,    1.0, -12.0, REQUIRED,
+             1, Attr.BOTTOM, Rel.EQ,  2, Attr.TOP,    1.0, -12.0, REQUIRED,
+             2, Attr.HEIGHT, Rel.EQ,  0, Attr.HEIGHT, 1.0,   0.0, REQUIRED,
+             2, Attr.HEIGHT, Rel.EQ,  1, Attr.HEIGHT, 1.0,   0.0, REQUIRED,
+             2, Attr.BOTTOM, Rel.EQ, -1, Attr.BOTTOM, 1.0,  -8.0, REQUIRED,
+        ];
+
+        this._layout.add_constraint_descriptors(objects, data);
     },
 });
 
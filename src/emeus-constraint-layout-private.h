@@ -23,6 +23,15 @@
 
 G_BEGIN_DECLS
 
+/* A named set of constraints that can be disabled as a whole */
+typedef struct {
+  char *name;
+
+  gboolean active;
+} ConstraintGroup;
+
+typedef struct _AsyncSolve      AsyncSolve;
+
 struct _EmeusConstraintLayoutChild
 {
   GtkBin parent_instance;
@@ -50,9 +59,31 @@ struct _EmeusConstraintLayoutChild
    */
   GHashTable *constraints;
 
+  /* Vec<uint>; the handles of the constraints on the widget added
+   * from descriptors, without a public API object.
+   */
+  GArray *constraint_handles;
+
+  /* HashSet<EmeusConstraint>; the constraints of the layout and of the
+   * other children that use the widget as their source. The set does
+   * not own the constraints.
+   */
+  GHashTable *source_constraints;
+
+  /* Vec<uint>; the handles of the constraints added from descriptors
+   * that use the widget as their source, and are owned by the layout
+   * or by other children.
+   */
+  GArray *source_handles;
+
   double intrinsic_width;
   double intrinsic_height;
 
+  /* Whether the constraints of the child are disabled in the solver,
+   * because the child is hidden
+   */
+  gboolean is_hidden;
+
   /* Internal constraints, created to satisfy specific bound
    * attributes; may be unset.
    */
@@ -79,6 +110,69 @@ struct _EmeusConstraintLayout
    */
   GHashTable *constraints;
 
+  /* HashTable<uint, ConstraintHandle>; the constraints added from
+   * descriptors, on the layout and on its children, and the last
+   * handle given out
+   */
+  GHashTable *constraint_handles;
+  guint last_constraint_handle;
+
+  /* HashTable<string, ConstraintGroup>; the named groups of
+   * constraints, and whether the membership or the state of a
+   * group changed since the constraints were last disabled
+   */
+  GHashTable *constraint_groups;
+  gboolean groups_changed;
+
+  /* Vec<ParametricSolution>; the most recently used solution is first;
+   * unset if the solution cache is not in use
+   */
+  GPtrArray *solution_cache;
+
+  /* The serial of the solver when the constraints of the hidden
+   * children were last disabled
+   */
+  int hidden_serial;
+
+  /* The number of emeus_constraint_layout_freeze() calls, and whether
+   * a resize was requested while the layout was frozen
+   */
+  int freeze_count;
+  gboolean resize_pending;
+
+  /* Whether the constraints are solved in a separate thread; the solve
+   * in progress, if any; and the solution waiting for the next frame to
+   * be applied, if any
+   */
+  gboolean async_solve;
+  AsyncSolve *async_job;
+  AsyncSolve *async_result;
+  guint async_tick_id;
+
+  /* The time, in microseconds, the solver can spend on each frame, or 0
+   * for no limit; and the tick callback that resumes an incomplete solve
+   * on the next frame
+   */
+  gint64 solve_budget;
+  guint budget_tick_id;
+
+  /* Whether the solutions are shared with other layouts */
+  gboolean use_shared_solution_cache;
+
+  /* The signature of the constraints, used to look up shared solutions,
+   * and the serial of the solver when it was computed
+   */
+  GBytes *signature;
+  guint64 signature_hash;
+  int signature_serial;
+
+  /* HashTable<string, TemplateChild>; the attributes of the named
+   * children of the template the layout was created from, until a
+   * child with the same name is added; unset if the layout was not
+   * created from a template
+   */
+  GHashTable *template_children;
+
   /* Internal constraints */
   Constraint *top_constraint;
   Constraint *left_constraint;
@@ -35,8 +35,10 @@
 #include "emeus-simplex-solver-private.h"
 #include "emeus-utils-private.h"
 #include "emeus-variable-private.h"
+#include "emeus-vfl-parser-private.h"
 
 #include <math.h>
+#include <string.h>
 
 enum {
   CHILD_PROP_NAME = 1,
@@ -50,12 +52,333 @@ G_DEFINE_TYPE (EmeusConstraintLayout, emeus_constraint_layout, GTK_TYPE_CONTAINE
 
 G_DEFINE_TYPE (EmeusConstraintLayoutChild, emeus_constraint_layout_child, GTK_TYPE_BIN)
 
+G_DEFINE_QUARK (emeus-constraint-layout-error-quark, emeus_constraint_layout_error)
+
 #ifdef EMEUS_ENABLE_DEBUG
 # define DEBUG(x)       x
 #else
 # define DEBUG(x)
 #endif
 
+/* The number of solutions kept when the solution cache is in use */
+#define SOLUTION_CACHE_SIZE     8
+
+/* The number of solutions kept in the cache shared between layouts */
+#define SHARED_SOLUTION_CACHE_SIZE      256
+
+/* The number of removed constraints after which the solver drops the
+ * variables and columns nothing refers to any more
+ */
+#define COMPACT_THRESHOLD       64
+
+static void
+clear_solution_cache (EmeusConstraintLayout *layout)
+{
+  if (layout->solution_cache != NULL)
+    g_ptr_array_set_size (layout->solution_cache, 0);
+}
+
+/* The attributes of a named child of the template a layout was created
+ * from, copied into the solver of the layout
+ */
+typedef struct {
+  /* HashTable<static string, Variable> */
+  GHashTable *bound_attributes;
+
+  /* Vec<uint>; the handles of the copied constraints owned by the child,
+   * and of the ones using the child as their source
+   */
+  GArray *constraint_handles;
+  GArray *source_handles;
+
+  Constraint *right_constraint;
+  Constraint *bottom_constraint;
+  Constraint *center_x_constraint;
+  Constraint *center_y_constraint;
+  Constraint *width_constraint;
+  Constraint *height_constraint;
+} TemplateChild;
+
+static void
+template_child_free (gpointer data)
+{
+  TemplateChild *tchild = data;
+
+  if (data == NULL)
+    return;
+
+  g_clear_pointer (&tchild->bound_attributes, g_hash_table_unref);
+  g_clear_pointer (&tchild->constraint_handles, g_array_unref);
+  g_clear_pointer (&tchild->source_handles, g_array_unref);
+
+  g_slice_free (TemplateChild, tchild);
+}
+
+/* A constraint added from a EmeusConstraintDescriptor */
+typedef struct {
+  Constraint *constraint;
+
+  /* The child owning the constraint, or NULL if the constraint is
+   * owned by the layout
+   */
+  EmeusConstraintLayoutChild *child;
+
+  /* The child used as the source of the constraint, if it does not
+   * own the constraint
+   */
+  EmeusConstraintLayoutChild *source;
+
+  /* The group of the constraint, if any */
+  ConstraintGroup *group;
+} ConstraintHandle;
+
+static void
+constraint_group_free (gpointer data)
+{
+  ConstraintGroup *group = data;
+
+  if (data == NULL)
+    return;
+
+  g_free (group->name);
+
+  g_slice_free (ConstraintGroup, group);
+}
+
+static ConstraintGroup *
+get_constraint_group (EmeusConstraintLayout *layout,
+                      const char            *name)
+{
+  ConstraintGroup *group;
+
+  if (name == NULL)
+    return NULL;
+
+  group = g_hash_table_lookup (layout->constraint_groups, name);
+  if (group == NULL)
+    {
+      group = g_slice_new (ConstraintGroup);
+      group->name = g_strdup (name);
+      group->active = TRUE;
+
+      g_hash_table_insert (layout->constraint_groups, group->name, group);
+    }
+
+  return group;
+}
+
+static void
+constraint_handle_free (gpointer data)
+{
+  ConstraintHandle *handle = data;
+
+  if (data == NULL)
+    return;
+
+  g_slice_free (ConstraintHandle, handle);
+}
+
+/* A solve running in a separate thread, on a copy of the solver */
+struct _AsyncSolve {
+  SimplexSolver fork;
+
+  /* The serial of the solver when the copy was made */
+  int serial;
+
+  /* The copies of the size of the layout, and the values to suggest */
+  Variable *layout_width;
+  Variable *layout_height;
+  double size[2];
+};
+
+static void
+async_solve_free (gpointer data)
+{
+  AsyncSolve *job = data;
+
+  if (data == NULL)
+    return;
+
+  simplex_solver_clear (&job->fork);
+
+  g_slice_free (AsyncSolve, job);
+}
+
+/* Finds the child used as the source of @constraint, or %NULL if the
+ * source is the layout or a constant
+ */
+static EmeusConstraintLayoutChild *
+get_source_child (EmeusConstraint *constraint)
+{
+  if (constraint->source_attribute == EMEUS_CONSTRAINT_ATTRIBUTE_INVALID ||
+      constraint->source_object == NULL)
+    return NULL;
+
+  if (EMEUS_IS_CONSTRAINT_LAYOUT_CHILD (constraint->source_object))
+    return constraint->source_object;
+
+  return (EmeusConstraintLayoutChild *) gtk_widget_get_parent (constraint->source_object);
+}
+
+static void
+untrack_source_constraint (EmeusConstraint *constraint)
+{
+  EmeusConstraintLayoutChild *source = get_source_child (constraint);
+
+  if (source != NULL)
+    g_hash_table_remove (source->source_constraints, constraint);
+}
+
+static void
+constraint_handles_remove (GArray *handles,
+                           guint   handle)
+{
+  guint i;
+
+  for (i = 0; i < handles->len; i++)
+    {
+      if (g_array_index (handles, guint, i) == handle)
+        {
+          g_array_remove_index_fast (handles, i);
+          break;
+        }
+    }
+}
+
+/* Removes the constraints owned by @child from the solver in a single
+ * batch, so that the cost depends on the number of constraints of the
+ * @child, instead of the size of the layout; the constraints keeping
+ * the intrinsic size of the @child are kept if @keep_intrinsic_size
+ * is set.
+ *
+ * The constraints of the layout and of the other children that use
+ * @child as their source are removed as well, as they refer to the
+ * attributes of @child
+ */
+static void
+remove_child_constraints (EmeusConstraintLayout      *layout,
+                          EmeusConstraintLayoutChild *child,
+                          gboolean                    keep_intrinsic_size)
+{
+  GHashTableIter iter;
+  GPtrArray *batch;
+  gpointer key_p;
+  int i;
+
+  batch = g_ptr_array_new ();
+
+  g_hash_table_iter_init (&iter, child->constraints);
+  while (g_hash_table_iter_next (&iter, &key_p, NULL))
+    {
+      EmeusConstraint *constraint = key_p;
+
+      g_ptr_array_add (batch, constraint->constraint);
+      untrack_source_constraint (constraint);
+
+      /* The constraint is removed along with the rest of the batch */
+      constraint->constraint = NULL;
+      emeus_constraint_detach (constraint);
+    }
+
+  g_hash_table_remove_all (child->constraints);
+
+  g_hash_table_iter_init (&iter, child->source_constraints);
+  while (g_hash_table_iter_next (&iter, &key_p, NULL))
+    {
+      EmeusConstraint *constraint = key_p;
+      gpointer owner = constraint->target_object;
+
+      g_ptr_array_add (batch, constraint->constraint);
+
+      constraint->constraint = NULL;
+      emeus_constraint_detach (constraint);
+
+      /* Drops the last reference on the constraint */
+      if (EMEUS_IS_CONSTRAINT_LAYOUT_CHILD (owner))
+        g_hash_table_remove (EMEUS_CONSTRAINT_LAYOUT_CHILD (owner)->constraints, constraint);
+      else
+        g_hash_table_remove (EMEUS_CONSTRAINT_LAYOUT (owner)->constraints, constraint);
+    }
+
+  g_hash_table_remove_all (child->source_constraints);
+
+  /* The handles are only valid while the child is in the layout */
+  if (layout != NULL)
+    {
+      for (i = 0; i < child->constraint_handles->len; i++)
+        {
+          guint id = g_array_index (child->constraint_handles, guint, i);
+          gpointer key = GUINT_TO_POINTER (id);
+          ConstraintHandle *handle = g_hash_table_lookup (layout->constraint_handles, key);
+
+          g_ptr_array_add (batch, handle->constraint);
+
+          if (handle->source != NULL)
+            constraint_handles_remove (handle->source->source_handles, id);
+
+          g_hash_table_remove (layout->constraint_handles, key);
+        }
+
+      g_array_set_size (child->constraint_handles, 0);
+
+      for (i = 0; i < child->source_handles->len; i++)
+        {
+          guint id = g_array_index (child->source_handles, guint, i);
+          gpointer key = GUINT_TO_POINTER (id);
+          ConstraintHandle *handle = g_hash_table_lookup (layout->constraint_handles, key);
+
+          g_ptr_array_add (batch, handle->constraint);
+
+          if (handle->child != NULL)
+            constraint_handles_remove (handle->child->constraint_handles, id);
+
+          g_hash_table_remove (layout->constraint_handles, key);
+        }
+
+      g_array_set_size (child->source_handles, 0);
+    }
+
+  g_ptr_array_add (batch, child->right_constraint);
+  g_ptr_array_add (batch, child->bottom_constraint);
+  g_ptr_array_add (batch, child->center_x_constraint);
+  g_ptr_array_add (batch, child->center_y_constraint);
+  child->right_constraint = NULL;
+  child->bottom_constraint = NULL;
+  child->center_x_constraint = NULL;
+  child->center_y_constraint = NULL;
+
+  if (child->width_constraint != NULL &&
+      !(keep_intrinsic_size && constraint_is_edit (child->width_constraint)))
+    {
+      g_ptr_array_add (batch, child->width_constraint);
+      child->width_constraint = NULL;
+    }
+
+  if (child->height_constraint != NULL &&
+      !(keep_intrinsic_size && constraint_is_edit (child->height_constraint)))
+    {
+      g_ptr_array_add (batch, child->height_constraint);
+      child->height_constraint = NULL;
+    }
+
+  if (child->solver != NULL)
+    simplex_solver_remove_constraints (child->solver,
+                                       (Constraint **) batch->pdata,
+                                       batch->len);
+
+  /* A child removed from the layout has no constraints left to enable,
+   * and no edit constraint for its intrinsic size
+   */
+  if (!keep_intrinsic_size)
+    {
+      child->is_hidden = FALSE;
+      child->intrinsic_width = -1;
+      child->intrinsic_height = -1;
+    }
+
+  g_ptr_array_unref (batch);
+}
+
 static void
 emeus_constraint_layout_finalize (GObject *gobject)
 {
@@ -67,6 +390,12 @@ emeus_constraint_layout_finalize (GObject *gobject)
   g_clear_pointer (&self->children, g_sequence_free);
   g_clear_pointer (&self->bound_attributes, g_hash_table_unref);
   g_clear_pointer (&self->constraints, g_hash_table_unref);
+  g_clear_pointer (&self->constraint_handles, g_hash_table_unref);
+  g_clear_pointer (&self->constraint_groups, g_hash_table_unref);
+  g_clear_pointer (&self->solution_cache, g_ptr_array_unref);
+  g_clear_pointer (&self->template_children, g_hash_table_unref);
+  g_clear_pointer (&self->signature, g_bytes_unref);
+  g_clear_pointer (&self->async_result, async_solve_free);
 
   simplex_solver_clear (&self->solver);
 
@@ -287,6 +616,187 @@ get_child_attribute (EmeusConstraintLayoutChild *child,
   return res;
 }
 
+/* Like GtkFlowBox, a child is hidden if either the child or the widget
+ * inside it is hidden
+ */
+static gboolean
+child_is_visible (EmeusConstraintLayoutChild *child)
+{
+  GtkWidget *widget = gtk_bin_get_child (GTK_BIN (child));
+
+  if (!gtk_widget_get_visible (GTK_WIDGET (child)))
+    return FALSE;
+
+  return widget == NULL || gtk_widget_get_visible (widget);
+}
+
+/* Adds @constraint to either @disabled or @enabled, if its state in the
+ * solver does not match @enable
+ */
+static void
+add_changed_constraint (SimplexSolver *solver,
+                        Constraint    *constraint,
+                        gboolean       enable,
+                        GPtrArray     *disabled,
+                        GPtrArray     *enabled)
+{
+  gboolean is_disabled;
+
+  if (constraint == NULL)
+    return;
+
+  is_disabled = simplex_solver_is_constraint_disabled (solver, constraint);
+
+  if (enable && is_disabled)
+    g_ptr_array_add (enabled, constraint);
+  else if (!enable && !is_disabled)
+    g_ptr_array_add (disabled, constraint);
+}
+
+static gboolean
+constraint_group_is_active (ConstraintGroup *group)
+{
+  return group == NULL || group->active;
+}
+
+/* Collects the constraints of @child whose state in the solver does not
+ * match the visibility of the @child and the state of their group; the
+ * edit constraints holding the intrinsic size are never disabled, as
+ * values are suggested for them
+ */
+static void
+collect_child_constraints (EmeusConstraintLayout      *self,
+                           EmeusConstraintLayoutChild *child,
+                           gboolean                    visible,
+                           GPtrArray                  *disabled,
+                           GPtrArray                  *enabled)
+{
+  GHashTableIter iter;
+  gpointer key_p;
+  int i;
+
+  g_hash_table_iter_init (&iter, child->constraints);
+  while (g_hash_table_iter_next (&iter, &key_p, NULL))
+    {
+      EmeusConstraint *constraint = key_p;
+
+      add_changed_constraint (&self->solver, constraint->constraint,
+                              visible && constraint_group_is_active (constraint->group),
+                              disabled, enabled);
+    }
+
+  for (i = 0; i < child->constraint_handles->len; i++)
+    {
+      gpointer key = GUINT_TO_POINTER (g_array_index (child->constraint_handles, guint, i));
+      ConstraintHandle *handle = g_hash_table_lookup (self->constraint_handles, key);
+
+      add_changed_constraint (&self->solver, handle->constraint,
+                              visible && constraint_group_is_active (handle->group),
+                              disabled, enabled);
+    }
+
+  add_changed_constraint (&self->solver, child->right_constraint, visible, disabled, enabled);
+  add_changed_constraint (&self->solver, child->bottom_constraint, visible, disabled, enabled);
+  add_changed_constraint (&self->solver, child->center_x_constraint, visible, disabled, enabled);
+  add_changed_constraint (&self->solver, child->center_y_constraint, visible, disabled, enabled);
+
+  if (child->width_constraint != NULL && !constraint_is_edit (child->width_constraint))
+    add_changed_constraint (&self->solver, child->width_constraint, visible, disabled, enabled);
+
+  if (child->height_constraint != NULL && !constraint_is_edit (child->height_constraint))
+    add_changed_constraint (&self->solver, child->height_constraint, visible, disabled, enabled);
+}
+
+/* Collects the constraints owned by the layout whose state in the solver
+ * does not match the state of their group
+ */
+static void
+collect_layout_constraints (EmeusConstraintLayout *self,
+                            GPtrArray             *disabled,
+                            GPtrArray             *enabled)
+{
+  GHashTableIter iter;
+  gpointer key_p, value_p;
+
+  g_hash_table_iter_init (&iter, self->constraints);
+  while (g_hash_table_iter_next (&iter, &key_p, NULL))
+    {
+      EmeusConstraint *constraint = key_p;
+
+      add_changed_constraint (&self->solver, constraint->constraint,
+                              constraint_group_is_active (constraint->group),
+                              disabled, enabled);
+    }
+
+  g_hash_table_iter_init (&iter, self->constraint_handles);
+  while (g_hash_table_iter_next (&iter, NULL, &value_p))
+    {
+      ConstraintHandle *handle = value_p;
+
+      if (handle->child != NULL)
+        continue;
+
+      add_changed_constraint (&self->solver, handle->constraint,
+                              constraint_group_is_active (handle->group),
+                              disabled, enabled);
+    }
+}
+
+/* Disables the constraints of the hidden children and of the inactive
+ * groups, and enables the constraints that were disabled, so that the
+ * solver only optimizes the visible children; all the changes are
+ * applied in two batches, to optimize the tableau once
+ */
+static void
+update_disabled_constraints (EmeusConstraintLayout *self)
+{
+  GPtrArray *disabled, *enabled;
+  GSequenceIter *iter;
+  gboolean constraints_changed;
+
+  /* The hidden children may have new constraints */
+  constraints_changed = self->hidden_serial != self->solver.serial;
+
+  disabled = g_ptr_array_new ();
+  enabled = g_ptr_array_new ();
+
+  iter = g_sequence_get_begin_iter (self->children);
+  while (!g_sequence_iter_is_end (iter))
+    {
+      EmeusConstraintLayoutChild *child = g_sequence_get (iter);
+      gboolean visible = child_is_visible (child);
+
+      iter = g_sequence_iter_next (iter);
+
+      if (self->groups_changed ||
+          visible == child->is_hidden ||
+          (!visible && constraints_changed))
+        {
+          collect_child_constraints (self, child, visible, disabled, enabled);
+          child->is_hidden = !visible;
+        }
+    }
+
+  if (self->groups_changed)
+    collect_layout_constraints (self, disabled, enabled);
+
+  if (disabled->len > 0)
+    simplex_solver_disable_constraints (&self->solver,
+                                        (Constraint **) disabled->pdata,
+                                        disabled->len);
+
+  if (enabled->len > 0)
+    simplex_solver_enable_constraints (&self->solver,
+                                       (Constraint **) enabled->pdata,
+                                       enabled->len);
+
+  self->hidden_serial = self->solver.serial;
+  self->groups_changed = FALSE;
+
+  g_ptr_array_unref (disabled);
+  g_ptr_array_unref (enabled);
+}
+
 static void
 emeus_constraint_layout_get_preferred_size (EmeusConstraintLayout *self,
                                             GtkOrientation         orientation,
@@ -306,6 +816,8 @@ emeus_constraint_layout_get_preferred_size (EmeusConstraintLayout *self,
       return;
     }
 
+  update_disabled_constraints (self);
+
   switch (orientation)
     {
     case GTK_ORIENTATION_HORIZONTAL:
@@ -350,568 +862,2619 @@ emeus_constraint_layout_get_preferred_height (GtkWidget *widget,
                                               minimum_p, natural_p);
 }
 
-static void
-emeus_constraint_layout_size_allocate (GtkWidget     *widget,
-                                       GtkAllocation *allocation)
+/* Looks for a cached solution valid for the given size, and applies it
+ * to the variables of the solver
+ */
+static gboolean
+apply_cached_solution (EmeusConstraintLayout *self,
+                       const double          *size)
 {
-  EmeusConstraintLayout *self = EMEUS_CONSTRAINT_LAYOUT (widget);
-  EmeusConstraintLayoutChild *child;
-  Variable *layout_width, *layout_height;
-  GSequenceIter *iter;
+  int i;
 
-  gtk_widget_set_allocation (widget, allocation);
+  if (self->solution_cache == NULL)
+    return FALSE;
 
-  if (g_sequence_is_empty (self->children))
-    return;
+  for (i = 0; i < self->solution_cache->len; i++)
+    {
+      ParametricSolution *solution = g_ptr_array_index (self->solution_cache, i);
 
-  layout_width = get_layout_attribute (self, EMEUS_CONSTRAINT_ATTRIBUTE_WIDTH);
-  layout_height = get_layout_attribute (self, EMEUS_CONSTRAINT_ATTRIBUTE_HEIGHT);
+      /* All cached solutions are invalidated at the same time */
+      if (solution->serial != self->solver.serial)
+        {
+          clear_solution_cache (self);
+          return FALSE;
+        }
 
-  if (!simplex_solver_has_edit_variable (&self->solver, layout_width))
-    simplex_solver_add_edit_variable (&self->solver, layout_width, STRENGTH_REQUIRED);
-  if (!simplex_solver_has_edit_variable (&self->solver, layout_height))
-    simplex_solver_add_edit_variable (&self->solver, layout_height, STRENGTH_REQUIRED);
+      if (parametric_solution_apply (solution, size))
+        {
+          /* Keep the most recently used solutions first */
+          if (i > 0)
+            {
+              g_ptr_array_remove_index_fast (self->solution_cache, i);
+              g_ptr_array_insert (self->solution_cache, 0, solution);
+            }
+
+          return TRUE;
+        }
+    }
 
-  simplex_solver_begin_edit (&self->solver);
-  simplex_solver_suggest_value (&self->solver, layout_width, allocation->width);
-  simplex_solver_suggest_value (&self->solver, layout_height, allocation->height);
-  simplex_solver_resolve (&self->solver);
+  return FALSE;
+}
 
-#ifdef EMEUS_ENABLE_DEBUG
-  DEBUG (g_debug ("layout [%p] = { .width:%g, .height:%g }",
-                  self,
-                  variable_get_value (layout_width),
-                  variable_get_value (layout_height)));
-#endif
+/* A solution shared between layouts with the same constraints, the same
+ * size, and the same intrinsic sizes for their children
+ */
+typedef struct {
+  /* The sorted hashes of the constraints of the layout */
+  GBytes *signature;
 
-  iter = g_sequence_get_begin_iter (self->children);
-  while (!g_sequence_iter_is_end (iter))
-    {
-      Variable *top, *left, *width, *height;
-      GtkAllocation child_alloc;
-      GtkRequisition minimum;
+  /* The size of the layout, followed by the intrinsic size of each child */
+  int n_inputs;
+  double *inputs;
 
-      child = g_sequence_get (iter);
-      iter = g_sequence_iter_next (iter);
+  guint hash;
 
-      top = get_child_attribute (child, EMEUS_CONSTRAINT_ATTRIBUTE_TOP);
-      left = get_child_attribute (child, EMEUS_CONSTRAINT_ATTRIBUTE_LEFT);
-      width = get_child_attribute (child, EMEUS_CONSTRAINT_ATTRIBUTE_WIDTH);
-      height = get_child_attribute (child, EMEUS_CONSTRAINT_ATTRIBUTE_HEIGHT);
+  /* The left, top, width and height of each child */
+  int n_values;
+  double *values;
+} SharedSolution;
 
-#ifdef EMEUS_ENABLE_DEBUG
-      DEBUG (g_debug ("child '%s' [%p] = { .top:%g, .left:%g, .width:%g, .height:%g }",
-                      child->name,
-                      child,
-                      variable_get_value (top),
-                      variable_get_value (left),
-                      variable_get_value (width),
-                      variable_get_value (height)));
-#endif
+/* HashSet<SharedSolution> */
+static GHashTable *shared_solutions;
 
-      gtk_widget_get_preferred_size (GTK_WIDGET (child), &minimum, NULL);
+/* Queue<SharedSolution>; the oldest solution is first */
+static GQueue shared_solutions_queue;
 
-      child_alloc.x = floor (variable_get_value (left));
-      child_alloc.y = floor (variable_get_value (top));
-      child_alloc.width = variable_get_value (width) > minimum.width
-                        ? ceil (variable_get_value (width))
-                        : minimum.width;
-      child_alloc.height = variable_get_value (height) > minimum.height
-                         ? ceil (variable_get_value (height))
-                         : minimum.height;
+static void
+shared_solution_free (gpointer data)
+{
+  SharedSolution *solution = data;
 
-      gtk_widget_size_allocate (GTK_WIDGET (child), &child_alloc);
-    }
+  g_bytes_unref (solution->signature);
+  g_free (solution->inputs);
+  g_free (solution->values);
 
-  simplex_solver_remove_edit_variable (&self->solver, layout_width);
-  simplex_solver_remove_edit_variable (&self->solver, layout_height);
+  g_slice_free (SharedSolution, solution);
 }
 
-static void
-emeus_constraint_layout_add (GtkContainer *container,
-                             GtkWidget    *widget)
+static guint
+shared_solution_hash (gconstpointer data)
 {
-  EmeusConstraintLayout *self = EMEUS_CONSTRAINT_LAYOUT (container);
+  const SharedSolution *solution = data;
 
-  emeus_constraint_layout_pack (self, widget, NULL, NULL);
+  return solution->hash;
+}
+
+static gboolean
+shared_solution_equal (gconstpointer a,
+                       gconstpointer b)
+{
+  const SharedSolution *sa = a;
+  const SharedSolution *sb = b;
+
+  return sa->hash == sb->hash &&
+         sa->n_inputs == sb->n_inputs &&
+         memcmp (sa->inputs, sb->inputs, sizeof (double) * sa->n_inputs) == 0 &&
+         g_bytes_equal (sa->signature, sb->signature);
+}
+
+static guint64
+hash_combine (guint64 seed,
+              guint64 value)
+{
+  return seed ^ (value + 0x9e3779b97f4a7c15UL + (seed << 6) + (seed >> 2));
+}
+
+static guint64
+hash_double (double value)
+{
+  guint64 bits;
+
+  memcpy (&bits, &value, sizeof (double));
+
+  return bits;
+}
+
+static int
+compare_hashes (gconstpointer a,
+                gconstpointer b)
+{
+  guint64 ha = *((const guint64 *) a);
+  guint64 hb = *((const guint64 *) b);
+
+  return ha < hb ? -1 : (ha > hb ? 1 : 0);
+}
+
+typedef struct {
+  /* HashTable<Variable, guint64> */
+  GHashTable *codes;
+  guint64 hash;
+} SignatureClosure;
+
+/* Variables are identified by the position of their child in the layout
+ * and by their attribute, so that the same constraints on different
+ * layouts have the same hash
+ */
+static guint64
+get_variable_code (GHashTable *codes,
+                   Variable   *variable)
+{
+  guint64 *code = g_hash_table_lookup (codes, variable);
+
+  if (code != NULL)
+    return *code;
+
+  /* Variables that do not belong to an attribute make the signature
+   * unique to the layout
+   */
+  return hash_combine (G_MAXUINT64, variable->id_);
 }
 
 static void
-emeus_constraint_layout_remove (GtkContainer *container,
-                                GtkWidget    *widget)
+add_variable_codes (GHashTable *codes,
+                    GHashTable *bound_attributes,
+                    guint64     position)
 {
-  EmeusConstraintLayout *self = EMEUS_CONSTRAINT_LAYOUT (container);
-  EmeusConstraintLayoutChild *child;
-  gboolean was_visible;
+  GHashTableIter iter;
+  gpointer key_p, value_p;
 
-  child = EMEUS_CONSTRAINT_LAYOUT_CHILD (widget);
-  if (g_sequence_iter_get_sequence (child->iter) != self->children)
+  g_hash_table_iter_init (&iter, bound_attributes);
+  while (g_hash_table_iter_next (&iter, &key_p, &value_p))
     {
-      g_critical ("Tried to remove non child %p", widget);
-      return;
+      guint64 *code = g_new (guint64, 1);
+
+      *code = hash_combine (position, g_str_hash (key_p));
+
+      g_hash_table_insert (codes, value_p, code);
     }
+}
 
-  was_visible = gtk_widget_get_visible (widget);
+static bool
+hash_term (Term     *term,
+           gpointer  data)
+{
+  SignatureClosure *closure = data;
 
-  gtk_widget_unparent (widget);
-  g_sequence_remove (child->iter);
+  /* The order of the terms depends on the variables, so their hashes
+   * are added together
+   */
+  closure->hash += hash_combine (get_variable_code (closure->codes, term_get_variable (term)),
+                                 hash_double (term_get_coefficient (term)));
 
-  if (was_visible && gtk_widget_get_visible (GTK_WIDGET (container)))
-    gtk_widget_queue_resize (GTK_WIDGET (container));
+  return true;
 }
 
+/* Computes the signature of the constraints of the layout, if they
+ * changed since the last time
+ */
 static void
-emeus_constraint_layout_forall (GtkContainer *container,
-                                gboolean      internals,
-                                GtkCallback   callback,
-                                gpointer      data)
+update_signature (EmeusConstraintLayout *self)
 {
-  EmeusConstraintLayout *self = EMEUS_CONSTRAINT_LAYOUT (container);
+  SignatureClosure closure;
   GSequenceIter *iter;
-  GtkWidget *child;
+  GHashTableIter constraint_iter;
+  GArray *hashes;
+  gpointer key_p;
+  guint64 position = 0;
+  int i;
 
-  if (g_sequence_is_empty (self->children))
+  if (self->signature != NULL && self->signature_serial == self->solver.serial)
     return;
 
+  closure.codes = g_hash_table_new_full (NULL, NULL, NULL, g_free);
+
+  add_variable_codes (closure.codes, self->bound_attributes, position++);
+
   iter = g_sequence_get_begin_iter (self->children);
   while (!g_sequence_iter_is_end (iter))
     {
-      child = g_sequence_get (iter);
+      EmeusConstraintLayoutChild *child = g_sequence_get (iter);
+
       iter = g_sequence_iter_next (iter);
 
-      callback (child, data);
+      add_variable_codes (closure.codes, child->bound_attributes, position++);
     }
-}
 
-static GType
-emeus_constraint_layout_child_type (GtkContainer *container)
-{
-  return EMEUS_TYPE_CONSTRAINT_LAYOUT_CHILD;
-}
+  hashes = g_array_new (FALSE, FALSE, sizeof (guint64));
 
-static void
-emeus_constraint_layout_class_init (EmeusConstraintLayoutClass *klass)
-{
-  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
-  GtkWidgetClass *widget_class = GTK_WIDGET_CLASS (klass);
-  GtkContainerClass *container_class = GTK_CONTAINER_CLASS (klass);
+  /* The number of children is part of the signature */
+  g_array_append_val (hashes, position);
 
-  gobject_class->finalize = emeus_constraint_layout_finalize;
+  g_hash_table_iter_init (&constraint_iter, self->solver.constraints);
+  while (g_hash_table_iter_next (&constraint_iter, &key_p, NULL))
+    {
+      Constraint *constraint = key_p;
+      guint64 hash = 0;
 
-  widget_class->get_preferred_width = emeus_constraint_layout_get_preferred_width;
-  widget_class->get_preferred_height = emeus_constraint_layout_get_preferred_height;
-  widget_class->size_allocate = emeus_constraint_layout_size_allocate;
+      hash = hash_combine (hash, constraint->op_type);
+      hash = hash_combine (hash, constraint->strength);
+      hash = hash_combine (hash, constraint->is_edit);
+      hash = hash_combine (hash, constraint->is_stay);
+      hash = hash_combine (hash, hash_double (expression_get_constant (constraint->expression)));
 
-  container_class->add = emeus_constraint_layout_add;
-  container_class->remove = emeus_constraint_layout_remove;
-  container_class->forall = emeus_constraint_layout_forall;
-  container_class->child_type = emeus_constraint_layout_child_type;
-  gtk_container_class_handle_border_width (container_class);
+      if (constraint->variable != NULL)
+        hash = hash_combine (hash, get_variable_code (closure.codes, constraint->variable));
+
+      closure.hash = 0;
+      expression_terms_foreach (constraint->expression, hash_term, &closure);
+      hash = hash_combine (hash, closure.hash);
+
+      g_array_append_val (hashes, hash);
+    }
+
+  /* The order of the constraints depends on the solver */
+  g_array_sort (hashes, compare_hashes);
+
+  g_clear_pointer (&self->signature, g_bytes_unref);
+  self->signature_hash = 0;
+  for (i = 0; i < hashes->len; i++)
+    self->signature_hash = hash_combine (self->signature_hash, g_array_index (hashes, guint64, i));
+
+  self->signature = g_bytes_new (hashes->data, hashes->len * sizeof (guint64));
+  self->signature_serial = self->solver.serial;
+
+  g_array_unref (hashes);
+  g_hash_table_unref (closure.codes);
 }
 
+/* Fills @key with the current inputs of the layout; the inputs are
+ * allocated, and must be freed
+ */
 static void
-emeus_constraint_layout_init (EmeusConstraintLayout *self)
+get_shared_solution_key (EmeusConstraintLayout *self,
+                         const double          *size,
+                         SharedSolution        *key)
 {
-  Variable *var;
-
-  gtk_widget_set_has_window (GTK_WIDGET (self), FALSE);
-
-  simplex_solver_init (&self->solver);
+  GSequenceIter *iter;
+  guint64 hash;
+  int i;
 
-  self->children = g_sequence_new (NULL);
+  update_signature (self);
 
-  self->bound_attributes = g_hash_table_new_full (NULL, NULL,
-                                                  NULL,
-                                                  (GDestroyNotify) variable_unref);
+  key->signature = self->signature;
+  key->n_inputs = 2 + g_sequence_get_length (self->children) * 2;
+  key->inputs = g_new (double, key->n_inputs);
+  key->inputs[0] = size[0];
+  key->inputs[1] = size[1];
 
-  self->constraints = g_hash_table_new_full (NULL, NULL,
-                                             g_object_unref,
-                                             NULL);
+  i = 2;
+  iter = g_sequence_get_begin_iter (self->children);
+  while (!g_sequence_iter_is_end (iter))
+    {
+      EmeusConstraintLayoutChild *child = g_sequence_get (iter);
 
-  /* Add two required stay constraints for the top left corner */
-  var = simplex_solver_create_variable (&self->solver, "top", 0.0);
-  variable_set_prefix (var, "super");
-  g_hash_table_insert (self->bound_attributes,
-                       (gpointer) get_attribute_name (EMEUS_CONSTRAINT_ATTRIBUTE_TOP),
-                       var);
-  self->top_constraint =
-    simplex_solver_add_stay_variable (&self->solver, var, STRENGTH_WEAK);
+      iter = g_sequence_iter_next (iter);
 
-  var = simplex_solver_create_variable (&self->solver, "left", 0.0);
-  variable_set_prefix (var, "super");
-  g_hash_table_insert (self->bound_attributes,
-                       (gpointer) get_attribute_name (EMEUS_CONSTRAINT_ATTRIBUTE_LEFT),
-                       var);
-  self->left_constraint =
-    simplex_solver_add_stay_variable (&self->solver, var, STRENGTH_WEAK);
+      key->inputs[i++] = child->intrinsic_width;
+      key->inputs[i++] = child->intrinsic_height;
+    }
 
-  var = simplex_solver_create_variable (&self->solver, "width", 0.0);
-  variable_set_prefix (var, "super");
-  g_hash_table_insert (self->bound_attributes,
-                       (gpointer) get_attribute_name (EMEUS_CONSTRAINT_ATTRIBUTE_WIDTH),
-                       var);
-  self->width_constraint =
-    simplex_solver_add_stay_variable (&self->solver, var, STRENGTH_STRONG);
+  hash = self->signature_hash;
+  for (i = 0; i < key->n_inputs; i++)
+    hash = hash_combine (hash, hash_double (key->inputs[i]));
 
-  var = simplex_solver_create_variable (&self->solver, "height", 0.0);
-  variable_set_prefix (var, "super");
-  g_hash_table_insert (self->bound_attributes,
-                       (gpointer) get_attribute_name (EMEUS_CONSTRAINT_ATTRIBUTE_HEIGHT),
-                       var);
-  self->height_constraint =
-    simplex_solver_add_stay_variable (&self->solver, var, STRENGTH_STRONG);
+  key->hash = (guint) (hash ^ (hash >> 32));
+  key->n_values = 0;
+  key->values = NULL;
 }
 
-/**
- * emeus_constraint_layout_new:
- *
- * Creates a new constraint-based layout manager.
- *
- * Returns: (transfer full): the newly created layout widget
- *
- * Since: 1.0
+static const EmeusConstraintAttribute child_rectangle[] = {
+  EMEUS_CONSTRAINT_ATTRIBUTE_LEFT,
+  EMEUS_CONSTRAINT_ATTRIBUTE_TOP,
+  EMEUS_CONSTRAINT_ATTRIBUTE_WIDTH,
+  EMEUS_CONSTRAINT_ATTRIBUTE_HEIGHT,
+};
+
+/* Looks for a solution computed by another layout with the same
+ * constraints and inputs, and applies it to the attributes of the
+ * children, without going through the solver
  */
-GtkWidget *
-emeus_constraint_layout_new (void)
+static gboolean
+apply_shared_solution (EmeusConstraintLayout *self,
+                       const double          *size)
 {
-  return g_object_new (EMEUS_TYPE_CONSTRAINT_LAYOUT, NULL);
+  SharedSolution key, *solution;
+  GSequenceIter *iter;
+  int i, j;
+
+  if (!self->use_shared_solution_cache || shared_solutions == NULL)
+    return FALSE;
+
+  get_shared_solution_key (self, size, &key);
+  solution = g_hash_table_lookup (shared_solutions, &key);
+  g_free (key.inputs);
+
+  if (solution == NULL)
+    return FALSE;
+
+  i = 0;
+  iter = g_sequence_get_begin_iter (self->children);
+  while (!g_sequence_iter_is_end (iter))
+    {
+      EmeusConstraintLayoutChild *child = g_sequence_get (iter);
+
+      iter = g_sequence_iter_next (iter);
+
+      for (j = 0; j < G_N_ELEMENTS (child_rectangle); j++)
+        variable_set_value (get_child_attribute (child, child_rectangle[j]),
+                            solution->values[i++]);
+    }
+
+  return TRUE;
 }
 
 static void
-add_layout_constraint (EmeusConstraintLayout *layout,
-                       EmeusConstraint       *constraint)
+add_shared_solution (EmeusConstraintLayout *self,
+                     const double          *size)
 {
-  Variable *attr1, *attr2;
-  Expression *expr;
-
-  if (!emeus_constraint_attach (constraint, layout, layout))
-    return;
-
-  g_hash_table_add (layout->constraints, g_object_ref_sink (constraint));
+  SharedSolution *solution;
+  GSequenceIter *iter;
+  int i, j;
 
-  attr1 = get_layout_attribute (layout, constraint->target_attribute);
-  if (constraint->source_attribute == EMEUS_CONSTRAINT_ATTRIBUTE_INVALID)
+  if (shared_solutions == NULL)
     {
-      attr2 = simplex_solver_create_variable (constraint->solver, "const",
-                                              emeus_constraint_get_constant (constraint));
+      shared_solutions = g_hash_table_new_full (shared_solution_hash,
+                                                shared_solution_equal,
+                                                shared_solution_free,
+                                                NULL);
+      g_queue_init (&shared_solutions_queue);
+    }
 
-      simplex_solver_add_stay_variable (constraint->solver, attr2, STRENGTH_REQUIRED);
+  solution = g_slice_new (SharedSolution);
 
-      constraint->constraint =
-        simplex_solver_add_constraint (constraint->solver,
-                                       attr1,
-                                       relation_to_operator (constraint->relation),
-                                       expression_new_from_variable (attr2),
-                                       strength_to_value (constraint->strength));
-      variable_unref (attr2);
+  get_shared_solution_key (self, size, solution);
 
+  if (g_hash_table_contains (shared_solutions, solution))
+    {
+      g_free (solution->inputs);
+      g_slice_free (SharedSolution, solution);
       return;
     }
 
-  if (constraint->source_object != NULL)
-    {
-      EmeusConstraintLayoutChild *source_child;
+  g_bytes_ref (solution->signature);
 
-      if (EMEUS_IS_CONSTRAINT_LAYOUT_CHILD (constraint->source_object))
-        source_child = constraint->source_object;
-      else
-        source_child = (EmeusConstraintLayoutChild *) gtk_widget_get_parent (constraint->source_object);
+  solution->n_values = g_sequence_get_length (self->children) * G_N_ELEMENTS (child_rectangle);
+  solution->values = g_new (double, solution->n_values);
 
-      attr2 = get_child_attribute (source_child, constraint->source_attribute);
-    }
-  else
+  i = 0;
+  iter = g_sequence_get_begin_iter (self->children);
+  while (!g_sequence_iter_is_end (iter))
     {
-      attr2 = get_layout_attribute (layout, constraint->source_attribute);
+      EmeusConstraintLayoutChild *child = g_sequence_get (iter);
+
+      iter = g_sequence_iter_next (iter);
+
+      for (j = 0; j < G_N_ELEMENTS (child_rectangle); j++)
+        solution->values[i++] = variable_get_value (get_child_attribute (child, child_rectangle[j]));
     }
 
-  expr =
-    expression_plus (expression_times (expression_new_from_variable (attr2),
-                                       constraint->multiplier),
-                     constraint->constant);
+  if (g_hash_table_size (shared_solutions) == SHARED_SOLUTION_CACHE_SIZE)
+    g_hash_table_remove (shared_solutions, g_queue_pop_head (&shared_solutions_queue));
 
-  constraint->constraint =
-    simplex_solver_add_constraint (constraint->solver,
-                                   attr1,
-                                   relation_to_operator (constraint->relation),
-                                   expr,
-                                   strength_to_value (constraint->strength));
+  g_hash_table_add (shared_solutions, solution);
+  g_queue_push_tail (&shared_solutions_queue, solution);
 }
 
 static void
-add_child_constraint (EmeusConstraintLayout      *layout,
-                      EmeusConstraintLayoutChild *child,
-                      EmeusConstraint            *constraint)
+add_cached_solution (EmeusConstraintLayout *self,
+                     Variable              *layout_width,
+                     Variable              *layout_height)
 {
-  Variable *attr1, *attr2;
-  Expression *expr;
+  Variable *parameters[2] = { layout_width, layout_height };
+  ParametricSolution *solution;
 
-  if (emeus_constraint_is_attached (constraint))
-    {
-      const char *constraint_description = emeus_constraint_to_string (constraint);
+  solution = simplex_solver_get_parametric_solution (&self->solver, parameters, 2);
+  if (solution == NULL)
+    return;
 
-      g_critical ("Constraint '%s' cannot be attached to more than "
-                  "one child.",
-                  constraint_description);
+  if (self->solution_cache->len == SOLUTION_CACHE_SIZE)
+    g_ptr_array_remove_index (self->solution_cache, SOLUTION_CACHE_SIZE - 1);
 
-      return;
-    }
+  g_ptr_array_insert (self->solution_cache, 0, solution);
+}
 
-  if (!emeus_constraint_attach (constraint, layout, child))
-    return;
+static void
+async_solve_thread (GTask        *task,
+                    gpointer      source_object,
+                    gpointer      task_data,
+                    GCancellable *cancellable)
+{
+  AsyncSolve *job = task_data;
 
-  g_hash_table_add (child->constraints, g_object_ref_sink (constraint));
+  /* The copy belongs to this thread until the task returns */
+  simplex_solver_begin_edit (&job->fork);
+  simplex_solver_suggest_value (&job->fork, job->layout_width, job->size[0]);
+  simplex_solver_suggest_value (&job->fork, job->layout_height, job->size[1]);
+  simplex_solver_resolve (&job->fork);
 
-  /* attr1 is the LHS of the linear equation */
-  attr1 = get_child_attribute (constraint->target_object,
-                               constraint->target_attribute);
+  g_task_return_boolean (task, TRUE);
+}
 
-  /* attr2 is the RHS of the linear equation; if it's a constant value
-   * we create a stay constraint for it. Stay constraints ensure that a
-   * variable won't be modified by the solver.
+/* Merges the solution computed in a separate thread into the solver of
+ * the layout, during the update phase of the frame clock, and allocates
+ * the children again
+ */
+static gboolean
+apply_async_solution (GtkWidget     *widget,
+                      GdkFrameClock *frame_clock,
+                      gpointer       data)
+{
+  EmeusConstraintLayout *self = EMEUS_CONSTRAINT_LAYOUT (widget);
+  AsyncSolve *job = g_steal_pointer (&self->async_result);
+
+  self->async_tick_id = 0;
+
+  if (job != NULL &&
+      job->serial == self->solver.serial &&
+      self->solver.needs_solving)
+    simplex_solver_merge_fork (&self->solver, &job->fork);
+
+  async_solve_free (job);
+
+  /* The new solution may change the preferred size of the layout; if
+   * the constraints changed since the solve started, this starts a
+   * new one
    */
-  if (constraint->source_attribute == EMEUS_CONSTRAINT_ATTRIBUTE_INVALID)
-    {
-      attr2 = simplex_solver_create_variable (constraint->solver, "const",
-                                              emeus_constraint_get_constant (constraint));
+  gtk_widget_queue_resize (widget);
 
-      simplex_solver_add_stay_variable (child->solver, attr2, STRENGTH_REQUIRED);
+  return G_SOURCE_REMOVE;
+}
 
-      constraint->constraint =
-        simplex_solver_add_constraint (constraint->solver,
-                                       attr1,
-                                       relation_to_operator (constraint->relation),
-                                       expression_new_from_variable (attr2),
-                                       strength_to_value (constraint->strength));
+static void
+async_solve_done (GObject      *gobject,
+                  GAsyncResult *result,
+                  gpointer      data)
+{
+  EmeusConstraintLayout *self = EMEUS_CONSTRAINT_LAYOUT (gobject);
+  AsyncSolve *job = g_task_get_task_data (G_TASK (result));
 
-      variable_unref (attr2);
+  g_assert (job == self->async_job);
+  self->async_job = NULL;
 
+  if (!g_task_propagate_boolean (G_TASK (result), NULL) ||
+      !self->async_solve ||
+      gtk_widget_in_destruction (GTK_WIDGET (self)))
+    {
+      async_solve_free (job);
       return;
     }
 
-  /* Alternatively, if it's not a constant value, we find the variable
-   * associated with it
+  g_clear_pointer (&self->async_result, async_solve_free);
+  self->async_result = job;
+
+  if (self->async_tick_id == 0)
+    self->async_tick_id = gtk_widget_add_tick_callback (GTK_WIDGET (self),
+                                                        apply_async_solution,
+                                                        NULL, NULL);
+}
+
+/* Solves the pending constraints on a copy of the solver, in a separate
+ * thread; the children keep the values of the last solution until the
+ * new one is applied
+ */
+static void
+start_async_solve (EmeusConstraintLayout *self,
+                   Variable              *layout_width,
+                   Variable              *layout_height,
+                   const double          *size)
+{
+  AsyncSolve *job;
+  GTask *task;
+
+  /* A single solve runs at any given time; once it is done, a new one
+   * starts if the constraints changed in the meantime
    */
-  if (constraint->source_object != NULL)
-    {
-      EmeusConstraintLayoutChild *source_child;
+  if (self->async_job != NULL)
+    return;
 
-      if (EMEUS_IS_CONSTRAINT_LAYOUT_CHILD (constraint->source_object))
-        source_child = constraint->source_object;
-      else
-        source_child = (EmeusConstraintLayoutChild *) gtk_widget_get_parent (constraint->source_object);
+  if (self->async_result != NULL && self->async_result->serial == self->solver.serial)
+    return;
 
-      attr2 = get_child_attribute (source_child, constraint->source_attribute);
-    }
-  else
+  job = g_slice_new0 (AsyncSolve);
+
+  /* The fork copies the whole solver, in O(n), before the thread runs */
+  simplex_solver_fork (&self->solver, &job->fork);
+  job->serial = self->solver.serial;
+  job->layout_width = simplex_solver_get_forked_variable (&job->fork, layout_width);
+  job->layout_height = simplex_solver_get_forked_variable (&job->fork, layout_height);
+  job->size[0] = size[0];
+  job->size[1] = size[1];
+
+  self->async_job = job;
+
+  /* The task keeps the layout alive until the solve is done */
+  task = g_task_new (self, NULL, async_solve_done, NULL);
+  g_task_set_task_data (task, job, NULL);
+  g_task_run_in_thread (task, async_solve_thread);
+  g_object_unref (task);
+}
+
+/* Resumes an incomplete solve on the next frame */
+static gboolean
+resume_budgeted_solve (GtkWidget     *widget,
+                       GdkFrameClock *frame_clock,
+                       gpointer       data)
+{
+  EmeusConstraintLayout *self = EMEUS_CONSTRAINT_LAYOUT (widget);
+
+  self->budget_tick_id = 0;
+
+  /* The preferred size of the layout depends on the solution */
+  gtk_widget_queue_resize (widget);
+
+  return G_SOURCE_REMOVE;
+}
+
+/* Solves the constraints for the given size, spending at most the
+ * budget of the layout on each frame; until the solution is complete,
+ * the children are allocated using values that satisfy the required
+ * constraints, and the solve continues on the next frame
+ *
+ * Returns: %TRUE if the solution is complete
+ */
+static gboolean
+solve_with_budget (EmeusConstraintLayout *self,
+                   Variable              *layout_width,
+                   Variable              *layout_height,
+                   const double          *size)
+{
+  gboolean done;
+
+  done = simplex_solver_resolve_with_budget (&self->solver, 0, self->solve_budget);
+
+  if (done)
     {
-      attr2 = get_layout_attribute (layout, constraint->source_attribute);
+      simplex_solver_begin_edit (&self->solver);
+      simplex_solver_suggest_value (&self->solver, layout_width, size[0]);
+      simplex_solver_suggest_value (&self->solver, layout_height, size[1]);
+      done = simplex_solver_resolve_with_budget (&self->solver, 0, self->solve_budget);
     }
 
-  /* Turn attr2 into an expression in the form:
+  if (!done && self->budget_tick_id == 0)
+    self->budget_tick_id = gtk_widget_add_tick_callback (GTK_WIDGET (self),
+                                                         resume_budgeted_solve,
+                                                         NULL, NULL);
+
+  return done;
+}
+
+static void
+emeus_constraint_layout_size_allocate (GtkWidget     *widget,
+                                       GtkAllocation *allocation)
+{
+  EmeusConstraintLayout *self = EMEUS_CONSTRAINT_LAYOUT (widget);
+  EmeusConstraintLayoutChild *child;
+  Variable *layout_width, *layout_height;
+  GSequenceIter *iter;
+  double size[2];
+
+  gtk_widget_set_allocation (widget, allocation);
+
+  if (g_sequence_is_empty (self->children))
+    return;
+
+  update_disabled_constraints (self);
+
+  layout_width = get_layout_attribute (self, EMEUS_CONSTRAINT_ATTRIBUTE_WIDTH);
+  layout_height = get_layout_attribute (self, EMEUS_CONSTRAINT_ATTRIBUTE_HEIGHT);
+
+  size[0] = allocation->width;
+  size[1] = allocation->height;
+
+  /* We keep the edit variables around between allocations: removing
+   * them would change the tableau, and the solver would not be able
+   * to reuse the current basis when resizing; they are also part of
+   * the constraints used to find a shared solution.
    *
-   *   expr = attr2 * multiplier + constant
+   * Since they outlive the allocation, they are not required: a required
+   * constraint added later can still make the layout larger than the
+   * last allocation, and the preferred size will reflect it
    */
-  expr =
-    expression_plus (expression_times (expression_new_from_variable (attr2),
-                                       constraint->multiplier),
-                     constraint->constant);
+  if (!simplex_solver_has_edit_variable (&self->solver, layout_width))
+    simplex_solver_add_edit_variable (&self->solver, layout_width, STRENGTH_REQUIRED - 1);
+  if (!simplex_solver_has_edit_variable (&self->solver, layout_height))
+    simplex_solver_add_edit_variable (&self->solver, layout_height, STRENGTH_REQUIRED - 1);
+
+  /* The pending constraints of an asynchronous layout are solved in a
+   * separate thread, unless the difference engine holds some of them, as
+   * the solution of a fork can only be merged back from the tableau
+   */
+  if (self->async_solve &&
+      self->solver.needs_solving &&
+      !simplex_solver_has_differences (&self->solver))
+    {
+      if (!apply_shared_solution (self, size))
+        start_async_solve (self, layout_width, layout_height, size);
+    }
+  else if (!apply_shared_solution (self, size))
+    {
+      gboolean done = TRUE;
+
+      if (!apply_cached_solution (self, size))
+        {
+          if (self->solve_budget > 0)
+            done = solve_with_budget (self, layout_width, layout_height, size);
+          else
+            {
+              simplex_solver_begin_edit (&self->solver);
+              simplex_solver_suggest_value (&self->solver, layout_width, allocation->width);
+              simplex_solver_suggest_value (&self->solver, layout_height, allocation->height);
+              simplex_solver_resolve (&self->solver);
+            }
+
+          /* An incomplete solution is neither cached nor shared */
+          if (done && self->solution_cache != NULL)
+            add_cached_solution (self, layout_width, layout_height);
+        }
+
+      if (done && self->use_shared_solution_cache)
+        add_shared_solution (self, size);
+    }
+
+#ifdef EMEUS_ENABLE_DEBUG
+  DEBUG (g_debug ("layout [%p] = { .width:%g, .height:%g }",
+                  self,
+                  variable_get_value (layout_width),
+                  variable_get_value (layout_height)));
+#endif
+
+  iter = g_sequence_get_begin_iter (self->children);
+  while (!g_sequence_iter_is_end (iter))
+    {
+      Variable *top, *left, *width, *height;
+      GtkAllocation child_alloc;
+      GtkRequisition minimum;
+
+      child = g_sequence_get (iter);
+      iter = g_sequence_iter_next (iter);
+
+      /* Hidden children are not part of the solution */
+      if (child->is_hidden)
+        continue;
+
+      top = get_child_attribute (child, EMEUS_CONSTRAINT_ATTRIBUTE_TOP);
+      left = get_child_attribute (child, EMEUS_CONSTRAINT_ATTRIBUTE_LEFT);
+      width = get_child_attribute (child, EMEUS_CONSTRAINT_ATTRIBUTE_WIDTH);
+      height = get_child_attribute (child, EMEUS_CONSTRAINT_ATTRIBUTE_HEIGHT);
+
+#ifdef EMEUS_ENABLE_DEBUG
+      DEBUG (g_debug ("child '%s' [%p] = { .top:%g, .left:%g, .width:%g, .height:%g }",
+                      child->name,
+                      child,
+                      variable_get_value (top),
+                      variable_get_value (left),
+                      variable_get_value (width),
+                      variable_get_value (height)));
+#endif
+
+      gtk_widget_get_preferred_size (GTK_WIDGET (child), &minimum, NULL);
+
+      child_alloc.x = floor (variable_get_value (left));
+      child_alloc.y = floor (variable_get_value (top));
+      child_alloc.width = variable_get_value (width) > minimum.width
+                        ? ceil (variable_get_value (width))
+                        : minimum.width;
+      child_alloc.height = variable_get_value (height) > minimum.height
+                         ? ceil (variable_get_value (height))
+                         : minimum.height;
+
+      gtk_widget_size_allocate (GTK_WIDGET (child), &child_alloc);
+    }
+}
+
+static void
+emeus_constraint_layout_add (GtkContainer *container,
+                             GtkWidget    *widget)
+{
+  EmeusConstraintLayout *self = EMEUS_CONSTRAINT_LAYOUT (container);
+
+  emeus_constraint_layout_pack (self, widget, NULL, NULL);
+}
+
+static void
+emeus_constraint_layout_remove (GtkContainer *container,
+                                GtkWidget    *widget)
+{
+  EmeusConstraintLayout *self = EMEUS_CONSTRAINT_LAYOUT (container);
+  EmeusConstraintLayoutChild *child;
+  gboolean was_visible;
+
+  child = EMEUS_CONSTRAINT_LAYOUT_CHILD (widget);
+  if (g_sequence_iter_get_sequence (child->iter) != self->children)
+    {
+      g_critical ("Tried to remove non child %p", widget);
+      return;
+    }
+
+  was_visible = gtk_widget_get_visible (widget);
+
+  remove_child_constraints (self, child, FALSE);
+
+  gtk_widget_unparent (widget);
+  g_sequence_remove (child->iter);
+
+  if (was_visible && gtk_widget_get_visible (GTK_WIDGET (container)))
+    {
+      if (self->freeze_count > 0)
+        self->resize_pending = TRUE;
+      else
+        gtk_widget_queue_resize (GTK_WIDGET (container));
+    }
+}
+
+static void
+emeus_constraint_layout_forall (GtkContainer *container,
+                                gboolean      internals,
+                                GtkCallback   callback,
+                                gpointer      data)
+{
+  EmeusConstraintLayout *self = EMEUS_CONSTRAINT_LAYOUT (container);
+  GSequenceIter *iter;
+  GtkWidget *child;
+
+  if (g_sequence_is_empty (self->children))
+    return;
+
+  iter = g_sequence_get_begin_iter (self->children);
+  while (!g_sequence_iter_is_end (iter))
+    {
+      child = g_sequence_get (iter);
+      iter = g_sequence_iter_next (iter);
+
+      callback (child, data);
+    }
+}
+
+static GType
+emeus_constraint_layout_child_type (GtkContainer *container)
+{
+  return EMEUS_TYPE_CONSTRAINT_LAYOUT_CHILD;
+}
+
+static void
+emeus_constraint_layout_class_init (EmeusConstraintLayoutClass *klass)
+{
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+  GtkWidgetClass *widget_class = GTK_WIDGET_CLASS (klass);
+  GtkContainerClass *container_class = GTK_CONTAINER_CLASS (klass);
+
+  gobject_class->finalize = emeus_constraint_layout_finalize;
+
+  widget_class->get_preferred_width = emeus_constraint_layout_get_preferred_width;
+  widget_class->get_preferred_height = emeus_constraint_layout_get_preferred_height;
+  widget_class->size_allocate = emeus_constraint_layout_size_allocate;
+
+  container_class->add = emeus_constraint_layout_add;
+  container_class->remove = emeus_constraint_layout_remove;
+  container_class->forall = emeus_constraint_layout_forall;
+  container_class->child_type = emeus_constraint_layout_child_type;
+  gtk_container_class_handle_border_width (container_class);
+}
+
+static void
+add_layout_stays (EmeusConstraintLayout *self)
+{
+  Variable *var;
+
+  /* Add two required stay constraints for the top left corner */
+  var = simplex_solver_create_variable (&self->solver, "top", 0.0);
+  variable_set_prefix (var, "super");
+  g_hash_table_insert (self->bound_attributes,
+                       (gpointer) get_attribute_name (EMEUS_CONSTRAINT_ATTRIBUTE_TOP),
+                       var);
+  self->top_constraint =
+    simplex_solver_add_stay_variable (&self->solver, var, STRENGTH_WEAK);
+
+  var = simplex_solver_create_variable (&self->solver, "left", 0.0);
+  variable_set_prefix (var, "super");
+  g_hash_table_insert (self->bound_attributes,
+                       (gpointer) get_attribute_name (EMEUS_CONSTRAINT_ATTRIBUTE_LEFT),
+                       var);
+  self->left_constraint =
+    simplex_solver_add_stay_variable (&self->solver, var, STRENGTH_WEAK);
+
+  var = simplex_solver_create_variable (&self->solver, "width", 0.0);
+  variable_set_prefix (var, "super");
+  g_hash_table_insert (self->bound_attributes,
+                       (gpointer) get_attribute_name (EMEUS_CONSTRAINT_ATTRIBUTE_WIDTH),
+                       var);
+  self->width_constraint =
+    simplex_solver_add_stay_variable (&self->solver, var, STRENGTH_STRONG);
+
+  var = simplex_solver_create_variable (&self->solver, "height", 0.0);
+  variable_set_prefix (var, "super");
+  g_hash_table_insert (self->bound_attributes,
+                       (gpointer) get_attribute_name (EMEUS_CONSTRAINT_ATTRIBUTE_HEIGHT),
+                       var);
+  self->height_constraint =
+    simplex_solver_add_stay_variable (&self->solver, var, STRENGTH_STRONG);
+}
+
+static void
+emeus_constraint_layout_init (EmeusConstraintLayout *self)
+{
+  gtk_widget_set_has_window (GTK_WIDGET (self), FALSE);
+
+  simplex_solver_init (&self->solver);
+  simplex_solver_set_compact_threshold (&self->solver, COMPACT_THRESHOLD);
+
+  self->children = g_sequence_new (NULL);
+
+  self->bound_attributes = g_hash_table_new_full (NULL, NULL,
+                                                  NULL,
+                                                  (GDestroyNotify) variable_unref);
+
+  self->constraints = g_hash_table_new_full (NULL, NULL,
+                                             g_object_unref,
+                                             NULL);
+
+  self->constraint_handles = g_hash_table_new_full (NULL, NULL,
+                                                    NULL,
+                                                    constraint_handle_free);
+
+  self->constraint_groups = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                                   NULL,
+                                                   constraint_group_free);
+
+  add_layout_stays (self);
+}
+
+/**
+ * emeus_constraint_layout_new:
+ *
+ * Creates a new constraint-based layout manager.
+ *
+ * Returns: (transfer full): the newly created layout widget
+ *
+ * Since: 1.0
+ */
+GtkWidget *
+emeus_constraint_layout_new (void)
+{
+  return g_object_new (EMEUS_TYPE_CONSTRAINT_LAYOUT, NULL);
+}
+
+static Constraint *
+get_forked_constraint (EmeusConstraintLayout *layout,
+                       Constraint            *constraint)
+{
+  if (constraint == NULL)
+    return NULL;
+
+  return simplex_solver_get_forked_constraint (&layout->solver, constraint);
+}
+
+/* Adds the copy of a constraint of the template to @layout as a handle;
+ * @owner and @source are the template children owning the constraint,
+ * and used as its source, and they bind the handle to the children of
+ * @layout with the same names, once they are added
+ */
+static void
+add_template_constraint (EmeusConstraintLayout *layout,
+                         Constraint            *constraint,
+                         ConstraintGroup       *group,
+                         TemplateChild         *owner,
+                         TemplateChild         *source)
+{
+  ConstraintHandle *handle;
+
+  if (constraint == NULL)
+    return;
+
+  handle = g_slice_new (ConstraintHandle);
+  handle->constraint = constraint;
+  handle->child = NULL;
+  handle->source = NULL;
+  handle->group = NULL;
+
+  if (group != NULL)
+    {
+      handle->group = get_constraint_group (layout, group->name);
+      handle->group->active = group->active;
+      layout->groups_changed = TRUE;
+    }
+
+  layout->last_constraint_handle += 1;
+
+  g_hash_table_insert (layout->constraint_handles,
+                       GUINT_TO_POINTER (layout->last_constraint_handle),
+                       handle);
+
+  if (owner != NULL)
+    g_array_append_val (owner->constraint_handles, layout->last_constraint_handle);
+
+  if (source != NULL && source != owner)
+    g_array_append_val (source->source_handles, layout->last_constraint_handle);
+}
+
+/* Adds the copy of @constraint to @layout if its owner and its source
+ * are either the layout or named children of the template, and drops it
+ * otherwise, as no child of @layout can be bound to it
+ */
+static void
+copy_template_constraint (EmeusConstraintLayout      *layout,
+                          GHashTable                 *tchildren,
+                          Constraint                 *constraint,
+                          ConstraintGroup            *group,
+                          EmeusConstraintLayoutChild *owner,
+                          EmeusConstraintLayoutChild *source,
+                          GPtrArray                  *dropped)
+{
+  TemplateChild *owner_tchild = NULL, *source_tchild = NULL;
+  Constraint *forked = get_forked_constraint (layout, constraint);
+
+  if (forked == NULL)
+    return;
+
+  if (owner != NULL)
+    {
+      owner_tchild = g_hash_table_lookup (tchildren, owner);
+      if (owner_tchild == NULL)
+        {
+          g_ptr_array_add (dropped, forked);
+          return;
+        }
+    }
+
+  if (source != NULL)
+    {
+      source_tchild = g_hash_table_lookup (tchildren, source);
+      if (source_tchild == NULL)
+        {
+          g_ptr_array_add (dropped, forked);
+          return;
+        }
+    }
+
+  add_template_constraint (layout, forked, group, owner_tchild, source_tchild);
+}
+
+/**
+ * emeus_constraint_layout_new_from_template:
+ * @template_layout: a #EmeusConstraintLayout
+ *
+ * Creates a new constraint-based layout manager, using the constraints
+ * of @template_layout and of its children.
+ *
+ * The constraints of @template_layout are solved only once, and copied
+ * into the new layout, which is faster than adding the same constraints
+ * to each new layout.
+ *
+ * Children packed into the new layout with the same name as a child of
+ * @template_layout are bound to the constraints of that child, and the
+ * constraints are removed along with them. The constraints of unnamed
+ * children, and the constraints referring to them, are not copied. The
+ * names of the children of @template_layout must be unique.
+ *
+ * Further constraints can be added to the new layout; the constraints
+ * copied from @template_layout can only be removed along with their
+ * children, or by emeus_constraint_layout_clear_constraints().
+ *
+ * Returns: (transfer full) (nullable): the newly created layout widget,
+ *   or %NULL if two children of @template_layout have the same name
+ *
+ * Since: 1.0
+ */
+GtkWidget *
+emeus_constraint_layout_new_from_template (EmeusConstraintLayout *template_layout)
+{
+  EmeusConstraintLayout *res;
+  GSequenceIter *iter;
+  GHashTableIter attr_iter;
+  GHashTable *names, *tchildren;
+  GPtrArray *dropped;
+  gpointer key_p, value_p;
+
+  g_return_val_if_fail (EMEUS_IS_CONSTRAINT_LAYOUT (template_layout), NULL);
+
+  /* The children of the new layout are bound by name */
+  names = g_hash_table_new (g_str_hash, g_str_equal);
+
+  iter = g_sequence_get_begin_iter (template_layout->children);
+  while (!g_sequence_iter_is_end (iter))
+    {
+      EmeusConstraintLayoutChild *child = g_sequence_get (iter);
+
+      iter = g_sequence_iter_next (iter);
+
+      if (child->name == NULL)
+        continue;
+
+      if (!g_hash_table_add (names, child->name))
+        {
+          g_critical ("The template layout %p has more than one child "
+                      "named '%s'",
+                      template_layout,
+                      child->name);
+          g_hash_table_unref (names);
+          return NULL;
+        }
+    }
+
+  g_hash_table_unref (names);
+
+  res = g_object_new (EMEUS_TYPE_CONSTRAINT_LAYOUT, NULL);
+
+  /* Replace the solver created when initializing the layout */
+  g_hash_table_remove_all (res->bound_attributes);
+  simplex_solver_clear (&res->solver);
+  simplex_solver_fork (&template_layout->solver, &res->solver);
+  simplex_solver_set_compact_threshold (&res->solver, COMPACT_THRESHOLD);
+
+  /* The copy is solved once, after its constraints are mapped */
+  simplex_solver_set_auto_solve (&res->solver, false);
+
+  g_hash_table_iter_init (&attr_iter, template_layout->bound_attributes);
+  while (g_hash_table_iter_next (&attr_iter, &key_p, &value_p))
+    g_hash_table_insert (res->bound_attributes,
+                         key_p,
+                         variable_ref (simplex_solver_get_forked_variable (&res->solver, value_p)));
+
+  res->top_constraint = get_forked_constraint (res, template_layout->top_constraint);
+  res->left_constraint = get_forked_constraint (res, template_layout->left_constraint);
+  res->width_constraint = get_forked_constraint (res, template_layout->width_constraint);
+  res->height_constraint = get_forked_constraint (res, template_layout->height_constraint);
+
+  res->template_children = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                                  g_free,
+                                                  template_child_free);
+
+  /* HashTable<EmeusConstraintLayoutChild, TemplateChild>; the named
+   * children of the template, used to map their constraints
+   */
+  tchildren = g_hash_table_new (NULL, NULL);
+
+  /* The forked constraints that no child of the new layout can own */
+  dropped = g_ptr_array_new ();
+
+  iter = g_sequence_get_begin_iter (template_layout->children);
+  while (!g_sequence_iter_is_end (iter))
+    {
+      EmeusConstraintLayoutChild *child = g_sequence_get (iter);
+      TemplateChild *tchild;
+      char *name;
+
+      iter = g_sequence_iter_next (iter);
+
+      if (child->name == NULL)
+        {
+          g_ptr_array_add (dropped, get_forked_constraint (res, child->right_constraint));
+          g_ptr_array_add (dropped, get_forked_constraint (res, child->bottom_constraint));
+          g_ptr_array_add (dropped, get_forked_constraint (res, child->center_x_constraint));
+          g_ptr_array_add (dropped, get_forked_constraint (res, child->center_y_constraint));
+          g_ptr_array_add (dropped, get_forked_constraint (res, child->width_constraint));
+          g_ptr_array_add (dropped, get_forked_constraint (res, child->height_constraint));
+          continue;
+        }
+
+      name = g_strdup (child->name);
+
+      tchild = g_slice_new0 (TemplateChild);
+      tchild->bound_attributes = g_hash_table_new_full (NULL, NULL,
+                                                        NULL,
+                                                        (GDestroyNotify) variable_unref);
+      tchild->constraint_handles = g_array_new (FALSE, FALSE, sizeof (guint));
+      tchild->source_handles = g_array_new (FALSE, FALSE, sizeof (guint));
+
+      g_hash_table_iter_init (&attr_iter, child->bound_attributes);
+      while (g_hash_table_iter_next (&attr_iter, &key_p, &value_p))
+        {
+          Variable *var = simplex_solver_get_forked_variable (&res->solver, value_p);
+
+          /* The name of the template's child may go away before ours */
+          variable_set_prefix (var, name);
+
+          g_hash_table_insert (tchild->bound_attributes, key_p, variable_ref (var));
+        }
+
+      tchild->right_constraint = get_forked_constraint (res, child->right_constraint);
+      tchild->bottom_constraint = get_forked_constraint (res, child->bottom_constraint);
+      tchild->center_x_constraint = get_forked_constraint (res, child->center_x_constraint);
+      tchild->center_y_constraint = get_forked_constraint (res, child->center_y_constraint);
+      tchild->width_constraint = get_forked_constraint (res, child->width_constraint);
+      tchild->height_constraint = get_forked_constraint (res, child->height_constraint);
+
+      g_hash_table_insert (res->template_children, name, tchild);
+      g_hash_table_insert (tchildren, child, tchild);
+    }
+
+  /* The constraints of the template, and of its children, become handles
+   * of the new layout, owned by the children with the same names
+   */
+  g_hash_table_iter_init (&attr_iter, template_layout->constraints);
+  while (g_hash_table_iter_next (&attr_iter, &key_p, NULL))
+    {
+      EmeusConstraint *constraint = key_p;
+
+      copy_template_constraint (res, tchildren,
+                                constraint->constraint, constraint->group,
+                                NULL, get_source_child (constraint),
+                                dropped);
+    }
+
+  iter = g_sequence_get_begin_iter (template_layout->children);
+  while (!g_sequence_iter_is_end (iter))
+    {
+      EmeusConstraintLayoutChild *child = g_sequence_get (iter);
+
+      iter = g_sequence_iter_next (iter);
+
+      g_hash_table_iter_init (&attr_iter, child->constraints);
+      while (g_hash_table_iter_next (&attr_iter, &key_p, NULL))
+        {
+          EmeusConstraint *constraint = key_p;
+          EmeusConstraintLayoutChild *source = get_source_child (constraint);
+
+          copy_template_constraint (res, tchildren,
+                                    constraint->constraint, constraint->group,
+                                    child, source != child ? source : NULL,
+                                    dropped);
+        }
+    }
+
+  g_hash_table_iter_init (&attr_iter, template_layout->constraint_handles);
+  while (g_hash_table_iter_next (&attr_iter, NULL, &value_p))
+    {
+      ConstraintHandle *handle = value_p;
+
+      copy_template_constraint (res, tchildren,
+                                handle->constraint, handle->group,
+                                handle->child, handle->source,
+                                dropped);
+    }
+
+  simplex_solver_remove_constraints (&res->solver,
+                                     (Constraint **) dropped->pdata,
+                                     dropped->len);
+
+  /* The children of the new layout start visible; the constraints of the
+   * hidden ones are disabled again on the next allocation. The dropped
+   * constraints were released, so they are not enabled
+   */
+  if (g_hash_table_size (res->solver.disabled_constraints) > 0)
+    {
+      guint n_disabled;
+      gpointer *disabled =
+        g_hash_table_get_keys_as_array (res->solver.disabled_constraints, &n_disabled);
+
+      simplex_solver_enable_constraints (&res->solver, (Constraint **) disabled, n_disabled);
+      g_free (disabled);
+    }
+
+  /* The template may be frozen, but the new layout is not */
+  simplex_solver_set_auto_solve (&res->solver, true);
+
+  g_ptr_array_unref (dropped);
+  g_hash_table_unref (tchildren);
+
+  if (template_layout->solution_cache != NULL)
+    emeus_constraint_layout_set_use_solution_cache (res, TRUE);
+
+  res->use_shared_solution_cache = template_layout->use_shared_solution_cache;
+
+  return GTK_WIDGET (res);
+}
+
+/* Binds @child to the attributes of the template's child with the same
+ * name, if any
+ */
+static void
+adopt_template_child (EmeusConstraintLayout      *layout,
+                      EmeusConstraintLayoutChild *child)
+{
+  TemplateChild *tchild;
+  GHashTableIter iter;
+  gpointer value_p;
+  guint i;
+
+  if (layout->template_children == NULL || child->name == NULL)
+    return;
+
+  if (g_hash_table_size (child->bound_attributes) != 0)
+    return;
+
+  tchild = g_hash_table_lookup (layout->template_children, child->name);
+  if (tchild == NULL)
+    return;
+
+  g_hash_table_iter_init (&iter, tchild->bound_attributes);
+  while (g_hash_table_iter_next (&iter, NULL, &value_p))
+    variable_set_prefix (value_p, child->name);
+
+  g_hash_table_unref (child->bound_attributes);
+  child->bound_attributes = g_steal_pointer (&tchild->bound_attributes);
+
+  child->right_constraint = tchild->right_constraint;
+  child->bottom_constraint = tchild->bottom_constraint;
+  child->center_x_constraint = tchild->center_x_constraint;
+  child->center_y_constraint = tchild->center_y_constraint;
+  child->width_constraint = tchild->width_constraint;
+  child->height_constraint = tchild->height_constraint;
+
+  /* The copied constraints may have gone with other children already */
+  for (i = 0; i < tchild->constraint_handles->len; i++)
+    {
+      guint id = g_array_index (tchild->constraint_handles, guint, i);
+      ConstraintHandle *handle = g_hash_table_lookup (layout->constraint_handles, GUINT_TO_POINTER (id));
+
+      if (handle == NULL)
+        continue;
+
+      handle->child = child;
+      g_array_append_val (child->constraint_handles, id);
+    }
+
+  for (i = 0; i < tchild->source_handles->len; i++)
+    {
+      guint id = g_array_index (tchild->source_handles, guint, i);
+      ConstraintHandle *handle = g_hash_table_lookup (layout->constraint_handles, GUINT_TO_POINTER (id));
+
+      if (handle == NULL)
+        continue;
+
+      handle->source = child;
+      g_array_append_val (child->source_handles, id);
+    }
+
+  g_hash_table_remove (layout->template_children, child->name);
+}
+
+static void
+add_layout_constraint (EmeusConstraintLayout *layout,
+                       EmeusConstraint       *constraint)
+{
+  Variable *attr1, *attr2;
+  Expression *expr;
+
+  if (!emeus_constraint_attach (constraint, layout, layout))
+    return;
+
+  g_hash_table_add (layout->constraints, g_object_ref_sink (constraint));
+
+  attr1 = get_layout_attribute (layout, constraint->target_attribute);
+  if (constraint->source_attribute == EMEUS_CONSTRAINT_ATTRIBUTE_INVALID)
+    {
+      expr = expression_new_from_constant (emeus_constraint_get_constant (constraint));
+
+      constraint->constraint =
+        simplex_solver_add_constraint (constraint->solver,
+                                       attr1,
+                                       relation_to_operator (constraint->relation),
+                                       expr,
+                                       strength_to_value (constraint->strength));
+
+      return;
+    }
+
+  if (constraint->source_object != NULL)
+    {
+      EmeusConstraintLayoutChild *source_child;
+
+      if (EMEUS_IS_CONSTRAINT_LAYOUT_CHILD (constraint->source_object))
+        source_child = constraint->source_object;
+      else
+        source_child = (EmeusConstraintLayoutChild *) gtk_widget_get_parent (constraint->source_object);
+
+      attr2 = get_child_attribute (source_child, constraint->source_attribute);
+
+      /* The constraint goes away with its source */
+      g_hash_table_add (source_child->source_constraints, constraint);
+    }
+  else
+    {
+      attr2 = get_layout_attribute (layout, constraint->source_attribute);
+    }
+
+  expr =
+    expression_plus (expression_times (expression_new_from_variable (attr2),
+                                       constraint->multiplier),
+                     constraint->constant);
+
+  constraint->constraint =
+    simplex_solver_add_constraint (constraint->solver,
+                                   attr1,
+                                   relation_to_operator (constraint->relation),
+                                   expr,
+                                   strength_to_value (constraint->strength));
+}
+
+static void
+add_child_constraint (EmeusConstraintLayout      *layout,
+                      EmeusConstraintLayoutChild *child,
+                      EmeusConstraint            *constraint)
+{
+  Variable *attr1, *attr2;
+  Expression *expr;
+
+  if (emeus_constraint_is_attached (constraint))
+    {
+      const char *constraint_description = emeus_constraint_to_string (constraint);
+
+      g_critical ("Constraint '%s' cannot be attached to more than "
+                  "one child.",
+                  constraint_description);
+
+      return;
+    }
+
+  if (!emeus_constraint_attach (constraint, layout, child))
+    return;
+
+  g_hash_table_add (child->constraints, g_object_ref_sink (constraint));
+
+  /* attr1 is the LHS of the linear equation */
+  attr1 = get_child_attribute (constraint->target_object,
+                               constraint->target_attribute);
+
+  /* attr2 is the RHS of the linear equation; if it's a constant value
+   * we use a constant expression; if attr1 is not in the tableau yet,
+   * this lets the solver substitute a required constraint with a bound
+   * on attr1 instead of adding a row for it.
+   */
+  if (constraint->source_attribute == EMEUS_CONSTRAINT_ATTRIBUTE_INVALID)
+    {
+      expr = expression_new_from_constant (emeus_constraint_get_constant (constraint));
+
+      constraint->constraint =
+        simplex_solver_add_constraint (constraint->solver,
+                                       attr1,
+                                       relation_to_operator (constraint->relation),
+                                       expr,
+                                       strength_to_value (constraint->strength));
+
+      return;
+    }
+
+  /* Alternatively, if it's not a constant value, we find the variable
+   * associated with it
+   */
+  if (constraint->source_object != NULL)
+    {
+      EmeusConstraintLayoutChild *source_child;
+
+      if (EMEUS_IS_CONSTRAINT_LAYOUT_CHILD (constraint->source_object))
+        source_child = constraint->source_object;
+      else
+        source_child = (EmeusConstraintLayoutChild *) gtk_widget_get_parent (constraint->source_object);
+
+      attr2 = get_child_attribute (source_child, constraint->source_attribute);
+
+      /* The constraint goes away with its source, as well as with its
+       * target
+       */
+      if (source_child != child)
+        g_hash_table_add (source_child->source_constraints, constraint);
+    }
+  else
+    {
+      attr2 = get_layout_attribute (layout, constraint->source_attribute);
+    }
+
+  /* Turn attr2 into an expression in the form:
+   *
+   *   expr = attr2 * multiplier + constant
+   */
+  expr =
+    expression_plus (expression_times (expression_new_from_variable (attr2),
+                                       constraint->multiplier),
+                     constraint->constant);
+
+  constraint->constraint =
+    simplex_solver_add_constraint (constraint->solver,
+                                   attr1,
+                                   relation_to_operator (constraint->relation),
+                                   expr,
+                                   strength_to_value (constraint->strength));
+}
+
+static gboolean
+remove_child_constraint (EmeusConstraintLayout      *layout,
+                         EmeusConstraintLayoutChild *child,
+                         EmeusConstraint            *constraint)
+{
+  if (constraint->target_object != child)
+    {
+      g_critical ("Attempting to remove unknown constraint %p", constraint);
+      return FALSE;
+    }
+
+  untrack_source_constraint (constraint);
+  emeus_constraint_detach (constraint);
+
+  g_hash_table_remove (child->constraints, constraint);
+
+  return TRUE;
+}
+
+SimplexSolver *
+emeus_constraint_layout_get_solver (EmeusConstraintLayout *layout)
+{
+  return &layout->solver;
+}
+
+gboolean
+emeus_constraint_layout_has_child_data (EmeusConstraintLayout *layout,
+                                        GtkWidget             *widget)
+{
+  GSequenceIter *iter;
+
+  if (gtk_widget_get_parent (widget) == GTK_WIDGET (layout))
+    return TRUE;
+
+  iter = g_sequence_get_begin_iter (layout->children);
+  while (!g_sequence_iter_is_end (iter))
+    {
+      GtkWidget *child = g_sequence_get (iter);
+
+      iter = g_sequence_iter_next (iter);
+
+      if (gtk_widget_get_parent (widget) == child)
+        return TRUE;
+    }
+
+  return FALSE;
+}
+
+static void
+layout_add_constraint (EmeusConstraintLayout *layout,
+                       EmeusConstraint       *constraint)
+{
+  EmeusConstraintLayoutChild *child;
+  GtkWidget *target, *parent;
+
+  if (emeus_constraint_is_attached (constraint))
+    {
+      g_critical ("Constraint '%s' is already attached.",
+                  emeus_constraint_to_string (constraint));
+      return;
+    }
+
+  target = emeus_constraint_get_target_object (constraint);
+  if (target == NULL)
+    {
+      add_layout_constraint (layout, constraint);
+      return;
+    }
+
+  parent = gtk_widget_get_parent (target);
+  if (parent == NULL)
+    {
+      g_critical ("The target widget '%s' does not have any parent set",
+                  G_OBJECT_TYPE_NAME (target));
+      return;
+    }
+
+  if (!EMEUS_IS_CONSTRAINT_LAYOUT_CHILD (target) &&
+      !EMEUS_IS_CONSTRAINT_LAYOUT_CHILD (parent))
+    {
+      g_critical ("The target widget '%s' is not a direct descendant of "
+                  "the constraint layout",
+                  G_OBJECT_TYPE_NAME (target));
+      return;
+    }
+
+  if (EMEUS_IS_CONSTRAINT_LAYOUT_CHILD (target))
+    child = EMEUS_CONSTRAINT_LAYOUT_CHILD (target);
+  else
+    child = EMEUS_CONSTRAINT_LAYOUT_CHILD (parent);
+
+  add_child_constraint (layout, child, constraint);
+}
+
+void
+emeus_constraint_layout_add_constraint (EmeusConstraintLayout *layout,
+                                        EmeusConstraint       *constraint)
+{
+  g_return_if_fail (EMEUS_IS_CONSTRAINT_LAYOUT (layout));
+  g_return_if_fail (EMEUS_IS_CONSTRAINT (constraint));
+
+  layout_add_constraint (layout, constraint);
+}
+
+void
+emeus_constraint_layout_add_constraints (EmeusConstraintLayout *layout,
+                                         EmeusConstraint       *first_constraint,
+                                         ...)
+{
+  EmeusConstraint *constraint;
+  va_list args;
+
+  g_return_if_fail (EMEUS_IS_CONSTRAINT_LAYOUT (layout));
+
+  va_start (args, first_constraint);
+
+  constraint = first_constraint;
+  while (constraint != NULL)
+    {
+      layout_add_constraint (layout, constraint);
+
+      constraint = va_arg (args, EmeusConstraint *);
+    }
+
+  va_end (args);
+}
+
+/* Finds the child of @layout for @object, which can either be a
+ * #EmeusConstraintLayoutChild or the widget inside it
+ */
+static EmeusConstraintLayoutChild *
+get_layout_child (EmeusConstraintLayout *layout,
+                  gpointer               object)
+{
+  GtkWidget *widget;
+
+  if (!GTK_IS_WIDGET (object))
+    return NULL;
+
+  widget = object;
+  if (!EMEUS_IS_CONSTRAINT_LAYOUT_CHILD (widget))
+    widget = gtk_widget_get_parent (widget);
+
+  if (widget == NULL ||
+      !EMEUS_IS_CONSTRAINT_LAYOUT_CHILD (widget) ||
+      gtk_widget_get_parent (widget) != GTK_WIDGET (layout))
+    return NULL;
+
+  return EMEUS_CONSTRAINT_LAYOUT_CHILD (widget);
+}
+
+static guint
+add_constraint_descriptor (EmeusConstraintLayout           *layout,
+                           const EmeusConstraintDescriptor *descriptor)
+{
+  EmeusConstraintLayoutChild *target = NULL, *source = NULL;
+  ConstraintHandle *handle;
+  Variable *attr1, *attr2;
+  Expression *expr;
+
+  if (descriptor->target_attribute <= EMEUS_CONSTRAINT_ATTRIBUTE_INVALID ||
+      descriptor->target_attribute > EMEUS_CONSTRAINT_ATTRIBUTE_BASELINE ||
+      descriptor->source_attribute < EMEUS_CONSTRAINT_ATTRIBUTE_INVALID ||
+      descriptor->source_attribute > EMEUS_CONSTRAINT_ATTRIBUTE_BASELINE ||
+      descriptor->relation < EMEUS_CONSTRAINT_RELATION_LE ||
+      descriptor->relation > EMEUS_CONSTRAINT_RELATION_GE ||
+      descriptor->strength < EMEUS_CONSTRAINT_STRENGTH_WEAK ||
+      descriptor->strength > EMEUS_CONSTRAINT_STRENGTH_REQUIRED)
+    {
+      g_critical ("Invalid constraint descriptor %p", descriptor);
+      return 0;
+    }
+
+  if (descriptor->target_object != NULL)
+    {
+      target = get_layout_child (layout, descriptor->target_object);
+      if (target == NULL)
+        {
+          g_critical ("The target widget %p is not a direct descendant of "
+                      "the constraint layout",
+                      descriptor->target_object);
+          return 0;
+        }
+    }
+
+  if (descriptor->source_attribute != EMEUS_CONSTRAINT_ATTRIBUTE_INVALID &&
+      descriptor->source_object != NULL)
+    {
+      source = get_layout_child (layout, descriptor->source_object);
+      if (source == NULL)
+        {
+          g_critical ("The source widget %p is not a direct descendant of "
+                      "the constraint layout",
+                      descriptor->source_object);
+          return 0;
+        }
+    }
+
+  if (target != NULL)
+    attr1 = get_child_attribute (target, descriptor->target_attribute);
+  else
+    attr1 = get_layout_attribute (layout, descriptor->target_attribute);
+
+  if (descriptor->source_attribute == EMEUS_CONSTRAINT_ATTRIBUTE_INVALID)
+    {
+      expr = expression_new_from_constant (descriptor->constant);
+    }
+  else
+    {
+      if (source != NULL)
+        attr2 = get_child_attribute (source, descriptor->source_attribute);
+      else
+        attr2 = get_layout_attribute (layout, descriptor->source_attribute);
+
+      expr =
+        expression_plus (expression_times (expression_new_from_variable (attr2),
+                                           descriptor->multiplier),
+                         descriptor->constant);
+    }
+
+  handle = g_slice_new (ConstraintHandle);
+  handle->child = target;
+  handle->source = source != target ? source : NULL;
+  handle->group = NULL;
+  handle->constraint =
+    simplex_solver_add_constraint (&layout->solver,
+                                   attr1,
+                                   relation_to_operator (descriptor->relation),
+                                   expr,
+                                   strength_to_value (descriptor->strength));
+
+  layout->last_constraint_handle += 1;
+
+  g_hash_table_insert (layout->constraint_handles,
+                       GUINT_TO_POINTER (layout->last_constraint_handle),
+                       handle);
+
+  if (target != NULL)
+    g_array_append_val (target->constraint_handles, layout->last_constraint_handle);
+
+  /* The constraint goes away with its source, as well as with its target */
+  if (handle->source != NULL)
+    g_array_append_val (handle->source->source_handles, layout->last_constraint_handle);
+
+  return layout->last_constraint_handle;
+}
+
+/**
+ * emeus_constraint_layout_add_constraint_descriptors:
+ * @layout: a #EmeusConstraintLayout
+ * @descriptors: (array length=n_descriptors): the constraints to add
+ * @n_descriptors: the number of constraints in @descriptors
+ * @handles: (out caller-allocates) (array length=n_descriptors) (optional):
+ *   return location for an array of @n_descriptors handles, or %NULL
+ *
+ * Adds the constraints described by @descriptors to the @layout at once,
+ * without creating a #EmeusConstraint instance for each one.
+ *
+ * The target and source objects of each descriptor must be children of
+ * the @layout, or %NULL for the @layout itself; the constraint is owned
+ * by its target, and it is removed along with it.
+ *
+ * Each constraint is identified by a handle, which can be passed to
+ * emeus_constraint_layout_remove_constraint_handles(); the handle is 0
+ * if the corresponding descriptor is not valid.
+ *
+ * The constraints are solved once, after all of them have been added.
+ *
+ * Since: 1.0
+ */
+void
+emeus_constraint_layout_add_constraint_descriptors (EmeusConstraintLayout           *layout,
+                                                    const EmeusConstraintDescriptor *descriptors,
+                                                    guint                            n_descriptors,
+                                                    guint                           *handles)
+{
+  guint i;
+
+  g_return_if_fail (EMEUS_IS_CONSTRAINT_LAYOUT (layout));
+  g_return_if_fail (descriptors != NULL || n_descriptors == 0);
+
+  if (n_descriptors == 0)
+    return;
+
+  emeus_constraint_layout_freeze (layout);
+
+  for (i = 0; i < n_descriptors; i++)
+    {
+      guint handle = add_constraint_descriptor (layout, &descriptors[i]);
+
+      if (handles != NULL)
+        handles[i] = handle;
+    }
+
+  layout->resize_pending = TRUE;
+
+  emeus_constraint_layout_thaw (layout);
+}
+
+/* The number of values describing each constraint, in the data passed
+ * to emeus_constraint_layout_add_constraint_data()
+ */
+#define CONSTRAINT_DATA_SIZE    8
+
+/**
+ * emeus_constraint_layout_add_constraint_data: (rename-to emeus_constraint_layout_add_constraint_descriptors)
+ * @layout: a #EmeusConstraintLayout
+ * @objects: (array length=n_objects) (nullable): the widgets used by
+ *   the constraints
+ * @n_objects: the number of widgets in @objects
+ * @data: (array length=n_data): the constraints to add
+ * @n_data: the number of values in @data
+ * @n_handles: (out) (optional): return location for the number of handles
+ *
+ * Adds constraints to the @layout at once, like
+ * emeus_constraint_layout_add_constraint_descriptors().
+ *
+ * This function is meant for language bindings, which can describe all
+ * the constraints using two plain arrays.
+ *
+ * Each constraint is described by 8 values in @data: the index of the
+ * target widget in @objects, or -1 for the @layout; the target attribute;
+ * the relation; the index of the source widget in @objects, or -1 for the
+ * @layout; the source attribute; the multiplier; the constant; and the
+ * strength.
+ *
+ * Returns: (array length=n_handles) (transfer full): the handles of the
+ *   constraints; use g_free() to free the returned array
+ *
+ * Since: 1.0
+ */
+guint *
+emeus_constraint_layout_add_constraint_data (EmeusConstraintLayout  *layout,
+                                             GtkWidget             **objects,
+                                             guint                   n_objects,
+                                             const double           *data,
+                                             guint                   n_data,
+                                             guint                  *n_handles)
+{
+  EmeusConstraintDescriptor *descriptors;
+  guint i, n_descriptors;
+  guint *res;
+
+  g_return_val_if_fail (EMEUS_IS_CONSTRAINT_LAYOUT (layout), NULL);
+  g_return_val_if_fail (objects != NULL || n_objects == 0, NULL);
+  g_return_val_if_fail (data != NULL || n_data == 0, NULL);
+  g_return_val_if_fail (n_data % CONSTRAINT_DATA_SIZE == 0, NULL);
+
+  n_descriptors = n_data / CONSTRAINT_DATA_SIZE;
+  descriptors = g_new (EmeusConstraintDescriptor, n_descriptors);
+
+  for (i = 0; i < n_descriptors; i++)
+    {
+      const double *values = data + i * CONSTRAINT_DATA_SIZE;
+      EmeusConstraintDescriptor *descriptor = &descriptors[i];
+      int target = values[0], source = values[3];
+
+      if (target < -1 || target >= (int) n_objects ||
+          source < -1 || source >= (int) n_objects)
+        {
+          g_critical ("Invalid widget index in the constraint data at %u", i);
+
+          /* Invalid descriptors are skipped, and get a 0 handle */
+          descriptor->target_attribute = EMEUS_CONSTRAINT_ATTRIBUTE_INVALID;
+          continue;
+        }
+
+      descriptor->target_object = target >= 0 ? objects[target] : NULL;
+      descriptor->target_attribute = values[1];
+      descriptor->relation = values[2];
+      descriptor->source_object = source >= 0 ? objects[source] : NULL;
+      descriptor->source_attribute = values[4];
+      descriptor->multiplier = values[5];
+      descriptor->constant = values[6];
+      descriptor->strength = values[7];
+    }
+
+  res = g_new0 (guint, MAX (n_descriptors, 1));
+
+  emeus_constraint_layout_add_constraint_descriptors (layout, descriptors, n_descriptors, res);
+
+  g_free (descriptors);
+
+  if (n_handles != NULL)
+    *n_handles = n_descriptors;
+
+  return res;
+}
+
+/**
+ * emeus_constraint_layout_add_constraints_from_description:
+ * @layout: a #EmeusConstraintLayout
+ * @description: the description of the constraints
+ * @length: the length of @description, or -1 if it is nul-terminated
+ * @hspacing: the default horizontal spacing
+ * @vspacing: the default vertical spacing
+ * @n_handles: (out) (optional): return location for the number of handles
+ * @error: return location for a #GError, or %NULL
+ *
+ * Adds the constraints described by @description to the @layout, using
+ * the visual format language, e.g.:
+ *
+ * |[<!-- language="plain" -->
+ *   H:|-8-[view1(==view2)]-12-[view2]-8-|
+ *   H:|-8-[view3]-8-|
+ *   V:|-8-[view1,view2]-12-[view3(==view1,view2)]-8-|
+ * ]|
+ *
+ * Each line of @description describes the constraints along the
+ * horizontal (`H:`, the default) or vertical (`V:`) orientation. The
+ * views are the children of the @layout, identified by the name passed
+ * to emeus_constraint_layout_pack(); `|` is the @layout itself. A `-`
+ * connection uses @hspacing or @vspacing, and views without a
+ * connection are adjacent. The views in the same brackets are laid out
+ * in parallel.
+ *
+ * Spacings and view sizes can use predicates, like `-(>=8@strong)-` or
+ * `[view1(>=100,<=view2)]`; the relation defaults to `==`, and the
+ * strength to `required`.
+ *
+ * All the constraints are added at once, like
+ * emeus_constraint_layout_add_constraint_descriptors(); if @description
+ * is not valid, none of them is added.
+ *
+ * Returns: (array length=n_handles) (transfer full) (nullable): the
+ *   handles of the constraints, or %NULL on error; use g_free() to free
+ *   the returned array
+ *
+ * Since: 1.0
+ */
+guint *
+emeus_constraint_layout_add_constraints_from_description (EmeusConstraintLayout  *layout,
+                                                          const char             *description,
+                                                          gssize                  length,
+                                                          int                     hspacing,
+                                                          int                     vspacing,
+                                                          guint                  *n_handles,
+                                                          GError                **error)
+{
+  GHashTable *views;
+  GSequenceIter *iter;
+  GArray *descriptors;
+  guint *res = NULL;
+
+  g_return_val_if_fail (EMEUS_IS_CONSTRAINT_LAYOUT (layout), NULL);
+  g_return_val_if_fail (description != NULL, NULL);
+  g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+  /* Index the children by name once, instead of looking up each name */
+  views = g_hash_table_new (g_str_hash, g_str_equal);
+
+  iter = g_sequence_get_begin_iter (layout->children);
+  while (!g_sequence_iter_is_end (iter))
+    {
+      EmeusConstraintLayoutChild *child = g_sequence_get (iter);
+      const char *name = emeus_constraint_layout_child_get_name (child);
+
+      iter = g_sequence_iter_next (iter);
+
+      if (name != NULL && !g_hash_table_contains (views, name))
+        g_hash_table_insert (views, (gpointer) name, child);
+    }
+
+  descriptors = g_array_new (FALSE, FALSE, sizeof (EmeusConstraintDescriptor));
+
+  if (vfl_parser_parse (description, length, hspacing, vspacing, views, descriptors, error))
+    {
+      res = g_new0 (guint, MAX (descriptors->len, 1));
+
+      emeus_constraint_layout_add_constraint_descriptors (layout,
+                                                          (EmeusConstraintDescriptor *) descriptors->data,
+                                                          descriptors->len,
+                                                          res);
+
+      if (n_handles != NULL)
+        *n_handles = descriptors->len;
+    }
+  else if (n_handles != NULL)
+    *n_handles = 0;
+
+  g_array_unref (descriptors);
+  g_hash_table_unref (views);
+
+  return res;
+}
+
+/**
+ * emeus_constraint_layout_remove_constraint_handles:
+ * @layout: a #EmeusConstraintLayout
+ * @handles: (array length=n_handles): the handles of the constraints
+ * @n_handles: the number of handles in @handles
+ *
+ * Removes the constraints added using emeus_constraint_layout_add_constraint_descriptors()
+ * from the @layout.
+ *
+ * The constraints are removed from the solver in a single batch.
+ *
+ * Handles equal to 0 are ignored.
+ *
+ * Since: 1.0
+ */
+void
+emeus_constraint_layout_remove_constraint_handles (EmeusConstraintLayout *layout,
+                                                   const guint           *handles,
+                                                   guint                  n_handles)
+{
+  GPtrArray *batch;
+  guint i;
+
+  g_return_if_fail (EMEUS_IS_CONSTRAINT_LAYOUT (layout));
+  g_return_if_fail (handles != NULL || n_handles == 0);
+
+  if (n_handles == 0)
+    return;
+
+  emeus_constraint_layout_freeze (layout);
+
+  batch = g_ptr_array_sized_new (n_handles);
+
+  for (i = 0; i < n_handles; i++)
+    {
+      ConstraintHandle *handle;
+      gpointer key;
+
+      if (handles[i] == 0)
+        continue;
+
+      key = GUINT_TO_POINTER (handles[i]);
+      handle = g_hash_table_lookup (layout->constraint_handles, key);
+      if (handle == NULL)
+        {
+          g_critical ("Attempting to remove unknown constraint handle %u", handles[i]);
+          continue;
+        }
+
+      if (handle->constraint != NULL)
+        g_ptr_array_add (batch, handle->constraint);
+
+      if (handle->child != NULL)
+        constraint_handles_remove (handle->child->constraint_handles, handles[i]);
+
+      if (handle->source != NULL)
+        constraint_handles_remove (handle->source->source_handles, handles[i]);
+
+      g_hash_table_remove (layout->constraint_handles, key);
+    }
+
+  /* The solver is optimized once for the whole batch */
+  simplex_solver_remove_constraints (&layout->solver,
+                                     (Constraint **) batch->pdata,
+                                     batch->len);
+  g_ptr_array_unref (batch);
+
+  layout->resize_pending = TRUE;
+
+  emeus_constraint_layout_thaw (layout);
+}
+
+static void
+detach_constraints (GHashTable *constraints)
+{
+  GHashTableIter iter;
+  gpointer key_p;
+
+  g_hash_table_iter_init (&iter, constraints);
+  while (g_hash_table_iter_next (&iter, &key_p, NULL))
+    {
+      EmeusConstraint *constraint = key_p;
+
+      /* The solver drops all of its constraints at once */
+      constraint->constraint = NULL;
+
+      emeus_constraint_detach (constraint);
+    }
+
+  g_hash_table_remove_all (constraints);
+}
+
+/**
+ * emeus_constraint_layout_clear_constraints:
+ * @layout: a #EmeusConstraintLayout
+ *
+ * Removes all the constraints of the @layout, and of its children.
+ *
+ * The memory used to solve the constraints is kept around, which makes
+ * adding a new set of constraints cheaper; this is useful when recycling
+ * a @layout, for instance in a list.
+ *
+ * Since: 1.0
+ */
+void
+emeus_constraint_layout_clear_constraints (EmeusConstraintLayout *layout)
+{
+  GSequenceIter *iter;
+
+  g_return_if_fail (EMEUS_IS_CONSTRAINT_LAYOUT (layout));
+
+  detach_constraints (layout->constraints);
+  g_hash_table_remove_all (layout->bound_attributes);
+  g_hash_table_remove_all (layout->constraint_handles);
+
+  iter = g_sequence_get_begin_iter (layout->children);
+  while (!g_sequence_iter_is_end (iter))
+    {
+      EmeusConstraintLayoutChild *child = g_sequence_get (iter);
+
+      iter = g_sequence_iter_next (iter);
+
+      detach_constraints (child->constraints);
+      g_hash_table_remove_all (child->bound_attributes);
+      g_hash_table_remove_all (child->source_constraints);
+      g_array_set_size (child->constraint_handles, 0);
+      g_array_set_size (child->source_handles, 0);
+
+      child->is_hidden = FALSE;
+      child->right_constraint = NULL;
+      child->bottom_constraint = NULL;
+      child->center_x_constraint = NULL;
+      child->center_y_constraint = NULL;
+      child->width_constraint = NULL;
+      child->height_constraint = NULL;
+      child->intrinsic_width = -1;
+      child->intrinsic_height = -1;
+    }
+
+  clear_solution_cache (layout);
+
+  /* The attributes of the template are gone with the solver's state */
+  g_clear_pointer (&layout->template_children, g_hash_table_unref);
+
+  simplex_solver_reset (&layout->solver);
+  add_layout_stays (layout);
+
+  if (layout->freeze_count > 0)
+    layout->resize_pending = TRUE;
+  else
+    gtk_widget_queue_resize (GTK_WIDGET (layout));
+}
+
+/**
+ * emeus_constraint_layout_pack:
+ * @layout: a #EmeusConstraintLayout
+ * @child: a #GtkWidget
+ * @name: (nullable): an optional name for the @child
+ * @first_constraint: (nullable): a #EmeusConstraint
+ * @...: a %NULL-terminated list of #EmeusConstraint instances
+ *
+ * Adds @child to the @layout, and applies a list of constraints to it.
+ *
+ * This convenience function is the equivalent of calling
+ * gtk_container_add() and emeus_constraint_layout_child_add_constraint()
+ * for each constraint instance.
+ *
+ * Since: 1.0
+ */
+void
+emeus_constraint_layout_pack (EmeusConstraintLayout *layout,
+                              GtkWidget             *child,
+                              const char            *name,
+                              EmeusConstraint       *first_constraint,
+                              ...)
+{
+  EmeusConstraintLayoutChild *layout_child;
+  EmeusConstraint *constraint;
+  va_list args;
+
+  g_return_if_fail (EMEUS_IS_CONSTRAINT_LAYOUT (layout));
+  g_return_if_fail (GTK_IS_WIDGET (child));
+  g_return_if_fail (EMEUS_IS_CONSTRAINT (first_constraint) || first_constraint == NULL);
+
+  g_return_if_fail (gtk_widget_get_parent (child) == NULL);
+
+  if (EMEUS_IS_CONSTRAINT_LAYOUT_CHILD (child))
+    layout_child = EMEUS_CONSTRAINT_LAYOUT_CHILD (child);
+  else
+    {
+      layout_child = (EmeusConstraintLayoutChild *) emeus_constraint_layout_child_new (name);
+
+      gtk_widget_show (GTK_WIDGET (layout_child));
+      gtk_container_add (GTK_CONTAINER (layout_child), child);
+    }
+
+  layout_child->iter = g_sequence_append (layout->children, layout_child);
+  layout_child->solver = &layout->solver;
+
+  adopt_template_child (layout, layout_child);
+
+  gtk_widget_set_parent (GTK_WIDGET (layout_child), GTK_WIDGET (layout));
+
+  if (first_constraint == NULL)
+    return;
+
+  va_start (args, first_constraint);
+
+  constraint = first_constraint;
+  while (constraint != NULL)
+    {
+      add_child_constraint (layout, layout_child, constraint);
+
+      constraint = va_arg (args, EmeusConstraint *);
+    }
+
+  va_end (args);
+}
+
+/**
+ * emeus_constraint_layout_set_use_solution_cache:
+ * @layout: a #EmeusConstraintLayout
+ * @use_cache: whether to cache the solutions of the layout
+ *
+ * Sets whether the @layout should cache the solutions of its constraints
+ * when allocating its size.
+ *
+ * Each solution is a linear function of the width and height of the
+ * @layout, valid for a range of sizes; while the size of the @layout
+ * remains within the range of a cached solution, for instance during an
+ * interactive resize, the position and size of each child are computed
+ * without solving the constraints again.
+ *
+ * The cache assumes that the layout only depends on its size; stay
+ * constraints that hold the values of a previous solution are not
+ * taken into account.
+ *
+ * The cache is cleared every time the constraints change.
+ *
+ * Since: 1.0
+ */
+void
+emeus_constraint_layout_set_use_solution_cache (EmeusConstraintLayout *layout,
+                                                gboolean               use_cache)
+{
+  g_return_if_fail (EMEUS_IS_CONSTRAINT_LAYOUT (layout));
+
+  use_cache = !!use_cache;
+
+  if (use_cache == (layout->solution_cache != NULL))
+    return;
+
+  if (use_cache)
+    layout->solution_cache =
+      g_ptr_array_new_with_free_func ((GDestroyNotify) parametric_solution_free);
+  else
+    g_clear_pointer (&layout->solution_cache, g_ptr_array_unref);
+}
+
+/**
+ * emeus_constraint_layout_set_use_shared_solution_cache:
+ * @layout: a #EmeusConstraintLayout
+ * @use_cache: whether to share the solutions of the layout
+ *
+ * Sets whether the @layout should share the solutions of its constraints
+ * with other layouts.
+ *
+ * Layouts with the same constraints, the same number of children, and
+ * the same intrinsic sizes for each child produce the same solution when
+ * allocated at the same size; layouts using the shared cache position
+ * their children using the solution computed by any of them, without
+ * solving their constraints.
+ *
+ * Children are matched using the order in which they were added to the
+ * layouts. Like emeus_constraint_layout_set_use_solution_cache(), the
+ * shared cache assumes that the layout only depends on its size.
+ *
+ * Since: 1.0
+ */
+void
+emeus_constraint_layout_set_use_shared_solution_cache (EmeusConstraintLayout *layout,
+                                                       gboolean               use_cache)
+{
+  g_return_if_fail (EMEUS_IS_CONSTRAINT_LAYOUT (layout));
+
+  layout->use_shared_solution_cache = !!use_cache;
+}
+
+/**
+ * emeus_constraint_layout_get_use_shared_solution_cache:
+ * @layout: a #EmeusConstraintLayout
+ *
+ * Retrieves whether the @layout shares the solutions of its constraints
+ * with other layouts.
+ *
+ * Returns: %TRUE if the shared solution cache is in use
+ *
+ * Since: 1.0
+ */
+gboolean
+emeus_constraint_layout_get_use_shared_solution_cache (EmeusConstraintLayout *layout)
+{
+  g_return_val_if_fail (EMEUS_IS_CONSTRAINT_LAYOUT (layout), FALSE);
+
+  return layout->use_shared_solution_cache;
+}
+
+/**
+ * emeus_constraint_layout_get_use_solution_cache:
+ * @layout: a #EmeusConstraintLayout
+ *
+ * Retrieves whether the @layout caches the solutions of its constraints.
+ *
+ * Returns: %TRUE if the solution cache is in use
+ *
+ * Since: 1.0
+ */
+gboolean
+emeus_constraint_layout_get_use_solution_cache (EmeusConstraintLayout *layout)
+{
+  g_return_val_if_fail (EMEUS_IS_CONSTRAINT_LAYOUT (layout), FALSE);
+
+  return layout->solution_cache != NULL;
+}
+
+/**
+ * emeus_constraint_layout_set_async_solve:
+ * @layout: a #EmeusConstraintLayout
+ * @async_solve: whether to solve the constraints in a separate thread
+ *
+ * Sets whether the @layout should solve its constraints in a separate
+ * thread.
+ *
+ * Solving a large number of constraints after they changed may take
+ * longer than a frame. If @async_solve is %TRUE, adding or removing
+ * constraints, and changing the visibility of children, does not solve
+ * the constraints right away; they are solved on a copy of the solver
+ * in a separate thread, and the @layout keeps allocating its children
+ * using the last solution until the new one is applied, on a following
+ * frame. Resizing the @layout is still done in the main thread, as it
+ * is typically much cheaper.
+ *
+ * The copy of the solver is made in the main thread, and it takes time
+ * proportional to the number of constraints of the @layout, so solving
+ * in a separate thread only pays off when solving the changes costs
+ * more than copying the constraints.
+ *
+ * While the @layout is waiting for a solution, functions like
+ * emeus_constraint_layout_child_get_width() return the values of the
+ * last solution.
+ *
+ * If @async_solve is %FALSE, any pending constraint is solved right away.
+ *
+ * Since: 1.0
+ */
+void
+emeus_constraint_layout_set_async_solve (EmeusConstraintLayout *layout,
+                                         gboolean               async_solve)
+{
+  g_return_if_fail (EMEUS_IS_CONSTRAINT_LAYOUT (layout));
+
+  async_solve = !!async_solve;
+
+  if (layout->async_solve == async_solve)
+    return;
+
+  layout->async_solve = async_solve;
+
+  /* A solve that is still running is dropped once it is done */
+  g_clear_pointer (&layout->async_result, async_solve_free);
+
+  if (layout->freeze_count > 0)
+    layout->resize_pending = TRUE;
+  else
+    {
+      simplex_solver_set_auto_solve (&layout->solver,
+                                     !layout->async_solve && layout->solve_budget == 0);
+      gtk_widget_queue_resize (GTK_WIDGET (layout));
+    }
+}
+
+/**
+ * emeus_constraint_layout_get_async_solve:
+ * @layout: a #EmeusConstraintLayout
+ *
+ * Retrieves whether the @layout solves its constraints in a separate
+ * thread.
+ *
+ * Returns: %TRUE if the constraints are solved in a separate thread
+ *
+ * Since: 1.0
+ */
+gboolean
+emeus_constraint_layout_get_async_solve (EmeusConstraintLayout *layout)
+{
+  g_return_val_if_fail (EMEUS_IS_CONSTRAINT_LAYOUT (layout), FALSE);
+
+  return layout->async_solve;
+}
+
+/**
+ * emeus_constraint_layout_set_solve_budget:
+ * @layout: a #EmeusConstraintLayout
+ * @budget: the time to spend solving the constraints on each frame, in
+ *   microseconds, or 0 for no limit
+ *
+ * Sets the maximum time the @layout spends solving its constraints each
+ * time it is allocated.
+ *
+ * If the constraints cannot be solved within @budget, the @layout
+ * allocates its children using values that satisfy all the required
+ * constraints, even if they do not satisfy the other ones as well as
+ * possible yet, and resumes solving the constraints on the next frame.
+ *
+ * If @budget is 0, the constraints are always solved completely.
+ *
+ * Since: 1.0
+ */
+void
+emeus_constraint_layout_set_solve_budget (EmeusConstraintLayout *layout,
+                                          gint64                 budget)
+{
+  g_return_if_fail (EMEUS_IS_CONSTRAINT_LAYOUT (layout));
+  g_return_if_fail (budget >= 0);
 
-  constraint->constraint =
-    simplex_solver_add_constraint (constraint->solver,
-                                   attr1,
-                                   relation_to_operator (constraint->relation),
-                                   expr,
-                                   strength_to_value (constraint->strength));
-}
+  if (layout->solve_budget == budget)
+    return;
 
-static gboolean
-remove_child_constraint (EmeusConstraintLayout      *layout,
-                         EmeusConstraintLayoutChild *child,
-                         EmeusConstraint            *constraint)
-{
-  if (constraint->target_object != child)
+  layout->solve_budget = budget;
+
+  if (layout->freeze_count > 0)
+    layout->resize_pending = TRUE;
+  else
     {
-      g_critical ("Attempting to remove unknown constraint %p", constraint);
-      return FALSE;
+      /* Going back to an unlimited budget finishes the pending work */
+      simplex_solver_set_auto_solve (&layout->solver,
+                                     !layout->async_solve && layout->solve_budget == 0);
+      gtk_widget_queue_resize (GTK_WIDGET (layout));
     }
+}
 
-  emeus_constraint_detach (constraint);
-
-  g_hash_table_remove (child->constraints, constraint);
+/**
+ * emeus_constraint_layout_get_solve_budget:
+ * @layout: a #EmeusConstraintLayout
+ *
+ * Retrieves the time the @layout spends solving its constraints on
+ * each frame, set using emeus_constraint_layout_set_solve_budget().
+ *
+ * Returns: the budget, in microseconds, or 0 for no limit
+ *
+ * Since: 1.0
+ */
+gint64
+emeus_constraint_layout_get_solve_budget (EmeusConstraintLayout *layout)
+{
+  g_return_val_if_fail (EMEUS_IS_CONSTRAINT_LAYOUT (layout), 0);
 
-  return TRUE;
+  return layout->solve_budget;
 }
 
-SimplexSolver *
-emeus_constraint_layout_get_solver (EmeusConstraintLayout *layout)
+/**
+ * emeus_constraint_layout_freeze:
+ * @layout: a #EmeusConstraintLayout
+ *
+ * Freezes the @layout, deferring the work needed to solve its
+ * constraints, and the resize requests of the @layout and its children,
+ * until emeus_constraint_layout_thaw() is called.
+ *
+ * Freezing the @layout is useful when adding or removing many children
+ * or constraints at once, for instance when building the @layout, as the
+ * constraints are solved only once.
+ *
+ * While the @layout is frozen, the values returned by functions like
+ * emeus_constraint_layout_child_get_width() may not take into account
+ * the constraints added or removed since the @layout was frozen.
+ *
+ * Calls to this function can be nested; each call must be matched by a
+ * call to emeus_constraint_layout_thaw().
+ *
+ * Since: 1.0
+ */
+void
+emeus_constraint_layout_freeze (EmeusConstraintLayout *layout)
 {
-  return &layout->solver;
+  g_return_if_fail (EMEUS_IS_CONSTRAINT_LAYOUT (layout));
+
+  if (layout->freeze_count++ == 0)
+    simplex_solver_set_auto_solve (&layout->solver, false);
 }
 
-gboolean
-emeus_constraint_layout_has_child_data (EmeusConstraintLayout *layout,
-                                        GtkWidget             *widget)
+/**
+ * emeus_constraint_layout_thaw:
+ * @layout: a #EmeusConstraintLayout
+ *
+ * Reverts the effect of a previous call to emeus_constraint_layout_freeze().
+ *
+ * Once the @layout is thawed, its constraints are solved and, if any
+ * resize was requested while the @layout was frozen, a single resize is
+ * queued.
+ *
+ * Since: 1.0
+ */
+void
+emeus_constraint_layout_thaw (EmeusConstraintLayout *layout)
 {
-  GSequenceIter *iter;
-
-  if (gtk_widget_get_parent (widget) == GTK_WIDGET (layout))
-    return TRUE;
+  g_return_if_fail (EMEUS_IS_CONSTRAINT_LAYOUT (layout));
+  g_return_if_fail (layout->freeze_count > 0);
 
-  iter = g_sequence_get_begin_iter (layout->children);
-  while (!g_sequence_iter_is_end (iter))
-    {
-      GtkWidget *child = g_sequence_get (iter);
+  if (--layout->freeze_count > 0)
+    return;
 
-      iter = g_sequence_iter_next (iter);
+  /* The pending constraints of an asynchronous layout, or of a layout
+   * with a solve budget, are solved when it is allocated
+   */
+  simplex_solver_set_auto_solve (&layout->solver,
+                                 !layout->async_solve && layout->solve_budget == 0);
 
-      if (gtk_widget_get_parent (widget) == child)
-        return TRUE;
+  if (layout->resize_pending)
+    {
+      layout->resize_pending = FALSE;
+      gtk_widget_queue_resize (GTK_WIDGET (layout));
     }
-
-  return FALSE;
 }
 
-static void
-layout_add_constraint (EmeusConstraintLayout *layout,
-                       EmeusConstraint       *constraint)
+/**
+ * emeus_constraint_layout_is_frozen:
+ * @layout: a #EmeusConstraintLayout
+ *
+ * Checks whether the @layout was frozen using emeus_constraint_layout_freeze().
+ *
+ * Returns: %TRUE if the @layout is frozen
+ *
+ * Since: 1.0
+ */
+gboolean
+emeus_constraint_layout_is_frozen (EmeusConstraintLayout *layout)
 {
-  EmeusConstraintLayoutChild *child;
-  GtkWidget *target, *parent;
+  g_return_val_if_fail (EMEUS_IS_CONSTRAINT_LAYOUT (layout), FALSE);
 
-  if (emeus_constraint_is_attached (constraint))
-    {
-      g_critical ("Constraint '%s' is already attached.",
-                  emeus_constraint_to_string (constraint));
-      return;
-    }
-
-  target = emeus_constraint_get_target_object (constraint);
-  if (target == NULL)
-    {
-      add_layout_constraint (layout, constraint);
-      return;
-    }
+  return layout->freeze_count > 0;
+}
 
-  parent = gtk_widget_get_parent (target);
-  if (parent == NULL)
+/* Queues a resize of @widget, unless its constraint layout is frozen */
+static void
+queue_resize (EmeusConstraintLayout *layout,
+              GtkWidget             *widget)
+{
+  if (layout != NULL && layout->freeze_count > 0)
     {
-      g_critical ("The target widget '%s' does not have any parent set",
-                  G_OBJECT_TYPE_NAME (target));
+      layout->resize_pending = TRUE;
       return;
     }
 
-  if (!EMEUS_IS_CONSTRAINT_LAYOUT_CHILD (target) &&
-      !EMEUS_IS_CONSTRAINT_LAYOUT_CHILD (parent))
-    {
-      g_critical ("The target widget '%s' is not a direct descendant of "
-                  "the constraint layout",
-                  G_OBJECT_TYPE_NAME (target));
-      return;
-    }
+  gtk_widget_queue_resize (widget);
+}
 
-  if (EMEUS_IS_CONSTRAINT_LAYOUT_CHILD (target))
-    child = EMEUS_CONSTRAINT_LAYOUT_CHILD (target);
-  else
-    child = EMEUS_CONSTRAINT_LAYOUT_CHILD (parent);
+static void
+constraint_groups_changed (EmeusConstraintLayout *layout)
+{
+  layout->groups_changed = TRUE;
 
-  add_child_constraint (layout, child, constraint);
+  queue_resize (layout, GTK_WIDGET (layout));
 }
 
+/**
+ * emeus_constraint_layout_set_constraint_group:
+ * @layout: a #EmeusConstraintLayout
+ * @constraint: a #EmeusConstraint attached to the @layout, or to one
+ *   of its children
+ * @group: (nullable): the name of a group, or %NULL
+ *
+ * Adds @constraint to the group of constraints named @group, replacing
+ * its previous group; if @group is %NULL, the @constraint is removed
+ * from its group.
+ *
+ * The constraints of a group are only used to compute the layout while
+ * the group is active; see emeus_constraint_layout_set_group_active().
+ *
+ * Since: 1.0
+ */
 void
-emeus_constraint_layout_add_constraint (EmeusConstraintLayout *layout,
-                                        EmeusConstraint       *constraint)
+emeus_constraint_layout_set_constraint_group (EmeusConstraintLayout *layout,
+                                              EmeusConstraint       *constraint,
+                                              const char            *group)
 {
   g_return_if_fail (EMEUS_IS_CONSTRAINT_LAYOUT (layout));
   g_return_if_fail (EMEUS_IS_CONSTRAINT (constraint));
 
-  layout_add_constraint (layout, constraint);
+  if (constraint->solver != &layout->solver)
+    {
+      g_critical ("The constraint %p is not attached to the layout %p",
+                  constraint,
+                  layout);
+      return;
+    }
+
+  constraint->group = get_constraint_group (layout, group);
+
+  constraint_groups_changed (layout);
 }
 
+/**
+ * emeus_constraint_layout_set_constraint_handles_group:
+ * @layout: a #EmeusConstraintLayout
+ * @handles: (array length=n_handles): the handles of the constraints
+ * @n_handles: the number of handles in @handles
+ * @group: (nullable): the name of a group, or %NULL
+ *
+ * Adds the constraints added using emeus_constraint_layout_add_constraint_descriptors()
+ * to the group of constraints named @group, replacing their previous
+ * group; if @group is %NULL, the constraints are removed from their
+ * group.
+ *
+ * Handles equal to 0 are ignored.
+ *
+ * Since: 1.0
+ */
 void
-emeus_constraint_layout_add_constraints (EmeusConstraintLayout *layout,
-                                         EmeusConstraint       *first_constraint,
-                                         ...)
+emeus_constraint_layout_set_constraint_handles_group (EmeusConstraintLayout *layout,
+                                                      const guint           *handles,
+                                                      guint                  n_handles,
+                                                      const char            *group)
 {
-  EmeusConstraint *constraint;
-  va_list args;
+  ConstraintGroup *constraint_group;
+  guint i;
 
   g_return_if_fail (EMEUS_IS_CONSTRAINT_LAYOUT (layout));
+  g_return_if_fail (handles != NULL || n_handles == 0);
 
-  va_start (args, first_constraint);
+  if (n_handles == 0)
+    return;
 
-  constraint = first_constraint;
-  while (constraint != NULL)
+  constraint_group = get_constraint_group (layout, group);
+
+  for (i = 0; i < n_handles; i++)
     {
-      layout_add_constraint (layout, constraint);
+      ConstraintHandle *handle;
 
-      constraint = va_arg (args, EmeusConstraint *);
+      if (handles[i] == 0)
+        continue;
+
+      handle = g_hash_table_lookup (layout->constraint_handles, GUINT_TO_POINTER (handles[i]));
+      if (handle == NULL)
+        {
+          g_critical ("Attempting to change the group of unknown constraint handle %u", handles[i]);
+          continue;
+        }
+
+      handle->group = constraint_group;
     }
 
-  va_end (args);
+  constraint_groups_changed (layout);
 }
 
 /**
- * emeus_constraint_layout_pack:
+ * emeus_constraint_layout_set_group_active:
  * @layout: a #EmeusConstraintLayout
- * @child: a #GtkWidget
- * @name: (nullable): an optional name for the @child
- * @first_constraint: (nullable): a #EmeusConstraint
- * @...: a %NULL-terminated list of #EmeusConstraint instances
+ * @group: the name of a group
+ * @active: whether the constraints of the group should be active
  *
- * Adds @child to the @layout, and applies a list of constraints to it.
+ * Enables or disables all the constraints in the group named @group.
  *
- * This convenience function is the equivalent of calling
- * gtk_container_add() and emeus_constraint_layout_child_add_constraint()
- * for each constraint instance.
+ * Disabled constraints are kept by the @layout, but they are not used
+ * to compute the layout until the group is enabled again; this is
+ * cheaper than removing and adding the constraints, for instance when
+ * switching between different sets of constraints depending on the
+ * size of the window.
+ *
+ * All the groups changed before the next size allocation of the
+ * @layout are applied at the same time.
+ *
+ * Groups are active by default.
  *
  * Since: 1.0
  */
 void
-emeus_constraint_layout_pack (EmeusConstraintLayout *layout,
-                              GtkWidget             *child,
-                              const char            *name,
-                              EmeusConstraint       *first_constraint,
-                              ...)
+emeus_constraint_layout_set_group_active (EmeusConstraintLayout *layout,
+                                          const char            *group,
+                                          gboolean               active)
 {
-  EmeusConstraintLayoutChild *layout_child;
-  EmeusConstraint *constraint;
-  va_list args;
+  ConstraintGroup *constraint_group;
 
   g_return_if_fail (EMEUS_IS_CONSTRAINT_LAYOUT (layout));
-  g_return_if_fail (GTK_IS_WIDGET (child));
-  g_return_if_fail (EMEUS_IS_CONSTRAINT (first_constraint) || first_constraint == NULL);
-
-  g_return_if_fail (gtk_widget_get_parent (child) == NULL);
-
-  if (EMEUS_IS_CONSTRAINT_LAYOUT_CHILD (child))
-    layout_child = EMEUS_CONSTRAINT_LAYOUT_CHILD (child);
-  else
-    {
-      layout_child = (EmeusConstraintLayoutChild *) emeus_constraint_layout_child_new (name);
+  g_return_if_fail (group != NULL);
 
-      gtk_widget_show (GTK_WIDGET (layout_child));
-      gtk_container_add (GTK_CONTAINER (layout_child), child);
-    }
+  active = !!active;
 
-  layout_child->iter = g_sequence_append (layout->children, layout_child);
-  layout_child->solver = &layout->solver;
+  constraint_group = get_constraint_group (layout, group);
+  if (constraint_group->active == active)
+    return;
 
-  gtk_widget_set_parent (GTK_WIDGET (layout_child), GTK_WIDGET (layout));
+  constraint_group->active = active;
 
-  if (first_constraint == NULL)
-    return;
+  constraint_groups_changed (layout);
+}
 
-  va_start (args, first_constraint);
+/**
+ * emeus_constraint_layout_get_group_active:
+ * @layout: a #EmeusConstraintLayout
+ * @group: the name of a group
+ *
+ * Checks whether the constraints in the group named @group are
+ * active.
+ *
+ * Returns: %TRUE if the group is active
+ *
+ * Since: 1.0
+ */
+gboolean
+emeus_constraint_layout_get_group_active (EmeusConstraintLayout *layout,
+                                          const char            *group)
+{
+  ConstraintGroup *constraint_group;
 
-  constraint = first_constraint;
-  while (constraint != NULL)
-    {
-      add_child_constraint (layout, layout_child, constraint);
+  g_return_val_if_fail (EMEUS_IS_CONSTRAINT_LAYOUT (layout), FALSE);
+  g_return_val_if_fail (group != NULL, FALSE);
 
-      constraint = va_arg (args, EmeusConstraint *);
-    }
+  constraint_group = g_hash_table_lookup (layout->constraint_groups, group);
+  if (constraint_group == NULL)
+    return TRUE;
 
-  va_end (args);
+  return constraint_group->active;
 }
 
 static void
@@ -920,38 +3483,47 @@ emeus_constraint_layout_child_finalize (GObject *gobject)
   EmeusConstraintLayoutChild *self = EMEUS_CONSTRAINT_LAYOUT_CHILD (gobject);
 
   g_free (self->name);
+  g_array_unref (self->constraint_handles);
+  g_array_unref (self->source_handles);
+  g_hash_table_unref (self->source_constraints);
 
   G_OBJECT_CLASS (emeus_constraint_layout_child_parent_class)->finalize (gobject);
 }
 
 static void
-emeus_constraint_layout_child_dispose (GObject *gobject)
+remove_attribute_constraints (EmeusConstraintLayoutChild *child)
 {
-  EmeusConstraintLayoutChild *self = EMEUS_CONSTRAINT_LAYOUT_CHILD (gobject);
-
-  if (self->right_constraint != NULL)
+  if (child->right_constraint != NULL)
     {
-      simplex_solver_remove_constraint (self->solver, self->right_constraint);
-      self->right_constraint = NULL;
+      simplex_solver_remove_constraint (child->solver, child->right_constraint);
+      child->right_constraint = NULL;
     }
 
-  if (self->bottom_constraint != NULL)
+  if (child->bottom_constraint != NULL)
     {
-      simplex_solver_remove_constraint (self->solver, self->bottom_constraint);
-      self->bottom_constraint = NULL;
+      simplex_solver_remove_constraint (child->solver, child->bottom_constraint);
+      child->bottom_constraint = NULL;
     }
 
-  if (self->center_x_constraint != NULL)
+  if (child->center_x_constraint != NULL)
     {
-      simplex_solver_remove_constraint (self->solver, self->center_x_constraint);
-      self->center_x_constraint = NULL;
+      simplex_solver_remove_constraint (child->solver, child->center_x_constraint);
+      child->center_x_constraint = NULL;
     }
 
-  if (self->center_y_constraint != NULL)
+  if (child->center_y_constraint != NULL)
     {
-      simplex_solver_remove_constraint (self->solver, self->center_y_constraint);
-      self->center_y_constraint = NULL;
+      simplex_solver_remove_constraint (child->solver, child->center_y_constraint);
+      child->center_y_constraint = NULL;
     }
+}
+
+static void
+emeus_constraint_layout_child_dispose (GObject *gobject)
+{
+  EmeusConstraintLayoutChild *self = EMEUS_CONSTRAINT_LAYOUT_CHILD (gobject);
+
+  remove_attribute_constraints (self);
 
   g_clear_pointer (&self->constraints, g_hash_table_unref);
   g_clear_pointer (&self->bound_attributes, g_hash_table_unref);
@@ -1109,9 +3681,18 @@ emeus_constraint_layout_child_init (EmeusConstraintLayoutChild *self)
                                              g_object_unref,
                                              NULL);
 
+  self->constraint_handles = g_array_new (FALSE, FALSE, sizeof (guint));
+
+  self->source_constraints = g_hash_table_new (NULL, NULL);
+  self->source_handles = g_array_new (FALSE, FALSE, sizeof (guint));
+
   self->bound_attributes = g_hash_table_new_full (NULL, NULL,
                                                   NULL,
                                                   (GDestroyNotify) variable_unref);
+
+  /* No intrinsic size, and no edit constraint for it */
+  self->intrinsic_width = -1;
+  self->intrinsic_height = -1;
 }
 
 /**
@@ -1164,7 +3745,7 @@ emeus_constraint_layout_child_add_constraint (EmeusConstraintLayoutChild *child,
   add_child_constraint (layout, child, constraint);
 
   if (gtk_widget_get_visible (widget))
-    gtk_widget_queue_resize (widget);
+    queue_resize (layout, widget);
 }
 
 /**
@@ -1196,7 +3777,7 @@ emeus_constraint_layout_child_remove_constraint (EmeusConstraintLayoutChild *chi
     return;
 
   if (gtk_widget_get_visible (widget))
-    gtk_widget_queue_resize (widget);
+    queue_resize (layout, widget);
 }
 
 /**
@@ -1210,12 +3791,62 @@ emeus_constraint_layout_child_remove_constraint (EmeusConstraintLayoutChild *chi
 void
 emeus_constraint_layout_child_clear_constraints (EmeusConstraintLayoutChild *child)
 {
+  GHashTableIter iter;
+  GtkWidget *parent;
+  gpointer value_p;
+
   g_return_if_fail (EMEUS_IS_CONSTRAINT_LAYOUT_CHILD (child));
 
-  g_hash_table_remove_all (child->constraints);
-  g_hash_table_remove_all (child->bound_attributes);
+  parent = gtk_widget_get_parent (GTK_WIDGET (child));
+
+  /* Remove the constraints from the solver as well, or they will keep
+   * referring to the attributes we are about to drop; the minimum size
+   * constraints are added again on the next size request, bound to the
+   * new attributes
+   */
+  remove_child_constraints (parent != NULL ? EMEUS_CONSTRAINT_LAYOUT (parent) : NULL,
+                            child,
+                            TRUE);
+
+  /* The intrinsic size is kept, along with the attributes it edits */
+  g_hash_table_iter_init (&iter, child->bound_attributes);
+  while (g_hash_table_iter_next (&iter, NULL, &value_p))
+    {
+      if (child->width_constraint != NULL &&
+          child->width_constraint->variable == value_p)
+        continue;
+
+      if (child->height_constraint != NULL &&
+          child->height_constraint->variable == value_p)
+        continue;
 
-  gtk_widget_queue_resize (GTK_WIDGET (child));
+      g_hash_table_iter_remove (&iter);
+    }
+
+  if (child->solver != NULL)
+    simplex_solver_compact (child->solver);
+
+  queue_resize (parent != NULL ? EMEUS_CONSTRAINT_LAYOUT (parent) : NULL,
+                GTK_WIDGET (child));
+}
+
+/**
+ * emeus_constraint_layout_child_get_name:
+ * @child: a #EmeusConstraintLayoutChild
+ *
+ * Retrieves the name of the @child, used to refer to it when describing
+ * constraints; see emeus_constraint_layout_add_constraints_from_description().
+ *
+ * Returns: (nullable): the name of the @child
+ *
+ * Since: 1.0
+ */
+const char *
+emeus_constraint_layout_child_get_name (EmeusConstraintLayoutChild *child)
+{
+  g_return_val_if_fail (EMEUS_IS_CONSTRAINT_LAYOUT_CHILD (child), NULL);
+
+  return child->name;
 }
 
 int
@@ -1318,6 +3949,7 @@ void
 emeus_constraint_layout_child_set_intrinsic_width (EmeusConstraintLayoutChild *child,
                                                    int                         width)
 {
+  GtkWidget *parent;
   Variable *attr;
 
   g_return_if_fail (EMEUS_IS_CONSTRAINT_LAYOUT_CHILD (child));
@@ -1341,6 +3973,10 @@ emeus_constraint_layout_child_set_intrinsic_width (EmeusConstraintLayoutChild *c
 
   child->intrinsic_width = width;
 
+  parent = gtk_widget_get_parent (GTK_WIDGET (child));
+  if (parent != NULL)
+    clear_solution_cache (EMEUS_CONSTRAINT_LAYOUT (parent));
+
   if (child->intrinsic_width > 0)
     {
       simplex_solver_suggest_value (child->solver, attr, child->intrinsic_width);
@@ -1348,13 +3984,15 @@ emeus_constraint_layout_child_set_intrinsic_width (EmeusConstraintLayoutChild *c
     }
 
   if (gtk_widget_get_visible (GTK_WIDGET (child)))
-    gtk_widget_queue_resize (GTK_WIDGET (child));
+    queue_resize (parent != NULL ? EMEUS_CONSTRAINT_LAYOUT (parent) : NULL,
+                  GTK_WIDGET (child));
 }
 
 void
 emeus_constraint_layout_child_set_intrinsic_height (EmeusConstraintLayoutChild *child,
                                                     int                         height)
 {
+  GtkWidget *parent;
   Variable *attr;
 
   g_return_if_fail (EMEUS_IS_CONSTRAINT_LAYOUT_CHILD (child));
@@ -1378,6 +4016,10 @@ emeus_constraint_layout_child_set_intrinsic_height (EmeusConstraintLayoutChild *
 
   child->intrinsic_height = height;
 
+  parent = gtk_widget_get_parent (GTK_WIDGET (child));
+  if (parent != NULL)
+    clear_solution_cache (EMEUS_CONSTRAINT_LAYOUT (parent));
+
   if (child->intrinsic_height > 0)
     {
       simplex_solver_suggest_value (child->solver, attr, height);
@@ -1385,5 +4027,6 @@ emeus_constraint_layout_child_set_intrinsic_height (EmeusConstraintLayoutChild *
     }
 
   if (gtk_widget_get_visible (GTK_WIDGET (child)))
-    gtk_widget_queue_resize (GTK_WIDGET (child));
+    queue_resize (parent != NULL ? EMEUS_CONSTRAINT_LAYOUT (parent) : NULL,
+                  GTK_WIDGET (child));
 }
@@ -25,12 +25,19 @@ G_BEGIN_DECLS
 
 #define EMEUS_TYPE_CONSTRAINT_LAYOUT (emeus_constraint_layout_get_type())
 
+#define EMEUS_CONSTRAINT_LAYOUT_ERROR (emeus_constraint_layout_error_quark())
+
+EMEUS_AVAILABLE_IN_1_0
+GQuark emeus_constraint_layout_error_quark (void);
+
 EMEUS_AVAILABLE_IN_1_0
 G_DECLARE_FINAL_TYPE (EmeusConstraintLayout, emeus_constraint_layout, EMEUS, CONSTRAINT_LAYOUT, GtkContainer)
 
 EMEUS_AVAILABLE_IN_1_0
 GtkWidget *     emeus_constraint_layout_new     (void);
 EMEUS_AVAILABLE_IN_1_0
+GtkWidget *     emeus_constraint_layout_new_from_template       (EmeusConstraintLayout *template_layout);
+EMEUS_AVAILABLE_IN_1_0
 void            emeus_constraint_layout_pack                    (EmeusConstraintLayout *layout,
                                                                  GtkWidget             *child,
                                                                  const char            *name,
@@ -43,6 +50,74 @@ EMEUS_AVAILABLE_IN_1_0
 void            emeus_constraint_layout_add_constraints         (EmeusConstraintLayout *layout,
                                                                  EmeusConstraint       *first_constraint,
                                                                  ...) G_GNUC_NULL_TERMINATED;
+EMEUS_AVAILABLE_IN_1_0
+void            emeus_constraint_layout_add_constraint_descriptors      (EmeusConstraintLayout           *layout,
+                                                                         const EmeusConstraintDescriptor *descriptors,
+                                                                         guint                            n_descriptors,
+                                                                         guint                           *handles);
+EMEUS_AVAILABLE_IN_1_0
+guint *         emeus_constraint_layout_add_constraint_data             (EmeusConstraintLayout           *layout,
+                                                                         GtkWidget                      **objects,
+                                                                         guint                            n_objects,
+                                                                         const double                    *data,
+                                                                         guint                            n_data,
+                                                                         guint                           *n_handles);
+EMEUS_AVAILABLE_IN_1_0
+guint *         emeus_constraint_layout_add_constraints_from_description        (EmeusConstraintLayout   *layout,
+                                                                                 const char              *description,
+                                                                                 gssize                   length,
+                                                                                 int                      hspacing,
+                                                                                 int                      vspacing,
+                                                                                 guint                   *n_handles,
+                                                                                 GError                 **error);
+EMEUS_AVAILABLE_IN_1_0
+void            emeus_constraint_layout_remove_constraint_handles       (EmeusConstraintLayout           *layout,
+                                                                         const guint                     *handles,
+                                                                         guint                            n_handles);
+EMEUS_AVAILABLE_IN_1_0
+void            emeus_constraint_layout_clear_constraints       (EmeusConstraintLayout *layout);
+EMEUS_AVAILABLE_IN_1_0
+void            emeus_constraint_layout_set_use_solution_cache  (EmeusConstraintLayout *layout,
+                                                                 gboolean               use_cache);
+EMEUS_AVAILABLE_IN_1_0
+gboolean        emeus_constraint_layout_get_use_solution_cache  (EmeusConstraintLayout *layout);
+EMEUS_AVAILABLE_IN_1_0
+void            emeus_constraint_layout_set_use_shared_solution_cache   (EmeusConstraintLayout *layout,
+                                                                         gboolean               use_cache);
+EMEUS_AVAILABLE_IN_1_0
+gboolean        emeus_constraint_layout_get_use_shared_solution_cache   (EmeusConstraintLayout *layout);
+EMEUS_AVAILABLE_IN_1_0
+void            emeus_constraint_layout_set_async_solve         (EmeusConstraintLayout *layout,
+                                                                 gboolean               async_solve);
+EMEUS_AVAILABLE_IN_1_0
+gboolean        emeus_constraint_layout_get_async_solve         (EmeusConstraintLayout *layout);
+EMEUS_AVAILABLE_IN_1_0
+void            emeus_constraint_layout_set_solve_budget        (EmeusConstraintLayout *layout,
+                                                                 gint64                 budget);
+EMEUS_AVAILABLE_IN_1_0
+gint64          emeus_constraint_layout_get_solve_budget        (EmeusConstraintLayout *layout);
+EMEUS_AVAILABLE_IN_1_0
+void            emeus_constraint_layout_freeze                  (EmeusConstraintLayout *layout);
+EMEUS_AVAILABLE_IN_1_0
+void            emeus_constraint_layout_thaw                    (EmeusConstraintLayout *layout);
+EMEUS_AVAILABLE_IN_1_0
+gboolean        emeus_constraint_layout_is_frozen               (EmeusConstraintLayout *layout);
+EMEUS_AVAILABLE_IN_1_0
+void            emeus_constraint_layout_set_constraint_group    (EmeusConstraintLayout *layout,
+                                                                 EmeusConstraint       *constraint,
+                                                                 const char            *group);
+EMEUS_AVAILABLE_IN_1_0
+void            emeus_constraint_layout_set_constraint_handles_group    (EmeusConstraintLayout *layout,
+                                                                         const guint           *handles,
+                                                                         guint                  n_handles,
+                                                                         const char            *group);
+EMEUS_AVAILABLE_IN_1_0
+void            emeus_constraint_layout_set_group_active        (EmeusConstraintLayout *layout,
+                                                                 const char            *group,
+                                                                 gboolean               active);
+EMEUS_AVAILABLE_IN_1_0
+gboolean        emeus_constraint_layout_get_group_active        (EmeusConstraintLayout *layout,
+                                                                 const char            *group);
 
 #define EMEUS_TYPE_CONSTRAINT_LAYOUT_CHILD (emeus_constraint_layout_child_get_type())
 
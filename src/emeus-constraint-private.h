@@ -44,6 +44,9 @@ struct _EmeusConstraint
   char *description;
   SimplexSolver *solver;
   Constraint *constraint;
+
+  /* The group of the constraint in the layout, if any */
+  ConstraintGroup *group;
 };
 
 gboolean        emeus_constraint_attach                 (EmeusConstraint       *constraint,
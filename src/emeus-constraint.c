@@ -592,6 +592,7 @@ emeus_constraint_detach (EmeusConstraint *constraint)
   constraint->constraint = NULL;
   constraint->target_object = NULL;
   constraint->solver = NULL;
+  constraint->group = NULL;
 }
 
 /**
@@ -612,3 +613,44 @@ emeus_constraint_is_attached (EmeusConstraint *constraint)
 
   return constraint->solver != NULL;
 }
+
+G_DEFINE_BOXED_TYPE (EmeusConstraintDescriptor, emeus_constraint_descriptor,
+                     emeus_constraint_descriptor_copy,
+                     emeus_constraint_descriptor_free)
+
+/**
+ * emeus_constraint_descriptor_copy:
+ * @descriptor: a #EmeusConstraintDescriptor
+ *
+ * Copies a #EmeusConstraintDescriptor.
+ *
+ * Returns: (transfer full): a copy of the @descriptor; use
+ *   emeus_constraint_descriptor_free() to free the resources
+ *   allocated by this function
+ *
+ * Since: 1.0
+ */
+EmeusConstraintDescriptor *
+emeus_constraint_descriptor_copy (const EmeusConstraintDescriptor *descriptor)
+{
+  g_return_val_if_fail (descriptor != NULL, NULL);
+
+  return g_slice_dup (EmeusConstraintDescriptor, descriptor);
+}
+
+/**
+ * emeus_constraint_descriptor_free:
+ * @descriptor: (nullable): a #EmeusConstraintDescriptor
+ *
+ * Frees the resources allocated by emeus_constraint_descriptor_copy().
+ *
+ * Since: 1.0
+ */
+void
+emeus_constraint_descriptor_free (EmeusConstraintDescriptor *descriptor)
+{
+  if (descriptor == NULL)
+    return;
+
+  g_slice_free (EmeusConstraintDescriptor, descriptor);
+}
@@ -65,4 +65,52 @@ gboolean                        emeus_constraint_is_required            (EmeusCo
 EMEUS_AVAILABLE_IN_1_0
 gboolean                        emeus_constraint_is_attached            (EmeusConstraint         *constraint);
 
+/**
+ * EmeusConstraintDescriptor:
+ * @target_object: (type Gtk.Widget) (nullable): the target widget, or
+ *   %NULL for the layout
+ * @target_attribute: the attribute to set on the target widget
+ * @relation: the relation between the target and source attributes
+ * @source_object: (type Gtk.Widget) (nullable): the source widget, or
+ *   %NULL for the layout
+ * @source_attribute: the attribute to get from the source widget, or
+ *   %EMEUS_CONSTRAINT_ATTRIBUTE_INVALID for a constant
+ * @multiplier: the multiplication coefficient to apply to the source
+ *   attribute
+ * @constant: the constant to add to the source attribute
+ * @strength: the strength of the constraint
+ *
+ * A plain description of a constraint, with the same fields as
+ * #EmeusConstraint.
+ *
+ * Descriptors are used to add many constraints to a #EmeusConstraintLayout
+ * at once, without creating a #EmeusConstraint instance for each one; see
+ * emeus_constraint_layout_add_constraint_descriptors().
+ *
+ * Since: 1.0
+ */
+typedef struct {
+  gpointer target_object;
+  EmeusConstraintAttribute target_attribute;
+
+  EmeusConstraintRelation relation;
+
+  gpointer source_object;
+  EmeusConstraintAttribute source_attribute;
+
+  double multiplier;
+  double constant;
+
+  EmeusConstraintStrength strength;
+} EmeusConstraintDescriptor;
+
+#define EMEUS_TYPE_CONSTRAINT_DESCRIPTOR (emeus_constraint_descriptor_get_type())
+
+EMEUS_AVAILABLE_IN_1_0
+GType                           emeus_constraint_descriptor_get_type    (void) G_GNUC_CONST;
+EMEUS_AVAILABLE_IN_1_0
+EmeusConstraintDescriptor *     emeus_constraint_descriptor_copy        (const EmeusConstraintDescriptor *descriptor);
+EMEUS_AVAILABLE_IN_1_0
+void                            emeus_constraint_descriptor_free        (EmeusConstraintDescriptor       *descriptor);
+
 G_END_DECLS
@@ -47,6 +47,15 @@ expression_get_constant (const Expression *expression)
   return expression->constant;
 }
 
+static inline int
+expression_get_n_terms (const Expression *expression)
+{
+  if (expression->terms == NULL)
+    return 0;
+
+  return g_hash_table_size (expression->terms);
+}
+
 Expression *expression_new (SimplexSolver *solver,
                             double constant);
 
@@ -169,6 +169,8 @@ expression_unref (Expression *expression)
       if (expression->terms != NULL)
         g_hash_table_unref (expression->terms);
 
+      g_list_free (expression->ordered_terms);
+
       g_slice_free (Expression, expression);
     }
 }
@@ -192,9 +194,10 @@ expression_add_variable (Expression *expression,
 
       if (t != NULL)
         {
-          double new_coefficient = term_get_coefficient (t) + coefficient;
+          double old_coefficient = term_get_coefficient (t);
+          double new_coefficient = old_coefficient + coefficient;
 
-          if (approx_val (new_coefficient, 0.0))
+          if (approx_zero (new_coefficient, MAX (fabs (old_coefficient), fabs (coefficient))))
             expression_remove_variable (expression, variable, subject);
           else
             t->coefficient = new_coefficient;
@@ -479,11 +482,11 @@ expression_substitute_out (Expression *expression,
 
       double old_coefficient = expression_get_coefficient (expression, clv);
 
-      if (old_coefficient > 0.0)
+      if (old_coefficient != 0.0)
         {
           double new_coefficient = old_coefficient + multiplier * coeff;
 
-          if (approx_val (new_coefficient, 0.0))
+          if (approx_zero (new_coefficient, MAX (fabs (old_coefficient), fabs (multiplier * coeff))))
             expression_remove_variable (expression, clv, subject);
           else
             expression_set_variable (expression, clv, new_coefficient);
@@ -48,6 +48,7 @@ constraint_is_edit (const Constraint *constraint)
 
 void simplex_solver_init (SimplexSolver *solver);
 void simplex_solver_clear (SimplexSolver *solver);
+void simplex_solver_reset (SimplexSolver *solver);
 
 Variable *simplex_solver_create_variable (SimplexSolver *solver,
                                           const char *name,
@@ -77,6 +78,20 @@ bool simplex_solver_has_stay_variable (SimplexSolver *solver,
 
 void simplex_solver_remove_constraint (SimplexSolver *solver,
                                        Constraint *constraint);
+void simplex_solver_remove_constraints (SimplexSolver *solver,
+                                        Constraint **constraints,
+                                        int n_constraints);
+
+void simplex_solver_disable_constraints (SimplexSolver *solver,
+                                         Constraint **constraints,
+                                         int n_constraints);
+void simplex_solver_enable_constraints (SimplexSolver *solver,
+                                        Constraint **constraints,
+                                        int n_constraints);
+bool simplex_solver_is_constraint_disabled (SimplexSolver *solver,
+                                            Constraint *constraint);
+
+bool simplex_solver_has_differences (SimplexSolver *solver);
 
 void simplex_solver_remove_edit_variable (SimplexSolver *solver,
                                           Variable *variable);
@@ -89,10 +104,64 @@ void simplex_solver_suggest_value (SimplexSolver *solver,
                                    double value);
 
 void simplex_solver_resolve (SimplexSolver *solver);
+bool simplex_solver_resolve_with_budget (SimplexSolver *solver,
+                                         int max_pivots,
+                                         gint64 max_time);
+
+void simplex_solver_set_auto_solve (SimplexSolver *solver,
+                                    bool auto_solve);
+void simplex_solver_solve (SimplexSolver *solver);
 
 void simplex_solver_begin_edit (SimplexSolver *solver);
 void simplex_solver_end_edit (SimplexSolver *solver);
 
+char *simplex_solver_get_statistics (SimplexSolver *solver);
+
+void simplex_solver_fork (SimplexSolver *solver,
+                          SimplexSolver *fork);
+Variable *simplex_solver_get_forked_variable (SimplexSolver *fork,
+                                              Variable *variable);
+Constraint *simplex_solver_get_forked_constraint (SimplexSolver *fork,
+                                                  Constraint *constraint);
+bool simplex_solver_merge_fork (SimplexSolver *solver,
+                                SimplexSolver *fork);
+
+void simplex_solver_solve_batch (SolverBatchItem *items,
+                                 int n_items,
+                                 int n_threads);
+
+void simplex_solver_begin_transaction (SimplexSolver *solver);
+void simplex_solver_commit_transaction (SimplexSolver *solver);
+void simplex_solver_rollback_transaction (SimplexSolver *solver);
+
+void simplex_solver_compact (SimplexSolver *solver);
+void simplex_solver_set_compact_threshold (SimplexSolver *solver,
+                                           int n_removals);
+
+GBytes *simplex_solver_serialize (SimplexSolver *solver,
+                                  guint64 key,
+                                  Variable **variables,
+                                  int n_variables,
+                                  Constraint **constraints,
+                                  int n_constraints);
+bool simplex_solver_deserialize (SimplexSolver *solver,
+                                 GBytes *image,
+                                 guint64 key,
+                                 Variable **variables,
+                                 int n_variables,
+                                 Constraint **constraints,
+                                 int n_constraints);
+
+ParametricSolution *simplex_solver_get_parametric_solution (SimplexSolver *solver,
+                                                            Variable **parameters,
+                                                            int n_parameters);
+
+bool parametric_solution_contains (const ParametricSolution *solution,
+                                   const double *parameters);
+bool parametric_solution_apply (const ParametricSolution *solution,
+                                const double *parameters);
+void parametric_solution_free (ParametricSolution *solution);
+
 /* Internal */
 void simplex_solver_note_added_variable (SimplexSolver *solver,
                                          Variable *variable,
@@ -36,7 +36,13 @@ typedef struct {
   Variable *eplus;
   Variable *eminus;
 
+  /* The value of the edit constant in the tableau */
   double prev_constant;
+
+  /* The last suggested value; it differs from prev_constant while the
+   * tableau lags behind the suggestions, see simplex_solver_resolve()
+   */
+  double suggested_value;
 } EditInfo;
 
 typedef struct {
@@ -53,6 +59,129 @@ typedef struct {
   Variable *second;
 } VariablePair;
 
+typedef struct {
+  /* The constraint that defines the alias */
+  Constraint *constraint;
+
+  /* variable = representative * scale + offset */
+  Variable *variable;
+  Variable *representative;
+  double scale;
+  double offset;
+} AliasInfo;
+
+typedef enum {
+  /* The constraint was added to the tableau or as an alias */
+  JOURNAL_ADDED,
+
+  /* The constraint was removed from the tableau or from the aliases */
+  JOURNAL_REMOVED,
+
+  /* The solver stopped tracking the constraint */
+  JOURNAL_UNTRACKED
+} JournalOp;
+
+typedef struct {
+  JournalOp op;
+
+  Constraint *constraint;
+
+  /* JOURNAL_ADDED: whether the constraint was already being tracked */
+  bool was_tracked;
+
+  /* JOURNAL_REMOVED: the bookkeeping of the constraint */
+  Variable *marker;
+  VariableSet *error_vars;
+  EditInfo *edit_info;
+  AliasInfo *alias;
+  bool is_stay;
+} JournalEntry;
+
+typedef struct {
+  Variable *variable;
+
+  double prev_constant;
+  double suggested_value;
+  double constant;
+} EditState;
+
+struct _Journal {
+  /* HashTable<Variable, Expression>; the rows modified by the transaction,
+   * as they were when it began, or NULL for the rows that did not exist;
+   * owns keys and values
+   */
+  GHashTable *rows;
+
+  /* HashSet<Variable>; the columns created by the transaction; owns keys */
+  GHashTable *columns;
+
+  /* Vec<JournalEntry>, in the order of the operations */
+  GArray *entries;
+
+  /* The stay error variables when the transaction began; new pairs are
+   * only ever appended to the array
+   */
+  GPtrArray *stay_error_vars;
+  int n_stay_error_vars;
+
+  /* Vec<EditState> */
+  GArray *edits;
+
+  bool needs_solving;
+};
+
+typedef struct {
+  /* The node at the other end of the edge */
+  int node;
+
+  Constraint *constraint;
+
+  /* Whether the edge is the reverse direction of an equality */
+  bool reverse;
+} DifferenceEdge;
+
+typedef struct {
+  Variable *variable;
+
+  /* Array<DifferenceEdge>; the edges leaving and entering the node */
+  GArray *out_edges;
+  GArray *in_edges;
+
+  /* The representative of the component of the node; on the
+   * representative, Array<int> of the nodes in the component
+   */
+  int parent;
+  GArray *members;
+
+  /* Set on the representative if the values of the component are out
+   * of date, and if they satisfy every constraint of the component
+   */
+  bool dirty;
+  bool exact;
+
+  /* The shortest distance from the origin, and to the origin */
+  double upper;
+  double lower;
+
+  int n_queued;
+  bool in_queue;
+} DifferenceNode;
+
+struct _DifferenceGraph {
+  /* Array<DifferenceNode>; the node 0 is the origin, i.e. the constant
+   * term, and it does not belong to any component
+   */
+  GArray *nodes;
+
+  /* HashTable<Variable, int> */
+  GHashTable *indices;
+
+  /* The nodes left without edges by the removal of constraints; they are
+   * not in any component, and are dropped when the graph is compacted
+   */
+  int n_unused;
+};
+
 static const char *operators[] = {
   "<=",
   "==",
@@ -136,6 +265,20 @@ stay_info_free (gpointer data)
   g_slice_free (StayInfo, data);
 }
 
+static void
+alias_info_free (gpointer data)
+{
+  AliasInfo *alias = data;
+
+  if (data == NULL)
+    return;
+
+  variable_unref (alias->variable);
+  variable_unref (alias->representative);
+
+  g_slice_free (AliasInfo, alias);
+}
+
 static void
 variable_set_free (gpointer data)
 {
@@ -226,6 +369,269 @@ variable_pair_free (gpointer data)
   g_slice_free (VariablePair, pair);
 }
 
+static void
+simplex_solver_queue_infeasible_row (SimplexSolver *solver,
+                                     Variable *variable)
+{
+  if (variable->is_queued)
+    return;
+
+  variable->is_queued = true;
+  g_ptr_array_add (solver->infeasible_rows, variable_ref (variable));
+}
+
+/* Takes the row with the most negative constant out of the worklist,
+ * and returns a reference on its basic variable; rows that have been
+ * removed from the tableau, or that became feasible again after being
+ * queued, are dropped along the way.
+ *
+ * The constants of queued rows change while pivoting, so we cannot
+ * keep the worklist sorted; we scan it instead, which is cheap given
+ * that only a handful of rows are infeasible at any given time.
+ */
+static Variable *
+simplex_solver_pop_infeasible_row (SimplexSolver *solver)
+{
+  GPtrArray *worklist = solver->infeasible_rows;
+  Variable *res = NULL;
+  double min_constant = 0.0;
+  int res_idx = -1;
+  int i = 0;
+
+  while (i < worklist->len)
+    {
+      Variable *v = g_ptr_array_index (worklist, i);
+      Expression *e = g_hash_table_lookup (solver->rows, v);
+      double constant = e != NULL ? expression_get_constant (e) : 0.0;
+
+      if (constant >= 0.0)
+        {
+          g_ptr_array_remove_index_fast (worklist, i);
+          v->is_queued = false;
+          variable_unref (v);
+
+          if (res_idx == (int) worklist->len)
+            res_idx = i;
+
+          continue;
+        }
+
+      if (constant < min_constant)
+        {
+          min_constant = constant;
+          res_idx = i;
+        }
+
+      i += 1;
+    }
+
+  if (res_idx < 0)
+    return NULL;
+
+  res = g_ptr_array_remove_index_fast (worklist, res_idx);
+  res->is_queued = false;
+
+  return res;
+}
+
+/* Transactions
+ *
+ * While a transaction is open, the solver records a copy of each row
+ * before modifying it for the first time, and the bookkeeping of each
+ * constraint that gets added or removed; rolling back the transaction
+ * puts the recorded state back, without going through the tableau
+ * operations needed to remove the constraints one by one.
+ */
+
+static void
+simplex_solver_journal_row (SimplexSolver *solver,
+                            Variable *subject)
+{
+  Journal *journal = solver->journal;
+  Expression *row;
+
+  if (journal == NULL || g_hash_table_contains (journal->rows, subject))
+    return;
+
+  row = g_hash_table_lookup (solver->rows, subject);
+
+  g_hash_table_insert (journal->rows,
+                       variable_ref (subject),
+                       row != NULL ? expression_clone (row) : NULL);
+}
+
+static void
+simplex_solver_journal_added (SimplexSolver *solver,
+                              Constraint *constraint)
+{
+  JournalEntry entry = { 0, };
+
+  if (solver->journal == NULL)
+    return;
+
+  entry.op = JOURNAL_ADDED;
+  entry.constraint = constraint;
+  entry.was_tracked = g_hash_table_contains (solver->constraints, constraint);
+
+  g_array_append_val (solver->journal->entries, entry);
+}
+
+static void
+simplex_solver_journal_removed (SimplexSolver *solver,
+                                Constraint *constraint)
+{
+  JournalEntry entry = { 0, };
+  AliasInfo *alias;
+
+  if (solver->journal == NULL)
+    return;
+
+  entry.op = JOURNAL_REMOVED;
+  entry.constraint = constraint;
+
+  alias = g_hash_table_lookup (solver->alias_constraints, constraint);
+  if (alias != NULL)
+    {
+      entry.alias = g_slice_dup (AliasInfo, alias);
+      variable_ref (entry.alias->variable);
+      variable_ref (entry.alias->representative);
+    }
+  else
+    {
+      VariableSet *error_vars = g_hash_table_lookup (solver->error_vars, constraint);
+      Variable *marker = g_hash_table_lookup (solver->marker_vars, constraint);
+
+      if (marker != NULL)
+        entry.marker = variable_ref (marker);
+
+      if (error_vars != NULL)
+        {
+          GHashTableIter iter;
+          Variable *v;
+
+          entry.error_vars = variable_set_new ();
+
+          variable_set_iter_init (error_vars, &iter);
+          while (variable_set_iter_next (&iter, &v))
+            variable_set_add_variable (entry.error_vars, v);
+        }
+
+      if (constraint_is_edit (constraint))
+        {
+          EditInfo *ei = g_hash_table_lookup (solver->edit_var_map, constraint->variable);
+
+          if (ei != NULL && ei->constraint == constraint)
+            entry.edit_info = g_slice_dup (EditInfo, ei);
+        }
+
+      if (constraint_is_stay (constraint))
+        {
+          StayInfo *si = g_hash_table_lookup (solver->stay_var_map, constraint->variable);
+
+          entry.is_stay = si != NULL && si->constraint == constraint;
+        }
+    }
+
+  g_array_append_val (solver->journal->entries, entry);
+}
+
+static void
+simplex_solver_journal_untracked (SimplexSolver *solver,
+                                  Constraint *constraint)
+{
+  JournalEntry entry = { 0, };
+
+  entry.op = JOURNAL_UNTRACKED;
+  entry.constraint = constraint;
+
+  g_array_append_val (solver->journal->entries, entry);
+}
+
+static void
+journal_free (Journal *journal)
+{
+  int i;
+
+  if (journal == NULL)
+    return;
+
+  for (i = 0; i < journal->entries->len; i++)
+    {
+      JournalEntry *entry = &g_array_index (journal->entries, JournalEntry, i);
+
+      /* Constraints that are still untracked were removed for good */
+      if (entry->op == JOURNAL_UNTRACKED)
+        constraint_free (entry->constraint);
+
+      if (entry->marker != NULL)
+        variable_unref (entry->marker);
+
+      variable_set_free (entry->error_vars);
+      alias_info_free (entry->alias);
+
+      if (entry->edit_info != NULL)
+        edit_info_free (entry->edit_info);
+    }
+
+  for (i = 0; i < journal->edits->len; i++)
+    variable_unref (g_array_index (journal->edits, EditState, i).variable);
+
+  g_array_unref (journal->entries);
+  g_array_unref (journal->edits);
+  g_ptr_array_unref (journal->stay_error_vars);
+  g_hash_table_unref (journal->columns);
+  g_hash_table_unref (journal->rows);
+
+  g_slice_free (Journal, journal);
+}
+
+static inline DifferenceNode *
+difference_graph_get_node (DifferenceGraph *graph,
+                           int index)
+{
+  return &g_array_index (graph->nodes, DifferenceNode, index);
+}
+
+static void
+difference_graph_free (DifferenceGraph *graph)
+{
+  int i;
+
+  if (graph == NULL)
+    return;
+
+  for (i = 1; i < graph->nodes->len; i++)
+    {
+      DifferenceNode *node = difference_graph_get_node (graph, i);
+
+      g_array_unref (node->out_edges);
+      g_array_unref (node->in_edges);
+      if (node->members != NULL)
+        g_array_unref (node->members);
+    }
+
+  g_array_unref (graph->nodes);
+  g_hash_table_unref (graph->indices);
+
+  g_slice_free (DifferenceGraph, graph);
+}
+
+static void
+simplex_solver_clear_infeasible_rows (SimplexSolver *solver)
+{
+  int i;
+
+  for (i = 0; i < solver->infeasible_rows->len; i++)
+    {
+      Variable *v = g_ptr_array_index (solver->infeasible_rows, i);
+
+      v->is_queued = false;
+      variable_unref (v);
+    }
+
+  g_ptr_array_set_size (solver->infeasible_rows, 0);
+}
+
 void
 simplex_solver_init (SimplexSolver *solver)
 {
@@ -252,10 +658,8 @@ simplex_solver_init (SimplexSolver *solver)
                                                  (GDestroyNotify) variable_unref,
                                                  NULL);
 
-  /* HashSet<Variable>; owns keys */
-  solver->infeasible_rows = g_hash_table_new_full (NULL, NULL,
-                                                   (GDestroyNotify) variable_unref,
-                                                   NULL);
+  /* Vec<Variable>; owns a reference on each queued variable */
+  solver->infeasible_rows = g_ptr_array_new ();
 
   /* HashSet<Variable>; owns keys */
   solver->external_parametric_vars = g_hash_table_new_full (NULL, NULL,
@@ -291,47 +695,126 @@ simplex_solver_init (SimplexSolver *solver)
   /* HashSet<Constraint> */
   solver->constraints = g_hash_table_new_full (NULL, NULL, constraint_free, NULL);
 
+  /* HashSet<Constraint>; the constraints taken out of the tableau by
+   * simplex_solver_disable_constraints()
+   */
+  solver->disabled_constraints = g_hash_table_new_full (NULL, NULL, constraint_free, NULL);
+
+  /* HashTable<Variable, AliasInfo>; does not own keys, but owns values */
+  solver->alias_vars = g_hash_table_new_full (NULL, NULL, NULL, alias_info_free);
+
+  /* HashTable<Constraint, AliasInfo>; owns neither keys nor values */
+  solver->alias_constraints = g_hash_table_new (NULL, NULL);
+
+  /* HashTable<Variable, int>; counts the aliases of a representative */
+  solver->alias_representatives = g_hash_table_new (NULL, NULL);
+
+  /* Vec<Constraint>; the constraints solved by the difference engine */
+  solver->difference_constraints = g_ptr_array_new ();
+  solver->difference_mode = true;
+
   solver->slack_counter = 0;
   solver->dummy_counter = 0;
   solver->artificial_counter = 0;
 
+  solver->pivot_count = 0;
+  solver->degenerate_pivot_count = 0;
+  solver->bland_fallback_count = 0;
+  solver->fill_in_count = 0;
+  solver->fast_resolve_count = 0;
+  solver->row_lookup_count = 0;
+
+  solver->compiled_basis = NULL;
+  solver->has_pending_edits = false;
+
   solver->needs_solving = false;
   solver->auto_solve = true;
   solver->initialized = true;
 }
 
+char *
+simplex_solver_get_statistics (SimplexSolver *solver)
+{
+  GHashTableIter iter;
+  gpointer value_p;
+  int n_terms = 0, n_bounds = 0;
+  double n_cells;
+  GString *buf;
+
+  if (!solver->initialized)
+    return NULL;
+
+  buf = g_string_new (NULL);
+
+  g_string_append_printf (buf, "- Rows: %d, Columns: %d\n",
+                          g_hash_table_size (solver->rows),
+                          g_hash_table_size (solver->columns));
+  g_string_append_printf (buf, "- Slack variables: %d\n", solver->slack_counter);
+  g_string_append_printf (buf, "- Error variables: %d (pairs: %d)\n",
+                          g_hash_table_size (solver->error_vars),
+                          solver->stay_error_vars->len);
+  g_string_append_printf (buf, "- Marker variables: %d\n", g_hash_table_size (solver->marker_vars));
+  g_string_append_printf (buf, "- Infeasible rows: %d\n", solver->infeasible_rows->len);
+  g_string_append_printf (buf, "- External rows: %d\n", g_hash_table_size (solver->external_rows));
+  g_string_append_printf (buf, "- Edit: %d, Stay: %d\n",
+                          g_hash_table_size (solver->edit_var_map),
+                          g_hash_table_size (solver->stay_var_map));
+  g_hash_table_iter_init (&iter, solver->alias_vars);
+  while (g_hash_table_iter_next (&iter, NULL, &value_p))
+    {
+      AliasInfo *alias = value_p;
+
+      if (constraint_is_inequality (alias->constraint))
+        n_bounds += 1;
+    }
+
+  g_string_append_printf (buf, "- Aliases: %d (substituted bounds: %d)\n",
+                          g_hash_table_size (solver->alias_vars),
+                          n_bounds);
+  if (solver->difference_mode)
+    g_string_append_printf (buf, "- Difference constraints: %d\n", solver->difference_constraints->len);
+  g_string_append_printf (buf, "- Optimizations: %d (fast resolves: %d)\n",
+                          solver->optimize_count,
+                          solver->fast_resolve_count);
+  g_string_append_printf (buf, "- Edit and stay row lookups: %d\n", solver->row_lookup_count);
+  g_string_append_printf (buf, "- Compactions: %d\n", solver->compact_count);
+  g_string_append_printf (buf, "- Pivots: %d (degenerate: %d, Bland's rule fallbacks: %d)\n",
+                          solver->pivot_count,
+                          solver->degenerate_pivot_count,
+                          solver->bland_fallback_count);
+
+  g_hash_table_iter_init (&iter, solver->rows);
+  while (g_hash_table_iter_next (&iter, NULL, &value_p))
+    n_terms += expression_get_n_terms (value_p);
+
+  n_cells = g_hash_table_size (solver->rows) * g_hash_table_size (solver->columns);
+
+  g_string_append_printf (buf, "- Tableau: %d terms (density: %.2f%%), fill-in: %d",
+                          n_terms,
+                          n_cells > 0 ? (double) n_terms / n_cells * 100.0 : 0.0,
+                          solver->fill_in_count);
+
+  return g_string_free (buf, FALSE);
+}
+
 void
 simplex_solver_clear (SimplexSolver *solver)
 {
   if (!solver->initialized)
     return;
 
-  solver->initialized = false;
-
 #ifdef EMEUS_ENABLE_DEBUG
   {
-    g_debug ("Solver [%p]:\n"
-             "- Rows: %d, Columns: %d\n"
-             "- Slack variables: %d\n"
-             "- Error variables: %d (pairs: %d)\n"
-             "- Marker variables: %d\n"
-             "- Infeasible rows: %d\n"
-             "- External rows: %d\n"
-             "- Edit: %d, Stay: %d",
-             solver,
-             g_hash_table_size (solver->rows),
-             g_hash_table_size (solver->columns),
-             solver->slack_counter,
-             g_hash_table_size (solver->error_vars),
-             solver->stay_error_vars->len,
-             g_hash_table_size (solver->marker_vars),
-             g_hash_table_size (solver->infeasible_rows),
-             g_hash_table_size (solver->external_rows),
-             g_hash_table_size (solver->edit_var_map),
-             g_hash_table_size (solver->stay_var_map));
+    char *stats = simplex_solver_get_statistics (solver);
+
+    g_debug ("Solver [%p]:\n%s", solver, stats);
+
+    g_free (stats);
   }
 #endif
 
+  solver->initialized = false;
+
   solver->objective = NULL;
 
   solver->needs_solving = false;
@@ -343,20 +826,114 @@ simplex_solver_clear (SimplexSolver *solver)
 
   g_clear_pointer (&solver->stay_error_vars, g_ptr_array_unref);
 
+  simplex_solver_clear_infeasible_rows (solver);
+  g_clear_pointer (&solver->infeasible_rows, g_ptr_array_unref);
+
   g_clear_pointer (&solver->external_rows, g_hash_table_unref);
-  g_clear_pointer (&solver->infeasible_rows, g_hash_table_unref);
   g_clear_pointer (&solver->external_parametric_vars, g_hash_table_unref);
   g_clear_pointer (&solver->error_vars, g_hash_table_unref);
   g_clear_pointer (&solver->marker_vars, g_hash_table_unref);
   g_clear_pointer (&solver->edit_var_map, g_hash_table_unref);
   g_clear_pointer (&solver->stay_var_map, g_hash_table_unref);
+  g_clear_pointer (&solver->alias_constraints, g_hash_table_unref);
+  g_clear_pointer (&solver->alias_representatives, g_hash_table_unref);
+  g_clear_pointer (&solver->alias_vars, g_hash_table_unref);
+  g_clear_pointer (&solver->difference_constraints, g_ptr_array_unref);
+  g_clear_pointer (&solver->difference_graph, difference_graph_free);
+  g_clear_pointer (&solver->compiled_basis, parametric_solution_free);
+  g_clear_pointer (&solver->forked_variables, g_hash_table_unref);
+  g_clear_pointer (&solver->forked_constraints, g_hash_table_unref);
+  g_clear_pointer (&solver->journal, journal_free);
+  g_clear_pointer (&solver->image, g_bytes_unref);
   g_clear_pointer (&solver->constraints, g_hash_table_unref);
+  g_clear_pointer (&solver->disabled_constraints, g_hash_table_unref);
 
   /* The columns need to be deleted last, for reference counting */
   g_clear_pointer (&solver->rows, g_hash_table_unref);
   g_clear_pointer (&solver->columns, g_hash_table_unref);
 }
 
+/**
+ * simplex_solver_reset:
+ * @solver: a #SimplexSolver
+ *
+ * Removes every constraint and variable from @solver, and brings it
+ * back to the state of a newly initialized solver.
+ *
+ * Unlike calling simplex_solver_clear() and simplex_solver_init(),
+ * the tables and arrays of @solver are emptied instead of being freed
+ * and allocated again, which makes resetting a solver that is going
+ * to be filled again cheaper. The settings of @solver, like whether
+ * it solves automatically, are preserved.
+ */
+void
+simplex_solver_reset (SimplexSolver *solver)
+{
+  if (!solver->initialized)
+    return;
+
+  /* The journal refers to the rows we are about to remove */
+  g_clear_pointer (&solver->journal, journal_free);
+  g_clear_pointer (&solver->compiled_basis, parametric_solution_free);
+  g_clear_pointer (&solver->forked_variables, g_hash_table_unref);
+  g_clear_pointer (&solver->forked_constraints, g_hash_table_unref);
+
+  g_ptr_array_set_size (solver->stay_error_vars, 0);
+
+  simplex_solver_clear_infeasible_rows (solver);
+
+  g_hash_table_remove_all (solver->external_rows);
+  g_hash_table_remove_all (solver->external_parametric_vars);
+  g_hash_table_remove_all (solver->error_vars);
+  g_hash_table_remove_all (solver->marker_vars);
+  g_hash_table_remove_all (solver->edit_var_map);
+  g_hash_table_remove_all (solver->stay_var_map);
+  g_hash_table_remove_all (solver->alias_constraints);
+  g_hash_table_remove_all (solver->alias_representatives);
+  g_hash_table_remove_all (solver->alias_vars);
+  g_hash_table_remove_all (solver->constraints);
+  g_hash_table_remove_all (solver->disabled_constraints);
+
+  if (solver->difference_constraints != NULL)
+    g_ptr_array_set_size (solver->difference_constraints, 0);
+  else
+    solver->difference_constraints = g_ptr_array_new ();
+
+  g_clear_pointer (&solver->difference_graph, difference_graph_free);
+
+  /* Keep the objective variable alive while emptying the rows, as
+   * the rows table owns it
+   */
+  variable_ref (solver->objective);
+  g_hash_table_remove_all (solver->rows);
+  g_hash_table_remove_all (solver->columns);
+  g_hash_table_insert (solver->rows, solver->objective, expression_new (solver, 0.0));
+
+  solver->slack_counter = 0;
+  solver->dummy_counter = 0;
+  solver->artificial_counter = 0;
+  solver->optimize_count = 0;
+
+  solver->pivot_count = 0;
+  solver->degenerate_pivot_count = 0;
+  solver->bland_fallback_count = 0;
+  solver->fill_in_count = 0;
+  solver->fast_resolve_count = 0;
+  solver->row_lookup_count = 0;
+
+  solver->removals_since_compact = 0;
+  solver->compact_count = 0;
+
+  /* Solutions computed before the reset are not valid any more */
+  solver->serial += 1;
+
+  solver->difference_mode = true;
+  solver->needs_solving = false;
+  solver->n_degenerate_pivots = 0;
+  solver->use_bland = false;
+  solver->has_pending_edits = false;
+}
+
 static VariableSet *
 simplex_solver_get_column_set (SimplexSolver *solver,
                                Variable *param_var)
@@ -367,6 +944,18 @@ simplex_solver_get_column_set (SimplexSolver *solver,
   return g_hash_table_lookup (solver->columns, param_var);
 }
 
+static int
+simplex_solver_get_column_size (SimplexSolver *solver,
+                                Variable *param_var)
+{
+  VariableSet *set = g_hash_table_lookup (solver->columns, param_var);
+
+  if (set == NULL)
+    return 0;
+
+  return variable_set_get_size (set);
+}
+
 static bool
 simplex_solver_column_has_key (SimplexSolver *solver,
                                Variable *subject)
@@ -392,6 +981,9 @@ simplex_solver_insert_column_variable (SimplexSolver *solver,
     {
       set = variable_set_new ();
       g_hash_table_insert (solver->columns, variable_ref (param_var), set);
+
+      if (solver->journal != NULL)
+        g_hash_table_add (solver->journal->columns, variable_ref (param_var));
     }
 
   if (row_var != NULL)
@@ -426,14 +1018,24 @@ simplex_solver_reset_stay_constants (SimplexSolver *solver)
   for (i = 0; i < solver->stay_error_vars->len; i++)
     {
       VariablePair *pair = g_ptr_array_index (solver->stay_error_vars, i);
+      Variable *subject = pair->first;
       Expression *expression;
 
-      expression = g_hash_table_lookup (solver->rows, pair->first);
+      solver->row_lookup_count += 1;
+
+      expression = g_hash_table_lookup (solver->rows, subject);
       if (expression == NULL)
-        expression = g_hash_table_lookup (solver->rows, pair->second);
+        {
+          subject = pair->second;
+          expression = g_hash_table_lookup (solver->rows, subject);
+        }
 
-      if (expression != NULL)
-        expression_set_constant (expression, 0.0);
+      if (expression != NULL && expression_get_constant (expression) != 0.0)
+        {
+          simplex_solver_journal_row (solver, subject);
+          expression_set_constant (expression, 0.0);
+          g_clear_pointer (&solver->compiled_basis, parametric_solution_free);
+        }
     }
 }
 
@@ -441,7 +1043,7 @@ static void
 simplex_solver_set_external_variables (SimplexSolver *solver)
 {
   GHashTableIter iter;
-  gpointer key_p;
+  gpointer key_p, value_p;
 
   g_hash_table_iter_init (&iter, solver->external_parametric_vars);
   while (g_hash_table_iter_next (&iter, &key_p, NULL))
@@ -465,13 +1067,37 @@ simplex_solver_set_external_variables (SimplexSolver *solver)
       variable_set_value (variable, expression_get_constant (expression));
     }
 
-  solver->needs_solving = false;
-}
+  /* Aliased variables never enter the tableau, so we compute their
+   * value from the value of their representative; a representative
+   * that is not in the tableau either is a parametric variable
+   */
+  g_hash_table_iter_init (&iter, solver->alias_vars);
+  while (g_hash_table_iter_next (&iter, NULL, &value_p))
+    {
+      AliasInfo *alias = value_p;
+      Variable *representative = alias->representative;
+      Expression *expression;
+      double value;
 
-typedef struct {
-  SimplexSolver *solver;
-  Variable *subject;
-} ForeachClosure;
+      /* The representative of a bound is not an external variable */
+      expression = g_hash_table_lookup (solver->rows, representative);
+      if (expression == NULL)
+        variable_set_value (representative, 0.0);
+      else
+        variable_set_value (representative, expression_get_constant (expression));
+
+      value = representative->value * alias->scale + alias->offset;
+
+      variable_set_value (alias->variable, value);
+    }
+
+  solver->needs_solving = false;
+}
+
+typedef struct {
+  SimplexSolver *solver;
+  Variable *subject;
+} ForeachClosure;
 
 static bool
 insert_expression_columns (Term *term,
@@ -500,6 +1126,8 @@ simplex_solver_add_row (SimplexSolver *solver,
   if (!solver->initialized)
     return;
 
+  simplex_solver_journal_row (solver, variable);
+
   g_hash_table_insert (solver->rows, variable_ref (variable), expression_ref (expression));
 
   data.subject = variable;
@@ -529,6 +1157,7 @@ simplex_solver_remove_column (SimplexSolver *solver,
     {
       Expression *e = g_hash_table_lookup (solver->rows, v);
 
+      simplex_solver_journal_row (solver, v);
       expression_remove_variable (e, variable, NULL);
     }
 
@@ -566,6 +1195,11 @@ simplex_solver_remove_row (SimplexSolver *solver,
   e = g_hash_table_lookup (solver->rows, variable);
   g_assert (e != NULL);
 
+  simplex_solver_journal_row (solver, variable);
+
+  /* The compiled basis caches the rows of the tableau */
+  g_clear_pointer (&solver->compiled_basis, parametric_solution_free);
+
   expression_ref (e);
 
   data.solver = solver;
@@ -574,8 +1208,6 @@ simplex_solver_remove_row (SimplexSolver *solver,
                             remove_expression_columns,
                             &data);
 
-  g_hash_table_remove (solver->infeasible_rows, variable);
-
   if (variable_is_external (variable))
     g_hash_table_remove (solver->external_rows, variable);
 
@@ -604,11 +1236,17 @@ simplex_solver_substitute_out (SimplexSolver *solver,
       while (variable_set_iter_next (&iter, &v))
         {
           Expression *row = g_hash_table_lookup (solver->rows, v);
+          int n_terms = expression_get_n_terms (row);
 
+          simplex_solver_journal_row (solver, v);
           expression_substitute_out (row, old_variable, expression, v);
 
+          /* Keep track of how much the substitution densified the tableau */
+          if (expression_get_n_terms (row) > n_terms)
+            solver->fill_in_count += expression_get_n_terms (row) - n_terms;
+
           if (variable_is_restricted (v) && expression_get_constant (row) < 0)
-            g_hash_table_add (solver->infeasible_rows, variable_ref (v));
+            simplex_solver_queue_infeasible_row (solver, v);
         }
     }
 
@@ -636,6 +1274,8 @@ simplex_solver_pivot (SimplexSolver *solver,
   if (exit_var == NULL)
     g_critical ("No exit variable for pivot");
 
+  solver->pivot_count += 1;
+
   expr = simplex_solver_remove_row (solver, exit_var);
   expression_change_subject (expr, exit_var, entry_var);
 
@@ -645,9 +1285,58 @@ simplex_solver_pivot (SimplexSolver *solver,
   expression_unref (expr);
 }
 
+/* Number of consecutive degenerate pivots after which the optimization
+ * switches to Bland's rule, which is slower to converge but guaranteed
+ * not to cycle
+ */
+#define DEGENERATE_PIVOTS_THRESHOLD     8
+
+/* The amount of work an optimization can do before returning */
+typedef struct {
+  /* The maximum number of pivots, or 0 */
+  int max_pivots;
+  int n_pivots;
+
+  /* The monotonic time at which to stop, or 0 */
+  gint64 deadline;
+} SolverBudget;
+
+static void
+solver_budget_init (SolverBudget *budget,
+                    int max_pivots,
+                    gint64 max_time)
+{
+  budget->max_pivots = MAX (max_pivots, 0);
+  budget->n_pivots = 0;
+  budget->deadline = max_time > 0 ? g_get_monotonic_time () + max_time : 0;
+}
+
+/* Accounts for a pivot, and checks whether the budget is spent; at least
+ * one pivot is always allowed, so that each call makes progress
+ */
+static bool
+solver_budget_spend_pivot (SolverBudget *budget)
+{
+  if (budget == NULL)
+    return false;
+
+  budget->n_pivots += 1;
+
+  if (budget->max_pivots > 0 && budget->n_pivots >= budget->max_pivots)
+    return true;
+
+  if (budget->deadline > 0 && g_get_monotonic_time () >= budget->deadline)
+    return true;
+
+  return false;
+}
+
 typedef struct {
+  SimplexSolver *solver;
   double objective_coefficient;
+  double scale;
   Variable *entry_variable;
+  int entry_column_size;
 } NegativeClosure;
 
 static bool
@@ -658,9 +1347,52 @@ find_negative_coefficient (Term *term,
   double coefficient = term_get_coefficient (term);
   NegativeClosure *data = data_;
 
-  if (variable_is_pivotable (variable) && coefficient < data->objective_coefficient)
+  data->scale = MAX (data->scale, fabs (coefficient));
+
+  if (!variable_is_pivotable (variable) || coefficient >= 0.0)
+    return true;
+
+  /* Dantzig's rule: pick the most negative coefficient; since the
+   * coefficients come from a handful of strengths, ties are common,
+   * and we break them by picking the variable with the smallest
+   * column, as the pivot has to substitute the new row into each
+   * row of the column
+   */
+  if (data->entry_variable == NULL ||
+      (coefficient < data->objective_coefficient && !approx_val (coefficient, data->objective_coefficient)))
+    {
+      data->objective_coefficient = coefficient;
+      data->entry_variable = variable;
+      data->entry_column_size = simplex_solver_get_column_size (data->solver, variable);
+    }
+  else if (approx_val (coefficient, data->objective_coefficient))
+    {
+      int column_size = simplex_solver_get_column_size (data->solver, variable);
+
+      if (column_size < data->entry_column_size)
+        {
+          data->objective_coefficient = coefficient;
+          data->entry_variable = variable;
+          data->entry_column_size = column_size;
+        }
+    }
+
+  return true;
+}
+
+static bool
+find_first_negative_coefficient (Term *term,
+                                 gpointer data_)
+{
+  Variable *variable = term_get_variable (term);
+  double coefficient = term_get_coefficient (term);
+  NegativeClosure *data = data_;
+
+  /* Bland's rule: the terms are visited in ascending id order, so we
+   * stop at the first coefficient that is negative enough
+   */
+  if (variable_is_pivotable (variable) && !approx_zero (coefficient, data->scale) && coefficient < 0.0)
     {
-      /* Stop at the first negative coefficient */
       data->objective_coefficient = coefficient;
       data->entry_variable = variable;
       return false;
@@ -669,15 +1401,23 @@ find_negative_coefficient (Term *term,
   return true;
 }
 
-static void
-simplex_solver_optimize (SimplexSolver *solver,
-                         Variable *z)
+/* Runs the primal simplex on the row of @z; each pivot keeps the tableau
+ * feasible, so if @budget is spent before reaching the optimum, the
+ * optimization can be resumed by calling this function again.
+ *
+ * Returns: %true if the optimum was reached
+ */
+static bool
+simplex_solver_optimize_with_budget (SimplexSolver *solver,
+                                     Variable *z,
+                                     SolverBudget *budget)
 {
   Variable *entry, *exit;
   Expression *z_row;
+  bool res = true;
 
   if (!solver->initialized)
-    return;
+    return true;
 
   z_row = g_hash_table_lookup (solver->rows, z);
   g_assert (z_row != NULL);
@@ -698,19 +1438,33 @@ simplex_solver_optimize (SimplexSolver *solver,
       Variable *v;
       double min_ratio;
       double r;
+      int exit_size;
 
+      data.solver = solver;
       data.objective_coefficient = 0.0;
+      data.scale = 0.0;
       data.entry_variable = NULL;
+      data.entry_column_size = 0;
 
       expression_terms_foreach (z_row, find_negative_coefficient, &data);
 
-      if (data.objective_coefficient >= -DBL_EPSILON || data.entry_variable == NULL)
+      if (data.entry_variable == NULL || approx_zero (data.objective_coefficient, data.scale))
         break;
 
+      if (solver->use_bland)
+        {
+          data.objective_coefficient = 0.0;
+          data.entry_variable = NULL;
+
+          expression_terms_foreach (z_row, find_first_negative_coefficient, &data);
+        }
+
       entry = data.entry_variable;
 
       min_ratio = DBL_MAX;
       r = 0;
+      exit = NULL;
+      exit_size = 0;
 
       column_vars = simplex_solver_get_column_set (solver, entry);
       if (column_vars == NULL)
@@ -726,23 +1480,77 @@ simplex_solver_optimize (SimplexSolver *solver,
 
               if (coeff < 0.0)
                 {
+                  int size = expression_get_n_terms (expr);
+
                   r = -1.0 * expression_get_constant (expr) / coeff;
-                  if (r < min_ratio)
+
+                  /* Ties are broken by picking the shortest row, as it's
+                   * the row that gets substituted into the entry column;
+                   * Bland's rule requires picking the lowest id instead
+                   */
+                  if (exit == NULL || (r < min_ratio && !approx_val (r, min_ratio)))
                     {
                       min_ratio = r;
                       exit = v;
+                      exit_size = size;
+                    }
+                  else if (approx_val (r, min_ratio))
+                    {
+                      bool replace;
+
+                      if (solver->use_bland || size == exit_size)
+                        replace = v->id_ < exit->id_;
+                      else
+                        replace = size < exit_size;
+
+                      if (replace)
+                        {
+                          exit = v;
+                          exit_size = size;
+                        }
                     }
                 }
             }
         }
 
-      if (min_ratio == DBL_MAX)
+      if (exit == NULL)
         {
           g_critical ("Unbounded objective variable during optimization");
           break;
         }
 
+      /* A pivot with a zero ratio does not improve the objective; a long
+       * enough sequence of them is a sign that we are cycling. The count
+       * is kept across calls, as an optimization that is resumed could
+       * otherwise cycle forever with a small budget
+       */
+      if (approx_zero (min_ratio, 1.0))
+        {
+          solver->degenerate_pivot_count += 1;
+          solver->n_degenerate_pivots += 1;
+
+          if (!solver->use_bland && solver->n_degenerate_pivots >= DEGENERATE_PIVOTS_THRESHOLD)
+            {
+              solver->bland_fallback_count += 1;
+              solver->use_bland = true;
+            }
+        }
+      else
+        solver->n_degenerate_pivots = 0;
+
       simplex_solver_pivot (solver, entry, exit);
+
+      if (solver_budget_spend_pivot (budget))
+        {
+          res = false;
+          break;
+        }
+    }
+
+  if (res)
+    {
+      solver->n_degenerate_pivots = 0;
+      solver->use_bland = false;
     }
 
 #ifdef EMEUS_ENABLE_DEBUG
@@ -750,6 +1558,15 @@ simplex_solver_optimize (SimplexSolver *solver,
            (float) (g_get_monotonic_time () - start_time) / 1000.f,
            solver->optimize_count);
 #endif
+
+  return res;
+}
+
+static void
+simplex_solver_optimize (SimplexSolver *solver,
+                         Variable *z)
+{
+  simplex_solver_optimize_with_budget (solver, z, NULL);
 }
 
 typedef struct {
@@ -765,7 +1582,19 @@ replace_terms (Term *term,
   double c = term_get_coefficient (term);
   ReplaceClosure *data = data_;
 
-  Expression *e = g_hash_table_lookup (data->solver->rows, v);
+  AliasInfo *alias = g_hash_table_lookup (data->solver->alias_vars, v);
+  Expression *e;
+
+  /* Replace an aliased variable with its representative */
+  if (alias != NULL)
+    {
+      expression_set_constant (data->expr, expression_get_constant (data->expr) + c * alias->offset);
+
+      v = alias->representative;
+      c = c * alias->scale;
+    }
+
+  e = g_hash_table_lookup (data->solver->rows, v);
 
   if (e == NULL)
     expression_add_variable (data->expr, v, c, NULL);
@@ -836,6 +1665,7 @@ simplex_solver_new_expression (SimplexSolver *solver,
           expression_set_variable (expr, eminus, 1.0);
           variable_unref (eminus);
 
+          simplex_solver_journal_row (solver, solver->objective);
           z_row = g_hash_table_lookup (solver->rows, solver->objective);
           expression_set_variable (z_row, eminus, constraint->strength);
 
@@ -890,6 +1720,7 @@ simplex_solver_new_expression (SimplexSolver *solver,
 
           g_hash_table_insert (solver->marker_vars, constraint, eplus);
 
+          simplex_solver_journal_row (solver, solver->objective);
           z_row = g_hash_table_lookup (solver->rows, solver->objective);
 
           expression_set_variable (z_row, eplus, constraint->strength);
@@ -951,39 +1782,34 @@ find_ratio (Term *term,
   return true;
 }
 
-static void
-simplex_solver_dual_optimize (SimplexSolver *solver)
+/* Runs the dual simplex on the infeasible rows; each pivot keeps the
+ * tableau optimal, and the rows left in the worklist when @budget is
+ * spent are picked up by the next call.
+ *
+ * Returns: %true if all the rows are feasible
+ */
+static bool
+simplex_solver_dual_optimize_with_budget (SimplexSolver *solver,
+                                          SolverBudget *budget)
 {
   Expression *z_row = g_hash_table_lookup (solver->rows, solver->objective);
-  GHashTableIter iter;
-  gpointer key_p, value_p;
+  Variable *exit_var;
+  bool res = true;
 
 #ifdef EMEUS_ENABLE_DEBUG
   gint64 start_time = g_get_monotonic_time ();
 #endif
 
-  g_hash_table_iter_init (&iter, solver->infeasible_rows);
-  while (g_hash_table_iter_next (&iter, &key_p, &value_p))
+  /* Pivoting can queue new infeasible rows, so we keep popping the
+   * most infeasible row until the worklist is empty
+   */
+  while ((exit_var = simplex_solver_pop_infeasible_row (solver)) != NULL)
     {
-      Variable *entry_var, *exit_var;
+      Variable *entry_var;
       Expression *expr;
       RatioClosure data;
 
-      exit_var = variable_ref (key_p);
-      g_hash_table_iter_remove (&iter);
-
       expr = g_hash_table_lookup (solver->rows, exit_var);
-      if (expr == NULL)
-        {
-          variable_unref (exit_var);
-          continue;
-        }
-
-      if (expression_get_constant (expr) >= 0.0)
-        {
-          variable_unref (exit_var);
-          continue;
-        }
 
       data.ratio = DBL_MAX;
       data.entry = NULL;
@@ -994,12 +1820,22 @@ simplex_solver_dual_optimize (SimplexSolver *solver)
 
       if (entry_var != NULL && !approx_val (data.ratio, DBL_MAX))
         simplex_solver_pivot (solver, entry_var, exit_var);
+
+      variable_unref (exit_var);
+
+      if (solver_budget_spend_pivot (budget) && solver->infeasible_rows->len > 0)
+        {
+          res = false;
+          break;
+        }
     }
 
 #ifdef EMEUS_ENABLE_DEBUG
   g_debug ("dual_optimize.time := %.3f ms",
            (float) (g_get_monotonic_time () - start_time) / 1000.f);
 #endif
+
+  return res;
 }
 
 static void
@@ -1015,16 +1851,21 @@ simplex_solver_delta_edit_constant (SimplexSolver *solver,
 
   if (!solver->initialized)
     return;
-  
+
+  g_clear_pointer (&solver->compiled_basis, parametric_solution_free);
+
+  solver->row_lookup_count += 1;
+
   plus_expr = g_hash_table_lookup (solver->rows, plus_error_var);
   if (plus_expr != NULL)
     {
       double new_constant = expression_get_constant (plus_expr) + delta;
 
+      simplex_solver_journal_row (solver, plus_error_var);
       expression_set_constant (plus_expr, new_constant);
 
       if (new_constant < 0.0)
-        g_hash_table_add (solver->infeasible_rows, variable_ref (plus_error_var));
+        simplex_solver_queue_infeasible_row (solver, plus_error_var);
 
       return;
     }
@@ -1034,10 +1875,11 @@ simplex_solver_delta_edit_constant (SimplexSolver *solver,
     {
       double new_constant = expression_get_constant (minus_expr) - delta;
 
+      simplex_solver_journal_row (solver, minus_error_var);
       expression_set_constant (minus_expr, new_constant);
 
       if (new_constant < 0.0)
-        g_hash_table_add (solver->infeasible_rows, variable_ref (minus_error_var));
+        simplex_solver_queue_infeasible_row (solver, minus_error_var);
 
       return;
     }
@@ -1059,10 +1901,11 @@ simplex_solver_delta_edit_constant (SimplexSolver *solver,
       c = expression_get_coefficient (expr, minus_error_var);
 
       new_constant = expression_get_constant (expr) + (c * delta);
+      simplex_solver_journal_row (solver, basic_var);
       expression_set_constant (expr, new_constant);
 
       if (variable_is_restricted (basic_var) && new_constant < 0.0)
-        g_hash_table_add (solver->infeasible_rows, variable_ref (basic_var));
+        simplex_solver_queue_infeasible_row (solver, basic_var);
     }
 }
 
@@ -1072,9 +1915,9 @@ simplex_solver_choose_subject (SimplexSolver *solver,
 {
   Variable *subject = NULL;
   Variable *retval = NULL;
-  bool found_unrestricted = false;
   bool found_new_restricted = false;
   bool retval_found = false;
+  int retval_column_size = 0;
   double coeff = 0.0;
   GHashTableIter iter;
   gpointer value_p;
@@ -1086,38 +1929,36 @@ simplex_solver_choose_subject (SimplexSolver *solver,
       Variable *v = term_get_variable (t);
       double c = term_get_coefficient (t);
 
-      if (found_unrestricted)
+      if (variable_is_restricted (v))
         {
-          if (!variable_is_restricted (v))
+          if (!found_new_restricted && !variable_is_dummy (v) && c < 0.0)
             {
-              if (!g_hash_table_contains (solver->columns, v))
+              VariableSet *cset = g_hash_table_lookup (solver->columns, v);
+
+              if (cset == NULL ||
+                  (variable_set_get_size (cset) == 1 && g_hash_table_contains (solver->columns, solver->objective)))
                 {
-                  retval_found = true;
-                  retval = v;
-                  break;
+                  subject = v;
+                  found_new_restricted = true;
                 }
             }
         }
       else
         {
-          if (variable_is_restricted (v))
-            {
-              if (!found_new_restricted && !variable_is_dummy (v) && c < 0.0)
-                {
-                  VariableSet *cset = g_hash_table_lookup (solver->columns, v);
+          /* Any unrestricted variable can be the subject, but the new row
+           * has to be substituted into every row of the subject's column;
+           * the row length is the same for every candidate, so we pick
+           * the smallest column to minimize the fill-in
+           */
+          int column_size = simplex_solver_get_column_size (solver, v);
 
-                  if (cset == NULL ||
-                      (variable_set_get_size (cset) == 1 && g_hash_table_contains (solver->columns, solver->objective)))
-                    {
-                      subject = v;
-                      found_new_restricted = true;
-                    }
-                }
-            }
-          else
+          if (!retval_found ||
+              column_size < retval_column_size ||
+              (column_size == retval_column_size && v->id_ < retval->id_))
             {
-              subject = v;
-              found_unrestricted = true;
+              retval_found = true;
+              retval = v;
+              retval_column_size = column_size;
             }
         }
     }
@@ -1186,46 +2027,77 @@ simplex_solver_try_adding_directly (SimplexSolver *solver,
   return true;
 }
 
-static void
-simplex_solver_add_with_artificial_variable (SimplexSolver *solver,
-                                             Expression *expression)
+static Variable *
+simplex_solver_new_artificial_variable (SimplexSolver *solver)
 {
-  Variable *av, *az;
-  Expression *az_row;
-  Expression *az_tableau_row;
-  Expression *e;
+  Variable *av = variable_new (solver, VARIABLE_SLACK);
 
-  if (!solver->initialized)
-    return;
-  
-  av = variable_new (solver, VARIABLE_SLACK);
   variable_set_prefix (av, "a");
   solver->artificial_counter += 1;
 
+  return av;
+}
+
+/* Minimizes @expression, a row of the tableau, using a temporary
+ * objective variable
+ *
+ * Returns: the minimum of @expression
+ */
+static double
+simplex_solver_minimize_row (SimplexSolver *solver,
+                             Expression *expression)
+{
+  Variable *az;
+  Expression *az_row;
+  double res;
+
   az = variable_new (solver, VARIABLE_OBJECTIVE);
   variable_set_name (az, "az");
 
   az_row = expression_clone (expression);
 
   simplex_solver_add_row (solver, az, az_row);
-  simplex_solver_add_row (solver, av, expression);
   simplex_solver_optimize (solver, az);
 
-  variable_unref (av);
-  variable_unref (az);
+  res = expression_get_constant (g_hash_table_lookup (solver->rows, az));
+
+  simplex_solver_remove_row (solver, az);
+
   expression_unref (az_row);
+  variable_unref (az);
+
+  return res;
+}
+
+/* Drives the artificial variable @av to zero and out of the tableau; if
+ * that is not possible, the constraint of @av cannot be satisfied, and
+ * its row is dropped
+ *
+ * Returns: true if the constraint of @av is satisfied
+ */
+static bool
+simplex_solver_remove_artificial_variable (SimplexSolver *solver,
+                                           Variable *av)
+{
+  Expression *e;
 
-  az_tableau_row = g_hash_table_lookup (solver->rows, az);
-  if (!approx_val (expression_get_constant (az_tableau_row), 0.0))
+  e = g_hash_table_lookup (solver->rows, av);
+  if (e != NULL && !approx_val (expression_get_constant (e), 0.0))
     {
-      simplex_solver_remove_row (solver, az);
-      simplex_solver_remove_column (solver, av);
+      if (!approx_val (simplex_solver_minimize_row (solver, e), 0.0))
+        {
+          if (g_hash_table_contains (solver->rows, av))
+            simplex_solver_remove_row (solver, av);
 
-      g_critical ("Unable to satisfy a required constraint");
-      return;
+          simplex_solver_remove_column (solver, av);
+
+          g_critical ("Unable to satisfy a required constraint");
+          return false;
+        }
+
+      e = g_hash_table_lookup (solver->rows, av);
     }
 
-  e = g_hash_table_lookup (solver->rows, av);
   if (e != NULL)
     {
       Variable *entry_var;
@@ -1233,8 +2105,7 @@ simplex_solver_add_with_artificial_variable (SimplexSolver *solver,
       if (expression_is_constant (e))
         {
           simplex_solver_remove_row (solver, av);
-          simplex_solver_remove_row (solver, az);
-          return;
+          return true;
         }
 
       entry_var = expression_get_pivotable_variable (e);
@@ -1244,7 +2115,60 @@ simplex_solver_add_with_artificial_variable (SimplexSolver *solver,
   g_assert (!g_hash_table_contains (solver->rows, av));
 
   simplex_solver_remove_column (solver, av);
-  simplex_solver_remove_row (solver, az);
+
+  return true;
+}
+
+static void
+simplex_solver_add_with_artificial_variable (SimplexSolver *solver,
+                                             Expression *expression)
+{
+  Variable *av;
+
+  if (!solver->initialized)
+    return;
+
+  av = simplex_solver_new_artificial_variable (solver);
+
+  simplex_solver_add_row (solver, av, expression);
+  simplex_solver_remove_artificial_variable (solver, av);
+
+  variable_unref (av);
+}
+
+/* Removes a batch of artificial variables added by
+ * simplex_solver_add_constraint_full(); a single phase I minimizes their
+ * sum, so the tableau is optimized once for the whole batch. Only the
+ * variables that are still positive afterwards, because their
+ * constraints conflict with the rest of the batch, are minimized on
+ * their own
+ */
+static void
+simplex_solver_remove_artificial_variables (SimplexSolver *solver,
+                                            GPtrArray *artificial_vars)
+{
+  int i;
+
+  if (artificial_vars->len > 1)
+    {
+      Expression *sum = expression_new (solver, 0.0);
+
+      for (i = 0; i < artificial_vars->len; i++)
+        {
+          Expression *e = g_hash_table_lookup (solver->rows, g_ptr_array_index (artificial_vars, i));
+
+          if (e != NULL)
+            expression_add_expression (sum, e, 1.0, NULL);
+        }
+
+      if (!expression_is_constant (sum))
+        simplex_solver_minimize_row (solver, sum);
+
+      expression_unref (sum);
+    }
+
+  for (i = 0; i < artificial_vars->len; i++)
+    simplex_solver_remove_artificial_variable (solver, g_ptr_array_index (artificial_vars, i));
 }
 
 void
@@ -1308,538 +2232,5329 @@ simplex_solver_create_expression (SimplexSolver *solver,
 }
 
 static void
-simplex_solver_add_constraint_internal (SimplexSolver *solver,
-                                        Constraint *constraint)
+simplex_solver_track_constraint (SimplexSolver *solver,
+                                 Constraint *constraint)
 {
-  Expression *expr;
-  Variable *eplus;
-  Variable *eminus;
-  double prev_constant;
+  /* Constraints can be added back after being removed from the tableau,
+   * and replacing the key would free the constraint
+   */
+  if (!g_hash_table_contains (solver->constraints, constraint))
+    g_hash_table_add (solver->constraints, constraint);
+}
 
-  expr = simplex_solver_new_expression (solver, constraint,
-                                        &eplus,
-                                        &eminus,
-                                        &prev_constant);
+static bool
+substitute_alias_terms (Term *term,
+                        gpointer data_)
+{
+  Variable *v = term_get_variable (term);
+  double c = term_get_coefficient (term);
+  ReplaceClosure *data = data_;
+  AliasInfo *alias = g_hash_table_lookup (data->solver->alias_vars, v);
 
-#ifdef EMEUS_ENABLE_DEBUG
-  {
-    char *str1 = constraint_to_string (constraint);
-    char *str2 = expression_to_string (expr);
+  if (alias != NULL)
+    {
+      expression_set_constant (data->expr, expression_get_constant (data->expr) + c * alias->offset);
+      expression_add_variable (data->expr, alias->representative, c * alias->scale, NULL);
+    }
+  else
+    expression_add_variable (data->expr, v, c, NULL);
 
-    g_debug ("Adding constraint: %s (normalized expression: %s)", str1, str2);
+  return true;
+}
 
-    g_free (str1);
-    g_free (str2);
-  }
-#endif
+/* A variable can be aliased only if nothing refers to it yet */
+static bool
+simplex_solver_can_alias_variable (SimplexSolver *solver,
+                                   Variable *variable)
+{
+  if (variable->type != VARIABLE_REGULAR)
+    return false;
 
-  if (constraint_is_stay (constraint))
-    {
-      StayInfo *si = g_slice_new (StayInfo);
+  return !g_hash_table_contains (solver->rows, variable) &&
+         !g_hash_table_contains (solver->columns, variable) &&
+         !g_hash_table_contains (solver->alias_vars, variable) &&
+         !g_hash_table_contains (solver->alias_representatives, variable);
+}
 
-      si->constraint = constraint;
+static void
+simplex_solver_remove_alias_info (SimplexSolver *solver,
+                                  AliasInfo *alias)
+{
+  int n_aliases;
 
-      g_hash_table_insert (solver->stay_var_map, constraint->variable, si);
-    }
+  simplex_solver_journal_removed (solver, alias->constraint);
+
+  n_aliases = GPOINTER_TO_INT (g_hash_table_lookup (solver->alias_representatives,
+                                                    alias->representative));
+  if (n_aliases > 1)
+    g_hash_table_insert (solver->alias_representatives,
+                         alias->representative,
+                         GINT_TO_POINTER (n_aliases - 1));
+  else
+    g_hash_table_remove (solver->alias_representatives, alias->representative);
+
+  g_hash_table_remove (solver->alias_constraints, alias->constraint);
+  g_hash_table_remove (solver->alias_vars, alias->variable);
+}
+
+/* Required equalities between two variables, e.g.
+ *
+ *   a = b * coefficient + constant
+ *
+ * are very common in layouts; instead of adding a row to the tableau
+ * for them, we can eliminate one of the two variables, and replace it
+ * with the other in every subsequent constraint. The aliases always
+ * point to the representative of their equivalence class, so we never
+ * have to follow a chain of aliases.
+ */
+static void simplex_solver_add_constraint_internal (SimplexSolver *solver,
+                                                    Constraint *constraint);
+
+static bool
+simplex_solver_try_adding_alias (SimplexSolver *solver,
+                                 Constraint *constraint)
+{
+  Variable *variable, *representative;
+  Term *first, *second, *alias_term, *rep_term;
+  ReplaceClosure data;
+  AliasInfo *alias;
+  Expression *expr;
+  int n_aliases;
+
+  if (!constraint_is_required (constraint) ||
+      constraint_is_inequality (constraint) ||
+      constraint_is_edit (constraint) ||
+      constraint_is_stay (constraint))
+    return false;
+
+  expr = expression_new (NULL, expression_get_constant (constraint->expression));
+
+  data.solver = solver;
+  data.expr = expr;
+  expression_terms_foreach (constraint->expression, substitute_alias_terms, &data);
+
+  if (expression_get_n_terms (expr) != 2)
+    {
+      expression_unref (expr);
+      return false;
+    }
+
+  /* The terms are sorted by descending variable id */
+  first = expr->ordered_terms->data;
+  second = expr->ordered_terms->next->data;
+
+  if (simplex_solver_can_alias_variable (solver, term_get_variable (first)))
+    {
+      alias_term = first;
+      rep_term = second;
+    }
+  else if (simplex_solver_can_alias_variable (solver, term_get_variable (second)))
+    {
+      alias_term = second;
+      rep_term = first;
+    }
+  else
+    {
+      expression_unref (expr);
+      return false;
+    }
+
+  variable = term_get_variable (alias_term);
+  representative = term_get_variable (rep_term);
+
+  /* a * variable + b * representative + constant = 0 */
+  alias = g_slice_new (AliasInfo);
+  alias->constraint = constraint;
+  alias->variable = variable_ref (variable);
+  alias->representative = variable_ref (representative);
+  alias->scale = -1.0 * term_get_coefficient (rep_term) / term_get_coefficient (alias_term);
+  alias->offset = -1.0 * expression_get_constant (expr) / term_get_coefficient (alias_term);
+
+  expression_unref (expr);
+
+  g_hash_table_insert (solver->alias_vars, variable, alias);
+  g_hash_table_insert (solver->alias_constraints, constraint, alias);
+
+  n_aliases = GPOINTER_TO_INT (g_hash_table_lookup (solver->alias_representatives, representative));
+  g_hash_table_insert (solver->alias_representatives, representative, GINT_TO_POINTER (n_aliases + 1));
+
+#ifdef EMEUS_ENABLE_DEBUG
+  {
+    char *str1 = variable_to_string (variable);
+    char *str2 = variable_to_string (representative);
+
+    g_debug ("Aliasing %s to %s * %g + %g", str1, str2, alias->scale, alias->offset);
+
+    g_free (str1);
+    g_free (str2);
+  }
+#endif
+
+  solver->needs_solving = true;
+
+  if (solver->auto_solve)
+    simplex_solver_set_external_variables (solver);
+
+  simplex_solver_track_constraint (solver, constraint);
+
+  return true;
+}
+
+/* Required bounds on a single variable, e.g.
+ *
+ *   variable >= constant
+ *   variable <= constant
+ *
+ * do not need a row and a slack variable in the tableau if nothing refers
+ * to the variable yet: we can replace the variable with a new restricted
+ * variable, shifted by the bound and negated for upper bounds, and let
+ * the simplex keep the latter non-negative, like it does for slacks.
+ * The bounded variables are stored as aliases of the restricted one.
+ *
+ * This is only a change of variable, not a bounded-variable simplex: the
+ * ratio test and the dual step know nothing about bounds, so only the
+ * first required bound on a variable that is not in the tableau can be
+ * substituted. A second bound on the same variable, a bound on a variable
+ * that already has a row or a column, and non-required bounds still add
+ * a row, like any other inequality.
+ */
+static bool
+simplex_solver_try_adding_bound (SimplexSolver *solver,
+                                 Constraint *constraint)
+{
+  Variable *variable, *bound_var;
+  ReplaceClosure data;
+  AliasInfo *alias;
+  Expression *expr;
+  double coefficient;
+  Term *term;
+
+  if (!constraint_is_required (constraint) ||
+      !constraint_is_inequality (constraint) ||
+      constraint_is_edit (constraint) ||
+      constraint_is_stay (constraint))
+    return false;
+
+  expr = expression_new (NULL, expression_get_constant (constraint->expression));
+
+  data.solver = solver;
+  data.expr = expr;
+  expression_terms_foreach (constraint->expression, substitute_alias_terms, &data);
+
+  if (expression_get_n_terms (expr) != 1)
+    {
+      expression_unref (expr);
+      return false;
+    }
+
+  term = expr->ordered_terms->data;
+  variable = term_get_variable (term);
+  coefficient = term_get_coefficient (term);
+
+  if (!simplex_solver_can_alias_variable (solver, variable))
+    {
+      expression_unref (expr);
+      return false;
+    }
+
+  solver->slack_counter += 1;
+
+  bound_var = variable_new (solver, VARIABLE_SLACK);
+  variable_set_prefix (bound_var, "b");
+
+  /* coefficient * variable + constant >= 0, i.e.
+   *
+   *   variable = bound_var + bound, if coefficient > 0
+   *   variable = bound - bound_var, if coefficient < 0
+   */
+  alias = g_slice_new (AliasInfo);
+  alias->constraint = constraint;
+  alias->variable = variable_ref (variable);
+  alias->representative = bound_var;
+  alias->scale = coefficient > 0.0 ? 1.0 : -1.0;
+  alias->offset = -1.0 * expression_get_constant (expr) / coefficient;
+
+  expression_unref (expr);
+
+  g_hash_table_insert (solver->alias_vars, variable, alias);
+  g_hash_table_insert (solver->alias_constraints, constraint, alias);
+  g_hash_table_insert (solver->alias_representatives, bound_var, GINT_TO_POINTER (1));
+
+#ifdef EMEUS_ENABLE_DEBUG
+  {
+    char *str = variable_to_string (variable);
+
+    g_debug ("Bounding %s %s %g", str, alias->scale > 0.0 ? ">=" : "<=", alias->offset);
+
+    g_free (str);
+  }
+#endif
+
+  solver->needs_solving = true;
+
+  if (solver->auto_solve)
+    simplex_solver_set_external_variables (solver);
+
+  simplex_solver_track_constraint (solver, constraint);
+
+  return true;
+}
+
+/* Difference constraints
+ *
+ * As long as every constraint is in the form:
+ *
+ *   x - y + constant {>=,==} 0
+ *
+ * or a bound on a single variable (including stay and edit variables),
+ * the system is a set of shortest path problems on the constraint graph,
+ * and we can solve it with Bellman-Ford instead of using the simplex
+ * tableau.
+ *
+ * Each constraint is an edge of the graph, and each connected component
+ * of the graph is solved on its own; a component is only solved again
+ * when one of its constraints changes, and adding a constraint that is
+ * satisfied by the current solution does not solve anything.
+ *
+ * The simplex minimizes the error of the non-required constraints,
+ * weighted by their strength, and picks a specific vertex of the feasible
+ * region when the system is under-determined. The graph cannot make the
+ * same choices, but it gives the same solution when the solution is
+ * unique, i.e. when the constraints of a component:
+ *
+ *  - can all be satisfied at once, and pin every variable to a single
+ *    value; or
+ *  - can be satisfied at once down to some strength, and pin every
+ *    variable to a single value, while the weaker constraints weigh less
+ *    than half of that strength; moving away from that solution by some
+ *    distance violates the stronger constraints by at least as much, and
+ *    changes the error of each weaker constraint by at most twice the
+ *    distance, so it cannot lower the total error
+ *
+ * The strengths are tried in order, starting from the required ones; a
+ * component that cannot be solved this way is moved into the tableau,
+ * and so is the component of a variable that takes part in a constraint
+ * of any other form. The other components stay in the graph, and the
+ * variables of the graph are never in the tableau.
+ */
+
+typedef enum {
+  DIFFERENCE_INFEASIBLE,
+  DIFFERENCE_UNDERDETERMINED,
+  DIFFERENCE_PINNED
+} DifferenceResult;
+
+static bool
+constraint_is_difference (const Constraint *constraint)
+{
+  int n_positive = 0, n_negative = 0;
+  GHashTableIter iter;
+  gpointer value_p;
+
+  if (constraint->expression->terms == NULL)
+    return false;
+
+  g_hash_table_iter_init (&iter, constraint->expression->terms);
+  while (g_hash_table_iter_next (&iter, NULL, &value_p))
+    {
+      Term *t = value_p;
+
+      if (term_get_variable (t)->type != VARIABLE_REGULAR)
+        return false;
+
+      if (approx_val (term_get_coefficient (t), 1.0))
+        n_positive += 1;
+      else if (approx_val (term_get_coefficient (t), -1.0))
+        n_negative += 1;
+      else
+        return false;
+    }
+
+  return n_positive <= 1 && n_negative <= 1;
+}
+
+static void
+constraint_get_difference_terms (const Constraint *constraint,
+                                 Variable **positive,
+                                 Variable **negative)
+{
+  GList *l;
+
+  *positive = NULL;
+  *negative = NULL;
+
+  for (l = constraint->expression->ordered_terms; l != NULL; l = l->next)
+    {
+      Term *t = l->data;
+
+      if (term_get_coefficient (t) > 0.0)
+        *positive = term_get_variable (t);
+      else
+        *negative = term_get_variable (t);
+    }
+}
+
+static inline double
+difference_edge_get_weight (const DifferenceEdge *edge)
+{
+  double constant = expression_get_constant (edge->constraint->expression);
+
+  return edge->reverse ? -1.0 * constant : constant;
+}
+
+static inline bool
+difference_edge_is_active (const DifferenceEdge *edge,
+                           StrengthType threshold)
+{
+  return edge->constraint->strength >= threshold;
+}
+
+static DifferenceGraph *
+difference_graph_new (void)
+{
+  DifferenceGraph *graph = g_slice_new (DifferenceGraph);
+  DifferenceNode origin = { NULL, };
+
+  graph->nodes = g_array_new (FALSE, FALSE, sizeof (DifferenceNode));
+  graph->indices = g_hash_table_new (NULL, NULL);
+  graph->n_unused = 0;
+
+  g_array_append_val (graph->nodes, origin);
+
+  return graph;
+}
+
+static int
+difference_graph_find (DifferenceGraph *graph,
+                       int index)
+{
+  int root = index;
+
+  while (difference_graph_get_node (graph, root)->parent != root)
+    root = difference_graph_get_node (graph, root)->parent;
+
+  while (index != root)
+    {
+      DifferenceNode *node = difference_graph_get_node (graph, index);
+
+      index = node->parent;
+      node->parent = root;
+    }
+
+  return root;
+}
+
+/* Returns the index of the node of @variable, or 0 for the origin; a new
+ * node is a component of its own
+ */
+static int
+difference_graph_lookup (DifferenceGraph *graph,
+                         Variable *variable,
+                         bool *is_new)
+{
+  DifferenceNode node = { NULL, };
+  gpointer index_p;
+  int index;
+
+  *is_new = false;
+
+  if (variable == NULL)
+    return 0;
+
+  if (g_hash_table_lookup_extended (graph->indices, variable, NULL, &index_p))
+    return GPOINTER_TO_INT (index_p);
+
+  index = graph->nodes->len;
+
+  node.variable = variable;
+  node.out_edges = g_array_new (FALSE, FALSE, sizeof (DifferenceEdge));
+  node.in_edges = g_array_new (FALSE, FALSE, sizeof (DifferenceEdge));
+  node.parent = index;
+  node.members = g_array_new (FALSE, FALSE, sizeof (int));
+  node.dirty = true;
+  node.exact = false;
+
+  g_array_append_val (node.members, index);
+  g_array_append_val (graph->nodes, node);
+  g_hash_table_insert (graph->indices, variable, GINT_TO_POINTER (index));
+
+  *is_new = true;
+
+  return index;
+}
+
+static void
+difference_graph_add_edge (DifferenceGraph *graph,
+                           int source,
+                           int target,
+                           Constraint *constraint,
+                           bool reverse)
+{
+  DifferenceEdge edge;
+
+  edge.constraint = constraint;
+  edge.reverse = reverse;
+
+  if (source != 0)
+    {
+      edge.node = target;
+      g_array_append_val (difference_graph_get_node (graph, source)->out_edges, edge);
+    }
+
+  if (target != 0)
+    {
+      edge.node = source;
+      g_array_append_val (difference_graph_get_node (graph, target)->in_edges, edge);
+    }
+}
+
+/* Merges the components of @a and @b, and returns the representative */
+static int
+difference_graph_union (DifferenceGraph *graph,
+                        int a,
+                        int b)
+{
+  DifferenceNode *root_a, *root_b;
+
+  a = difference_graph_find (graph, a);
+  b = difference_graph_find (graph, b);
+  if (a == b)
+    return a;
+
+  root_a = difference_graph_get_node (graph, a);
+  root_b = difference_graph_get_node (graph, b);
+
+  if (root_a->members->len < root_b->members->len)
+    {
+      DifferenceNode *tmp = root_a;
+      int tmp_index = a;
+
+      root_a = root_b;
+      root_b = tmp;
+      a = b;
+      b = tmp_index;
+    }
+
+  g_array_append_vals (root_a->members, root_b->members->data, root_b->members->len);
+  g_clear_pointer (&root_b->members, g_array_unref);
+
+  root_b->parent = a;
+  root_a->dirty = root_a->dirty || root_b->dirty;
+  root_a->exact = root_a->exact && root_b->exact;
+
+  return a;
+}
+
+static inline double
+difference_graph_get_value (DifferenceGraph *graph,
+                            int index)
+{
+  if (index == 0)
+    return 0.0;
+
+  return variable_get_value (difference_graph_get_node (graph, index)->variable);
+}
+
+/* Adds @constraint to the graph. A component whose values satisfy all
+ * its constraints keeps its values if they also satisfy @constraint, and
+ * a new variable that is tied to it by an equality is simply moved; every
+ * other change marks the component as out of date
+ */
+static void
+difference_graph_add_constraint (DifferenceGraph *graph,
+                                 Constraint *constraint)
+{
+  Variable *positive, *negative;
+  bool positive_is_new, negative_is_new;
+  bool keep_values = true;
+  double constant, value;
+  int p, n, root;
+
+  constraint_get_difference_terms (constraint, &positive, &negative);
+
+  p = difference_graph_lookup (graph, positive, &positive_is_new);
+  n = difference_graph_lookup (graph, negative, &negative_is_new);
+
+  /* positive - negative + constant >= 0, i.e.
+   *
+   *   negative - positive <= constant
+   *
+   * which is an edge from positive to negative; an equality also adds
+   * the edge in the opposite direction
+   */
+  difference_graph_add_edge (graph, p, n, constraint, false);
+  if (!constraint_is_inequality (constraint))
+    difference_graph_add_edge (graph, n, p, constraint, true);
+
+  if (p != 0 && !positive_is_new)
+    {
+      DifferenceNode *r = difference_graph_get_node (graph, difference_graph_find (graph, p));
+
+      keep_values = keep_values && !r->dirty && r->exact;
+    }
+
+  if (n != 0 && !negative_is_new)
+    {
+      DifferenceNode *r = difference_graph_get_node (graph, difference_graph_find (graph, n));
+
+      keep_values = keep_values && !r->dirty && r->exact;
+    }
+
+  constant = expression_get_constant (constraint->expression);
+
+  if (positive_is_new && negative_is_new)
+    keep_values = false;
+  else if (positive_is_new || negative_is_new)
+    {
+      /* A new variable is only pinned by an equality */
+      if (constraint_is_inequality (constraint))
+        keep_values = false;
+      else if (keep_values && positive_is_new)
+        variable_set_value (positive, difference_graph_get_value (graph, n) - constant);
+      else if (keep_values)
+        variable_set_value (negative, difference_graph_get_value (graph, p) + constant);
+    }
+
+  if (keep_values)
+    {
+      value = difference_graph_get_value (graph, p) - difference_graph_get_value (graph, n) + constant;
+
+      if (constraint_is_inequality (constraint))
+        keep_values = value > 0.0 || approx_val (value, 0.0);
+      else
+        keep_values = approx_val (value, 0.0);
+    }
+
+  if (p != 0 && n != 0)
+    root = difference_graph_union (graph, p, n);
+  else
+    root = difference_graph_find (graph, p != 0 ? p : n);
+
+  difference_graph_get_node (graph, root)->dirty = !keep_values;
+  difference_graph_get_node (graph, root)->exact = keep_values;
+}
+
+static DifferenceGraph *
+difference_graph_new_from_constraints (GPtrArray *constraints)
+{
+  DifferenceGraph *graph = difference_graph_new ();
+  int i;
+
+  for (i = 0; i < constraints->len; i++)
+    difference_graph_add_constraint (graph, g_ptr_array_index (constraints, i));
+
+  /* The values are not a solution of the new graph */
+  for (i = 1; i < graph->nodes->len; i++)
+    difference_graph_get_node (graph, i)->dirty = true;
+
+  return graph;
+}
+
+static void
+difference_graph_invalidate (DifferenceGraph *graph,
+                             Variable *variable)
+{
+  gpointer index_p;
+
+  if (graph == NULL)
+    return;
+
+  if (!g_hash_table_lookup_extended (graph->indices, variable, NULL, &index_p))
+    return;
+
+  difference_graph_get_node (graph, difference_graph_find (graph, GPOINTER_TO_INT (index_p)))->dirty = true;
+}
+
+static void
+difference_edges_remove (GArray *edges,
+                         Constraint *constraint)
+{
+  int i = 0;
+
+  while (i < edges->len)
+    {
+      if (g_array_index (edges, DifferenceEdge, i).constraint == constraint)
+        g_array_remove_index_fast (edges, i);
+      else
+        i += 1;
+    }
+}
+
+/* Takes the node of @index out of the component of @root once it has no
+ * edges left; the node stays in the forest of the components, as other
+ * nodes can point to it, but it does not have a variable any more
+ */
+static void
+difference_graph_release_node (DifferenceGraph *graph,
+                               int index,
+                               int root)
+{
+  DifferenceNode *node = difference_graph_get_node (graph, index);
+  GArray *members = difference_graph_get_node (graph, root)->members;
+  int i;
+
+  if (node->out_edges->len != 0 || node->in_edges->len != 0)
+    return;
+
+  for (i = 0; i < members->len; i++)
+    {
+      if (g_array_index (members, int, i) == index)
+        {
+          g_array_remove_index_fast (members, i);
+          break;
+        }
+    }
+
+  g_hash_table_remove (graph->indices, node->variable);
+  node->variable = NULL;
+
+  graph->n_unused += 1;
+}
+
+/* Removes the edges of @constraint from the graph, and marks its component
+ * as out of date; the component is not split, even if the removal leaves
+ * it disconnected, and the variables that have no constraints left are
+ * taken out of it
+ */
+static void
+difference_graph_remove_constraint (DifferenceGraph *graph,
+                                    Constraint *constraint)
+{
+  Variable *positive, *negative;
+  DifferenceNode *root_node;
+  int p = 0, n = 0, root;
+
+  constraint_get_difference_terms (constraint, &positive, &negative);
+
+  if (positive != NULL)
+    p = GPOINTER_TO_INT (g_hash_table_lookup (graph->indices, positive));
+  if (negative != NULL)
+    n = GPOINTER_TO_INT (g_hash_table_lookup (graph->indices, negative));
+
+  root = difference_graph_find (graph, p != 0 ? p : n);
+
+  if (p != 0)
+    {
+      difference_edges_remove (difference_graph_get_node (graph, p)->out_edges, constraint);
+      difference_edges_remove (difference_graph_get_node (graph, p)->in_edges, constraint);
+    }
+
+  if (n != 0)
+    {
+      difference_edges_remove (difference_graph_get_node (graph, n)->out_edges, constraint);
+      difference_edges_remove (difference_graph_get_node (graph, n)->in_edges, constraint);
+    }
+
+  root_node = difference_graph_get_node (graph, root);
+  root_node->dirty = true;
+  root_node->exact = false;
+
+  if (p != 0)
+    difference_graph_release_node (graph, p, root);
+  if (n != 0)
+    difference_graph_release_node (graph, n, root);
+}
+
+/* Takes every node of the component of @root out of the graph */
+static void
+difference_graph_release_component (DifferenceGraph *graph,
+                                    int root)
+{
+  DifferenceNode *root_node = difference_graph_get_node (graph, root);
+  int i;
+
+  for (i = 0; i < root_node->members->len; i++)
+    {
+      DifferenceNode *node = difference_graph_get_node (graph, g_array_index (root_node->members, int, i));
+
+      g_array_set_size (node->out_edges, 0);
+      g_array_set_size (node->in_edges, 0);
+
+      g_hash_table_remove (graph->indices, node->variable);
+      node->variable = NULL;
+    }
+
+  graph->n_unused += root_node->members->len;
+
+  g_array_set_size (root_node->members, 0);
+  root_node->dirty = false;
+  root_node->exact = false;
+}
+
+/* Computes the shortest distance from the origin to every node of a
+ * component, or from every node to the origin if @reverse is set, using
+ * only the constraints with at least the @threshold strength; this is a
+ * queue-based Bellman-Ford relaxation, which scans the edges of each node
+ * it visits. Returns false if there is a negative cycle, i.e. the
+ * constraints cannot be satisfied
+ */
+static bool
+difference_graph_shortest_paths (DifferenceGraph *graph,
+                                 GArray *members,
+                                 StrengthType threshold,
+                                 bool reverse)
+{
+  int n_members = members->len;
+  int *queue = g_new (int, n_members);
+  int head = 0, len = 0;
+  bool res = true;
+  int i, j;
+
+  for (i = 0; i < n_members; i++)
+    {
+      int index = g_array_index (members, int, i);
+      DifferenceNode *node = difference_graph_get_node (graph, index);
+      GArray *edges = reverse ? node->out_edges : node->in_edges;
+      double distance = DBL_MAX;
+
+      /* The edges from the origin */
+      for (j = 0; j < edges->len; j++)
+        {
+          const DifferenceEdge *edge = &g_array_index (edges, DifferenceEdge, j);
+
+          if (edge->node == 0 && difference_edge_is_active (edge, threshold))
+            distance = MIN (distance, difference_edge_get_weight (edge));
+        }
+
+      if (reverse)
+        node->lower = distance;
+      else
+        node->upper = distance;
+
+      node->in_queue = distance != DBL_MAX;
+      node->n_queued = node->in_queue ? 1 : 0;
+
+      if (node->in_queue)
+        queue[len++] = index;
+    }
+
+  while (len > 0)
+    {
+      int index = queue[head];
+      DifferenceNode *node = difference_graph_get_node (graph, index);
+      GArray *edges = reverse ? node->in_edges : node->out_edges;
+      double distance = reverse ? node->lower : node->upper;
+
+      head = (head + 1) % n_members;
+      len -= 1;
+      node->in_queue = false;
+
+      for (j = 0; j < edges->len; j++)
+        {
+          const DifferenceEdge *edge = &g_array_index (edges, DifferenceEdge, j);
+          DifferenceNode *target;
+          double *target_distance;
+          double d;
+
+          if (!difference_edge_is_active (edge, threshold))
+            continue;
+
+          d = distance + difference_edge_get_weight (edge);
+
+          /* A path from the origin back to itself must not be negative */
+          if (edge->node == 0)
+            {
+              if (d < 0.0 && !approx_val (d, 0.0))
+                {
+                  res = false;
+                  goto out;
+                }
+
+              continue;
+            }
+
+          target = difference_graph_get_node (graph, edge->node);
+          target_distance = reverse ? &target->lower : &target->upper;
+
+          if (d < *target_distance && !approx_val (d, *target_distance))
+            {
+              *target_distance = d;
+
+              if (!target->in_queue)
+                {
+                  target->n_queued += 1;
+                  if (target->n_queued > n_members)
+                    {
+                      res = false;
+                      goto out;
+                    }
+
+                  queue[(head + len) % n_members] = edge->node;
+                  len += 1;
+                  target->in_queue = true;
+                }
+            }
+        }
+    }
+
+out:
+  g_free (queue);
+
+  return res;
+}
+
+/* The shortest path from the origin to a node is the upper bound of the
+ * variable, and the shortest path from the node to the origin is the
+ * opposite of its lower bound; the variable is pinned if they match
+ */
+static DifferenceResult
+difference_graph_bound_component (DifferenceGraph *graph,
+                                  GArray *members,
+                                  StrengthType threshold)
+{
+  int i;
+
+  if (!difference_graph_shortest_paths (graph, members, threshold, false) ||
+      !difference_graph_shortest_paths (graph, members, threshold, true))
+    return DIFFERENCE_INFEASIBLE;
+
+  for (i = 0; i < members->len; i++)
+    {
+      DifferenceNode *node = difference_graph_get_node (graph, g_array_index (members, int, i));
+
+      if (node->upper == DBL_MAX || node->lower == DBL_MAX)
+        return DIFFERENCE_UNDERDETERMINED;
+
+      if (node->upper < -1.0 * node->lower && !approx_val (node->upper, -1.0 * node->lower))
+        return DIFFERENCE_INFEASIBLE;
+
+      if (!approx_val (node->upper, -1.0 * node->lower))
+        return DIFFERENCE_UNDERDETERMINED;
+    }
+
+  return DIFFERENCE_PINNED;
+}
+
+static int
+compare_strengths (gconstpointer a,
+                   gconstpointer b)
+{
+  StrengthType s1 = *(const StrengthType *) a;
+  StrengthType s2 = *(const StrengthType *) b;
+
+  return s1 > s2 ? -1 : (s1 < s2 ? 1 : 0);
+}
+
+/* Solves a component, trying every constraint at once first, and then the
+ * strengths in order; returns false if the solution of the simplex is not
+ * guaranteed to be the same
+ */
+static bool
+difference_graph_solve_component (DifferenceGraph *graph,
+                                  int root)
+{
+  DifferenceNode *root_node = difference_graph_get_node (graph, root);
+  GArray *members = root_node->members;
+  DifferenceResult result;
+  GArray *strengths;
+  bool res = false;
+  int i, j;
+
+  result = difference_graph_bound_component (graph, members, 0);
+  if (result == DIFFERENCE_UNDERDETERMINED)
+    return false;
+
+  if (result == DIFFERENCE_PINNED)
+    {
+      root_node->exact = true;
+      goto out;
+    }
+
+  /* The non-required strengths of the constraints, each constraint being
+   * listed once, under the edge in the positive direction
+   */
+  strengths = g_array_new (FALSE, FALSE, sizeof (StrengthType));
+  for (i = 0; i < members->len; i++)
+    {
+      DifferenceNode *node = difference_graph_get_node (graph, g_array_index (members, int, i));
+
+      for (j = 0; j < node->out_edges->len; j++)
+        {
+          const DifferenceEdge *edge = &g_array_index (node->out_edges, DifferenceEdge, j);
+
+          if (!edge->reverse && !constraint_is_required (edge->constraint))
+            g_array_append_val (strengths, edge->constraint->strength);
+        }
+
+      for (j = 0; j < node->in_edges->len; j++)
+        {
+          const DifferenceEdge *edge = &g_array_index (node->in_edges, DifferenceEdge, j);
+
+          if (edge->node == 0 && !edge->reverse && !constraint_is_required (edge->constraint))
+            g_array_append_val (strengths, edge->constraint->strength);
+        }
+    }
+
+  g_array_sort (strengths, compare_strengths);
+
+  /* The required constraints are the first layer; every constraint that
+   * is weaker than the layer adds its strength to the weight of the error
+   * that a different solution could save
+   */
+  for (i = -1; i < (int) strengths->len; i++)
+    {
+      StrengthType threshold = i < 0 ? STRENGTH_REQUIRED : g_array_index (strengths, StrengthType, i);
+      double weaker_weight = 0.0;
+
+      if (i > 0 && g_array_index (strengths, StrengthType, i - 1) == threshold)
+        continue;
+
+      for (j = strengths->len - 1; j >= 0 && g_array_index (strengths, StrengthType, j) < threshold; j--)
+        weaker_weight += g_array_index (strengths, StrengthType, j);
+
+      /* The whole set of constraints is known to be infeasible */
+      if (weaker_weight == 0.0)
+        break;
+
+      result = difference_graph_bound_component (graph, members, threshold);
+      if (result == DIFFERENCE_INFEASIBLE)
+        break;
+
+      if (result == DIFFERENCE_PINNED)
+        {
+          res = i < 0 || 2.0 * weaker_weight < threshold;
+          break;
+        }
+    }
+
+  g_array_unref (strengths);
+
+  if (!res)
+    return false;
+
+  root_node->exact = false;
+
+out:
+  for (i = 0; i < members->len; i++)
+    {
+      DifferenceNode *node = difference_graph_get_node (graph, g_array_index (members, int, i));
+
+      variable_set_value (node->variable, node->upper);
+    }
+
+  root_node->dirty = false;
+
+  return true;
+}
+
+static DifferenceGraph *
+simplex_solver_get_difference_graph (SimplexSolver *solver)
+{
+  /* Without a graph, it is built from every constraint */
+  if (solver->difference_graph == NULL)
+    solver->difference_graph = difference_graph_new_from_constraints (solver->difference_constraints);
+
+  return solver->difference_graph;
+}
+
+/* Checks whether @variable belongs to a component of the graph; the
+ * variables of the graph are never in the tableau
+ */
+static bool
+simplex_solver_is_difference_variable (SimplexSolver *solver,
+                                       Variable *variable)
+{
+  if (!solver->difference_mode)
+    return false;
+
+  return g_hash_table_contains (simplex_solver_get_difference_graph (solver)->indices, variable);
+}
+
+static bool
+simplex_solver_is_difference_constraint (SimplexSolver *solver,
+                                         Constraint *constraint)
+{
+  GList *terms = constraint->expression->ordered_terms;
+
+  if (terms == NULL)
+    return false;
+
+  return simplex_solver_is_difference_variable (solver, term_get_variable (terms->data));
+}
+
+static bool
+simplex_solver_has_tableau_variables (SimplexSolver *solver,
+                                      Constraint *constraint)
+{
+  GList *l;
+
+  for (l = constraint->expression->ordered_terms; l != NULL; l = l->next)
+    {
+      Variable *v = term_get_variable (l->data);
+
+      if (g_hash_table_contains (solver->rows, v) ||
+          g_hash_table_contains (solver->columns, v) ||
+          g_hash_table_contains (solver->alias_vars, v))
+        return true;
+    }
+
+  return false;
+}
+
+/* Moves the constraints of the components of @roots into the tableau;
+ * the other components stay in the graph
+ */
+static void
+simplex_solver_move_difference_components (SimplexSolver *solver,
+                                           const int *roots,
+                                           int n_roots)
+{
+  DifferenceGraph *graph = solver->difference_graph;
+  GPtrArray *constraints, *moved;
+  GHashTable *component;
+  bool auto_solve = solver->auto_solve;
+  int i, j, k;
+
+  /* Each constraint is listed once, under the edge in the positive
+   * direction
+   */
+  component = g_hash_table_new (NULL, NULL);
+  for (k = 0; k < n_roots; k++)
+    {
+      GArray *members = difference_graph_get_node (graph, roots[k])->members;
+
+      for (i = 0; i < members->len; i++)
+        {
+          DifferenceNode *node = difference_graph_get_node (graph, g_array_index (members, int, i));
+
+          for (j = 0; j < node->out_edges->len; j++)
+            {
+              const DifferenceEdge *edge = &g_array_index (node->out_edges, DifferenceEdge, j);
+
+              if (!edge->reverse)
+                g_hash_table_add (component, edge->constraint);
+            }
+
+          for (j = 0; j < node->in_edges->len; j++)
+            {
+              const DifferenceEdge *edge = &g_array_index (node->in_edges, DifferenceEdge, j);
+
+              if (edge->node == 0 && !edge->reverse)
+                g_hash_table_add (component, edge->constraint);
+            }
+        }
+
+      difference_graph_release_component (graph, roots[k]);
+    }
+
+  /* The constraints keep the order in which they were added */
+  constraints = solver->difference_constraints;
+  moved = g_ptr_array_sized_new (g_hash_table_size (component));
+
+  for (i = 0, j = 0; i < constraints->len; i++)
+    {
+      Constraint *constraint = g_ptr_array_index (constraints, i);
+
+      if (g_hash_table_contains (component, constraint))
+        g_ptr_array_add (moved, constraint);
+      else
+        constraints->pdata[j++] = constraint;
+    }
+
+  g_ptr_array_set_size (constraints, j);
+
+#ifdef EMEUS_ENABLE_DEBUG
+  g_debug ("Moving %d difference constraints into the tableau", moved->len);
+#endif
+
+  /* The constraints must not go back into the graph */
+  solver->difference_mode = false;
+  solver->auto_solve = false;
+
+  for (i = 0; i < moved->len; i++)
+    simplex_solver_add_constraint_internal (solver, g_ptr_array_index (moved, i));
+
+  solver->auto_solve = auto_solve;
+  solver->difference_mode = true;
+
+  g_ptr_array_unref (moved);
+  g_hash_table_unref (component);
+}
+
+/* Moves the components of the variables of @constraint into the tableau */
+static void
+simplex_solver_move_difference_variables (SimplexSolver *solver,
+                                          Constraint *constraint)
+{
+  DifferenceGraph *graph = simplex_solver_get_difference_graph (solver);
+  int *roots = g_newa (int, expression_get_n_terms (constraint->expression));
+  int n_roots = 0;
+  GList *l;
+
+  for (l = constraint->expression->ordered_terms; l != NULL; l = l->next)
+    {
+      gpointer index_p;
+
+      if (g_hash_table_lookup_extended (graph->indices, term_get_variable (l->data), NULL, &index_p))
+        roots[n_roots++] = difference_graph_find (graph, GPOINTER_TO_INT (index_p));
+    }
+
+  if (n_roots > 0)
+    simplex_solver_move_difference_components (solver, roots, n_roots);
+}
+
+/* Builds the graph again once more than half of its nodes are unused;
+ * this also splits the components that removals disconnected. The new
+ * components keep the state of the old ones, as the solution of a
+ * component is also the solution of each of its parts
+ */
+static void
+simplex_solver_compact_difference_graph (SimplexSolver *solver)
+{
+  DifferenceGraph *old_graph = solver->difference_graph;
+  DifferenceGraph *graph;
+  int i;
+
+  if (old_graph == NULL || old_graph->n_unused * 2 <= old_graph->nodes->len)
+    return;
+
+  graph = difference_graph_new ();
+
+  for (i = 0; i < solver->difference_constraints->len; i++)
+    {
+      Constraint *constraint = g_ptr_array_index (solver->difference_constraints, i);
+      Variable *positive, *negative;
+      bool is_new;
+      int p, n;
+
+      constraint_get_difference_terms (constraint, &positive, &negative);
+
+      p = difference_graph_lookup (graph, positive, &is_new);
+      n = difference_graph_lookup (graph, negative, &is_new);
+
+      difference_graph_add_edge (graph, p, n, constraint, false);
+      if (!constraint_is_inequality (constraint))
+        difference_graph_add_edge (graph, n, p, constraint, true);
+
+      if (p != 0 && n != 0)
+        difference_graph_union (graph, p, n);
+    }
+
+  for (i = 1; i < graph->nodes->len; i++)
+    {
+      DifferenceNode *root = difference_graph_get_node (graph, difference_graph_find (graph, i));
+
+      root->dirty = false;
+      root->exact = true;
+    }
+
+  for (i = 1; i < graph->nodes->len; i++)
+    {
+      DifferenceNode *node = difference_graph_get_node (graph, i);
+      DifferenceNode *root = difference_graph_get_node (graph, difference_graph_find (graph, i));
+      int old_index = GPOINTER_TO_INT (g_hash_table_lookup (old_graph->indices, node->variable));
+      DifferenceNode *old_root = difference_graph_get_node (old_graph, difference_graph_find (old_graph, old_index));
+
+      root->dirty = root->dirty || old_root->dirty;
+      root->exact = root->exact && old_root->exact;
+    }
+
+  difference_graph_free (old_graph);
+  solver->difference_graph = graph;
+}
+
+/* Solves the components that are out of date; a component that the graph
+ * cannot solve the way the simplex would is moved into the tableau
+ */
+static void
+simplex_solver_solve_differences (SimplexSolver *solver)
+{
+  DifferenceGraph *graph = simplex_solver_get_difference_graph (solver);
+  int i;
+
+  for (i = 1; i < graph->nodes->len; i++)
+    {
+      DifferenceNode *node = difference_graph_get_node (graph, i);
+
+      if (node->parent != i || !node->dirty)
+        continue;
+
+      if (!difference_graph_solve_component (graph, i))
+        simplex_solver_move_difference_components (solver, &i, 1);
+    }
+
+  simplex_solver_compact_difference_graph (solver);
+}
+
+/* Moves the stay constants of the difference engine to the current
+ * values, as resetting the stay constants does for the tableau; the
+ * solution is still the same, so the components stay up to date
+ */
+static void
+simplex_solver_reset_difference_stays (SimplexSolver *solver)
+{
+  DifferenceGraph *graph = solver->difference_graph;
+  int i;
+
+  if (graph == NULL)
+    return;
+
+  for (i = 0; i < solver->difference_constraints->len; i++)
+    {
+      Constraint *constraint = g_ptr_array_index (solver->difference_constraints, i);
+      int index;
+
+      if (!constraint_is_stay (constraint))
+        continue;
+
+      index = GPOINTER_TO_INT (g_hash_table_lookup (graph->indices, constraint->variable));
+      if (index == 0 || difference_graph_get_node (graph, difference_graph_find (graph, index))->dirty)
+        continue;
+
+      expression_set_constant (constraint->expression, variable_get_value (constraint->variable));
+    }
+}
+
+/* Moves every constraint handled by the difference engine into the
+ * tableau, and stops using the engine; there is no way back
+ */
+static void
+simplex_solver_leave_difference_mode (SimplexSolver *solver)
+{
+  GPtrArray *constraints = solver->difference_constraints;
+  bool auto_solve = solver->auto_solve;
+  int i;
+
+  solver->difference_constraints = NULL;
+  solver->difference_mode = false;
+
+  g_clear_pointer (&solver->difference_graph, difference_graph_free);
+
+#ifdef EMEUS_ENABLE_DEBUG
+  g_debug ("Moving %d difference constraints into the tableau", constraints->len);
+#endif
+
+  solver->auto_solve = false;
+
+  for (i = 0; i < constraints->len; i++)
+    simplex_solver_add_constraint_internal (solver, g_ptr_array_index (constraints, i));
+
+  solver->auto_solve = auto_solve;
+
+  g_ptr_array_unref (constraints);
+}
+
+/* The components of the graph are solved first, as the ones that move
+ * into the tableau need to be solved with it
+ */
+static void
+simplex_solver_solve_internal (SimplexSolver *solver)
+{
+  if (solver->difference_mode)
+    simplex_solver_solve_differences (solver);
+
+  simplex_solver_optimize (solver, solver->objective);
+  simplex_solver_set_external_variables (solver);
+}
+
+static bool
+simplex_solver_try_adding_difference (SimplexSolver *solver,
+                                      Constraint *constraint)
+{
+  DifferenceGraph *graph;
+
+  if (!solver->difference_mode)
+    return false;
+
+  /* The constraint goes into the tableau, along with the components of
+   * its variables
+   */
+  if (!constraint_is_difference (constraint) ||
+      simplex_solver_has_tableau_variables (solver, constraint))
+    {
+      simplex_solver_move_difference_variables (solver, constraint);
+      return false;
+    }
+
+  graph = simplex_solver_get_difference_graph (solver);
+
+  if (constraint_is_edit (constraint))
+    {
+      EditInfo *ei = g_slice_new (EditInfo);
+
+      ei->constraint = constraint;
+      ei->eplus = NULL;
+      ei->eminus = NULL;
+      ei->prev_constant = expression_get_constant (constraint->expression);
+      ei->suggested_value = ei->prev_constant;
+
+      g_hash_table_insert (solver->edit_var_map, constraint->variable, ei);
+    }
+
+  if (constraint_is_stay (constraint))
+    {
+      StayInfo *si = g_slice_new (StayInfo);
+
+      si->constraint = constraint;
+
+      g_hash_table_insert (solver->stay_var_map, constraint->variable, si);
+    }
+
+  g_ptr_array_add (solver->difference_constraints, constraint);
+  difference_graph_add_constraint (graph, constraint);
+
+  solver->needs_solving = true;
+
+  if (solver->auto_solve)
+    simplex_solver_solve_internal (solver);
+
+  simplex_solver_track_constraint (solver, constraint);
+
+  return true;
+}
+
+/* Brings the tableau up to date with the suggested values, and solves it
+ * within @budget
+ *
+ * Returns: %true if the tableau was solved
+ */
+static bool
+simplex_solver_resolve_internal_with_budget (SimplexSolver *solver,
+                                             SolverBudget *budget)
+{
+  if (solver->has_pending_edits)
+    {
+      GHashTableIter iter;
+      gpointer value_p;
+
+      g_hash_table_iter_init (&iter, solver->edit_var_map);
+      while (g_hash_table_iter_next (&iter, NULL, &value_p))
+        {
+          EditInfo *ei = value_p;
+          double delta = ei->suggested_value - ei->prev_constant;
+
+          if (delta == 0.0)
+            continue;
+
+          ei->prev_constant = ei->suggested_value;
+
+          simplex_solver_delta_edit_constant (solver, delta, ei->eplus, ei->eminus);
+        }
+
+      solver->has_pending_edits = false;
+    }
+
+  if (!simplex_solver_dual_optimize_with_budget (solver, budget))
+    {
+      /* The tableau is not feasible yet, so the variables keep the values
+       * of the last solution; the edits stay pending, so that the resolve
+       * is finished before anything else changes the tableau
+       */
+      g_clear_pointer (&solver->compiled_basis, parametric_solution_free);
+      solver->has_pending_edits = true;
+
+      return false;
+    }
+
+  simplex_solver_set_external_variables (solver);
+
+  simplex_solver_clear_infeasible_rows (solver);
+  simplex_solver_reset_stay_constants (solver);
+
+  solver->needs_solving = false;
+
+  return true;
+}
+
+static void
+simplex_solver_resolve_internal (SimplexSolver *solver)
+{
+  simplex_solver_resolve_internal_with_budget (solver, NULL);
+}
+
+/* Adds @constraint to the tableau; if @artificial_vars is set, the
+ * constraints that need an artificial variable keep it in the tableau,
+ * and it is added to @artificial_vars, to be removed by the caller with
+ * simplex_solver_remove_artificial_variables()
+ */
+static void
+simplex_solver_add_constraint_full (SimplexSolver *solver,
+                                    Constraint *constraint,
+                                    GPtrArray *artificial_vars)
+{
+  Expression *expr;
+  Variable *eplus;
+  Variable *eminus;
+  double prev_constant;
+
+  if (solver->has_pending_edits)
+    simplex_solver_resolve_internal (solver);
+
+  solver->serial += 1;
+  g_clear_pointer (&solver->compiled_basis, parametric_solution_free);
+
+  simplex_solver_journal_added (solver, constraint);
+
+  if (simplex_solver_try_adding_difference (solver, constraint))
+    return;
+
+  if (simplex_solver_try_adding_alias (solver, constraint))
+    return;
+
+  if (simplex_solver_try_adding_bound (solver, constraint))
+    return;
+
+  expr = simplex_solver_new_expression (solver, constraint,
+                                        &eplus,
+                                        &eminus,
+                                        &prev_constant);
+
+#ifdef EMEUS_ENABLE_DEBUG
+  {
+    char *str1 = constraint_to_string (constraint);
+    char *str2 = expression_to_string (expr);
+
+    g_debug ("Adding constraint: %s (normalized expression: %s)", str1, str2);
+
+    g_free (str1);
+    g_free (str2);
+  }
+#endif
+
+  if (constraint_is_stay (constraint))
+    {
+      StayInfo *si = g_slice_new (StayInfo);
+
+      si->constraint = constraint;
+
+      g_hash_table_insert (solver->stay_var_map, constraint->variable, si);
+    }
+
+  if (constraint_is_edit (constraint))
+    {
+      EditInfo *ei = g_slice_new (EditInfo);
+
+      ei->constraint = constraint;
+      ei->eplus = eplus;
+      ei->eminus = eminus;
+      ei->prev_constant = prev_constant;
+      ei->suggested_value = prev_constant;
+
+      g_hash_table_insert (solver->edit_var_map, constraint->variable, ei);
+    }
+
+  if (simplex_solver_try_adding_directly (solver, expr))
+    ;
+  else if (artificial_vars != NULL)
+    {
+      Variable *av = simplex_solver_new_artificial_variable (solver);
+
+      simplex_solver_add_row (solver, av, expr);
+      g_ptr_array_add (artificial_vars, av);
+    }
+  else
+    simplex_solver_add_with_artificial_variable (solver, expr);
+
+  solver->needs_solving = true;
+
+  if (solver->auto_solve)
+    {
+      simplex_solver_optimize (solver, solver->objective);
+      simplex_solver_set_external_variables (solver);
+    }
+
+  expression_unref (expr);
+
+  simplex_solver_track_constraint (solver, constraint);
+}
+
+static void
+simplex_solver_add_constraint_internal (SimplexSolver *solver,
+                                        Constraint *constraint)
+{
+  simplex_solver_add_constraint_full (solver, constraint, NULL);
+}
+
+Constraint *
+simplex_solver_add_constraint (SimplexSolver *solver,
+                               Variable *variable,
+                               OperatorType op,
+                               Expression *expression,
+                               StrengthType strength)
+{
+  Constraint *res;
+
+  if (!solver->initialized)
+    {
+      g_critical ("SimplexSolver %p has not been initialized.", solver);
+      return NULL;
+    }
+
+  res = g_slice_new0 (Constraint);
+  res->solver = solver;
+  res->strength = strength;
+  res->is_edit = false;
+  res->is_stay = false;
+  res->op_type = op;
+
+  if (expression == NULL)
+    res->expression = expression_new_from_variable (variable);
+  else
+    {
+      res->expression = expression_ref (expression);
+      if (res->expression->solver == NULL)
+        res->expression->solver = solver;
+
+      if (variable != NULL)
+        {
+          switch (res->op_type)
+            {
+            case OPERATOR_TYPE_EQ:
+              expression_add_variable (res->expression, variable, -1.0, NULL);
+              break;
+
+            case OPERATOR_TYPE_LE:
+              expression_add_variable (res->expression, variable, -1.0, NULL);
+              break;
+
+            case OPERATOR_TYPE_GE:
+              expression_times (res->expression, -1.0);
+              expression_add_variable (res->expression, variable, 1.0, NULL);
+              break;
+            }
+        }
+    }
+
+  simplex_solver_add_constraint_internal (solver, res);
+
+  return res;
+}
+
+Constraint *
+simplex_solver_add_stay_variable (SimplexSolver *solver,
+                                  Variable *variable,
+                                  StrengthType strength)
+{
+  Constraint *res;
+
+  if (!solver->initialized)
+    {
+      g_critical ("SimplexSolver %p has not been initialized.", solver);
+      return NULL;
+    }
+
+  res = g_slice_new0 (Constraint);
+  res->solver = solver;
+  res->variable = variable_ref (variable);
+  res->op_type = OPERATOR_TYPE_EQ;
+  res->strength = strength;
+  res->is_stay = true;
+  res->is_edit = false;
+
+  res->expression = expression_new (solver, variable_get_value (res->variable));
+  expression_add_variable (res->expression, res->variable, -1.0, NULL);
+
+  simplex_solver_add_constraint_internal (solver, res);
+
+  return res;
+}
+
+bool
+simplex_solver_has_stay_variable (SimplexSolver *solver,
+                                  Variable *variable)
+{
+  if (!solver->initialized)
+    return false;
+
+  return g_hash_table_contains (solver->stay_var_map, variable);
+}
+
+void
+simplex_solver_remove_stay_variable (SimplexSolver *solver,
+                                     Variable *variable)
+{
+  StayInfo *si;
+
+  if (!solver->initialized)
+    {
+      g_critical ("Solver %p is not initialized.", solver);
+      return;
+    }
+
+  si = g_hash_table_lookup (solver->stay_var_map, variable);
+  if (si == NULL)
+    {
+      char *str = variable_to_string (variable);
+
+      g_critical ("Unknown stay variable '%s'", str);
+
+      g_free (str);
+
+      return;
+    }
+
+  simplex_solver_remove_constraint (solver, si->constraint);
+}
+
+Constraint *
+simplex_solver_add_edit_variable (SimplexSolver *solver,
+                                  Variable *variable,
+                                  StrengthType strength)
+{
+  Constraint *res;
+
+  if (!solver->initialized)
+    return NULL;
+
+  res = g_slice_new (Constraint);
+  res->solver = solver;
+  res->variable = variable_ref (variable);
+  res->op_type = OPERATOR_TYPE_EQ;
+  res->strength = strength;
+  res->is_stay = false;
+  res->is_edit = true;
+
+  res->expression = expression_new (solver, variable_get_value (variable));
+  expression_add_variable (res->expression, variable, -1.0, NULL);
+
+  simplex_solver_add_constraint_internal (solver, res);
+
+  return res;
+}
+
+bool
+simplex_solver_has_edit_variable (SimplexSolver *solver,
+                                  Variable *variable)
+{
+  if (!solver->initialized)
+    return false;
+
+  return g_hash_table_contains (solver->edit_var_map, variable);
+}
+
+void
+simplex_solver_remove_edit_variable (SimplexSolver *solver,
+                                     Variable *variable)
+{
+  EditInfo *ei;
+
+  if (!solver->initialized)
+    {
+      g_critical ("Solver %p is not initialized.", solver);
+      return;
+    }
+
+  ei = g_hash_table_lookup (solver->edit_var_map, variable);
+  if (ei == NULL)
+    {
+      char *str = variable_to_string (variable);
+
+      g_critical ("Unknown edit variable '%s'", str);
+
+      g_free (str);
+
+      return;
+    }
+
+  simplex_solver_remove_constraint (solver, ei->constraint);
+}
+
+/* Removes the constraint from the tableau, without releasing it; the
+ * stay constants are reset first unless @reset_stays is false, which
+ * lets a batch of removals reset them only once
+ */
+static void
+simplex_solver_remove_constraint_internal (SimplexSolver *solver,
+                                           Constraint *constraint,
+                                           bool reset_stays)
+{
+  Expression *z_row;
+  VariableSet *error_vars;
+  GHashTableIter iter;
+  Variable *marker;
+
+  solver->needs_solving = true;
+
+  simplex_solver_journal_removed (solver, constraint);
+
+  if (reset_stays)
+    simplex_solver_reset_stay_constants (solver);
+
+  simplex_solver_journal_row (solver, solver->objective);
+  z_row = g_hash_table_lookup (solver->rows, solver->objective);
+  error_vars = g_hash_table_lookup (solver->error_vars, constraint);
+
+  if (error_vars != NULL)
+    {
+      Variable *v;
+
+      variable_set_iter_init (error_vars, &iter);
+      while (variable_set_iter_next (&iter, &v))
+        {
+          Expression *e;
+
+          e = g_hash_table_lookup (solver->rows, v);
+
+          if (e == NULL)
+            {
+              expression_add_variable (z_row,
+                                       v,
+                                       -1.0 * constraint->strength,
+                                       solver->objective);
+            }
+          else
+            {
+              expression_add_expression (z_row,
+                                         e,
+                                         -1.0 * constraint->strength,
+                                         solver->objective);
+            }
+        }
+    }
+
+  marker = g_hash_table_lookup (solver->marker_vars, constraint);
+  if (marker == NULL)
+    {
+      g_critical ("Constraint %p not found", constraint);
+      return;
+    }
+
+  g_hash_table_remove (solver->marker_vars, constraint);
+
+  if (g_hash_table_lookup (solver->rows, marker) == NULL)
+    {
+      VariableSet *set = g_hash_table_lookup (solver->columns, marker);
+      Variable *exit_var = NULL;
+      Variable *v;
+      double min_ratio = 0;
+
+      if (set == NULL)
+        goto no_columns;
+
+      variable_set_iter_init (set, &iter);
+      while (variable_set_iter_next (&iter, &v))
+        {
+          if (variable_is_restricted (v))
+            {
+              Expression *e = g_hash_table_lookup (solver->rows, v);
+              double coeff = expression_get_coefficient (e, marker);
+
+              if (coeff < 0.0)
+                {
+                  double r = -expression_get_constant (e) / coeff;
+
+                  if (exit_var == NULL ||
+                      r < min_ratio ||
+                      approx_val (r, min_ratio))
+                    {
+                      min_ratio = r;
+                      exit_var = v;
+                    }
+                }
+            }
+        }
+
+      if (exit_var == NULL)
+        {
+          variable_set_iter_init (set, &iter);
+          while (variable_set_iter_next (&iter, &v))
+            {
+              if (variable_is_restricted (v))
+                {
+                  Expression *e = g_hash_table_lookup (solver->rows, v);
+                  double coeff = expression_get_coefficient (e, marker);
+                  double r = 0.0;
+                  
+                  if (!approx_val (coeff, 0.0))
+                    r = expression_get_constant (e) / coeff;
+
+                  if (exit_var == NULL || r < min_ratio)
+                    {
+                      min_ratio = r;
+                      exit_var = v;
+                    }
+                }
+            }
+        }
+
+      if (exit_var == NULL)
+        {
+          if (variable_set_get_size (set) == 0)
+            simplex_solver_remove_column (solver, marker);
+          else
+            {
+              variable_set_iter_init (set, &iter);
+              while (variable_set_iter_next (&iter, &v))
+                {
+                  if (v != solver->objective)
+                    {
+                      exit_var = v;
+                      break;
+                    }
+                }
+            }
+        }
+
+      if (exit_var != NULL)
+        simplex_solver_pivot (solver, marker, exit_var);
+    }
+
+no_columns:
+  if (g_hash_table_lookup (solver->rows, marker) != NULL)
+    simplex_solver_remove_row (solver, marker);
+
+  if (error_vars != NULL)
+    {
+      Variable *v;
+
+      variable_set_iter_init (error_vars, &iter);
+      while (variable_set_iter_next (&iter, &v))
+        {
+          if (v != marker)
+            simplex_solver_remove_column (solver, v);
+        }
+    }
+
+  if (constraint_is_stay (constraint))
+    {
+      if (error_vars != NULL)
+        {
+          GPtrArray *remaining = g_ptr_array_new_with_free_func (variable_pair_free);
+          int i = 0;
+
+          for (i = 0; i < solver->stay_error_vars->len; i++)
+            {
+              VariablePair *pair = g_ptr_array_index (solver->stay_error_vars, i);
+              bool found = false;
+
+              if (variable_set_remove_variable (error_vars, pair->first))
+                found = true;
+
+              if (variable_set_remove_variable (error_vars, pair->second))
+                found = true;
+
+              if (!found)
+                g_ptr_array_add (remaining, variable_pair_new (pair->first, pair->second));
+            }
+
+          g_clear_pointer (&solver->stay_error_vars, g_ptr_array_unref);
+          solver->stay_error_vars = remaining;
+        }
+
+      g_hash_table_remove (solver->stay_var_map, constraint->variable);
+    }
+  else if (constraint_is_edit (constraint))
+    {
+      EditInfo *ei = g_hash_table_lookup (solver->edit_var_map, constraint->variable);
+
+      simplex_solver_remove_column (solver, ei->eminus);
+
+      g_hash_table_remove (solver->edit_var_map, constraint->variable);
+    }
+
+  if (error_vars != NULL)
+    g_hash_table_remove (solver->error_vars, constraint);
+}
+
+static void
+simplex_solver_remove_alias (SimplexSolver *solver,
+                             Constraint *constraint)
+{
+  AliasInfo *alias = g_hash_table_lookup (solver->alias_constraints, constraint);
+  GHashTable *dependent_vars, *visited;
+  GPtrArray *dependents;
+  bool auto_solve, changed;
+  int i;
+
+  solver->needs_solving = true;
+
+  dependent_vars = g_hash_table_new (NULL, NULL);
+  visited = g_hash_table_new (NULL, NULL);
+  dependents = g_ptr_array_new ();
+
+  g_hash_table_add (dependent_vars, alias->variable);
+  g_hash_table_add (visited, constraint);
+
+  /* Every constraint involving the aliased variable went through the
+   * substitution, so it has to be removed and added back once the alias
+   * is gone; this applies transitively to the aliases that have been
+   * defined in terms of the aliased variable
+   */
+  do
+    {
+      GHashTableIter iter;
+      gpointer key_p;
+
+      changed = false;
+
+      g_hash_table_iter_init (&iter, solver->constraints);
+      while (g_hash_table_iter_next (&iter, &key_p, NULL))
+        {
+          Constraint *c = key_p;
+          GHashTableIter var_iter;
+          gpointer var_p;
+
+          if (g_hash_table_contains (visited, c))
+            continue;
+
+          g_hash_table_iter_init (&var_iter, dependent_vars);
+          while (g_hash_table_iter_next (&var_iter, &var_p, NULL))
+            {
+              if (expression_has_variable (c->expression, var_p))
+                {
+                  AliasInfo *dep_alias = g_hash_table_lookup (solver->alias_constraints, c);
+
+                  g_hash_table_add (visited, c);
+                  g_ptr_array_add (dependents, c);
+
+                  if (dep_alias != NULL)
+                    g_hash_table_add (dependent_vars, dep_alias->variable);
+
+                  changed = true;
+                  break;
+                }
+            }
+        }
+    }
+  while (changed);
+
+  auto_solve = solver->auto_solve;
+  solver->auto_solve = false;
+
+  for (i = 0; i < dependents->len; i++)
+    {
+      Constraint *c = g_ptr_array_index (dependents, i);
+      AliasInfo *dep_alias = g_hash_table_lookup (solver->alias_constraints, c);
+
+      if (dep_alias != NULL)
+        simplex_solver_remove_alias_info (solver, dep_alias);
+      else
+        simplex_solver_remove_constraint_internal (solver, c, true);
+    }
+
+  simplex_solver_remove_alias_info (solver, alias);
+
+  for (i = 0; i < dependents->len; i++)
+    simplex_solver_add_constraint_internal (solver, g_ptr_array_index (dependents, i));
+
+  solver->auto_solve = auto_solve;
+
+  g_ptr_array_unref (dependents);
+  g_hash_table_unref (visited);
+  g_hash_table_unref (dependent_vars);
+}
+
+/* Removes @constraint from the solver, without solving the remaining
+ * constraints; if @disable is set, the constraint is kept in the set of
+ * disabled constraints instead of being released. Returns false if the
+ * constraint is unknown
+ */
+static bool
+simplex_solver_remove_constraint_full (SimplexSolver *solver,
+                                       Constraint *constraint,
+                                       bool reset_stays,
+                                       bool disable)
+{
+  if (!g_hash_table_contains (solver->constraints, constraint))
+    {
+      char *str = constraint_to_string (constraint);
+
+      g_critical ("Unknown constraint '%s', unable to remove it from solver", str);
+
+      g_free (str);
+
+      return false;
+    }
+
+  if (solver->has_pending_edits)
+    simplex_solver_resolve_internal (solver);
+
+  solver->serial += 1;
+  g_clear_pointer (&solver->compiled_basis, parametric_solution_free);
+
+  if (simplex_solver_is_difference_constraint (solver, constraint))
+    {
+      if (reset_stays)
+        simplex_solver_reset_difference_stays (solver);
+
+      g_ptr_array_remove (solver->difference_constraints, constraint);
+
+      if (constraint_is_edit (constraint))
+        g_hash_table_remove (solver->edit_var_map, constraint->variable);
+
+      if (constraint_is_stay (constraint))
+        g_hash_table_remove (solver->stay_var_map, constraint->variable);
+
+      /* Only the component of the constraint needs to be solved again */
+      difference_graph_remove_constraint (solver->difference_graph, constraint);
+
+      solver->needs_solving = true;
+    }
+  else if (g_hash_table_contains (solver->alias_constraints, constraint))
+    simplex_solver_remove_alias (solver, constraint);
+  else
+    simplex_solver_remove_constraint_internal (solver, constraint, reset_stays);
+
+  if (disable)
+    {
+      g_hash_table_steal (solver->constraints, constraint);
+      g_hash_table_add (solver->disabled_constraints, constraint);
+      return true;
+    }
+
+  /* A rollback can bring the constraint back */
+  if (solver->journal != NULL)
+    {
+      g_hash_table_steal (solver->constraints, constraint);
+      simplex_solver_journal_untracked (solver, constraint);
+    }
+  else
+    g_hash_table_remove (solver->constraints, constraint);
+
+  solver->removals_since_compact += 1;
+
+  return true;
+}
+
+/* Releases @constraint if it is disabled; returns false otherwise */
+static bool
+simplex_solver_remove_disabled_constraint (SimplexSolver *solver,
+                                           Constraint *constraint)
+{
+  if (!g_hash_table_contains (solver->disabled_constraints, constraint))
+    return false;
+
+  /* A rollback cannot bring a disabled constraint back */
+  if (solver->journal != NULL)
+    {
+      g_critical ("Unable to remove a disabled constraint inside a transaction");
+      return true;
+    }
+
+  g_hash_table_remove (solver->disabled_constraints, constraint);
+
+  return true;
+}
+
+static void
+simplex_solver_maybe_compact (SimplexSolver *solver)
+{
+  if (solver->compact_threshold > 0 &&
+      solver->removals_since_compact >= solver->compact_threshold &&
+      solver->journal == NULL)
+    simplex_solver_compact (solver);
+}
+
+void
+simplex_solver_remove_constraint (SimplexSolver *solver,
+                                  Constraint *constraint)
+{
+  if (!solver->initialized)
+    return;
+
+  if (simplex_solver_remove_disabled_constraint (solver, constraint))
+    return;
+
+  if (!simplex_solver_remove_constraint_full (solver, constraint, true, false))
+    return;
+
+  if (solver->auto_solve)
+    simplex_solver_solve_internal (solver);
+
+  simplex_solver_maybe_compact (solver);
+}
+
+/**
+ * simplex_solver_remove_constraints:
+ * @solver: a #SimplexSolver
+ * @constraints: the constraints to remove
+ * @n_constraints: the number of constraints
+ *
+ * Removes a batch of constraints from @solver.
+ *
+ * Unlike calling simplex_solver_remove_constraint() for each constraint,
+ * the values of the stay variables are reset once, and the remaining
+ * constraints are solved once, so the cost of the removal depends on the
+ * size of the batch instead of the number of stays and optimizations.
+ *
+ * Disabled constraints are released, and %NULL constraints are ignored.
+ */
+void
+simplex_solver_remove_constraints (SimplexSolver *solver,
+                                   Constraint **constraints,
+                                   int n_constraints)
+{
+  bool removed = false;
+  int i;
+
+  if (!solver->initialized)
+    return;
+
+  if (n_constraints == 0)
+    return;
+
+  if (solver->has_pending_edits)
+    simplex_solver_resolve_internal (solver);
+
+  /* The stay variables keep the values they had before the batch */
+  if (solver->difference_mode)
+    simplex_solver_reset_difference_stays (solver);
+  simplex_solver_reset_stay_constants (solver);
+
+  for (i = 0; i < n_constraints; i++)
+    {
+      if (constraints[i] == NULL)
+        continue;
+
+      if (simplex_solver_remove_disabled_constraint (solver, constraints[i]))
+        continue;
+
+      if (simplex_solver_remove_constraint_full (solver, constraints[i], false, false))
+        removed = true;
+    }
+
+  if (!removed)
+    return;
+
+  if (solver->auto_solve)
+    simplex_solver_solve_internal (solver);
+
+  simplex_solver_maybe_compact (solver);
+}
+
+/**
+ * simplex_solver_disable_constraints:
+ * @solver: a #SimplexSolver
+ * @constraints: the constraints to disable
+ * @n_constraints: the number of constraints
+ *
+ * Takes a batch of constraints out of the tableau of @solver, without
+ * releasing them; the constraints do not affect the solution until they
+ * are enabled again with simplex_solver_enable_constraints().
+ *
+ * Disabled constraints can still be removed with
+ * simplex_solver_remove_constraint().
+ *
+ * %NULL and disabled constraints are ignored.
+ */
+void
+simplex_solver_disable_constraints (SimplexSolver *solver,
+                                    Constraint **constraints,
+                                    int n_constraints)
+{
+  bool disabled = false;
+  int i;
+
+  if (!solver->initialized)
+    return;
+
+  if (solver->journal != NULL)
+    {
+      g_critical ("Unable to disable constraints of the SimplexSolver %p "
+                  "inside a transaction",
+                  solver);
+      return;
+    }
+
+  if (n_constraints == 0)
+    return;
+
+  if (solver->has_pending_edits)
+    simplex_solver_resolve_internal (solver);
+
+  /* The stay variables keep the values they had before the batch */
+  if (solver->difference_mode)
+    simplex_solver_reset_difference_stays (solver);
+  simplex_solver_reset_stay_constants (solver);
+
+  for (i = 0; i < n_constraints; i++)
+    {
+      if (constraints[i] == NULL)
+        continue;
+
+      if (g_hash_table_contains (solver->disabled_constraints, constraints[i]))
+        continue;
+
+      if (simplex_solver_remove_constraint_full (solver, constraints[i], false, true))
+        disabled = true;
+    }
+
+  if (disabled && solver->auto_solve)
+    simplex_solver_solve_internal (solver);
+}
+
+/**
+ * simplex_solver_enable_constraints:
+ * @solver: a #SimplexSolver
+ * @constraints: the constraints to enable
+ * @n_constraints: the number of constraints
+ *
+ * Adds back to the tableau of @solver a batch of constraints disabled
+ * by simplex_solver_disable_constraints().
+ *
+ * The required constraints that cannot be added directly to the tableau
+ * are made feasible together, with a single optimization.
+ *
+ * %NULL and enabled constraints are ignored.
+ */
+void
+simplex_solver_enable_constraints (SimplexSolver *solver,
+                                   Constraint **constraints,
+                                   int n_constraints)
+{
+  GPtrArray *artificial_vars;
+  bool auto_solve;
+  int i;
+
+  if (!solver->initialized)
+    return;
+
+  if (solver->journal != NULL)
+    {
+      g_critical ("Unable to enable constraints of the SimplexSolver %p "
+                  "inside a transaction",
+                  solver);
+      return;
+    }
+
+  auto_solve = solver->auto_solve;
+  solver->auto_solve = false;
+
+  /* The constraints that cannot be added directly keep their artificial
+   * variables until the whole group is in the tableau, so that a single
+   * optimization removes all of them
+   */
+  artificial_vars = g_ptr_array_new_with_free_func ((GDestroyNotify) variable_unref);
+
+  for (i = 0; i < n_constraints; i++)
+    {
+      if (constraints[i] == NULL)
+        continue;
+
+      if (!g_hash_table_steal (solver->disabled_constraints, constraints[i]))
+        continue;
+
+      simplex_solver_add_constraint_full (solver, constraints[i], artificial_vars);
+    }
+
+  simplex_solver_remove_artificial_variables (solver, artificial_vars);
+  g_ptr_array_unref (artificial_vars);
+
+  solver->auto_solve = auto_solve;
+
+  if (solver->auto_solve && solver->needs_solving)
+    simplex_solver_solve_internal (solver);
+}
+
+/**
+ * simplex_solver_is_constraint_disabled:
+ * @solver: a #SimplexSolver
+ * @constraint: a constraint of @solver
+ *
+ * Checks whether @constraint was disabled by simplex_solver_disable_constraints().
+ *
+ * Returns: true if the constraint is disabled
+ */
+bool
+simplex_solver_is_constraint_disabled (SimplexSolver *solver,
+                                       Constraint *constraint)
+{
+  if (!solver->initialized)
+    return false;
+
+  return g_hash_table_contains (solver->disabled_constraints, constraint);
+}
+
+/**
+ * simplex_solver_has_differences:
+ * @solver: a #SimplexSolver
+ *
+ * Checks whether some of the constraints of @solver are solved by the
+ * difference engine instead of the tableau; the other constraints are
+ * in the tableau.
+ *
+ * Returns: true if the difference engine holds constraints
+ */
+bool
+simplex_solver_has_differences (SimplexSolver *solver)
+{
+  if (!solver->initialized)
+    return false;
+
+  return solver->difference_mode && solver->difference_constraints->len > 0;
+}
+
+static void
+parametric_rows_append (GArray *rows,
+                        Variable *variable,
+                        Expression *expression,
+                        double coefficient)
+{
+  ParametricRow row = { variable, expression, coefficient };
+
+  g_array_append_val (rows, row);
+}
+
+/* Caches the rows of the tableau that a fast resolve updates, so that it
+ * does not need to look them up: the rows moved by each edit constant,
+ * with the same coefficients as simplex_solver_delta_edit_constant(),
+ * the rows of the stays, and the rows of the bounds
+ */
+static void
+simplex_solver_cache_basis_rows (SimplexSolver *solver,
+                                 ParametricSolution *basis)
+{
+  GArray *edit_rows, *stay_rows;
+  int i;
+
+  edit_rows = g_array_new (FALSE, FALSE, sizeof (ParametricRow));
+  basis->edit_offsets = g_new (int, basis->n_parameters + 1);
+
+  for (i = 0; i < basis->n_parameters; i++)
+    {
+      EditInfo *ei = g_hash_table_lookup (solver->edit_var_map, basis->parameters[i]);
+      VariableSet *column_set;
+      GHashTableIter iter;
+      Variable *basic_var;
+      Expression *expr;
+
+      basis->edit_offsets[i] = edit_rows->len;
+
+      expr = g_hash_table_lookup (solver->rows, ei->eplus);
+      if (expr != NULL)
+        {
+          parametric_rows_append (edit_rows, ei->eplus, expr, 1.0);
+          continue;
+        }
+
+      expr = g_hash_table_lookup (solver->rows, ei->eminus);
+      if (expr != NULL)
+        {
+          parametric_rows_append (edit_rows, ei->eminus, expr, -1.0);
+          continue;
+        }
+
+      column_set = g_hash_table_lookup (solver->columns, ei->eminus);
+      if (column_set == NULL)
+        continue;
+
+      variable_set_iter_init (column_set, &iter);
+      while (variable_set_iter_next (&iter, &basic_var))
+        {
+          expr = g_hash_table_lookup (solver->rows, basic_var);
+
+          parametric_rows_append (edit_rows, basic_var, expr,
+                                  expression_get_coefficient (expr, ei->eminus));
+        }
+    }
+
+  basis->edit_offsets[basis->n_parameters] = edit_rows->len;
+  basis->edit_rows = (ParametricRow *) (void *) g_array_free (edit_rows, FALSE);
+
+  stay_rows = g_array_new (FALSE, FALSE, sizeof (ParametricRow));
+
+  for (i = 0; i < solver->stay_error_vars->len; i++)
+    {
+      VariablePair *pair = g_ptr_array_index (solver->stay_error_vars, i);
+      Expression *expr;
+
+      expr = g_hash_table_lookup (solver->rows, pair->first);
+      if (expr != NULL)
+        {
+          parametric_rows_append (stay_rows, pair->first, expr, 0.0);
+          continue;
+        }
+
+      expr = g_hash_table_lookup (solver->rows, pair->second);
+      if (expr != NULL)
+        parametric_rows_append (stay_rows, pair->second, expr, 0.0);
+    }
+
+  basis->n_stay_rows = stay_rows->len;
+  basis->stay_rows = (ParametricRow *) (void *) g_array_free (stay_rows, FALSE);
+
+  basis->bound_rows = g_new (Expression *, basis->n_bounds);
+  for (i = 0; i < basis->n_bounds; i++)
+    basis->bound_rows[i] = g_hash_table_lookup (solver->rows, basis->bound_variables[i]);
+}
+
+static void
+simplex_solver_compile_basis (SimplexSolver *solver)
+{
+  Variable **parameters;
+  GHashTableIter iter;
+  gpointer key_p;
+  int n_parameters = 0;
+
+  parameters = g_newa (Variable *, g_hash_table_size (solver->edit_var_map));
+
+  /* The edit variables of the graph are not in the tableau; suggesting
+   * a value for them drops the compiled basis
+   */
+  g_hash_table_iter_init (&iter, solver->edit_var_map);
+  while (g_hash_table_iter_next (&iter, &key_p, NULL))
+    {
+      if (!simplex_solver_is_difference_variable (solver, key_p))
+        parameters[n_parameters++] = key_p;
+    }
+
+  solver->compiled_basis =
+    simplex_solver_get_parametric_solution (solver, parameters, n_parameters);
+
+  if (solver->compiled_basis != NULL)
+    simplex_solver_cache_basis_rows (solver, solver->compiled_basis);
+}
+
+/* Moves the origin of the compiled basis to @parameters, once the
+ * tableau caught up with them; the basic variables are the same, so
+ * only the constant of each form changes. The bounds are read back from
+ * the tableau, as resetting the stay constants moves them
+ */
+static void
+simplex_solver_rebase_compiled_basis (SimplexSolver *solver,
+                                      ParametricSolution *basis,
+                                      const double *parameters)
+{
+  int stride = basis->n_parameters + 1;
+  int i, j;
+
+  for (i = 0; i < basis->n_values; i++)
+    {
+      double *form = basis->values + (i * stride);
+
+      for (j = 0; j < basis->n_parameters; j++)
+        form[0] += form[j + 1] * (parameters[j] - basis->origin[j]);
+    }
+
+  for (i = 0; i < basis->n_bounds; i++)
+    basis->bounds[i * stride] = expression_get_constant (basis->bound_rows[i]);
+
+  for (i = 0; i < basis->n_parameters; i++)
+    basis->origin[i] = parameters[i];
+}
+
+/* If the suggested values keep the compiled basis feasible, we can
+ * evaluate the values of the variables directly, and skip the dual
+ * simplex; the tableau still takes the new edit constants, and the stay
+ * constants are reset, so that the next resolve starts from the same
+ * tableau as after a full resolve. The rows are updated through the
+ * ones cached in the basis, without looking them up in the tableau
+ */
+static bool
+simplex_solver_try_fast_resolve (SimplexSolver *solver)
+{
+  ParametricSolution *basis = solver->compiled_basis;
+  double *values;
+  int i;
+
+  if (!solver->has_pending_edits || basis == NULL)
+    return false;
+
+  if (basis->serial != solver->serial)
+    return false;
+
+  values = g_newa (double, basis->n_parameters);
+  for (i = 0; i < basis->n_parameters; i++)
+    {
+      EditInfo *ei = g_hash_table_lookup (solver->edit_var_map, basis->parameters[i]);
+
+      values[i] = ei->suggested_value;
+    }
+
+  if (!parametric_solution_apply (basis, values))
+    return false;
+
+  /* The basis is feasible, so the rows are not queued as infeasible, even
+   * if they end up within the tolerance below zero
+   */
+  for (i = 0; i < basis->n_parameters; i++)
+    {
+      EditInfo *ei = g_hash_table_lookup (solver->edit_var_map, basis->parameters[i]);
+      double delta = values[i] - ei->prev_constant;
+      int j;
+
+      if (delta == 0.0)
+        continue;
+
+      ei->prev_constant = values[i];
+
+      for (j = basis->edit_offsets[i]; j < basis->edit_offsets[i + 1]; j++)
+        {
+          const ParametricRow *row = &basis->edit_rows[j];
+
+          simplex_solver_journal_row (solver, row->variable);
+          expression_set_constant (row->expression,
+                                   expression_get_constant (row->expression) +
+                                   row->coefficient * delta);
+        }
+    }
+
+  for (i = 0; i < basis->n_stay_rows; i++)
+    {
+      const ParametricRow *row = &basis->stay_rows[i];
+
+      if (expression_get_constant (row->expression) != 0.0)
+        {
+          simplex_solver_journal_row (solver, row->variable);
+          expression_set_constant (row->expression, 0.0);
+        }
+    }
+
+  simplex_solver_rebase_compiled_basis (solver, basis, values);
+
+  solver->has_pending_edits = false;
+  solver->needs_solving = false;
+
+  return true;
+}
+
+void
+simplex_solver_suggest_value (SimplexSolver *solver,
+                              Variable *variable,
+                              double value)
+{
+  EditInfo *ei;
+  double delta;
+
+  if (!solver->initialized)
+    {
+      char *str = variable_to_string (variable);
+
+      g_critical ("Unable to suggest value '%g' for variable '%s': the "
+                  "SimplexSolver %p is not initialized.",
+                  value, str, solver);
+
+      g_free (str);
+      return;
+    }
+
+  ei = g_hash_table_lookup (solver->edit_var_map, variable);
+  if (ei == NULL)
+    {
+      g_critical ("Suggesting value '%g' but variable %p is not editable",
+                  value, variable);
+      return;
+    }
+
+  if (simplex_solver_is_difference_variable (solver, variable))
+    {
+      /* The edit constraint is in the form: value - variable = 0; the
+       * compiled basis does not cover the variables of the graph
+       */
+      expression_set_constant (ei->constraint->expression, value);
+      ei->prev_constant = value;
+      ei->suggested_value = value;
+      difference_graph_invalidate (solver->difference_graph, variable);
+      g_clear_pointer (&solver->compiled_basis, parametric_solution_free);
+      solver->needs_solving = true;
+      return;
+    }
+
+  /* The edit constants can only be changed in an optimal tableau */
+  if (solver->needs_solving)
+    simplex_solver_solve_internal (solver);
+
+  ei->suggested_value = value;
+
+  /* Compile the current basis, so that simplex_solver_resolve() can
+   * skip the dual simplex if the suggested values keep it feasible
+   */
+  if (solver->compiled_basis == NULL &&
+      !solver->needs_solving &&
+      !solver->has_pending_edits)
+    simplex_solver_compile_basis (solver);
+
+  if (solver->compiled_basis != NULL)
+    {
+      solver->has_pending_edits = true;
+      return;
+    }
+
+  delta = value - ei->prev_constant;
+  ei->prev_constant = value;
+
+  simplex_solver_delta_edit_constant (solver, delta, ei->eplus, ei->eminus);
+}
+
+void
+simplex_solver_resolve (SimplexSolver *solver)
+{
+  if (!solver->initialized)
+    {
+      g_critical ("Unable to resolve the simplex: the SimplexSolver %p "
+                  "is not initialized",
+                  solver);
+      return;
+    }
+
+#ifdef EMEUS_ENABLE_DEBUG
+  gint64 start_time = g_get_monotonic_time ();
+#endif
+
+  /* The constraints changed while the solver was not solving them
+   * automatically, and the dual simplex needs an optimal tableau; this
+   * also solves the components of the difference engine
+   */
+  if (solver->needs_solving)
+    simplex_solver_solve_internal (solver);
+
+  if (simplex_solver_try_fast_resolve (solver))
+    solver->fast_resolve_count += 1;
+  else
+    simplex_solver_resolve_internal (solver);
+
+  if (solver->difference_mode)
+    simplex_solver_reset_difference_stays (solver);
+
+#ifdef EMEUS_ENABLE_DEBUG
+  g_debug ("resolve.time := %.3f ms",
+           (float) (g_get_monotonic_time () - start_time) / 1000.f);
+#endif
+}
+
+/**
+ * simplex_solver_resolve_with_budget:
+ * @solver: a #SimplexSolver
+ * @max_pivots: the maximum number of pivots, or 0 for no limit
+ * @max_time: the maximum time to spend, in microseconds, or 0 for no limit
+ *
+ * Like simplex_solver_resolve(), but stops once @max_pivots pivots were
+ * done, or once @max_time microseconds passed, whichever comes first; at
+ * least one pivot is done on each call.
+ *
+ * If the constraints changed since the last time they were solved, the
+ * variables are updated with a solution that satisfies the constraints,
+ * even if it is not optimal yet. If only the suggested values changed,
+ * the variables keep their previous values until the new solution is
+ * found.
+ *
+ * Calling this function again resumes the work where it stopped; all
+ * the other functions finish the pending work before changing @solver.
+ *
+ * Returns: %true if the solution is optimal, and %false if this function
+ *   needs to be called again
+ */
+bool
+simplex_solver_resolve_with_budget (SimplexSolver *solver,
+                                    int max_pivots,
+                                    gint64 max_time)
+{
+  SolverBudget budget;
+
+  if (!solver->initialized)
+    {
+      g_critical ("Unable to resolve the simplex: the SimplexSolver %p "
+                  "is not initialized",
+                  solver);
+      return true;
+    }
+
+  /* The difference engine does not pivot, so its components are solved
+   * outside of the budget; the ones it cannot solve join the tableau
+   */
+  if (solver->difference_mode && solver->needs_solving)
+    {
+      simplex_solver_solve_differences (solver);
+      simplex_solver_reset_difference_stays (solver);
+    }
+
+  solver_budget_init (&budget, max_pivots, max_time);
+
+  if (solver->needs_solving)
+    {
+      bool done = simplex_solver_optimize_with_budget (solver, solver->objective, &budget);
+
+      /* The primal simplex keeps the tableau feasible, so the values of
+       * the variables satisfy the constraints, even before the optimum
+       */
+      simplex_solver_set_external_variables (solver);
+
+      if (!done)
+        {
+          solver->needs_solving = true;
+          return false;
+        }
+    }
+
+  if (simplex_solver_try_fast_resolve (solver))
+    {
+      solver->fast_resolve_count += 1;
+      return true;
+    }
+
+  return simplex_solver_resolve_internal_with_budget (solver, &budget);
+}
+
+/**
+ * simplex_solver_set_auto_solve:
+ * @solver: a #SimplexSolver
+ * @auto_solve: whether to solve the constraints automatically
+ *
+ * Sets whether @solver should solve its constraints every time one is
+ * added or removed.
+ *
+ * Disabling automatic solving is useful when adding or removing many
+ * constraints at once; simplex_solver_solve() solves all of them in
+ * one pass. Enabling automatic solving solves the pending changes.
+ */
+void
+simplex_solver_set_auto_solve (SimplexSolver *solver,
+                               bool auto_solve)
+{
+  if (!solver->initialized)
+    return;
+
+  solver->auto_solve = auto_solve;
+
+  if (solver->auto_solve)
+    simplex_solver_solve (solver);
+}
+
+/**
+ * simplex_solver_solve:
+ * @solver: a #SimplexSolver
+ *
+ * Solves the constraints added to, or removed from @solver since it was
+ * last solved, and updates the values of the variables.
+ *
+ * This function is only needed if automatic solving was disabled with
+ * simplex_solver_set_auto_solve().
+ */
+void
+simplex_solver_solve (SimplexSolver *solver)
+{
+  if (!solver->initialized)
+    return;
+
+  if (!solver->needs_solving)
+    return;
+
+  simplex_solver_solve_internal (solver);
+}
+
+void
+simplex_solver_begin_edit (SimplexSolver *solver)
+{
+  if (g_hash_table_size (solver->edit_var_map) == 0)
+    {
+      g_critical ("Solver %p does not have editable variables.", solver);
+      return;
+    }
+
+  /* The stay constants are reset at the end of a full resolve, and the
+   * tableau is left untouched while it lags behind the suggestions
+   */
+  if (solver->has_pending_edits)
+    return;
+
+  simplex_solver_clear_infeasible_rows (solver);
+  simplex_solver_reset_stay_constants (solver);
+}
+
+
+void
+simplex_solver_end_edit (SimplexSolver *solver)
+{
+  simplex_solver_resolve (solver);
+}
+
+/* Forking
+ *
+ * A fork is a deep copy of the solver: every variable, expression and
+ * constraint is duplicated, so the fork and its parent can be modified
+ * and solved independently, and from different threads. The variables
+ * keep their identifiers, so that the fork makes the same choices as
+ * its parent when pivoting.
+ *
+ * Forking is O(n) in the size of the solver, however few rows the fork
+ * changes afterwards. The rows cannot be shared copy-on-write between a
+ * fork and its parent: they refer to variables, and each variable holds
+ * the value and the bookkeeping of a single solver.
+ */
+
+static Variable *
+fork_variable (SimplexSolver *fork,
+               Variable *variable)
+{
+  Variable *res;
+
+  if (variable == NULL)
+    return NULL;
+
+  res = g_hash_table_lookup (fork->forked_variables, variable);
+  if (res == NULL)
+    {
+      res = variable_clone (variable, fork);
+      g_hash_table_insert (fork->forked_variables, variable, res);
+    }
+
+  return res;
+}
+
+static Expression *
+fork_expression (SimplexSolver *fork,
+                 Expression *expression)
+{
+  Expression *res = expression_new (fork, expression_get_constant (expression));
+  GList *l;
+
+  /* The terms are sorted by variable id, and the copies keep the ids;
+   * adding them in reverse order always inserts at the head of the list
+   */
+  for (l = g_list_last (expression->ordered_terms); l != NULL; l = l->prev)
+    {
+      Term *t = l->data;
+
+      expression_set_variable (res,
+                               fork_variable (fork, term_get_variable (t)),
+                               term_get_coefficient (t));
+    }
+
+  return res;
+}
+
+static Constraint *
+fork_constraint (SimplexSolver *fork,
+                 Constraint *constraint)
+{
+  Constraint *res;
+
+  if (constraint == NULL)
+    return NULL;
+
+  res = g_hash_table_lookup (fork->forked_constraints, constraint);
+  if (res != NULL)
+    return res;
+
+  res = g_slice_new (Constraint);
+  res->solver = fork;
+  res->expression = fork_expression (fork, constraint->expression);
+  res->op_type = constraint->op_type;
+  res->strength = constraint->strength;
+  res->is_edit = constraint->is_edit;
+  res->is_stay = constraint->is_stay;
+  res->variable = fork_variable (fork, constraint->variable);
+
+  if (res->is_edit || res->is_stay)
+    variable_ref (res->variable);
+
+  g_hash_table_insert (fork->forked_constraints, constraint, res);
+
+  return res;
+}
+
+static VariableSet *
+fork_variable_set (SimplexSolver *fork,
+                   VariableSet *set)
+{
+  VariableSet *res = variable_set_new ();
+  GHashTableIter iter;
+  Variable *v;
+
+  variable_set_iter_init (set, &iter);
+  while (variable_set_iter_next (&iter, &v))
+    variable_set_add_variable (res, fork_variable (fork, v));
+
+  return res;
+}
+
+static ParametricSolution *
+fork_parametric_solution (SimplexSolver *fork,
+                          const ParametricSolution *solution)
+{
+  ParametricSolution *res = g_slice_new0 (ParametricSolution);
+  int stride = solution->n_parameters + 1;
+  int i;
+
+  res->solver = fork;
+  res->serial = solution->serial;
+
+  res->n_parameters = solution->n_parameters;
+  res->parameters = g_new (Variable *, solution->n_parameters);
+  res->origin = g_new (double, solution->n_parameters);
+  memcpy (res->origin, solution->origin, sizeof (double) * solution->n_parameters);
+  for (i = 0; i < solution->n_parameters; i++)
+    res->parameters[i] = variable_ref (fork_variable (fork, solution->parameters[i]));
+
+  res->n_values = solution->n_values;
+  res->variables = g_new (Variable *, solution->n_values);
+  res->values = g_new (double, solution->n_values * stride);
+  memcpy (res->values, solution->values, sizeof (double) * solution->n_values * stride);
+  for (i = 0; i < solution->n_values; i++)
+    res->variables[i] = variable_ref (fork_variable (fork, solution->variables[i]));
+
+  res->n_bounds = solution->n_bounds;
+  res->bound_variables = g_new (Variable *, solution->n_bounds);
+  res->bounds = g_new (double, solution->n_bounds * stride);
+  memcpy (res->bounds, solution->bounds, sizeof (double) * solution->n_bounds * stride);
+  for (i = 0; i < solution->n_bounds; i++)
+    res->bound_variables[i] = variable_ref (fork_variable (fork, solution->bound_variables[i]));
+
+  return res;
+}
+
+/**
+ * simplex_solver_fork:
+ * @solver: the solver to copy
+ * @fork: an uninitialized solver
+ *
+ * Initializes @fork with a copy of the state of @solver.
+ *
+ * Forking is O(n) in time and memory, where n is the size of @solver:
+ * the terms of every row of the tableau, and the variables and the
+ * constraints, are copied, even if the fork only changes a few of them
+ * afterwards. In exchange, the fork does not share any state with its
+ * parent, and can be solved in a separate thread.
+ *
+ * Use simplex_solver_get_forked_variable() and
+ * simplex_solver_get_forked_constraint() to find the copies of the
+ * variables and constraints of @solver inside @fork.
+ *
+ * Once created, the fork is independent from @solver, and it must be
+ * cleared with simplex_solver_clear().
+ */
+void
+simplex_solver_fork (SimplexSolver *solver,
+                     SimplexSolver *fork)
+{
+  GHashTableIter iter;
+  gpointer key_p, value_p;
+  int i;
+
+  if (!solver->initialized)
+    {
+      g_critical ("Unable to fork the SimplexSolver %p: the solver is "
+                  "not initialized.",
+                  solver);
+      return;
+    }
+
+  simplex_solver_init (fork);
+
+  /* HashTable<Variable, Variable>; the keys belong to the parent, and
+   * the table owns a reference on the values
+   */
+  fork->forked_variables = g_hash_table_new_full (NULL, NULL,
+                                                  NULL,
+                                                  (GDestroyNotify) variable_unref);
+
+  /* HashTable<Constraint, Constraint>; owns neither keys nor values */
+  fork->forked_constraints = g_hash_table_new (NULL, NULL);
+
+  /* Replace the objective row created by simplex_solver_init() */
+  g_hash_table_remove (fork->rows, fork->objective);
+  fork->objective = fork_variable (fork, solver->objective);
+
+  g_hash_table_iter_init (&iter, solver->constraints);
+  while (g_hash_table_iter_next (&iter, &key_p, NULL))
+    g_hash_table_add (fork->constraints, fork_constraint (fork, key_p));
+
+  g_hash_table_iter_init (&iter, solver->disabled_constraints);
+  while (g_hash_table_iter_next (&iter, &key_p, NULL))
+    g_hash_table_add (fork->disabled_constraints, fork_constraint (fork, key_p));
+
+  g_hash_table_iter_init (&iter, solver->rows);
+  while (g_hash_table_iter_next (&iter, &key_p, &value_p))
+    g_hash_table_insert (fork->rows,
+                         variable_ref (fork_variable (fork, key_p)),
+                         fork_expression (fork, value_p));
+
+  g_hash_table_iter_init (&iter, solver->columns);
+  while (g_hash_table_iter_next (&iter, &key_p, &value_p))
+    g_hash_table_insert (fork->columns,
+                         variable_ref (fork_variable (fork, key_p)),
+                         fork_variable_set (fork, value_p));
+
+  g_hash_table_iter_init (&iter, solver->external_rows);
+  while (g_hash_table_iter_next (&iter, &key_p, NULL))
+    g_hash_table_add (fork->external_rows, variable_ref (fork_variable (fork, key_p)));
+
+  g_hash_table_iter_init (&iter, solver->external_parametric_vars);
+  while (g_hash_table_iter_next (&iter, &key_p, NULL))
+    g_hash_table_add (fork->external_parametric_vars, variable_ref (fork_variable (fork, key_p)));
+
+  for (i = 0; i < solver->infeasible_rows->len; i++)
+    simplex_solver_queue_infeasible_row (fork,
+                                         fork_variable (fork, g_ptr_array_index (solver->infeasible_rows, i)));
+
+  for (i = 0; i < solver->stay_error_vars->len; i++)
+    {
+      VariablePair *pair = g_ptr_array_index (solver->stay_error_vars, i);
+
+      g_ptr_array_add (fork->stay_error_vars,
+                       variable_pair_new (fork_variable (fork, pair->first),
+                                          fork_variable (fork, pair->second)));
+    }
+
+  g_hash_table_iter_init (&iter, solver->error_vars);
+  while (g_hash_table_iter_next (&iter, &key_p, &value_p))
+    g_hash_table_insert (fork->error_vars,
+                         fork_constraint (fork, key_p),
+                         fork_variable_set (fork, value_p));
+
+  g_hash_table_iter_init (&iter, solver->marker_vars);
+  while (g_hash_table_iter_next (&iter, &key_p, &value_p))
+    g_hash_table_insert (fork->marker_vars,
+                         fork_constraint (fork, key_p),
+                         fork_variable (fork, value_p));
+
+  g_hash_table_iter_init (&iter, solver->edit_var_map);
+  while (g_hash_table_iter_next (&iter, &key_p, &value_p))
+    {
+      EditInfo *ei = value_p;
+      EditInfo *res = g_slice_new (EditInfo);
+
+      res->constraint = fork_constraint (fork, ei->constraint);
+      res->eplus = fork_variable (fork, ei->eplus);
+      res->eminus = fork_variable (fork, ei->eminus);
+      res->prev_constant = ei->prev_constant;
+      res->suggested_value = ei->suggested_value;
+
+      g_hash_table_insert (fork->edit_var_map, fork_variable (fork, key_p), res);
+    }
+
+  g_hash_table_iter_init (&iter, solver->stay_var_map);
+  while (g_hash_table_iter_next (&iter, &key_p, &value_p))
+    {
+      StayInfo *si = value_p;
+      StayInfo *res = g_slice_new (StayInfo);
+
+      res->constraint = fork_constraint (fork, si->constraint);
+
+      g_hash_table_insert (fork->stay_var_map, fork_variable (fork, key_p), res);
+    }
+
+  g_hash_table_iter_init (&iter, solver->alias_vars);
+  while (g_hash_table_iter_next (&iter, &key_p, &value_p))
+    {
+      AliasInfo *alias = value_p;
+      AliasInfo *res = g_slice_new (AliasInfo);
+
+      res->constraint = fork_constraint (fork, alias->constraint);
+      res->variable = variable_ref (fork_variable (fork, alias->variable));
+      res->representative = variable_ref (fork_variable (fork, alias->representative));
+      res->scale = alias->scale;
+      res->offset = alias->offset;
+
+      g_hash_table_insert (fork->alias_vars, res->variable, res);
+      g_hash_table_insert (fork->alias_constraints, res->constraint, res);
+    }
+
+  g_hash_table_iter_init (&iter, solver->alias_representatives);
+  while (g_hash_table_iter_next (&iter, &key_p, &value_p))
+    g_hash_table_insert (fork->alias_representatives, fork_variable (fork, key_p), value_p);
+
+  fork->difference_mode = solver->difference_mode;
+  if (!solver->difference_mode)
+    g_clear_pointer (&fork->difference_constraints, g_ptr_array_unref);
+  else
+    {
+      for (i = 0; i < solver->difference_constraints->len; i++)
+        g_ptr_array_add (fork->difference_constraints,
+                         fork_constraint (fork, g_ptr_array_index (solver->difference_constraints, i)));
+    }
+
+  fork->slack_counter = solver->slack_counter;
+  fork->artificial_counter = solver->artificial_counter;
+  fork->dummy_counter = solver->dummy_counter;
+  fork->serial = solver->serial;
+
+  fork->auto_solve = solver->auto_solve;
+  fork->needs_solving = solver->needs_solving;
+  fork->has_pending_edits = solver->has_pending_edits;
+
+  /* The pending edits of the parent are resolved with its compiled
+   * basis, so the fork needs it to find the same solution
+   */
+  if (solver->compiled_basis != NULL)
+    {
+      fork->compiled_basis = fork_parametric_solution (fork, solver->compiled_basis);
+      simplex_solver_cache_basis_rows (fork, fork->compiled_basis);
+    }
+
+  fork->n_degenerate_pivots = solver->n_degenerate_pivots;
+  fork->use_bland = solver->use_bland;
+}
+
+/**
+ * simplex_solver_get_forked_variable:
+ * @fork: a solver initialized by simplex_solver_fork()
+ * @variable: a variable of the parent solver
+ *
+ * Retrieves the copy of @variable inside @fork; variables that the
+ * parent solver did not know about when @fork was created are copied
+ * on demand, so that new constraints can refer to them.
+ *
+ * Returns: (transfer none): a variable of @fork
+ */
+Variable *
+simplex_solver_get_forked_variable (SimplexSolver *fork,
+                                    Variable *variable)
+{
+  if (fork->forked_variables == NULL)
+    {
+      g_critical ("The SimplexSolver %p is not a fork", fork);
+      return NULL;
+    }
+
+  return fork_variable (fork, variable);
+}
+
+/**
+ * simplex_solver_get_forked_constraint:
+ * @fork: a solver initialized by simplex_solver_fork()
+ * @constraint: a constraint of the parent solver
+ *
+ * Retrieves the copy of @constraint inside @fork.
+ *
+ * Returns: (transfer none) (nullable): a constraint of @fork, or %NULL
+ *   if the parent solver did not have @constraint when @fork was created
+ */
+Constraint *
+simplex_solver_get_forked_constraint (SimplexSolver *fork,
+                                      Constraint *constraint)
+{
+  if (fork->forked_constraints == NULL)
+    {
+      g_critical ("The SimplexSolver %p is not a fork", fork);
+      return NULL;
+    }
+
+  return g_hash_table_lookup (fork->forked_constraints, constraint);
+}
+
+/* Checks whether @variable is still referenced by the tableau of @solver,
+ * without dereferencing it, as it may have been freed since the fork
+ */
+static bool
+simplex_solver_has_variable (SimplexSolver *solver,
+                             Variable *variable)
+{
+  return g_hash_table_contains (solver->rows, variable) ||
+         g_hash_table_contains (solver->columns, variable) ||
+         g_hash_table_contains (solver->edit_var_map, variable) ||
+         g_hash_table_contains (solver->stay_var_map, variable) ||
+         g_hash_table_contains (solver->alias_vars, variable) ||
+         g_hash_table_contains (solver->alias_representatives, variable);
+}
+
+typedef struct {
+  GHashTable *parents;
+  bool is_valid;
+} UnforkClosure;
+
+static bool
+check_unforked_term (Term *term,
+                     gpointer data)
+{
+  UnforkClosure *closure = data;
+
+  if (!g_hash_table_contains (closure->parents, term_get_variable (term)))
+    closure->is_valid = false;
+
+  return closure->is_valid;
+}
+
+static Expression *
+unfork_expression (SimplexSolver *solver,
+                   GHashTable *parents,
+                   Expression *expression)
+{
+  Expression *res = expression_new (solver, expression_get_constant (expression));
+  GList *l;
+
+  /* See fork_expression() */
+  for (l = g_list_last (expression->ordered_terms); l != NULL; l = l->prev)
+    {
+      Term *t = l->data;
+
+      expression_set_variable (res,
+                               g_hash_table_lookup (parents, term_get_variable (t)),
+                               term_get_coefficient (t));
+    }
+
+  return res;
+}
+
+/**
+ * simplex_solver_merge_fork:
+ * @solver: a #SimplexSolver
+ * @fork: a solver initialized by simplex_solver_fork() from @solver
+ *
+ * Replaces the tableau of @solver, and the values of its variables,
+ * with the ones of @fork.
+ *
+ * This allows solving the constraints of @solver on a copy, for instance
+ * in a separate thread, and bringing the result back in a time that is
+ * proportional to the size of the tableau, instead of solving again.
+ *
+ * The constraints of @solver must not have changed since @fork was
+ * created, and no constraint must have been added to, or removed from
+ * @fork. The values suggested to @solver are kept: if they differ from
+ * the ones suggested to @fork, they are applied on the next call to
+ * simplex_solver_resolve().
+ *
+ * Returns: %true if the tableau of @fork was merged into @solver
+ */
+bool
+simplex_solver_merge_fork (SimplexSolver *solver,
+                           SimplexSolver *fork)
+{
+  GHashTable *parents, *rows, *columns, *external_rows, *external_parametric_vars;
+  UnforkClosure closure;
+  GHashTableIter iter;
+  gpointer key_p, value_p;
+  bool has_pending_edits;
+  int i;
+
+  if (!solver->initialized || fork->forked_variables == NULL)
+    {
+      g_critical ("The SimplexSolver %p is not a fork of the SimplexSolver %p",
+                  fork, solver);
+      return false;
+    }
+
+  /* The difference engine does not have a tableau, and transactions
+   * would need to record the whole tableau
+   */
+  if (fork->serial != solver->serial ||
+      simplex_solver_has_differences (solver) ||
+      simplex_solver_has_differences (fork) ||
+      solver->journal != NULL || fork->journal != NULL)
+    return false;
+
+  /* HashTable<Variable, Variable>; maps the variables of the fork to the
+   * variables of @solver that are still in use
+   */
+  parents = g_hash_table_new (NULL, NULL);
+
+  g_hash_table_iter_init (&iter, fork->forked_variables);
+  while (g_hash_table_iter_next (&iter, &key_p, &value_p))
+    {
+      if (simplex_solver_has_variable (solver, key_p))
+        g_hash_table_insert (parents, value_p, key_p);
+    }
+
+  /* Check that the tableau of the fork only refers to known variables
+   * before changing anything
+   */
+  closure.parents = parents;
+  closure.is_valid = true;
+
+  g_hash_table_iter_init (&iter, fork->rows);
+  while (g_hash_table_iter_next (&iter, &key_p, &value_p))
+    {
+      if (!g_hash_table_contains (parents, key_p))
+        goto out;
+
+      expression_terms_foreach (value_p, check_unforked_term, &closure);
+      if (!closure.is_valid)
+        goto out;
+    }
+
+  g_hash_table_iter_init (&iter, fork->columns);
+  while (g_hash_table_iter_next (&iter, &key_p, NULL))
+    {
+      if (!g_hash_table_contains (parents, key_p))
+        goto out;
+    }
+
+  rows = g_hash_table_new_full (NULL, NULL,
+                                (GDestroyNotify) variable_unref,
+                                (GDestroyNotify) expression_unref);
+  g_hash_table_iter_init (&iter, fork->rows);
+  while (g_hash_table_iter_next (&iter, &key_p, &value_p))
+    g_hash_table_insert (rows,
+                         variable_ref (g_hash_table_lookup (parents, key_p)),
+                         unfork_expression (solver, parents, value_p));
+
+  columns = g_hash_table_new_full (NULL, NULL,
+                                   (GDestroyNotify) variable_unref,
+                                   variable_set_free);
+  g_hash_table_iter_init (&iter, fork->columns);
+  while (g_hash_table_iter_next (&iter, &key_p, &value_p))
+    {
+      VariableSet *set = variable_set_new ();
+      GHashTableIter set_iter;
+      Variable *v;
+
+      variable_set_iter_init (value_p, &set_iter);
+      while (variable_set_iter_next (&set_iter, &v))
+        {
+          Variable *parent = g_hash_table_lookup (parents, v);
+
+          /* Rows that are not in the tableau any more, like the ones
+           * of the artificial objectives, are dropped
+           */
+          if (parent != NULL)
+            variable_set_add_variable (set, parent);
+        }
+
+      g_hash_table_insert (columns, variable_ref (g_hash_table_lookup (parents, key_p)), set);
+    }
+
+  external_rows = g_hash_table_new_full (NULL, NULL,
+                                         (GDestroyNotify) variable_unref,
+                                         NULL);
+  g_hash_table_iter_init (&iter, fork->external_rows);
+  while (g_hash_table_iter_next (&iter, &key_p, NULL))
+    g_hash_table_add (external_rows, variable_ref (g_hash_table_lookup (parents, key_p)));
+
+  external_parametric_vars = g_hash_table_new_full (NULL, NULL,
+                                                    (GDestroyNotify) variable_unref,
+                                                    NULL);
+  g_hash_table_iter_init (&iter, fork->external_parametric_vars);
+  while (g_hash_table_iter_next (&iter, &key_p, NULL))
+    {
+      Variable *v = g_hash_table_lookup (parents, key_p);
+
+      if (v != NULL)
+        g_hash_table_add (external_parametric_vars, variable_ref (v));
+    }
+
+  simplex_solver_clear_infeasible_rows (solver);
+
+  /* The new tables hold references on the variables that are still in
+   * use; the columns need to be deleted last, for reference counting
+   */
+  g_hash_table_unref (solver->rows);
+  g_hash_table_unref (solver->columns);
+  g_hash_table_unref (solver->external_rows);
+  g_hash_table_unref (solver->external_parametric_vars);
+
+  solver->rows = rows;
+  solver->columns = columns;
+  solver->external_rows = external_rows;
+  solver->external_parametric_vars = external_parametric_vars;
+
+  for (i = 0; i < fork->infeasible_rows->len; i++)
+    {
+      Variable *v = g_hash_table_lookup (parents, g_ptr_array_index (fork->infeasible_rows, i));
+
+      if (v != NULL && g_hash_table_contains (solver->rows, v))
+        simplex_solver_queue_infeasible_row (solver, v);
+    }
+
+  g_hash_table_iter_init (&iter, parents);
+  while (g_hash_table_iter_next (&iter, &key_p, &value_p))
+    {
+      Variable *fork_var = key_p;
+      Variable *v = value_p;
+
+      v->value = fork_var->value;
+    }
+
+  /* The edit constants follow the tableau of the fork, but the values
+   * suggested to @solver win over the ones suggested to the fork
+   */
+  has_pending_edits = fork->has_pending_edits;
+
+  g_hash_table_iter_init (&iter, solver->edit_var_map);
+  while (g_hash_table_iter_next (&iter, &key_p, &value_p))
+    {
+      EditInfo *ei = value_p;
+      EditInfo *fork_ei;
+      double suggested_value = ei->suggested_value;
+
+      fork_ei = g_hash_table_lookup (fork->edit_var_map,
+                                     g_hash_table_lookup (fork->forked_variables, key_p));
+      if (fork_ei == NULL)
+        continue;
+
+      ei->prev_constant = fork_ei->prev_constant;
+      ei->suggested_value = fork_ei->suggested_value;
+      expression_set_constant (ei->constraint->expression,
+                               expression_get_constant (fork_ei->constraint->expression));
+
+      if (suggested_value != ei->suggested_value)
+        {
+          ei->suggested_value = suggested_value;
+          has_pending_edits = true;
+        }
+    }
+
+  g_clear_pointer (&solver->compiled_basis, parametric_solution_free);
+
+  solver->needs_solving = fork->needs_solving;
+  solver->has_pending_edits = has_pending_edits;
+
+  g_hash_table_unref (parents);
+
+  return true;
+
+out:
+  g_hash_table_unref (parents);
+
+  return false;
+}
+
+/* Batch solving
+ *
+ * Solvers do not share any state, so independent systems can be solved
+ * from different threads at the same time.
+ */
+
+typedef struct {
+  SolverBatchItem *items;
+  int n_items;
+
+  /* The index of the next system to solve; each thread claims systems
+   * until none is left, so that the threads that get the cheap systems
+   * pick up more of them
+   */
+  int next_item;
+} SolverBatch;
+
+static void
+solve_batch_item (SolverBatchItem *item)
+{
+  gint64 start_time = g_get_monotonic_time ();
+  int i;
+
+  simplex_solver_solve (item->solver);
+
+  if (item->n_edits > 0)
+    {
+      simplex_solver_begin_edit (item->solver);
+
+      for (i = 0; i < item->n_edits; i++)
+        simplex_solver_suggest_value (item->solver,
+                                      item->edit_variables[i],
+                                      item->edit_values[i]);
+
+      simplex_solver_resolve (item->solver);
+    }
+
+  for (i = 0; i < item->n_variables; i++)
+    item->values[i] = variable_get_value (item->variables[i]);
+
+  item->solve_time = g_get_monotonic_time () - start_time;
+}
+
+static void
+solve_batch_worker (gpointer data,
+                    gpointer user_data)
+{
+  SolverBatch *batch = user_data;
+
+  while (true)
+    {
+      int i = g_atomic_int_add (&batch->next_item, 1);
+
+      if (i >= batch->n_items)
+        break;
+
+      solve_batch_item (&batch->items[i]);
+    }
+}
+
+/**
+ * simplex_solver_solve_batch:
+ * @items: the systems to solve
+ * @n_items: the number of systems
+ * @n_threads: the number of threads to use, or 0 to use one per processor
+ *
+ * Solves a batch of independent constraint systems, using multiple
+ * threads.
+ *
+ * Each system is solved in a single thread: its pending constraints are
+ * solved, the values of its edit variables are suggested, and the values
+ * of its variables are stored, along with the time spent solving it.
+ *
+ * The solvers must not be used by other threads until this function
+ * returns, and must not share any variable; solvers with automatic
+ * solving disabled defer all the work to this function.
+ */
+void
+simplex_solver_solve_batch (SolverBatchItem *items,
+                            int n_items,
+                            int n_threads)
+{
+  SolverBatch batch;
+  GThreadPool *pool;
+  int i;
+
+  if (n_items <= 0)
+    return;
+
+  if (n_threads <= 0)
+    n_threads = g_get_num_processors ();
+
+  n_threads = MIN (n_threads, n_items);
+
+  batch.items = items;
+  batch.n_items = n_items;
+  batch.next_item = 0;
+
+  if (n_threads == 1)
+    {
+      solve_batch_worker (NULL, &batch);
+      return;
+    }
+
+  /* The calling thread solves systems as well; the pool shares its
+   * threads with the other non-exclusive pools, so they are reused
+   * across batches
+   */
+  pool = g_thread_pool_new (solve_batch_worker, &batch, n_threads - 1, FALSE, NULL);
+  if (pool == NULL)
+    {
+      solve_batch_worker (NULL, &batch);
+      return;
+    }
+
+  for (i = 0; i < n_threads - 1; i++)
+    g_thread_pool_push (pool, GINT_TO_POINTER (i + 1), NULL);
+
+  solve_batch_worker (NULL, &batch);
+
+  g_thread_pool_free (pool, FALSE, TRUE);
+}
+
+/**
+ * simplex_solver_begin_transaction:
+ * @solver: a #SimplexSolver
+ *
+ * Opens a transaction on @solver.
+ *
+ * The changes made until the next call to simplex_solver_commit_transaction()
+ * or simplex_solver_rollback_transaction() are recorded, so that they can
+ * be undone at a cost proportional to the number of rows they touched.
+ *
+ * Transactions cannot be nested. The difference engine does not keep
+ * track of its changes, so opening a transaction moves its constraints
+ * into the tableau.
+ */
+void
+simplex_solver_begin_transaction (SimplexSolver *solver)
+{
+  Journal *journal;
+  GHashTableIter iter;
+  gpointer key_p, value_p;
+
+  if (!solver->initialized)
+    {
+      g_critical ("Unable to begin a transaction: the SimplexSolver %p "
+                  "is not initialized.",
+                  solver);
+      return;
+    }
+
+  if (solver->journal != NULL)
+    {
+      g_critical ("The SimplexSolver %p already has an open transaction.", solver);
+      return;
+    }
+
+  if (solver->difference_mode)
+    {
+      simplex_solver_leave_difference_mode (solver);
+
+      if (solver->auto_solve)
+        {
+          simplex_solver_optimize (solver, solver->objective);
+          simplex_solver_set_external_variables (solver);
+        }
+    }
+
+  if (solver->has_pending_edits)
+    simplex_solver_resolve_internal (solver);
+
+  journal = g_slice_new (Journal);
+
+  journal->rows = g_hash_table_new_full (NULL, NULL,
+                                         (GDestroyNotify) variable_unref,
+                                         (GDestroyNotify) expression_unref);
+  journal->columns = g_hash_table_new_full (NULL, NULL,
+                                            (GDestroyNotify) variable_unref,
+                                            NULL);
+  journal->entries = g_array_new (FALSE, FALSE, sizeof (JournalEntry));
+  journal->stay_error_vars = g_ptr_array_ref (solver->stay_error_vars);
+  journal->n_stay_error_vars = solver->stay_error_vars->len;
+  journal->edits = g_array_sized_new (FALSE, FALSE, sizeof (EditState),
+                                      g_hash_table_size (solver->edit_var_map));
+  journal->needs_solving = solver->needs_solving;
+
+  g_hash_table_iter_init (&iter, solver->edit_var_map);
+  while (g_hash_table_iter_next (&iter, &key_p, &value_p))
+    {
+      EditInfo *ei = value_p;
+      EditState state;
+
+      state.variable = variable_ref (key_p);
+      state.prev_constant = ei->prev_constant;
+      state.suggested_value = ei->suggested_value;
+      state.constant = expression_get_constant (ei->constraint->expression);
+
+      g_array_append_val (journal->edits, state);
+    }
+
+  solver->journal = journal;
+}
+
+/**
+ * simplex_solver_commit_transaction:
+ * @solver: a #SimplexSolver
+ *
+ * Closes the transaction opened by simplex_solver_begin_transaction(),
+ * keeping its changes.
+ */
+void
+simplex_solver_commit_transaction (SimplexSolver *solver)
+{
+  if (solver->journal == NULL)
+    {
+      g_critical ("The SimplexSolver %p does not have an open transaction.", solver);
+      return;
+    }
+
+  g_clear_pointer (&solver->journal, journal_free);
+}
+
+static void
+simplex_solver_forget_constraint (SimplexSolver *solver,
+                                  Constraint *constraint)
+{
+  AliasInfo *alias = g_hash_table_lookup (solver->alias_constraints, constraint);
+
+  if (alias != NULL)
+    {
+      simplex_solver_remove_alias_info (solver, alias);
+      return;
+    }
+
+  g_hash_table_remove (solver->marker_vars, constraint);
+  g_hash_table_remove (solver->error_vars, constraint);
+
+  if (constraint_is_stay (constraint))
+    {
+      StayInfo *si = g_hash_table_lookup (solver->stay_var_map, constraint->variable);
+
+      if (si != NULL && si->constraint == constraint)
+        g_hash_table_remove (solver->stay_var_map, constraint->variable);
+    }
 
   if (constraint_is_edit (constraint))
     {
-      EditInfo *ei = g_slice_new (EditInfo);
+      EditInfo *ei = g_hash_table_lookup (solver->edit_var_map, constraint->variable);
+
+      if (ei != NULL && ei->constraint == constraint)
+        g_hash_table_remove (solver->edit_var_map, constraint->variable);
+    }
+}
+
+static void
+simplex_solver_restore_constraint (SimplexSolver *solver,
+                                   JournalEntry *entry)
+{
+  Constraint *constraint = entry->constraint;
+
+  if (entry->alias != NULL)
+    {
+      AliasInfo *alias = g_steal_pointer (&entry->alias);
+      int n_aliases;
+
+      g_hash_table_insert (solver->alias_vars, alias->variable, alias);
+      g_hash_table_insert (solver->alias_constraints, constraint, alias);
+
+      n_aliases = GPOINTER_TO_INT (g_hash_table_lookup (solver->alias_representatives,
+                                                        alias->representative));
+      g_hash_table_insert (solver->alias_representatives,
+                           alias->representative,
+                           GINT_TO_POINTER (n_aliases + 1));
+      return;
+    }
+
+  if (entry->marker != NULL)
+    g_hash_table_insert (solver->marker_vars, constraint, entry->marker);
+
+  if (entry->error_vars != NULL)
+    g_hash_table_insert (solver->error_vars, constraint, g_steal_pointer (&entry->error_vars));
+
+  if (entry->edit_info != NULL)
+    g_hash_table_insert (solver->edit_var_map,
+                         constraint->variable,
+                         g_steal_pointer (&entry->edit_info));
+
+  if (entry->is_stay)
+    {
+      StayInfo *si = g_slice_new (StayInfo);
+
+      si->constraint = constraint;
+
+      g_hash_table_insert (solver->stay_var_map, constraint->variable, si);
+    }
+}
+
+/**
+ * simplex_solver_rollback_transaction:
+ * @solver: a #SimplexSolver
+ *
+ * Closes the transaction opened by simplex_solver_begin_transaction(),
+ * and puts @solver back in the state it was when the transaction began.
+ *
+ * The constraints added during the transaction are freed, and the
+ * constraints removed during the transaction are valid again.
+ */
+void
+simplex_solver_rollback_transaction (SimplexSolver *solver)
+{
+  Journal *journal = solver->journal;
+  GHashTableIter iter;
+  gpointer key_p, value_p;
+  ForeachClosure data;
+  int i;
+
+  if (journal == NULL)
+    {
+      g_critical ("The SimplexSolver %p does not have an open transaction.", solver);
+      return;
+    }
+
+  /* Nothing that happens from here on needs to be recorded */
+  solver->journal = NULL;
+
+  simplex_solver_clear_infeasible_rows (solver);
+  g_clear_pointer (&solver->compiled_basis, parametric_solution_free);
+  solver->has_pending_edits = false;
+
+  for (i = journal->entries->len - 1; i >= 0; i--)
+    {
+      JournalEntry *entry = &g_array_index (journal->entries, JournalEntry, i);
+
+      switch (entry->op)
+        {
+        case JOURNAL_ADDED:
+          simplex_solver_forget_constraint (solver, entry->constraint);
+          if (!entry->was_tracked)
+            g_hash_table_remove (solver->constraints, entry->constraint);
+          break;
+
+        case JOURNAL_REMOVED:
+          simplex_solver_restore_constraint (solver, entry);
+          break;
+
+        case JOURNAL_UNTRACKED:
+          g_hash_table_add (solver->constraints, g_steal_pointer (&entry->constraint));
+          break;
+        }
+    }
+
+  /* Take the modified rows out of the columns... */
+  g_hash_table_iter_init (&iter, journal->rows);
+  while (g_hash_table_iter_next (&iter, &key_p, NULL))
+    {
+      Variable *subject = key_p;
+      Expression *row = g_hash_table_lookup (solver->rows, subject);
+      GList *l;
+
+      if (row == NULL)
+        continue;
+
+      for (l = row->ordered_terms; l != NULL; l = l->next)
+        {
+          Variable *v = term_get_variable (l->data);
+          VariableSet *set = g_hash_table_lookup (solver->columns, v);
+
+          if (set == NULL)
+            continue;
+
+          variable_set_remove_variable (set, subject);
+          if (variable_set_get_size (set) == 0)
+            g_hash_table_remove (solver->columns, v);
+        }
+
+      if (variable_is_external (subject))
+        g_hash_table_remove (solver->external_rows, subject);
+    }
+
+  /* ... put back the rows as they were... */
+  g_hash_table_iter_init (&iter, journal->rows);
+  while (g_hash_table_iter_next (&iter, &key_p, &value_p))
+    {
+      Variable *subject = key_p;
+      Expression *row = value_p;
 
-      ei->constraint = constraint;
-      ei->eplus = eplus;
-      ei->eminus = eminus;
-      ei->prev_constant = prev_constant;
+      if (row == NULL)
+        {
+          g_hash_table_remove (solver->rows, subject);
+          continue;
+        }
+
+      g_hash_table_insert (solver->rows, variable_ref (subject), expression_ref (row));
+
+      data.solver = solver;
+      data.subject = subject;
+      expression_terms_foreach (row, insert_expression_columns, &data);
+
+      if (variable_is_external (subject))
+        g_hash_table_add (solver->external_rows, variable_ref (subject));
+    }
+
+  /* ... and remove the columns of the basic variables */
+  g_hash_table_iter_init (&iter, journal->rows);
+  while (g_hash_table_iter_next (&iter, &key_p, &value_p))
+    {
+      if (value_p == NULL)
+        continue;
+
+      g_hash_table_remove (solver->columns, key_p);
+      g_hash_table_remove (solver->external_parametric_vars, key_p);
+    }
+
+  /* Removing a column leaves it behind, so the columns created by the
+   * transaction may refer to rows that do not contain them any more
+   */
+  g_hash_table_iter_init (&iter, journal->columns);
+  while (g_hash_table_iter_next (&iter, &key_p, NULL))
+    {
+      VariableSet *set = g_hash_table_lookup (solver->columns, key_p);
+      GHashTableIter set_iter;
+      Variable *v;
+
+      if (set == NULL)
+        continue;
+
+      variable_set_iter_init (set, &set_iter);
+      while (variable_set_iter_next (&set_iter, &v))
+        {
+          Expression *row = g_hash_table_lookup (solver->rows, v);
+
+          if (row == NULL || !expression_has_variable (row, key_p))
+            g_hash_table_iter_remove (&set_iter);
+        }
+
+      if (variable_set_get_size (set) == 0)
+        g_hash_table_remove (solver->columns, key_p);
+    }
+
+  g_ptr_array_set_size (journal->stay_error_vars, journal->n_stay_error_vars);
+  g_ptr_array_unref (solver->stay_error_vars);
+  solver->stay_error_vars = g_ptr_array_ref (journal->stay_error_vars);
+
+  for (i = 0; i < journal->edits->len; i++)
+    {
+      EditState *state = &g_array_index (journal->edits, EditState, i);
+      EditInfo *ei = g_hash_table_lookup (solver->edit_var_map, state->variable);
+
+      if (ei == NULL)
+        continue;
+
+      ei->prev_constant = state->prev_constant;
+      ei->suggested_value = state->suggested_value;
+      expression_set_constant (ei->constraint->expression, state->constant);
+    }
+
+  solver->serial += 1;
+
+  if (!journal->needs_solving)
+    simplex_solver_set_external_variables (solver);
+
+  solver->needs_solving = journal->needs_solving;
+
+  journal_free (journal);
+}
+
+/* Compaction
+ *
+ * Removing a constraint only removes the rows and columns of the
+ * variables it created; the external variables it used stay in the
+ * tableau even when nothing refers to them any more, and the columns
+ * keep their entries, even when empty. Compacting the solver drops
+ * the rows of unused external variables and the stale columns.
+ */
+
+static bool
+collect_used_variables (Term *term,
+                        gpointer data)
+{
+  g_hash_table_add (data, term_get_variable (term));
+
+  return true;
+}
+
+/**
+ * simplex_solver_compact:
+ * @solver: a #SimplexSolver
+ *
+ * Removes the external variables that are not used by any constraint
+ * from the tableau, as well as the stale columns.
+ *
+ * The values of the removed variables are not changed.
+ */
+void
+simplex_solver_compact (SimplexSolver *solver)
+{
+  GHashTable *used_vars;
+  GPtrArray *unused_rows;
+  GHashTableIter iter;
+  gpointer key_p, value_p;
+  int i;
+
+  if (!solver->initialized)
+    return;
+
+  if (solver->journal != NULL)
+    {
+      g_critical ("Unable to compact the SimplexSolver %p inside a transaction",
+                  solver);
+      return;
+    }
+
+  if (solver->has_pending_edits)
+    simplex_solver_resolve_internal (solver);
+
+  /* HashSet<Variable>; the external variables used by a constraint */
+  used_vars = g_hash_table_new (NULL, NULL);
+
+  g_hash_table_iter_init (&iter, solver->constraints);
+  while (g_hash_table_iter_next (&iter, &key_p, NULL))
+    {
+      Constraint *constraint = key_p;
+
+      expression_terms_foreach (constraint->expression, collect_used_variables, used_vars);
+
+      if (constraint->variable != NULL)
+        g_hash_table_add (used_vars, constraint->variable);
+    }
+
+  /* The row of an unused external variable cannot appear anywhere else,
+   * as the variable is basic
+   */
+  unused_rows = g_ptr_array_new ();
+
+  g_hash_table_iter_init (&iter, solver->rows);
+  while (g_hash_table_iter_next (&iter, &key_p, NULL))
+    {
+      Variable *v = key_p;
+
+      if (v->type == VARIABLE_REGULAR && !v->is_queued && !g_hash_table_contains (used_vars, v))
+        g_ptr_array_add (unused_rows, v);
+    }
+
+  for (i = 0; i < unused_rows->len; i++)
+    expression_unref (simplex_solver_remove_row (solver, g_ptr_array_index (unused_rows, i)));
+
+  /* Drop the entries of the rows that do not contain the parametric
+   * variable any more, and then the empty columns
+   */
+  g_hash_table_iter_init (&iter, solver->columns);
+  while (g_hash_table_iter_next (&iter, &key_p, &value_p))
+    {
+      Variable *param_var = key_p;
+      GHashTableIter set_iter;
+      Variable *v;
+
+      variable_set_iter_init (value_p, &set_iter);
+      while (variable_set_iter_next (&set_iter, &v))
+        {
+          Expression *row = g_hash_table_lookup (solver->rows, v);
+
+          if (row == NULL || !expression_has_variable (row, param_var))
+            g_hash_table_iter_remove (&set_iter);
+        }
+
+      if (variable_set_get_size (value_p) == 0)
+        {
+          g_hash_table_remove (solver->external_parametric_vars, param_var);
+          g_hash_table_iter_remove (&iter);
+        }
+    }
+
+  if (unused_rows->len > 0)
+    g_clear_pointer (&solver->compiled_basis, parametric_solution_free);
+
+  g_ptr_array_unref (unused_rows);
+  g_hash_table_unref (used_vars);
+
+  solver->removals_since_compact = 0;
+  solver->compact_count += 1;
+}
+
+/**
+ * simplex_solver_set_compact_threshold:
+ * @solver: a #SimplexSolver
+ * @n_removals: the number of removed constraints after which the
+ *   solver is compacted, or 0 to disable
+ *
+ * Makes @solver call simplex_solver_compact() on itself every
+ * @n_removals removed constraints.
+ */
+void
+simplex_solver_set_compact_threshold (SimplexSolver *solver,
+                                      int n_removals)
+{
+  if (!solver->initialized)
+    return;
+
+  solver->compact_threshold = MAX (n_removals, 0);
+}
+
+/* Serialization
+ *
+ * A solver image is a flat, position independent copy of the tableau
+ * and of the bookkeeping of a solver. It starts with an ImageHeader,
+ * followed by these sections:
+ *
+ *  - ImageVariable[n_variables], sorted by variable id
+ *  - ImageRow[n_rows]
+ *  - ImageConstraint[n_constraints]
+ *  - ImageTerm[n_terms]: the terms of each row, followed by the terms
+ *    of each constraint
+ *  - guint32[n_indices]: the error variables of each constraint, the
+ *    pairs of stay error variables, and the variables and constraints
+ *    requested by the caller
+ *  - the NUL-terminated names of the variables
+ *
+ * Every reference to a variable is an index in the variables section;
+ * the columns and the sets of external variables are not stored, as
+ * they can be computed from the rows.
+ */
+
+#define IMAGE_MAGIC             0x56534d45      /* "EMSV" */
+#define IMAGE_VERSION           1
+#define IMAGE_NONE              G_MAXUINT32
+
+enum {
+  IMAGE_SOLVER_DIFFERENCE_MODE = 1 << 0,
+  IMAGE_SOLVER_NEEDS_SOLVING   = 1 << 1
+};
+
+enum {
+  IMAGE_VARIABLE_EXTERNAL   = 1 << 0,
+  IMAGE_VARIABLE_PIVOTABLE  = 1 << 1,
+  IMAGE_VARIABLE_RESTRICTED = 1 << 2
+};
+
+enum {
+  IMAGE_CONSTRAINT_EDIT       = 1 << 0,
+  IMAGE_CONSTRAINT_STAY       = 1 << 1,
+  IMAGE_CONSTRAINT_EDIT_INFO  = 1 << 2,
+  IMAGE_CONSTRAINT_STAY_INFO  = 1 << 3,
+  IMAGE_CONSTRAINT_ALIAS      = 1 << 4,
+  IMAGE_CONSTRAINT_DIFFERENCE = 1 << 5
+};
+
+typedef struct {
+  guint32 magic;
+  guint32 version;
+
+  /* Identifies the set of constraints, see simplex_solver_serialize() */
+  guint64 key;
+
+  /* FNV-1a hash of the image, computed with this field set to zero */
+  guint64 checksum;
+
+  guint32 flags;
+  guint32 objective;
+
+  guint32 n_variables;
+  guint32 n_rows;
+  guint32 n_constraints;
+  guint32 n_terms;
+  guint32 n_indices;
+  guint32 n_stay_pairs;
+  guint32 n_requested_variables;
+  guint32 n_requested_constraints;
+  guint32 strings_size;
+
+  guint32 slack_counter;
+  guint32 artificial_counter;
+  guint32 dummy_counter;
+} ImageHeader;
+
+typedef struct {
+  guint32 name;
+  guint32 prefix;
+  guint32 type;
+  guint32 flags;
+  double value;
+} ImageVariable;
+
+typedef struct {
+  guint32 subject;
+  guint32 n_terms;
+  double constant;
+} ImageRow;
+
+typedef struct {
+  guint32 variable;
+  guint32 padding;
+  double coefficient;
+} ImageTerm;
+
+typedef struct {
+  guint32 flags;
+  gint32 op_type;
+  guint32 strength;
+  guint32 n_terms;
+  guint32 n_error_vars;
+
+  guint32 variable;
+  guint32 marker;
+
+  /* EditInfo */
+  guint32 eplus;
+  guint32 eminus;
+
+  /* AliasInfo */
+  guint32 alias_variable;
+  guint32 alias_representative;
+
+  guint32 padding;
+
+  double constant;
+  double prev_constant;
+  double suggested_value;
+  double scale;
+  double offset;
+} ImageConstraint;
+
+static guint64
+image_checksum_update (guint64 res,
+                       const guint8 *data,
+                       gsize size)
+{
+  gsize i;
+
+  for (i = 0; i < size; i++)
+    {
+      res ^= data[i];
+      res *= 0x100000001b3UL;
+    }
+
+  return res;
+}
+
+static guint64
+image_checksum (const guint8 *data,
+                gsize size)
+{
+  return image_checksum_update (0xcbf29ce484222325UL, data, size);
+}
+
+typedef struct {
+  /* HashTable<Variable, index> */
+  GHashTable *indices;
+  GPtrArray *variables;
+
+  /* HashTable<string, offset> */
+  GHashTable *offsets;
+  GString *strings;
+} ImageWriter;
+
+static void
+image_writer_add_variable (ImageWriter *writer,
+                           Variable *variable)
+{
+  if (variable == NULL || g_hash_table_contains (writer->indices, variable))
+    return;
+
+  g_hash_table_insert (writer->indices, variable, GUINT_TO_POINTER (writer->variables->len));
+  g_ptr_array_add (writer->variables, variable);
+}
+
+static bool
+collect_expression_variables (Term *term,
+                              gpointer data)
+{
+  image_writer_add_variable (data, term_get_variable (term));
+
+  return true;
+}
+
+static guint32
+image_writer_get_index (ImageWriter *writer,
+                        Variable *variable)
+{
+  if (variable == NULL)
+    return IMAGE_NONE;
+
+  return GPOINTER_TO_UINT (g_hash_table_lookup (writer->indices, variable));
+}
+
+static guint32
+image_writer_add_string (ImageWriter *writer,
+                         const char *str)
+{
+  gpointer offset_p;
+
+  if (str == NULL)
+    return IMAGE_NONE;
+
+  if (g_hash_table_lookup_extended (writer->offsets, str, NULL, &offset_p))
+    return GPOINTER_TO_UINT (offset_p);
+
+  offset_p = GUINT_TO_POINTER (writer->strings->len);
+  g_hash_table_insert (writer->offsets, (gpointer) str, offset_p);
+  g_string_append_len (writer->strings, str, strlen (str) + 1);
+
+  return GPOINTER_TO_UINT (offset_p);
+}
+
+static int
+sort_variables_by_id (gconstpointer a,
+                      gconstpointer b)
+{
+  const Variable *va = *((Variable **) a);
+  const Variable *vb = *((Variable **) b);
+
+  return va->id_ - vb->id_;
+}
+
+static void
+image_append_terms (GByteArray *terms,
+                    ImageWriter *writer,
+                    Expression *expression)
+{
+  GList *l;
+
+  for (l = expression->ordered_terms; l != NULL; l = l->next)
+    {
+      ImageTerm term = { 0, };
+
+      term.variable = image_writer_get_index (writer, term_get_variable (l->data));
+      term.coefficient = term_get_coefficient (l->data);
+
+      g_byte_array_append (terms, (const guint8 *) &term, sizeof (ImageTerm));
+    }
+}
+
+static void
+image_append_index (GByteArray *indices,
+                    guint32 index)
+{
+  g_byte_array_append (indices, (const guint8 *) &index, sizeof (guint32));
+}
+
+/**
+ * simplex_solver_serialize:
+ * @solver: a #SimplexSolver
+ * @key: an identifier for the set of constraints of @solver
+ * @variables: (array length=n_variables): variables to find again after
+ *   loading the image
+ * @n_variables: the number of @variables
+ * @constraints: (array length=n_constraints): constraints to find again
+ *   after loading the image
+ * @n_constraints: the number of @constraints
+ *
+ * Stores the state of @solver into an image that can be loaded with
+ * simplex_solver_deserialize(), without adding the constraints and
+ * solving them again.
+ *
+ * The @key should be computed from the description of the constraints,
+ * for instance by hashing it, so that an image created for a different
+ * set of constraints is rejected when loading it.
+ *
+ * Returns: (transfer full) (nullable): the image of @solver
+ */
+GBytes *
+simplex_solver_serialize (SimplexSolver *solver,
+                          guint64 key,
+                          Variable **variables,
+                          int n_variables,
+                          Constraint **constraints,
+                          int n_constraints)
+{
+  ImageWriter writer;
+  ImageHeader header = { 0, };
+  GByteArray *vars, *rows, *cons, *terms, *indices, *res;
+  GHashTable *constraint_indices;
+  GPtrArray *constraint_list;
+  GHashTableIter iter;
+  gpointer key_p, value_p;
+  int i;
+
+  if (!solver->initialized)
+    {
+      g_critical ("Unable to serialize the SimplexSolver %p: the solver "
+                  "is not initialized.",
+                  solver);
+      return NULL;
+    }
+
+  for (i = 0; i < n_constraints; i++)
+    {
+      if (!g_hash_table_contains (solver->constraints, constraints[i]))
+        {
+          g_critical ("Unable to serialize the SimplexSolver %p: unknown "
+                      "constraint %p",
+                      solver, constraints[i]);
+          return NULL;
+        }
+    }
+
+  if (solver->has_pending_edits)
+    simplex_solver_resolve_internal (solver);
+
+  writer.indices = g_hash_table_new (NULL, NULL);
+  writer.variables = g_ptr_array_new ();
+  writer.offsets = g_hash_table_new (g_str_hash, g_str_equal);
+  writer.strings = g_string_new (NULL);
+
+  /* Collect every variable known to the solver */
+  image_writer_add_variable (&writer, solver->objective);
+
+  g_hash_table_iter_init (&iter, solver->rows);
+  while (g_hash_table_iter_next (&iter, &key_p, &value_p))
+    {
+      image_writer_add_variable (&writer, key_p);
+      expression_terms_foreach (value_p, collect_expression_variables, &writer);
+    }
+
+  constraint_indices = g_hash_table_new (NULL, NULL);
+  constraint_list = g_ptr_array_new ();
+
+  /* The difference engine solves its constraints in order, so they are
+   * stored first
+   */
+  if (solver->difference_mode)
+    {
+      for (i = 0; i < solver->difference_constraints->len; i++)
+        {
+          Constraint *constraint = g_ptr_array_index (solver->difference_constraints, i);
+
+          g_hash_table_insert (constraint_indices, constraint, GUINT_TO_POINTER (constraint_list->len));
+          g_ptr_array_add (constraint_list, constraint);
+        }
+    }
+
+  g_hash_table_iter_init (&iter, solver->constraints);
+  while (g_hash_table_iter_next (&iter, &key_p, NULL))
+    {
+      if (g_hash_table_contains (constraint_indices, key_p))
+        continue;
+
+      g_hash_table_insert (constraint_indices, key_p, GUINT_TO_POINTER (constraint_list->len));
+      g_ptr_array_add (constraint_list, key_p);
+    }
+
+  for (i = 0; i < constraint_list->len; i++)
+    {
+      Constraint *constraint = g_ptr_array_index (constraint_list, i);
+      AliasInfo *alias = g_hash_table_lookup (solver->alias_constraints, constraint);
+      EditInfo *ei = NULL;
+
+      expression_terms_foreach (constraint->expression, collect_expression_variables, &writer);
+      image_writer_add_variable (&writer, constraint->variable);
+      image_writer_add_variable (&writer, g_hash_table_lookup (solver->marker_vars, constraint));
+
+      if (constraint_is_edit (constraint))
+        ei = g_hash_table_lookup (solver->edit_var_map, constraint->variable);
+
+      if (ei != NULL && ei->constraint == constraint)
+        {
+          image_writer_add_variable (&writer, ei->eplus);
+          image_writer_add_variable (&writer, ei->eminus);
+        }
+
+      if (alias != NULL)
+        {
+          image_writer_add_variable (&writer, alias->variable);
+          image_writer_add_variable (&writer, alias->representative);
+        }
+    }
+
+  g_hash_table_iter_init (&iter, solver->error_vars);
+  while (g_hash_table_iter_next (&iter, NULL, &value_p))
+    {
+      GHashTableIter set_iter;
+      Variable *v;
 
-      g_hash_table_insert (solver->edit_var_map, constraint->variable, ei);
+      variable_set_iter_init (value_p, &set_iter);
+      while (variable_set_iter_next (&set_iter, &v))
+        image_writer_add_variable (&writer, v);
     }
 
-  if (!simplex_solver_try_adding_directly (solver, expr))
-    simplex_solver_add_with_artificial_variable (solver, expr);
+  for (i = 0; i < n_variables; i++)
+    image_writer_add_variable (&writer, variables[i]);
 
-  solver->needs_solving = true;
+  /* Keep the relative order of the variables, so that the loaded solver
+   * makes the same choices when pivoting
+   */
+  g_ptr_array_sort (writer.variables, sort_variables_by_id);
+  for (i = 0; i < writer.variables->len; i++)
+    g_hash_table_insert (writer.indices, g_ptr_array_index (writer.variables, i), GUINT_TO_POINTER (i));
 
-  if (solver->auto_solve)
+  vars = g_byte_array_new ();
+  for (i = 0; i < writer.variables->len; i++)
     {
-      simplex_solver_optimize (solver, solver->objective);
-      simplex_solver_set_external_variables (solver);
+      Variable *v = g_ptr_array_index (writer.variables, i);
+      ImageVariable image_var = { 0, };
+
+      image_var.name = image_writer_add_string (&writer, v->name);
+      image_var.prefix = image_writer_add_string (&writer, v->prefix);
+      image_var.type = v->type;
+      image_var.value = v->value;
+
+      if (v->is_external)
+        image_var.flags |= IMAGE_VARIABLE_EXTERNAL;
+      if (v->is_pivotable)
+        image_var.flags |= IMAGE_VARIABLE_PIVOTABLE;
+      if (v->is_restricted)
+        image_var.flags |= IMAGE_VARIABLE_RESTRICTED;
+
+      g_byte_array_append (vars, (const guint8 *) &image_var, sizeof (ImageVariable));
     }
 
-  expression_unref (expr);
+  rows = g_byte_array_new ();
+  terms = g_byte_array_new ();
 
-  g_hash_table_add (solver->constraints, constraint);
-}
+  g_hash_table_iter_init (&iter, solver->rows);
+  while (g_hash_table_iter_next (&iter, &key_p, &value_p))
+    {
+      ImageRow row = { 0, };
 
-Constraint *
-simplex_solver_add_constraint (SimplexSolver *solver,
-                               Variable *variable,
-                               OperatorType op,
-                               Expression *expression,
-                               StrengthType strength)
-{
-  Constraint *res;
+      row.subject = image_writer_get_index (&writer, key_p);
+      row.n_terms = expression_get_n_terms (value_p);
+      row.constant = expression_get_constant (value_p);
 
-  if (!solver->initialized)
-    {
-      g_critical ("SimplexSolver %p has not been initialized.", solver);
-      return NULL;
+      g_byte_array_append (rows, (const guint8 *) &row, sizeof (ImageRow));
+      image_append_terms (terms, &writer, value_p);
     }
 
-  res = g_slice_new0 (Constraint);
-  res->solver = solver;
-  res->strength = strength;
-  res->is_edit = false;
-  res->is_stay = false;
-  res->op_type = op;
+  cons = g_byte_array_new ();
+  indices = g_byte_array_new ();
 
-  if (expression == NULL)
-    res->expression = expression_new_from_variable (variable);
-  else
+  for (i = 0; i < constraint_list->len; i++)
     {
-      res->expression = expression_ref (expression);
-      if (res->expression->solver == NULL)
-        res->expression->solver = solver;
-
-      if (variable != NULL)
+      Constraint *constraint = g_ptr_array_index (constraint_list, i);
+      AliasInfo *alias = g_hash_table_lookup (solver->alias_constraints, constraint);
+      VariableSet *error_vars = g_hash_table_lookup (solver->error_vars, constraint);
+      ImageConstraint image_cons = { 0, };
+
+      image_cons.op_type = constraint->op_type;
+      image_cons.strength = constraint->strength;
+      image_cons.n_terms = expression_get_n_terms (constraint->expression);
+      image_cons.constant = expression_get_constant (constraint->expression);
+      image_cons.variable = image_writer_get_index (&writer, constraint->variable);
+      image_cons.marker = image_writer_get_index (&writer, g_hash_table_lookup (solver->marker_vars, constraint));
+      image_cons.eplus = IMAGE_NONE;
+      image_cons.eminus = IMAGE_NONE;
+      image_cons.alias_variable = IMAGE_NONE;
+      image_cons.alias_representative = IMAGE_NONE;
+
+      if (constraint_is_edit (constraint))
         {
-          switch (res->op_type)
-            {
-            case OPERATOR_TYPE_EQ:
-              expression_add_variable (res->expression, variable, -1.0, NULL);
-              break;
+          EditInfo *ei = g_hash_table_lookup (solver->edit_var_map, constraint->variable);
 
-            case OPERATOR_TYPE_LE:
-              expression_add_variable (res->expression, variable, -1.0, NULL);
-              break;
+          image_cons.flags |= IMAGE_CONSTRAINT_EDIT;
 
-            case OPERATOR_TYPE_GE:
-              expression_times (res->expression, -1.0);
-              expression_add_variable (res->expression, variable, 1.0, NULL);
-              break;
+          if (ei != NULL && ei->constraint == constraint)
+            {
+              image_cons.flags |= IMAGE_CONSTRAINT_EDIT_INFO;
+              image_cons.eplus = image_writer_get_index (&writer, ei->eplus);
+              image_cons.eminus = image_writer_get_index (&writer, ei->eminus);
+              image_cons.prev_constant = ei->prev_constant;
+              image_cons.suggested_value = ei->suggested_value;
             }
         }
+
+      if (constraint_is_stay (constraint))
+        {
+          StayInfo *si = g_hash_table_lookup (solver->stay_var_map, constraint->variable);
+
+          image_cons.flags |= IMAGE_CONSTRAINT_STAY;
+
+          if (si != NULL && si->constraint == constraint)
+            image_cons.flags |= IMAGE_CONSTRAINT_STAY_INFO;
+        }
+
+      if (alias != NULL)
+        {
+          image_cons.flags |= IMAGE_CONSTRAINT_ALIAS;
+          image_cons.alias_variable = image_writer_get_index (&writer, alias->variable);
+          image_cons.alias_representative = image_writer_get_index (&writer, alias->representative);
+          image_cons.scale = alias->scale;
+          image_cons.offset = alias->offset;
+        }
+
+      if (solver->difference_mode && i < solver->difference_constraints->len)
+        image_cons.flags |= IMAGE_CONSTRAINT_DIFFERENCE;
+
+      if (error_vars != NULL)
+        {
+          GHashTableIter set_iter;
+          Variable *v;
+
+          image_cons.n_error_vars = variable_set_get_size (error_vars);
+
+          variable_set_iter_init (error_vars, &set_iter);
+          while (variable_set_iter_next (&set_iter, &v))
+            image_append_index (indices, image_writer_get_index (&writer, v));
+        }
+
+      g_byte_array_append (cons, (const guint8 *) &image_cons, sizeof (ImageConstraint));
+      image_append_terms (terms, &writer, constraint->expression);
     }
 
-  simplex_solver_add_constraint_internal (solver, res);
+  for (i = 0; i < solver->stay_error_vars->len; i++)
+    {
+      VariablePair *pair = g_ptr_array_index (solver->stay_error_vars, i);
 
-  return res;
+      image_append_index (indices, image_writer_get_index (&writer, pair->first));
+      image_append_index (indices, image_writer_get_index (&writer, pair->second));
+    }
+
+  for (i = 0; i < n_variables; i++)
+    image_append_index (indices, image_writer_get_index (&writer, variables[i]));
+
+  for (i = 0; i < n_constraints; i++)
+    image_append_index (indices, GPOINTER_TO_UINT (g_hash_table_lookup (constraint_indices, constraints[i])));
+
+  /* Keep the strings section aligned */
+  if (indices->len % 8 != 0)
+    image_append_index (indices, 0);
+
+  header.magic = IMAGE_MAGIC;
+  header.version = IMAGE_VERSION;
+  header.key = key;
+  header.objective = image_writer_get_index (&writer, solver->objective);
+  header.n_variables = writer.variables->len;
+  header.n_rows = g_hash_table_size (solver->rows);
+  header.n_constraints = constraint_list->len;
+  header.n_terms = terms->len / sizeof (ImageTerm);
+  header.n_indices = indices->len / sizeof (guint32);
+  header.n_stay_pairs = solver->stay_error_vars->len;
+  header.n_requested_variables = n_variables;
+  header.n_requested_constraints = n_constraints;
+  header.strings_size = writer.strings->len;
+  header.slack_counter = solver->slack_counter;
+  header.artificial_counter = solver->artificial_counter;
+  header.dummy_counter = solver->dummy_counter;
+
+  if (solver->difference_mode)
+    header.flags |= IMAGE_SOLVER_DIFFERENCE_MODE;
+  if (solver->needs_solving)
+    header.flags |= IMAGE_SOLVER_NEEDS_SOLVING;
+
+  res = g_byte_array_sized_new (sizeof (ImageHeader) + vars->len + rows->len +
+                                cons->len + terms->len + indices->len +
+                                writer.strings->len);
+
+  g_byte_array_append (res, (const guint8 *) &header, sizeof (ImageHeader));
+  g_byte_array_append (res, vars->data, vars->len);
+  g_byte_array_append (res, rows->data, rows->len);
+  g_byte_array_append (res, cons->data, cons->len);
+  g_byte_array_append (res, terms->data, terms->len);
+  g_byte_array_append (res, indices->data, indices->len);
+  g_byte_array_append (res, (const guint8 *) writer.strings->str, writer.strings->len);
+
+  header.checksum = image_checksum (res->data, res->len);
+  memcpy (res->data, &header, sizeof (ImageHeader));
+
+  g_byte_array_unref (vars);
+  g_byte_array_unref (rows);
+  g_byte_array_unref (cons);
+  g_byte_array_unref (terms);
+  g_byte_array_unref (indices);
+  g_string_free (writer.strings, TRUE);
+  g_hash_table_unref (writer.offsets);
+  g_ptr_array_unref (writer.variables);
+  g_hash_table_unref (writer.indices);
+  g_ptr_array_unref (constraint_list);
+  g_hash_table_unref (constraint_indices);
+
+  return g_byte_array_free_to_bytes (res);
 }
 
-Constraint *
-simplex_solver_add_stay_variable (SimplexSolver *solver,
-                                  Variable *variable,
-                                  StrengthType strength)
+typedef struct {
+  const ImageHeader *header;
+  const ImageVariable *variables;
+  const ImageRow *rows;
+  const ImageConstraint *constraints;
+  const ImageTerm *terms;
+  const guint32 *indices;
+  const char *strings;
+} ImageReader;
+
+static bool
+image_reader_init (ImageReader *reader,
+                   const guint8 *data,
+                   gsize size,
+                   guint64 key)
 {
-  Constraint *res;
+  const ImageHeader *header = (const ImageHeader *) data;
+  ImageHeader unchecked_header;
+  guint64 expected_size, n_terms, n_indices, checksum;
+  int i;
 
-  if (!solver->initialized)
-    {
-      g_critical ("SimplexSolver %p has not been initialized.", solver);
-      return NULL;
-    }
+  if (size < sizeof (ImageHeader) || ((gsize) data % 8) != 0)
+    return false;
 
-  res = g_slice_new0 (Constraint);
-  res->solver = solver;
-  res->variable = variable_ref (variable);
-  res->op_type = OPERATOR_TYPE_EQ;
-  res->strength = strength;
-  res->is_stay = true;
-  res->is_edit = false;
+  if (header->magic != IMAGE_MAGIC ||
+      header->version != IMAGE_VERSION ||
+      header->key != key)
+    return false;
 
-  res->expression = expression_new (solver, variable_get_value (res->variable));
-  expression_add_variable (res->expression, res->variable, -1.0, NULL);
+  expected_size = sizeof (ImageHeader)
+                + (guint64) header->n_variables * sizeof (ImageVariable)
+                + (guint64) header->n_rows * sizeof (ImageRow)
+                + (guint64) header->n_constraints * sizeof (ImageConstraint)
+                + (guint64) header->n_terms * sizeof (ImageTerm)
+                + (guint64) header->n_indices * sizeof (guint32)
+                + (guint64) header->strings_size;
 
-  simplex_solver_add_constraint_internal (solver, res);
+  if (expected_size != size || header->n_indices % 2 != 0)
+    return false;
 
-  return res;
-}
+  unchecked_header = *header;
+  unchecked_header.checksum = 0;
 
-bool
-simplex_solver_has_stay_variable (SimplexSolver *solver,
-                                  Variable *variable)
-{
-  if (!solver->initialized)
+  checksum = image_checksum ((const guint8 *) &unchecked_header, sizeof (ImageHeader));
+  checksum = image_checksum_update (checksum, data + sizeof (ImageHeader), size - sizeof (ImageHeader));
+  if (checksum != header->checksum)
     return false;
 
-  return g_hash_table_contains (solver->stay_var_map, variable);
-}
+  reader->header = header;
+  reader->variables = (const ImageVariable *) (header + 1);
+  reader->rows = (const ImageRow *) (reader->variables + header->n_variables);
+  reader->constraints = (const ImageConstraint *) (reader->rows + header->n_rows);
+  reader->terms = (const ImageTerm *) (reader->constraints + header->n_constraints);
+  reader->indices = (const guint32 *) (reader->terms + header->n_terms);
+  reader->strings = (const char *) (reader->indices + header->n_indices);
+
+  /* The checksum does not protect against a well-formed image written
+   * by a buggy producer, so the references are checked as well
+   */
+  if (header->strings_size > 0 && reader->strings[header->strings_size - 1] != '\0')
+    return false;
 
-void
-simplex_solver_remove_stay_variable (SimplexSolver *solver,
-                                     Variable *variable)
-{
-  StayInfo *si;
+  if (header->objective >= header->n_variables)
+    return false;
 
-  if (!solver->initialized)
+  for (i = 0; i < header->n_variables; i++)
     {
-      g_critical ("Solver %p is not initialized.", solver);
-      return;
+      const ImageVariable *v = &reader->variables[i];
+
+      if ((v->name != IMAGE_NONE && v->name >= header->strings_size) ||
+          (v->prefix != IMAGE_NONE && v->prefix >= header->strings_size))
+        return false;
+
+      if (v->type != VARIABLE_DUMMY && v->type != VARIABLE_OBJECTIVE &&
+          v->type != VARIABLE_SLACK && v->type != VARIABLE_REGULAR)
+        return false;
     }
 
-  si = g_hash_table_lookup (solver->stay_var_map, variable);
-  if (si == NULL)
+  for (i = 0; i < header->n_terms; i++)
     {
-      char *str = variable_to_string (variable);
+      if (reader->terms[i].variable >= header->n_variables)
+        return false;
+    }
 
-      g_critical ("Unknown stay variable '%s'", str);
+  n_terms = 0;
+  n_indices = 0;
 
-      g_free (str);
+  for (i = 0; i < header->n_rows; i++)
+    {
+      if (reader->rows[i].subject >= header->n_variables ||
+          reader->rows[i].n_terms > header->n_terms)
+        return false;
 
-      return;
+      n_terms += reader->rows[i].n_terms;
     }
 
-  simplex_solver_remove_constraint (solver, si->constraint);
-}
+  for (i = 0; i < header->n_constraints; i++)
+    {
+      const ImageConstraint *c = &reader->constraints[i];
+
+      if (c->op_type < OPERATOR_TYPE_LE || c->op_type > OPERATOR_TYPE_GE ||
+          c->n_terms > header->n_terms ||
+          c->n_error_vars > header->n_indices)
+        return false;
+
+      if ((c->variable != IMAGE_NONE && c->variable >= header->n_variables) ||
+          (c->marker != IMAGE_NONE && c->marker >= header->n_variables) ||
+          (c->eplus != IMAGE_NONE && c->eplus >= header->n_variables) ||
+          (c->eminus != IMAGE_NONE && c->eminus >= header->n_variables))
+        return false;
+
+      if ((c->flags & (IMAGE_CONSTRAINT_EDIT | IMAGE_CONSTRAINT_STAY)) != 0 &&
+          c->variable == IMAGE_NONE)
+        return false;
+
+      if ((c->flags & IMAGE_CONSTRAINT_ALIAS) != 0 &&
+          (c->alias_variable >= header->n_variables ||
+           c->alias_representative >= header->n_variables))
+        return false;
+
+      n_terms += c->n_terms;
+      n_indices += c->n_error_vars;
+    }
 
-Constraint *
-simplex_solver_add_edit_variable (SimplexSolver *solver,
-                                  Variable *variable,
-                                  StrengthType strength)
-{
-  Constraint *res;
+  n_indices += (guint64) header->n_stay_pairs * 2
+             + header->n_requested_variables
+             + header->n_requested_constraints;
 
-  if (!solver->initialized)
-    return NULL;
+  if (n_terms != header->n_terms ||
+      n_indices > header->n_indices ||
+      n_indices + 1 < header->n_indices)
+    return false;
 
-  res = g_slice_new (Constraint);
-  res->solver = solver;
-  res->variable = variable_ref (variable);
-  res->op_type = OPERATOR_TYPE_EQ;
-  res->strength = strength;
-  res->is_stay = false;
-  res->is_edit = true;
+  for (i = 0; i < n_indices; i++)
+    {
+      guint32 limit = header->n_variables;
 
-  res->expression = expression_new (solver, variable_get_value (variable));
-  expression_add_variable (res->expression, variable, -1.0, NULL);
+      if (i + header->n_requested_constraints >= n_indices)
+        limit = header->n_constraints;
 
-  simplex_solver_add_constraint_internal (solver, res);
+      if (reader->indices[i] >= limit)
+        return false;
+    }
+
+  return true;
+}
+
+static Expression *
+image_read_expression (SimplexSolver *solver,
+                       Variable **variables,
+                       const ImageTerm *terms,
+                       int n_terms,
+                       double constant)
+{
+  Expression *res = expression_new (solver, constant);
+  int i;
+
+  for (i = n_terms - 1; i >= 0; i--)
+    expression_set_variable (res, variables[terms[i].variable], terms[i].coefficient);
 
   return res;
 }
 
+/**
+ * simplex_solver_deserialize:
+ * @solver: an uninitialized solver
+ * @image: an image created by simplex_solver_serialize()
+ * @key: the identifier of the set of constraints
+ * @variables: (array length=n_variables) (out caller-allocates): return
+ *   location for the variables requested when creating @image
+ * @n_variables: the number of @variables
+ * @constraints: (array length=n_constraints) (out caller-allocates):
+ *   return location for the constraints requested when creating @image
+ * @n_constraints: the number of @constraints
+ *
+ * Initializes @solver with the state stored in @image, in a time
+ * proportional to the size of the image.
+ *
+ * The @image can be the contents of a memory mapped file; @solver keeps
+ * a reference on it, as the names of the variables are not copied.
+ *
+ * If @image is not valid, or if it was created with a different @key or
+ * with a different number of requested variables and constraints, @solver
+ * is left uninitialized.
+ *
+ * Returns: %true if @solver was initialized; the caller owns a reference
+ *   on each of the returned @variables
+ */
 bool
-simplex_solver_has_edit_variable (SimplexSolver *solver,
-                                  Variable *variable)
+simplex_solver_deserialize (SimplexSolver *solver,
+                            GBytes *image,
+                            guint64 key,
+                            Variable **variables,
+                            int n_variables,
+                            Constraint **constraints,
+                            int n_constraints)
 {
-  if (!solver->initialized)
+  const ImageHeader *header;
+  ImageReader reader;
+  Variable **vars;
+  Constraint **cons;
+  const ImageTerm *terms;
+  const guint32 *indices;
+  gconstpointer data;
+  gsize size;
+  int i, j;
+
+  if (solver->initialized)
+    {
+      g_critical ("The SimplexSolver %p has already been initialized", solver);
+      return false;
+    }
+
+  data = g_bytes_get_data (image, &size);
+
+  if (!image_reader_init (&reader, data, size, key))
     return false;
 
-  return g_hash_table_contains (solver->edit_var_map, variable);
-}
+  header = reader.header;
 
-void
-simplex_solver_remove_edit_variable (SimplexSolver *solver,
-                                     Variable *variable)
-{
-  EditInfo *ei;
+  if (header->n_requested_variables != n_variables ||
+      header->n_requested_constraints != n_constraints)
+    return false;
 
-  if (!solver->initialized)
+  simplex_solver_init (solver);
+
+  solver->image = g_bytes_ref (image);
+
+  vars = g_new (Variable *, header->n_variables);
+  for (i = 0; i < header->n_variables; i++)
     {
-      g_critical ("Solver %p is not initialized.", solver);
-      return;
+      const ImageVariable *image_var = &reader.variables[i];
+      Variable *v = variable_new (solver, image_var->type);
+
+      if (image_var->name != IMAGE_NONE)
+        v->name = reader.strings + image_var->name;
+      if (image_var->prefix != IMAGE_NONE)
+        v->prefix = reader.strings + image_var->prefix;
+
+      v->value = image_var->value;
+      v->is_external = (image_var->flags & IMAGE_VARIABLE_EXTERNAL) != 0;
+      v->is_pivotable = (image_var->flags & IMAGE_VARIABLE_PIVOTABLE) != 0;
+      v->is_restricted = (image_var->flags & IMAGE_VARIABLE_RESTRICTED) != 0;
+
+      vars[i] = v;
     }
 
-  ei = g_hash_table_lookup (solver->edit_var_map, variable);
-  if (ei == NULL)
+  /* Replace the objective row created by simplex_solver_init() */
+  g_hash_table_remove (solver->rows, solver->objective);
+  solver->objective = vars[header->objective];
+
+  terms = reader.terms;
+  for (i = 0; i < header->n_rows; i++)
     {
-      char *str = variable_to_string (variable);
+      const ImageRow *row = &reader.rows[i];
+      Expression *expr;
 
-      g_critical ("Unknown edit variable '%s'", str);
+      expr = image_read_expression (solver, vars, terms, row->n_terms, row->constant);
+      terms += row->n_terms;
 
-      g_free (str);
+      simplex_solver_add_row (solver, vars[row->subject], expr);
+      expression_unref (expr);
+    }
 
-      return;
+  cons = g_new (Constraint *, header->n_constraints);
+  indices = reader.indices;
+  for (i = 0; i < header->n_constraints; i++)
+    {
+      const ImageConstraint *image_cons = &reader.constraints[i];
+      Constraint *constraint = g_slice_new0 (Constraint);
+
+      constraint->solver = solver;
+      constraint->op_type = image_cons->op_type;
+      constraint->strength = image_cons->strength;
+      constraint->is_edit = (image_cons->flags & IMAGE_CONSTRAINT_EDIT) != 0;
+      constraint->is_stay = (image_cons->flags & IMAGE_CONSTRAINT_STAY) != 0;
+      constraint->expression = image_read_expression (solver, vars, terms,
+                                                      image_cons->n_terms,
+                                                      image_cons->constant);
+      terms += image_cons->n_terms;
+
+      if (image_cons->variable != IMAGE_NONE)
+        constraint->variable = vars[image_cons->variable];
+      if (constraint->is_edit || constraint->is_stay)
+        variable_ref (constraint->variable);
+
+      g_hash_table_add (solver->constraints, constraint);
+
+      if (image_cons->marker != IMAGE_NONE)
+        g_hash_table_insert (solver->marker_vars, constraint, vars[image_cons->marker]);
+
+      for (j = 0; j < image_cons->n_error_vars; j++)
+        simplex_solver_insert_error_variable (solver, constraint, vars[*indices++]);
+
+      if ((image_cons->flags & IMAGE_CONSTRAINT_EDIT_INFO) != 0)
+        {
+          EditInfo *ei = g_slice_new (EditInfo);
+
+          ei->constraint = constraint;
+          ei->eplus = image_cons->eplus != IMAGE_NONE ? vars[image_cons->eplus] : NULL;
+          ei->eminus = image_cons->eminus != IMAGE_NONE ? vars[image_cons->eminus] : NULL;
+          ei->prev_constant = image_cons->prev_constant;
+          ei->suggested_value = image_cons->suggested_value;
+
+          g_hash_table_insert (solver->edit_var_map, constraint->variable, ei);
+        }
+
+      if ((image_cons->flags & IMAGE_CONSTRAINT_STAY_INFO) != 0)
+        {
+          StayInfo *si = g_slice_new (StayInfo);
+
+          si->constraint = constraint;
+
+          g_hash_table_insert (solver->stay_var_map, constraint->variable, si);
+        }
+
+      if ((image_cons->flags & IMAGE_CONSTRAINT_ALIAS) != 0)
+        {
+          AliasInfo *alias = g_slice_new (AliasInfo);
+          int n_aliases;
+
+          alias->constraint = constraint;
+          alias->variable = variable_ref (vars[image_cons->alias_variable]);
+          alias->representative = variable_ref (vars[image_cons->alias_representative]);
+          alias->scale = image_cons->scale;
+          alias->offset = image_cons->offset;
+
+          g_hash_table_insert (solver->alias_vars, alias->variable, alias);
+          g_hash_table_insert (solver->alias_constraints, constraint, alias);
+
+          n_aliases = GPOINTER_TO_INT (g_hash_table_lookup (solver->alias_representatives,
+                                                            alias->representative));
+          g_hash_table_insert (solver->alias_representatives,
+                               alias->representative,
+                               GINT_TO_POINTER (n_aliases + 1));
+        }
+
+      if ((image_cons->flags & IMAGE_CONSTRAINT_DIFFERENCE) != 0)
+        g_ptr_array_add (solver->difference_constraints, constraint);
+
+      cons[i] = constraint;
     }
 
-  simplex_solver_remove_constraint (solver, ei->constraint);
-}
+  for (i = 0; i < header->n_stay_pairs; i++)
+    {
+      g_ptr_array_add (solver->stay_error_vars,
+                       variable_pair_new (vars[indices[0]], vars[indices[1]]));
+      indices += 2;
+    }
 
-void
-simplex_solver_remove_constraint (SimplexSolver *solver,
-                                  Constraint *constraint)
-{
-  Expression *z_row;
-  VariableSet *error_vars;
-  GHashTableIter iter;
-  Variable *marker;
+  for (i = 0; i < n_variables; i++)
+    variables[i] = variable_ref (vars[*indices++]);
 
-  if (!solver->initialized)
-    return;
+  for (i = 0; i < n_constraints; i++)
+    constraints[i] = cons[*indices++];
 
-  if (!g_hash_table_contains (solver->constraints, constraint))
+  solver->difference_mode = (header->flags & IMAGE_SOLVER_DIFFERENCE_MODE) != 0;
+  if (!solver->difference_mode)
+    g_clear_pointer (&solver->difference_constraints, g_ptr_array_unref);
+
+  solver->needs_solving = (header->flags & IMAGE_SOLVER_NEEDS_SOLVING) != 0;
+  solver->slack_counter = header->slack_counter;
+  solver->artificial_counter = header->artificial_counter;
+  solver->dummy_counter = header->dummy_counter;
+
+  /* Like simplex_solver_add_constraint(), the solver keeps the reference
+   * on the slack and dummy variables it creates
+   */
+  for (i = 0; i < header->n_variables; i++)
     {
-      char *str = constraint_to_string (constraint);
+      if (vars[i]->type == VARIABLE_REGULAR || vars[i]->type == VARIABLE_OBJECTIVE)
+        variable_unref (vars[i]);
+    }
 
-      g_critical ("Unknown constraint '%s', unable to remove it from solver", str);
+  g_free (vars);
+  g_free (cons);
 
-      g_free (str);
+  return true;
+}
+
+/* Parametric solutions
+ *
+ * Changing the value of an edit variable only changes the constants of
+ * the rows in the tableau; as long as every restricted basic variable
+ * stays non-negative, the current basis remains feasible and optimal,
+ * and every variable is an affine function of the edit values:
+ *
+ *   value = base + Σ coefficient[i] * (edit[i] - origin[i])
+ *
+ * We follow the same rules as simplex_solver_delta_edit_constant() to
+ * find the coefficients of each row, and store the rows of the restricted
+ * basic variables as the bounds of the region in which the solution is
+ * valid.
+ */
+
+static double *
+parametric_coefficients_lookup (GHashTable *coefficients,
+                                Variable *variable,
+                                int n_parameters)
+{
+  double *res = g_hash_table_lookup (coefficients, variable);
+
+  if (res == NULL)
+    {
+      res = g_new0 (double, n_parameters);
+      g_hash_table_insert (coefficients, variable, res);
     }
 
-  solver->needs_solving = true;
+  return res;
+}
 
-  simplex_solver_reset_stay_constants (solver);
+static void
+parametric_solution_add_value (ParametricSolution *solution,
+                               GArray *values,
+                               GHashTable *coefficients,
+                               Variable *variable,
+                               double base,
+                               double scale)
+{
+  double *row_coefficients = g_hash_table_lookup (coefficients, variable);
+  int i;
 
-  z_row = g_hash_table_lookup (solver->rows, solver->objective);
-  error_vars = g_hash_table_lookup (solver->error_vars, constraint);
+  g_array_append_val (values, base);
 
-  if (error_vars != NULL)
+  for (i = 0; i < solution->n_parameters; i++)
     {
-      Variable *v;
+      double c = row_coefficients != NULL ? row_coefficients[i] * scale : 0.0;
 
-      variable_set_iter_init (error_vars, &iter);
-      while (variable_set_iter_next (&iter, &v))
-        {
-          Expression *e;
+      g_array_append_val (values, c);
+    }
+}
 
-          e = g_hash_table_lookup (solver->rows, v);
+ParametricSolution *
+simplex_solver_get_parametric_solution (SimplexSolver *solver,
+                                        Variable **parameters,
+                                        int n_parameters)
+{
+  ParametricSolution *res;
+  GHashTable *coefficients;
+  GPtrArray *variables, *bound_variables;
+  GArray *values, *bounds;
+  GHashTableIter iter;
+  gpointer key_p, value_p;
+  int i;
 
-          if (e == NULL)
-            {
-              expression_add_variable (z_row,
-                                       v,
-                                       constraint->strength,
-                                       solver->objective);
-            }
-          else
-            {
-              expression_add_expression (z_row,
-                                         e,
-                                         constraint->strength,
-                                         solver->objective);
-            }
-        }
-    }
+  if (!solver->initialized || solver->needs_solving)
+    return NULL;
 
-  marker = g_hash_table_lookup (solver->marker_vars, constraint);
-  if (marker == NULL)
+  /* The components of the difference engine do not depend on the edit
+   * variables of the tableau, but they are not functions of their own
+   * edit variables
+   */
+  for (i = 0; i < n_parameters; i++)
     {
-      g_critical ("Constraint %p not found", constraint);
-      return;
+      if (simplex_solver_is_difference_variable (solver, parameters[i]))
+        return NULL;
     }
 
-  g_hash_table_remove (solver->marker_vars, constraint);
+  /* HashTable<Variable, double[n_parameters]>; the coefficients of each
+   * basic variable that depends on the parameters
+   */
+  coefficients = g_hash_table_new_full (NULL, NULL, NULL, g_free);
 
-  if (g_hash_table_lookup (solver->rows, marker) == NULL)
+  for (i = 0; i < n_parameters; i++)
     {
-      VariableSet *set = g_hash_table_lookup (solver->columns, marker);
-      Variable *exit_var = NULL;
-      Variable *v;
-      double min_ratio = 0;
+      EditInfo *ei = g_hash_table_lookup (solver->edit_var_map, parameters[i]);
+      VariableSet *column_set;
+      Variable *basic_var;
 
-      if (set == NULL)
-        goto no_columns;
-
-      variable_set_iter_init (set, &iter);
-      while (variable_set_iter_next (&iter, &v))
+      if (ei == NULL)
         {
-          if (variable_is_restricted (v))
-            {
-              Expression *e = g_hash_table_lookup (solver->rows, v);
-              double coeff = expression_get_coefficient (e, marker);
-
-              if (coeff < 0.0)
-                {
-                  double r = -expression_get_constant (e) / coeff;
-
-                  if (exit_var == NULL ||
-                      r < min_ratio ||
-                      approx_val (r, min_ratio))
-                    {
-                      min_ratio = r;
-                      exit_var = v;
-                    }
-                }
-            }
+          g_critical ("The variable %p is not an edit variable of the solver %p",
+                      parameters[i],
+                      solver);
+          g_hash_table_unref (coefficients);
+          return NULL;
         }
 
-      if (exit_var == NULL)
+      if (g_hash_table_contains (solver->rows, ei->eplus))
         {
-          variable_set_iter_init (set, &iter);
-          while (variable_set_iter_next (&iter, &v))
-            {
-              if (variable_is_restricted (v))
-                {
-                  Expression *e = g_hash_table_lookup (solver->rows, v);
-                  double coeff = expression_get_coefficient (e, marker);
-                  double r = 0.0;
-                  
-                  if (!approx_val (coeff, 0.0))
-                    r = expression_get_constant (e) / coeff;
-
-                  if (exit_var == NULL || r < min_ratio)
-                    {
-                      min_ratio = r;
-                      exit_var = v;
-                    }
-                }
-            }
+          parametric_coefficients_lookup (coefficients, ei->eplus, n_parameters)[i] = 1.0;
+          continue;
         }
 
-      if (exit_var == NULL)
+      if (g_hash_table_contains (solver->rows, ei->eminus))
         {
-          if (variable_set_get_size (set) == 0)
-            simplex_solver_remove_column (solver, marker);
-          else
-            {
-              variable_set_iter_init (set, &iter);
-              while (variable_set_iter_next (&iter, &v))
-                {
-                  if (v != solver->objective)
-                    {
-                      exit_var = v;
-                      break;
-                    }
-                }
-            }
+          parametric_coefficients_lookup (coefficients, ei->eminus, n_parameters)[i] = -1.0;
+          continue;
         }
 
-      if (exit_var != NULL)
-        simplex_solver_pivot (solver, marker, exit_var);
-    }
-
-no_columns:
-  if (g_hash_table_lookup (solver->rows, marker) == NULL)
-    simplex_solver_remove_row (solver, marker);
-
-  if (error_vars != NULL)
-    {
-      Variable *v;
+      column_set = g_hash_table_lookup (solver->columns, ei->eminus);
+      if (column_set == NULL)
+        continue;
 
-      variable_set_iter_init (error_vars, &iter);
-      while (variable_set_iter_next (&iter, &v))
+      variable_set_iter_init (column_set, &iter);
+      while (variable_set_iter_next (&iter, &basic_var))
         {
-          if (v != marker)
-            simplex_solver_remove_column (solver, v);
+          Expression *expr = g_hash_table_lookup (solver->rows, basic_var);
+
+          parametric_coefficients_lookup (coefficients, basic_var, n_parameters)[i] =
+            expression_get_coefficient (expr, ei->eminus);
         }
     }
 
-  if (constraint_is_stay (constraint))
+  res = g_slice_new0 (ParametricSolution);
+  res->solver = solver;
+  res->serial = solver->serial;
+  res->n_parameters = n_parameters;
+  res->parameters = g_new (Variable *, n_parameters);
+  res->origin = g_new (double, n_parameters);
+
+  for (i = 0; i < n_parameters; i++)
     {
-      if (error_vars != NULL)
-        {
-          GPtrArray *remaining = g_ptr_array_new_with_free_func (variable_pair_free);
-          int i = 0;
+      EditInfo *ei = g_hash_table_lookup (solver->edit_var_map, parameters[i]);
 
-          for (i = 0; i < solver->stay_error_vars->len; i++)
-            {
-              VariablePair *pair = g_ptr_array_index (solver->stay_error_vars, i);
-              bool found = false;
+      res->parameters[i] = variable_ref (parameters[i]);
+      res->origin[i] = ei->prev_constant;
+    }
 
-              if (variable_set_remove_variable (error_vars, pair->first))
-                found = true;
+  variables = g_ptr_array_new ();
+  bound_variables = g_ptr_array_new ();
+  values = g_array_new (FALSE, FALSE, sizeof (double));
+  bounds = g_array_new (FALSE, FALSE, sizeof (double));
 
-              if (variable_set_remove_variable (error_vars, pair->second))
-                found = true;
+  /* The restricted basic variables that depend on the parameters */
+  g_hash_table_iter_init (&iter, coefficients);
+  while (g_hash_table_iter_next (&iter, &key_p, &value_p))
+    {
+      Variable *basic_var = key_p;
+      Expression *expr = g_hash_table_lookup (solver->rows, basic_var);
+      double *row_coefficients = value_p;
+      double base;
 
-              if (!found)
-                g_ptr_array_add (remaining, variable_pair_new (pair->first, pair->second));
-            }
+      if (!variable_is_restricted (basic_var) || basic_var == solver->objective)
+        continue;
 
-          g_clear_pointer (&solver->stay_error_vars, g_ptr_array_unref);
-          solver->stay_error_vars = remaining;
-        }
+      base = expression_get_constant (expr);
+      g_ptr_array_add (bound_variables, variable_ref (basic_var));
+      g_array_append_val (bounds, base);
+      g_array_append_vals (bounds, row_coefficients, n_parameters);
+    }
 
-      g_hash_table_remove (solver->stay_var_map, constraint->variable);
+  /* The external variables; the parametric ones are always zero */
+  g_hash_table_iter_init (&iter, solver->external_rows);
+  while (g_hash_table_iter_next (&iter, &key_p, NULL))
+    {
+      Variable *variable = key_p;
+      Expression *expr = g_hash_table_lookup (solver->rows, variable);
+
+      g_ptr_array_add (variables, variable_ref (variable));
+      parametric_solution_add_value (res, values, coefficients, variable,
+                                     expression_get_constant (expr),
+                                     1.0);
     }
-  else if (constraint_is_edit (constraint))
+
+  g_hash_table_iter_init (&iter, solver->external_parametric_vars);
+  while (g_hash_table_iter_next (&iter, &key_p, NULL))
     {
-      EditInfo *ei = g_hash_table_lookup (solver->edit_var_map, constraint->variable);
+      Variable *variable = key_p;
 
-      simplex_solver_remove_column (solver, ei->eminus);
+      if (g_hash_table_contains (solver->rows, variable))
+        continue;
 
-      g_hash_table_remove (solver->edit_var_map, constraint->variable);
+      g_ptr_array_add (variables, variable_ref (variable));
+      parametric_solution_add_value (res, values, coefficients, variable, 0.0, 1.0);
     }
 
-  if (error_vars != NULL)
-    g_hash_table_remove (solver->error_vars, constraint);
+  g_hash_table_iter_init (&iter, solver->alias_vars);
+  while (g_hash_table_iter_next (&iter, NULL, &value_p))
+    {
+      AliasInfo *alias = value_p;
+      Expression *expr = g_hash_table_lookup (solver->rows, alias->representative);
+      double base = expr != NULL ? expression_get_constant (expr) : 0.0;
+
+      g_ptr_array_add (variables, variable_ref (alias->variable));
+      parametric_solution_add_value (res, values, coefficients, alias->representative,
+                                     base * alias->scale + alias->offset,
+                                     alias->scale);
+    }
 
-  if (solver->auto_solve)
+  /* The variables of the difference engine keep their values */
+  if (solver->difference_graph != NULL)
     {
-      simplex_solver_optimize (solver, solver->objective);
-      simplex_solver_set_external_variables (solver);
+      g_hash_table_iter_init (&iter, solver->difference_graph->indices);
+      while (g_hash_table_iter_next (&iter, &key_p, NULL))
+        {
+          Variable *variable = key_p;
+
+          g_ptr_array_add (variables, variable_ref (variable));
+          parametric_solution_add_value (res, values, coefficients, variable,
+                                         variable_get_value (variable),
+                                         1.0);
+        }
     }
 
-  g_hash_table_remove (solver->constraints, constraint);
+  res->n_values = variables->len;
+  res->variables = (Variable **) g_ptr_array_free (variables, FALSE);
+  res->values = (double *) (void *) g_array_free (values, FALSE);
+  res->n_bounds = bound_variables->len;
+  res->bound_variables = (Variable **) g_ptr_array_free (bound_variables, FALSE);
+  res->bounds = (double *) (void *) g_array_free (bounds, FALSE);
+
+  g_hash_table_unref (coefficients);
+
+  return res;
 }
 
-void
-simplex_solver_suggest_value (SimplexSolver *solver,
-                              Variable *variable,
-                              double value)
+static double
+parametric_evaluate (const double *form,
+                     const double *deltas,
+                     int n_parameters)
 {
-  EditInfo *ei;
+  double res = form[0];
+  int i;
 
-  if (!solver->initialized)
-    {
-      char *str = variable_to_string (variable);
+  for (i = 0; i < n_parameters; i++)
+    res += form[i + 1] * deltas[i];
 
-      g_critical ("Unable to suggest value '%g' for variable '%s': the "
-                  "SimplexSolver %p is not initialized.",
-                  value, str, solver);
+  return res;
+}
 
-      g_free (str);
-      return;
-    }
+bool
+parametric_solution_contains (const ParametricSolution *solution,
+                              const double *parameters)
+{
+  double *deltas;
+  bool res = true;
+  int i, stride;
 
-  ei = g_hash_table_lookup (solver->edit_var_map, variable);
-  if (ei == NULL)
+  if (solution->serial != solution->solver->serial)
+    return false;
+
+  deltas = g_newa (double, solution->n_parameters);
+  for (i = 0; i < solution->n_parameters; i++)
+    deltas[i] = parameters[i] - solution->origin[i];
+
+  stride = solution->n_parameters + 1;
+
+  for (i = 0; i < solution->n_bounds; i++)
     {
-      g_critical ("Suggesting value '%g' but variable %p is not editable",
-                  value, variable);
-      return;
-    }
+      const double *bound = solution->bounds + (i * stride);
+      double value = parametric_evaluate (bound, deltas, solution->n_parameters);
 
-  ei->prev_constant = value - ei->prev_constant;
+      if (value < 0.0 && !approx_zero (value, bound[0]))
+        {
+          res = false;
+          break;
+        }
+    }
 
-  simplex_solver_delta_edit_constant (solver, ei->prev_constant, ei->eplus, ei->eminus);
+  return res;
 }
 
-void
-simplex_solver_resolve (SimplexSolver *solver)
+bool
+parametric_solution_apply (const ParametricSolution *solution,
+                           const double *parameters)
 {
-  if (!solver->initialized)
-    {
-      g_critical ("Unable to resolve the simplex: the SimplexSolver %p "
-                  "is not initialized",
-                  solver);
-      return;
-    }
+  double *deltas;
+  int i, stride;
 
-#ifdef EMEUS_ENABLE_DEBUG
-  gint64 start_time = g_get_monotonic_time ();
-#endif
+  if (!parametric_solution_contains (solution, parameters))
+    return false;
 
-  simplex_solver_dual_optimize (solver);
-  simplex_solver_set_external_variables (solver);
+  deltas = g_newa (double, solution->n_parameters);
+  for (i = 0; i < solution->n_parameters; i++)
+    deltas[i] = parameters[i] - solution->origin[i];
 
-  g_hash_table_remove_all (solver->infeasible_rows);
+  stride = solution->n_parameters + 1;
 
-  simplex_solver_reset_stay_constants (solver);
+  for (i = 0; i < solution->n_values; i++)
+    {
+      const double *form = solution->values + (i * stride);
 
-#ifdef EMEUS_ENABLE_DEBUG
-  g_debug ("resolve.time := %.3f ms",
-           (float) (g_get_monotonic_time () - start_time) / 1000.f);
-#endif
+      variable_set_value (solution->variables[i],
+                          parametric_evaluate (form, deltas, solution->n_parameters));
+    }
 
-  solver->needs_solving = false;
+  return true;
 }
 
 void
-simplex_solver_begin_edit (SimplexSolver *solver)
+parametric_solution_free (ParametricSolution *solution)
 {
-  if (g_hash_table_size (solver->edit_var_map) == 0)
-    {
-      g_critical ("Solver %p does not have editable variables.", solver);
-      return;
-    }
+  int i;
 
-  g_hash_table_remove_all (solver->infeasible_rows);
-  simplex_solver_reset_stay_constants (solver);
-}
+  if (solution == NULL)
+    return;
 
+  for (i = 0; i < solution->n_values; i++)
+    variable_unref (solution->variables[i]);
 
-void
-simplex_solver_end_edit (SimplexSolver *solver)
-{
-  simplex_solver_resolve (solver);
+  for (i = 0; i < solution->n_bounds; i++)
+    variable_unref (solution->bound_variables[i]);
+
+  for (i = 0; i < solution->n_parameters; i++)
+    variable_unref (solution->parameters[i]);
+
+  g_free (solution->parameters);
+  g_free (solution->variables);
+  g_free (solution->bound_variables);
+  g_free (solution->values);
+  g_free (solution->bounds);
+  g_free (solution->origin);
+  g_free (solution->edit_offsets);
+  g_free (solution->edit_rows);
+  g_free (solution->stay_rows);
+  g_free (solution->bound_rows);
+
+  g_slice_free (ParametricSolution, solution);
 }
@@ -24,6 +24,9 @@
 G_BEGIN_DECLS
 
 typedef struct _SimplexSolver   SimplexSolver;
+typedef struct _ParametricSolution ParametricSolution;
+typedef struct _Journal         Journal;
+typedef struct _DifferenceGraph DifferenceGraph;
 
 typedef enum {
   VARIABLE_DUMMY     = 'd',
@@ -48,6 +51,11 @@ typedef struct {
   bool is_pivotable;
   bool is_restricted;
 
+  /* Whether the row keyed by this variable is in the solver's
+   * infeasible rows worklist
+   */
+  bool is_queued;
+
   SimplexSolver *solver;
 } Variable;
 
@@ -117,9 +125,19 @@ typedef struct {
     NULL, NULL, \
     NULL, NULL, \
     NULL, \
+    NULL, NULL, \
+    NULL, NULL, NULL, \
+    NULL, NULL, \
+    NULL, \
+    NULL, NULL, \
+    NULL, \
     NULL, \
     0, 0, 0, 0, \
-    false, false, \
+    0, 0, 0, 0, \
+    0, 0, 0, \
+    0, 0, 0, \
+    false, false, false, false, \
+    0, false, \
   }
 
 struct _SimplexSolver {
@@ -131,8 +149,10 @@ struct _SimplexSolver {
   /* HashTable<Variable, Expression> */
   GHashTable *rows;
 
+  /* Vec<Variable>; the worklist of rows with a negative constant */
+  GPtrArray *infeasible_rows;
+
   /* Sets */
-  GHashTable *infeasible_rows;
   GHashTable *external_rows;
   GHashTable *external_parametric_vars;
 
@@ -147,14 +167,139 @@ struct _SimplexSolver {
   Variable *objective;
 
   GHashTable *constraints;
+  GHashTable *disabled_constraints;
+
+  /* Equality aliases between variables that never enter the tableau */
+  GHashTable *alias_vars;
+  GHashTable *alias_constraints;
+  GHashTable *alias_representatives;
+
+  /* Vec<Constraint>; the constraints solved by the difference engine */
+  GPtrArray *difference_constraints;
+
+  /* The constraint graph of the difference engine, or NULL if it needs
+   * to be built from the constraints
+   */
+  DifferenceGraph *difference_graph;
+
+  /* The current basis, as a function of the edit variables */
+  ParametricSolution *compiled_basis;
+
+  /* Maps the variables and constraints of the parent solver to their
+   * copies; only set if the solver was created by simplex_solver_fork()
+   */
+  GHashTable *forked_variables;
+  GHashTable *forked_constraints;
+
+  /* The undo log of the open transaction, if any */
+  Journal *journal;
+
+  /* The image the solver was loaded from, if any */
+  GBytes *image;
 
   int slack_counter;
   int artificial_counter;
   int dummy_counter;
   int optimize_count;
 
+  int pivot_count;
+  int degenerate_pivot_count;
+  int bland_fallback_count;
+  int fill_in_count;
+  int fast_resolve_count;
+
+  /* The rows of the edit and stay variables looked up in the tableau to
+   * update their constants; a fast resolve uses the rows cached in the
+   * compiled basis instead
+   */
+  int row_lookup_count;
+
+  /* Incremented every time a constraint is added or removed */
+  int serial;
+
+  /* The number of removed constraints after which the solver compacts
+   * itself, or 0; see simplex_solver_compact()
+   */
+  int compact_threshold;
+  int removals_since_compact;
+  int compact_count;
+
   bool auto_solve;
   bool needs_solving;
+  bool difference_mode;
+
+  /* Whether the tableau lags behind the suggested edit values */
+  bool has_pending_edits;
+
+  /* The consecutive degenerate pivots of the last optimization, and
+   * whether it switched to Bland's rule; kept while the optimization
+   * is incomplete
+   */
+  int n_degenerate_pivots;
+  bool use_bland;
+};
+
+/* A row of the tableau, with the coefficient of a parameter */
+typedef struct {
+  Variable *variable;
+  Expression *expression;
+  double coefficient;
+} ParametricRow;
+
+struct _ParametricSolution {
+  SimplexSolver *solver;
+
+  /* The value of SimplexSolver.serial when the solution was computed */
+  int serial;
+
+  /* The edit variables, and their values when the solution was computed */
+  int n_parameters;
+  Variable **parameters;
+  double *origin;
+
+  /* Each value and bound is stored as n_parameters + 1 doubles: the
+   * base value, followed by the coefficient of each parameter
+   */
+  int n_values;
+  Variable **variables;
+  double *values;
+
+  /* The restricted basic variables of the bounds */
+  int n_bounds;
+  Variable **bound_variables;
+  double *bounds;
+
+  /* The rows updated by a fast resolve, if the solution is the compiled
+   * basis of its solver, or NULL: the rows moved by the parameter i are
+   * edit_rows[edit_offsets[i]] up to edit_rows[edit_offsets[i + 1]];
+   * the rows are valid as long as the basis, as removing a row from the
+   * tableau drops the compiled basis
+   */
+  int *edit_offsets;
+  ParametricRow *edit_rows;
+  int n_stay_rows;
+  ParametricRow *stay_rows;
+  Expression **bound_rows;
 };
 
+/* An independent constraint system solved by simplex_solver_solve_batch() */
+typedef struct {
+  SimplexSolver *solver;
+
+  /* The values to suggest for the edit variables, if any */
+  int n_edits;
+  Variable **edit_variables;
+  double *edit_values;
+
+  /* The variables to read back, and their values once solved; values
+   * has room for n_variables doubles
+   */
+  int n_variables;
+  Variable **variables;
+  double *values;
+
+  /* The time spent solving the system, in microseconds */
+  gint64 solve_time;
+} SolverBatchItem;
+
 G_END_DECLS
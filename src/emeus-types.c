@@ -46,3 +46,8 @@ EMEUS_DEFINE_ENUM_TYPE (EmeusConstraintStrength, emeus_constraint_strength,
                         EMEUS_ENUM_VALUE (EMEUS_CONSTRAINT_STRENGTH_MEDIUM, "medium")
                         EMEUS_ENUM_VALUE (EMEUS_CONSTRAINT_STRENGTH_STRONG, "strong")
                         EMEUS_ENUM_VALUE (EMEUS_CONSTRAINT_STRENGTH_REQUIRED, "required"))
+
+EMEUS_DEFINE_ENUM_TYPE (EmeusConstraintLayoutError, emeus_constraint_layout_error,
+                        EMEUS_ENUM_VALUE (EMEUS_CONSTRAINT_LAYOUT_ERROR_INVALID_SYMBOL, "invalid-symbol")
+                        EMEUS_ENUM_VALUE (EMEUS_CONSTRAINT_LAYOUT_ERROR_INVALID_VIEW, "invalid-view")
+                        EMEUS_ENUM_VALUE (EMEUS_CONSTRAINT_LAYOUT_ERROR_INVALID_PREDICATE, "invalid-predicate"))
@@ -120,4 +120,26 @@ typedef enum
 EMEUS_AVAILABLE_IN_1_0
 GType emeus_constraint_attribute_get_type (void) G_GNUC_CONST;
 
+/**
+ * EmeusConstraintLayoutError:
+ * @EMEUS_CONSTRAINT_LAYOUT_ERROR_INVALID_SYMBOL: An unexpected symbol
+ * @EMEUS_CONSTRAINT_LAYOUT_ERROR_INVALID_VIEW: An unknown view name
+ * @EMEUS_CONSTRAINT_LAYOUT_ERROR_INVALID_PREDICATE: An invalid predicate
+ *
+ * The errors returned when parsing the description of constraints, in
+ * the %EMEUS_CONSTRAINT_LAYOUT_ERROR domain.
+ *
+ * Since: 1.0
+ */
+typedef enum {
+  EMEUS_CONSTRAINT_LAYOUT_ERROR_INVALID_SYMBOL,
+  EMEUS_CONSTRAINT_LAYOUT_ERROR_INVALID_VIEW,
+  EMEUS_CONSTRAINT_LAYOUT_ERROR_INVALID_PREDICATE
+} EmeusConstraintLayoutError;
+
+#define EMEUS_TYPE_CONSTRAINT_LAYOUT_ERROR (emeus_constraint_layout_error_get_type())
+
+EMEUS_AVAILABLE_IN_1_0
+GType emeus_constraint_layout_error_get_type (void) G_GNUC_CONST;
+
 G_END_DECLS
@@ -30,5 +30,6 @@ OperatorType relation_to_operator (EmeusConstraintRelation rel);
 StrengthType strength_to_value (EmeusConstraintStrength strength);
 
 bool approx_val (double v1, double v2);
+bool approx_zero (double v, double scale);
 
 G_END_DECLS
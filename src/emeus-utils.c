@@ -90,9 +90,27 @@ strength_to_value (EmeusConstraintStrength strength)
   return STRENGTH_REQUIRED;
 }
 
+/* The coefficients in the tableau span many orders of magnitude, from
+ * the weak strength (1) to the required one (~1e9), so comparing them
+ * against an absolute epsilon either misses the rounding noise left by
+ * cancellation in large coefficients, or confuses small but meaningful
+ * coefficients with zero. We use a tolerance relative to the magnitude
+ * of the values involved instead.
+ */
+#define RELATIVE_EPSILON        1.0e-12
+
 bool
 approx_val (double v1,
             double v2)
 {
-  return fabs (v1 - v2) < DBL_EPSILON;
+  double scale = MAX (fabs (v1), fabs (v2));
+
+  return fabs (v1 - v2) <= RELATIVE_EPSILON * MAX (scale, 1.0);
+}
+
+bool
+approx_zero (double v,
+             double scale)
+{
+  return fabs (v) <= RELATIVE_EPSILON * MAX (fabs (scale), 1.0);
 }
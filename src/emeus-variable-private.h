@@ -71,6 +71,8 @@ variable_get_value (const Variable *variable)
 
 Variable *variable_new (SimplexSolver *solver,
                         VariableType type);
+Variable *variable_clone (const Variable *variable,
+                          SimplexSolver *solver);
 Variable *variable_ref (Variable *variable);
 void variable_unref (Variable *variable);
 
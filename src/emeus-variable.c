@@ -66,7 +66,7 @@ variable_new (SimplexSolver *solver,
   Variable *res = g_slice_new0 (Variable);
 
   res->solver = solver;
-  res->id_ = ++variable_id;
+  res->id_ = g_atomic_int_add (&variable_id, 1) + 1;
   res->type = type;
   res->ref_count = 1;
   res->name = NULL;
@@ -94,6 +94,20 @@ variable_new (SimplexSolver *solver,
   return res;
 }
 
+/* Copies @variable for use in @solver; the copy keeps the same id */
+Variable *
+variable_clone (const Variable *variable,
+                SimplexSolver *solver)
+{
+  Variable *res = g_slice_dup (Variable, variable);
+
+  res->solver = solver;
+  res->ref_count = 1;
+  res->is_queued = false;
+
+  return res;
+}
+
 static void
 variable_free (Variable *variable)
 {
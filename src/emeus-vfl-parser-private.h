@@ -0,0 +1,36 @@
+/* emeus-vfl-parser-private.h: Visual format language parser
+ *
+ * Copyright 2016  Endless
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "emeus-types.h"
+#include "emeus-constraint.h"
+
+#include <stdbool.h>
+
+G_BEGIN_DECLS
+
+bool vfl_parser_parse (const char *text,
+                       gssize length,
+                       int hspacing,
+                       int vspacing,
+                       GHashTable *views,
+                       GArray *descriptors,
+                       GError **error);
+
+G_END_DECLS
@@ -0,0 +1,696 @@
+/* emeus-vfl-parser.c: Visual format language parser
+ *
+ * Copyright 2016  Endless
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* The grammar of each line is:
+ *
+ *   line        := (orientation ':')? ('|' connection)? view (connection view)* (connection '|')?
+ *   orientation := 'H' | 'V'
+ *   connection  := '' | '-' | '-' number '-' | '-' predicates '-'
+ *   view        := '[' name predicates? (',' name predicates?)* ']'
+ *   predicates  := '(' predicate (',' predicate)* ')'
+ *   predicate   := relation? (number | name) ('@' strength)?
+ *   relation    := '==' | '<=' | '>='
+ *   strength    := 'required' | 'strong' | 'medium' | 'weak'
+ *
+ * The views in the same brackets are laid out in parallel: each one is
+ * connected to the views, or the layout, on both sides.
+ *
+ * The text is parsed in a single pass, without building a syntax tree:
+ * each constraint is appended to the descriptors as soon as it is read.
+ */
+
+#include "config.h"
+
+#include "emeus-vfl-parser-private.h"
+
+#include "emeus-constraint-layout.h"
+
+#include <string.h>
+
+typedef struct {
+  const char *line_start;
+  const char *cursor;
+  const char *end;
+  int line_number;
+
+  int spacing;
+
+  /* The leading, trailing and size attributes for the orientation */
+  EmeusConstraintAttribute leading;
+  EmeusConstraintAttribute trailing;
+  EmeusConstraintAttribute size;
+
+  GHashTable *views;
+  GArray *descriptors;
+
+  /* The views before and after the current connection; a NULL view is
+   * the layout; the arrays are reused for each connection
+   */
+  GPtrArray *previous;
+  GPtrArray *next;
+} VflParser;
+
+typedef struct {
+  EmeusConstraintRelation relation;
+
+  /* The view, or NULL for a constant */
+  gpointer view;
+  double constant;
+
+  EmeusConstraintStrength strength;
+} VflPredicate;
+
+static void
+vfl_parser_set_error (VflParser *parser,
+                      GError **error,
+                      EmeusConstraintLayoutError code,
+                      const char *format,
+                      ...) G_GNUC_PRINTF (4, 5);
+
+static void
+vfl_parser_set_error (VflParser *parser,
+                      GError **error,
+                      EmeusConstraintLayoutError code,
+                      const char *format,
+                      ...)
+{
+  va_list args;
+  char *message;
+
+  va_start (args, format);
+  message = g_strdup_vprintf (format, args);
+  va_end (args);
+
+  g_set_error (error, EMEUS_CONSTRAINT_LAYOUT_ERROR, code,
+               "Line %d, column %d: %s",
+               parser->line_number,
+               (int) (parser->cursor - parser->line_start) + 1,
+               message);
+
+  g_free (message);
+}
+
+static inline char
+vfl_parser_peek (VflParser *parser)
+{
+  while (parser->cursor < parser->end &&
+         (*parser->cursor == ' ' || *parser->cursor == '\t' || *parser->cursor == '\r'))
+    parser->cursor++;
+
+  return parser->cursor < parser->end ? *parser->cursor : '\0';
+}
+
+static inline bool
+vfl_parser_accept (VflParser *parser,
+                   char c)
+{
+  if (vfl_parser_peek (parser) != c)
+    return false;
+
+  parser->cursor++;
+
+  return true;
+}
+
+static inline bool
+is_name_start (char c)
+{
+  return g_ascii_isalpha (c) || c == '_';
+}
+
+static inline bool
+is_name_char (char c)
+{
+  return g_ascii_isalnum (c) || c == '_' || c == '-' || c == '.';
+}
+
+/* Looks up a view by name, without copying the name unless it is long */
+static bool
+vfl_parser_parse_view_name (VflParser *parser,
+                            gpointer *view,
+                            GError **error)
+{
+  const char *start;
+  char buf[128];
+  char *name;
+  gsize len;
+
+  if (!is_name_start (vfl_parser_peek (parser)))
+    {
+      vfl_parser_set_error (parser, error, EMEUS_CONSTRAINT_LAYOUT_ERROR_INVALID_VIEW,
+                            "Expected a view name");
+      return false;
+    }
+
+  start = parser->cursor;
+  while (parser->cursor < parser->end && is_name_char (*parser->cursor))
+    parser->cursor++;
+
+  len = parser->cursor - start;
+  if (len < sizeof (buf))
+    {
+      memcpy (buf, start, len);
+      buf[len] = '\0';
+      name = buf;
+    }
+  else
+    name = g_strndup (start, len);
+
+  *view = g_hash_table_lookup (parser->views, name);
+  if (*view == NULL)
+    {
+      parser->cursor = start;
+      vfl_parser_set_error (parser, error, EMEUS_CONSTRAINT_LAYOUT_ERROR_INVALID_VIEW,
+                            "Unknown view '%s'", name);
+    }
+
+  if (name != buf)
+    g_free (name);
+
+  return *view != NULL;
+}
+
+static bool
+vfl_parser_parse_number (VflParser *parser,
+                         double *number,
+                         GError **error)
+{
+  char *end;
+
+  vfl_parser_peek (parser);
+
+  /* The text is not nul-terminated, so the number is parsed before the end */
+  if (parser->cursor < parser->end &&
+      (g_ascii_isdigit (*parser->cursor) || *parser->cursor == '.' || *parser->cursor == '-'))
+    {
+      char buf[G_ASCII_DTOSTR_BUF_SIZE];
+      gsize len = 0;
+
+      while (parser->cursor + len < parser->end &&
+             len < sizeof (buf) - 1 &&
+             (g_ascii_isdigit (parser->cursor[len]) ||
+              parser->cursor[len] == '.' ||
+              (len == 0 && parser->cursor[len] == '-')))
+        {
+          buf[len] = parser->cursor[len];
+          len++;
+        }
+
+      buf[len] = '\0';
+
+      *number = g_ascii_strtod (buf, &end);
+      if (end != buf && *end == '\0')
+        {
+          parser->cursor += len;
+          return true;
+        }
+    }
+
+  vfl_parser_set_error (parser, error, EMEUS_CONSTRAINT_LAYOUT_ERROR_INVALID_PREDICATE,
+                        "Expected a number");
+
+  return false;
+}
+
+static bool
+vfl_parser_parse_strength (VflParser *parser,
+                           EmeusConstraintStrength *strength,
+                           GError **error)
+{
+  static const struct {
+    const char *name;
+    EmeusConstraintStrength strength;
+  } strengths[] = {
+    { "required", EMEUS_CONSTRAINT_STRENGTH_REQUIRED },
+    { "strong", EMEUS_CONSTRAINT_STRENGTH_STRONG },
+    { "medium", EMEUS_CONSTRAINT_STRENGTH_MEDIUM },
+    { "weak", EMEUS_CONSTRAINT_STRENGTH_WEAK },
+  };
+  const char *start = parser->cursor;
+  gsize len;
+  int i;
+
+  while (parser->cursor < parser->end && g_ascii_isalpha (*parser->cursor))
+    parser->cursor++;
+
+  len = parser->cursor - start;
+
+  for (i = 0; i < G_N_ELEMENTS (strengths); i++)
+    {
+      if (strlen (strengths[i].name) == len &&
+          strncmp (start, strengths[i].name, len) == 0)
+        {
+          *strength = strengths[i].strength;
+          return true;
+        }
+    }
+
+  parser->cursor = start;
+  vfl_parser_set_error (parser, error, EMEUS_CONSTRAINT_LAYOUT_ERROR_INVALID_PREDICATE,
+                        "Unknown strength '%.*s'", (int) len, start);
+
+  return false;
+}
+
+/* predicate := relation? (number | name) ('@' strength)? */
+static bool
+vfl_parser_parse_predicate (VflParser *parser,
+                            bool allow_views,
+                            VflPredicate *predicate,
+                            GError **error)
+{
+  char c = vfl_parser_peek (parser);
+
+  predicate->relation = EMEUS_CONSTRAINT_RELATION_EQ;
+  predicate->view = NULL;
+  predicate->constant = 0.0;
+  predicate->strength = EMEUS_CONSTRAINT_STRENGTH_REQUIRED;
+
+  if ((c == '=' || c == '<' || c == '>') &&
+      parser->cursor + 1 < parser->end &&
+      parser->cursor[1] == '=')
+    {
+      predicate->relation = c == '=' ? EMEUS_CONSTRAINT_RELATION_EQ
+                          : c == '<' ? EMEUS_CONSTRAINT_RELATION_LE
+                          : EMEUS_CONSTRAINT_RELATION_GE;
+      parser->cursor += 2;
+    }
+  else if (c == '=' || c == '<' || c == '>')
+    {
+      vfl_parser_set_error (parser, error, EMEUS_CONSTRAINT_LAYOUT_ERROR_INVALID_PREDICATE,
+                            "Expected '==', '<=' or '>='");
+      return false;
+    }
+
+  if (is_name_start (vfl_parser_peek (parser)))
+    {
+      if (!allow_views)
+        {
+          vfl_parser_set_error (parser, error, EMEUS_CONSTRAINT_LAYOUT_ERROR_INVALID_PREDICATE,
+                                "Spacings cannot refer to views");
+          return false;
+        }
+
+      if (!vfl_parser_parse_view_name (parser, &predicate->view, error))
+        return false;
+    }
+  else if (!vfl_parser_parse_number (parser, &predicate->constant, error))
+    return false;
+
+  if (vfl_parser_accept (parser, '@'))
+    return vfl_parser_parse_strength (parser, &predicate->strength, error);
+
+  return true;
+}
+
+static void
+vfl_parser_add_descriptor (VflParser *parser,
+                           gpointer target_object,
+                           EmeusConstraintAttribute target_attribute,
+                           const VflPredicate *predicate,
+                           gpointer source_object,
+                           EmeusConstraintAttribute source_attribute)
+{
+  EmeusConstraintDescriptor descriptor;
+
+  descriptor.target_object = target_object;
+  descriptor.target_attribute = target_attribute;
+  descriptor.relation = predicate->relation;
+  descriptor.source_object = source_object;
+  descriptor.source_attribute = source_attribute;
+  descriptor.multiplier = 1.0;
+  descriptor.constant = predicate->constant;
+  descriptor.strength = predicate->strength;
+
+  g_array_append_val (parser->descriptors, descriptor);
+}
+
+/* The predicates of a view constrain its size, to a constant or to the
+ * size of another view
+ */
+static bool
+vfl_parser_parse_view_predicates (VflParser *parser,
+                                  gpointer view,
+                                  GError **error)
+{
+  do
+    {
+      VflPredicate predicate;
+
+      if (!vfl_parser_parse_predicate (parser, true, &predicate, error))
+        return false;
+
+      if (predicate.view != NULL)
+        vfl_parser_add_descriptor (parser,
+                                   view, parser->size,
+                                   &predicate,
+                                   predicate.view, parser->size);
+      else
+        vfl_parser_add_descriptor (parser,
+                                   view, parser->size,
+                                   &predicate,
+                                   NULL, EMEUS_CONSTRAINT_ATTRIBUTE_INVALID);
+    }
+  while (vfl_parser_accept (parser, ','));
+
+  if (!vfl_parser_accept (parser, ')'))
+    {
+      vfl_parser_set_error (parser, error, EMEUS_CONSTRAINT_LAYOUT_ERROR_INVALID_SYMBOL,
+                            "Expected ')'");
+      return false;
+    }
+
+  return true;
+}
+
+/* view := '[' name predicates? (',' name predicates?)* ']' */
+static bool
+vfl_parser_parse_views (VflParser *parser,
+                        GError **error)
+{
+  g_ptr_array_set_size (parser->next, 0);
+
+  do
+    {
+      gpointer view;
+
+      if (!vfl_parser_parse_view_name (parser, &view, error))
+        return false;
+
+      if (vfl_parser_accept (parser, '(') &&
+          !vfl_parser_parse_view_predicates (parser, view, error))
+        return false;
+
+      g_ptr_array_add (parser->next, view);
+    }
+  while (vfl_parser_accept (parser, ','));
+
+  if (!vfl_parser_accept (parser, ']'))
+    {
+      vfl_parser_set_error (parser, error, EMEUS_CONSTRAINT_LAYOUT_ERROR_INVALID_SYMBOL,
+                            "Expected ']'");
+      return false;
+    }
+
+  return true;
+}
+
+/* Connects the leading edge of each view after a connection to the
+ * trailing edge of each view before it; the edges of the layout are
+ * used for the NULL views
+ */
+static void
+vfl_parser_connect (VflParser *parser,
+                    const VflPredicate *predicate)
+{
+  int i, j;
+
+  for (i = 0; i < parser->next->len; i++)
+    {
+      gpointer target = g_ptr_array_index (parser->next, i);
+
+      for (j = 0; j < parser->previous->len; j++)
+        {
+          gpointer source = g_ptr_array_index (parser->previous, j);
+
+          vfl_parser_add_descriptor (parser,
+                                     target, target != NULL ? parser->leading : parser->trailing,
+                                     predicate,
+                                     source, source != NULL ? parser->trailing : parser->leading);
+        }
+    }
+}
+
+/* connection := '' | '-' | '-' number '-' | '-' predicates '-'
+ *
+ * The predicates are stored in the given array, which has room for
+ * max_predicates; returns the number of predicates, or -1 on error
+ */
+static int
+vfl_parser_parse_connection (VflParser *parser,
+                             VflPredicate *predicates,
+                             int max_predicates,
+                             GError **error)
+{
+  int n_predicates = 0;
+  char c;
+
+  predicates[0].relation = EMEUS_CONSTRAINT_RELATION_EQ;
+  predicates[0].view = NULL;
+  predicates[0].strength = EMEUS_CONSTRAINT_STRENGTH_REQUIRED;
+
+  /* Adjacent views */
+  if (!vfl_parser_accept (parser, '-'))
+    {
+      predicates[0].constant = 0.0;
+      return 1;
+    }
+
+  /* The default spacing */
+  c = vfl_parser_peek (parser);
+  if (c == '[' || c == '|')
+    {
+      predicates[0].constant = parser->spacing;
+      return 1;
+    }
+
+  if (vfl_parser_accept (parser, '('))
+    {
+      do
+        {
+          if (n_predicates == max_predicates)
+            {
+              vfl_parser_set_error (parser, error, EMEUS_CONSTRAINT_LAYOUT_ERROR_INVALID_PREDICATE,
+                                    "Too many predicates");
+              return -1;
+            }
+
+          if (!vfl_parser_parse_predicate (parser, false, &predicates[n_predicates], error))
+            return -1;
+
+          n_predicates += 1;
+        }
+      while (vfl_parser_accept (parser, ','));
+
+      if (!vfl_parser_accept (parser, ')'))
+        {
+          vfl_parser_set_error (parser, error, EMEUS_CONSTRAINT_LAYOUT_ERROR_INVALID_SYMBOL,
+                                "Expected ')'");
+          return -1;
+        }
+    }
+  else
+    {
+      if (!vfl_parser_parse_number (parser, &predicates[0].constant, error))
+        return -1;
+
+      n_predicates = 1;
+    }
+
+  if (!vfl_parser_accept (parser, '-'))
+    {
+      vfl_parser_set_error (parser, error, EMEUS_CONSTRAINT_LAYOUT_ERROR_INVALID_SYMBOL,
+                            "Expected '-'");
+      return -1;
+    }
+
+  return n_predicates;
+}
+
+#define MAX_CONNECTION_PREDICATES       8
+
+static bool
+vfl_parser_parse_line (VflParser *parser,
+                       GError **error)
+{
+  VflPredicate predicates[MAX_CONNECTION_PREDICATES];
+  bool has_views = false;
+  int i, n_predicates;
+
+  parser->leading = EMEUS_CONSTRAINT_ATTRIBUTE_START;
+  parser->trailing = EMEUS_CONSTRAINT_ATTRIBUTE_END;
+  parser->size = EMEUS_CONSTRAINT_ATTRIBUTE_WIDTH;
+
+  switch (vfl_parser_peek (parser))
+    {
+    case 'V':
+      parser->leading = EMEUS_CONSTRAINT_ATTRIBUTE_TOP;
+      parser->trailing = EMEUS_CONSTRAINT_ATTRIBUTE_BOTTOM;
+      parser->size = EMEUS_CONSTRAINT_ATTRIBUTE_HEIGHT;
+      /* fall through */
+
+    case 'H':
+      parser->cursor++;
+      if (!vfl_parser_accept (parser, ':'))
+        {
+          vfl_parser_set_error (parser, error, EMEUS_CONSTRAINT_LAYOUT_ERROR_INVALID_SYMBOL,
+                                "Expected ':' after the orientation");
+          return false;
+        }
+      break;
+
+    default:
+      break;
+    }
+
+  g_ptr_array_set_size (parser->previous, 0);
+
+  if (vfl_parser_accept (parser, '|'))
+    g_ptr_array_add (parser->previous, NULL);
+
+  while (true)
+    {
+      char c;
+
+      if (parser->previous->len > 0)
+        {
+          n_predicates = vfl_parser_parse_connection (parser, predicates,
+                                                      G_N_ELEMENTS (predicates),
+                                                      error);
+          if (n_predicates < 0)
+            return false;
+        }
+      else
+        n_predicates = 0;
+
+      c = vfl_parser_peek (parser);
+      if (c == '[')
+        {
+          parser->cursor++;
+          if (!vfl_parser_parse_views (parser, error))
+            return false;
+
+          has_views = true;
+        }
+      else if (c == '|' && has_views)
+        {
+          parser->cursor++;
+          g_ptr_array_set_size (parser->next, 0);
+          g_ptr_array_add (parser->next, NULL);
+        }
+      else
+        {
+          vfl_parser_set_error (parser, error, EMEUS_CONSTRAINT_LAYOUT_ERROR_INVALID_SYMBOL,
+                                "Expected a view");
+          return false;
+        }
+
+      for (i = 0; i < n_predicates; i++)
+        vfl_parser_connect (parser, &predicates[i]);
+
+      /* The layout ends the line */
+      if (g_ptr_array_index (parser->next, 0) == NULL)
+        break;
+
+      /* Swap the arrays for the next connection */
+      {
+        GPtrArray *tmp = parser->previous;
+
+        parser->previous = parser->next;
+        parser->next = tmp;
+      }
+
+      c = vfl_parser_peek (parser);
+      if (c == '\0' || c == '\n')
+        break;
+    }
+
+  if (vfl_parser_peek (parser) != '\0' && *parser->cursor != '\n')
+    {
+      vfl_parser_set_error (parser, error, EMEUS_CONSTRAINT_LAYOUT_ERROR_INVALID_SYMBOL,
+                            "Unexpected '%c'", *parser->cursor);
+      return false;
+    }
+
+  return true;
+}
+
+/*< private >
+ * vfl_parser_parse:
+ * @text: the description of the constraints
+ * @length: the length of @text, or -1 if it is nul-terminated
+ * @hspacing: the default horizontal spacing
+ * @vspacing: the default vertical spacing
+ * @views: a hash table mapping view names to their widgets
+ * @descriptors: an array of #EmeusConstraintDescriptor
+ * @error: return location for a #GError
+ *
+ * Parses the constraints described by @text, in the visual format
+ * language, one description per line, and appends them to
+ * @descriptors.
+ *
+ * Empty lines are skipped. On error, @descriptors may contain the
+ * constraints of the lines before the failing one.
+ *
+ * Returns: %true on success
+ */
+bool
+vfl_parser_parse (const char *text,
+                  gssize length,
+                  int hspacing,
+                  int vspacing,
+                  GHashTable *views,
+                  GArray *descriptors,
+                  GError **error)
+{
+  VflParser parser;
+  bool res = true;
+
+  if (length < 0)
+    length = strlen (text);
+
+  parser.cursor = text;
+  parser.end = text + length;
+  parser.line_number = 0;
+  parser.views = views;
+  parser.descriptors = descriptors;
+  parser.previous = g_ptr_array_new ();
+  parser.next = g_ptr_array_new ();
+
+  while (parser.cursor < parser.end)
+    {
+      parser.line_start = parser.cursor;
+      parser.line_number += 1;
+
+      if (vfl_parser_peek (&parser) != '\n' && vfl_parser_peek (&parser) != '\0')
+        {
+          /* The spacing depends on the orientation, which is not known
+           * until the line is parsed; a 'V:' prefix comes first
+           */
+          parser.spacing = vfl_parser_peek (&parser) == 'V' ? vspacing : hspacing;
+
+          if (!vfl_parser_parse_line (&parser, error))
+            {
+              res = false;
+              break;
+            }
+        }
+
+      /* Skip to the next line */
+      while (parser.cursor < parser.end && *parser.cursor != '\n')
+        parser.cursor++;
+
+      if (parser.cursor < parser.end)
+        parser.cursor++;
+    }
+
+  g_ptr_array_unref (parser.previous);
+  g_ptr_array_unref (parser.next);
+
+  return res;
+}
@@ -0,0 +1,82 @@
+#include "emeus.h"
+
+#include "emeus-test-utils.h"
+
+static GtkWidget *
+create_child (EmeusConstraintLayout *layout,
+              const char *name)
+{
+  GtkWidget *child = emeus_constraint_layout_child_new (name);
+
+  gtk_container_add (GTK_CONTAINER (child), gtk_drawing_area_new ());
+  gtk_widget_show_all (child);
+
+  gtk_container_add (GTK_CONTAINER (layout), child);
+
+  return child;
+}
+
+static void
+allocate_layout (EmeusConstraintLayout *layout,
+                 int width,
+                 int height)
+{
+  GtkAllocation allocation = { 0, 0, width, height };
+  GtkRequisition minimum;
+
+  gtk_widget_get_preferred_size (GTK_WIDGET (layout), &minimum, NULL);
+  gtk_widget_size_allocate (GTK_WIDGET (layout), &allocation);
+}
+
+static void
+emeus_layout_clear_child_constraints (void)
+{
+  EmeusConstraintLayout *layout;
+  EmeusConstraintLayoutChild *child;
+
+  layout = EMEUS_CONSTRAINT_LAYOUT (emeus_constraint_layout_new ());
+  g_object_ref_sink (layout);
+
+  child = EMEUS_CONSTRAINT_LAYOUT_CHILD (create_child (layout, "child"));
+
+  emeus_constraint_layout_child_add_constraint (child,
+                                                emeus_constraint_new (child, EMEUS_CONSTRAINT_ATTRIBUTE_START,
+                                                                      EMEUS_CONSTRAINT_RELATION_EQ,
+                                                                      NULL, EMEUS_CONSTRAINT_ATTRIBUTE_START,
+                                                                      1.0, 20.0,
+                                                                      EMEUS_CONSTRAINT_STRENGTH_REQUIRED));
+  emeus_constraint_layout_child_set_intrinsic_width (child, 100);
+
+  allocate_layout (layout, 400, 300);
+
+  g_assert_cmpint (emeus_constraint_layout_child_get_left (child), ==, 20);
+  g_assert_cmpint (gtk_widget_get_allocated_width (GTK_WIDGET (child)), ==, 100);
+
+  /* Clearing the constraints keeps the intrinsic size, and it can
+   * still be changed afterwards
+   */
+  emeus_constraint_layout_child_clear_constraints (child);
+  emeus_constraint_layout_child_set_intrinsic_width (child, 150);
+
+  allocate_layout (layout, 400, 300);
+
+  g_assert_cmpint (emeus_constraint_layout_child_get_width (child), ==, 150);
+  g_assert_cmpint (gtk_widget_get_allocated_width (GTK_WIDGET (child)), ==, 150);
+
+  gtk_widget_destroy (GTK_WIDGET (layout));
+  g_object_unref (layout);
+}
+
+int
+main (int argc, char *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+
+  /* The layout needs a display; 77 marks the test as skipped */
+  if (!gtk_init_check (NULL, NULL))
+    return 77;
+
+  g_test_add_func ("/emeus/layout/clear-child-constraints", emeus_layout_clear_child_constraints);
+
+  return g_test_run ();
+}
@@ -244,6 +244,1943 @@ emeus_solver_edit_var_suggest (void)
   simplex_solver_clear (&solver);
 }
 
+static void
+emeus_solver_edit_var_large_delta (void)
+{
+  SimplexSolver solver = SIMPLEX_SOLVER_INIT;
+
+  simplex_solver_init (&solver);
+
+  Variable *a = simplex_solver_create_variable (&solver, "a", 0.0);
+  Variable *b = simplex_solver_create_variable (&solver, "b", 10.0);
+  Variable *c = simplex_solver_create_variable (&solver, "c", 20.0);
+
+  /* b >= a + 10, c >= b + 10 */
+  simplex_solver_add_constraint (&solver,
+                                 b, OPERATOR_TYPE_GE, expression_plus (expression_new_from_variable (a), 10.0),
+                                 STRENGTH_REQUIRED);
+  simplex_solver_add_constraint (&solver,
+                                 c, OPERATOR_TYPE_GE, expression_plus (expression_new_from_variable (b), 10.0),
+                                 STRENGTH_REQUIRED);
+
+  simplex_solver_add_stay_variable (&solver, a, STRENGTH_WEAK);
+  simplex_solver_add_stay_variable (&solver, b, STRENGTH_WEAK);
+  simplex_solver_add_stay_variable (&solver, c, STRENGTH_WEAK);
+
+  /* Moving a by a large amount makes both inequalities infeasible */
+  simplex_solver_add_edit_variable (&solver, a, STRENGTH_REQUIRED);
+  simplex_solver_begin_edit (&solver);
+  simplex_solver_suggest_value (&solver, a, 2560.0);
+  simplex_solver_end_edit (&solver);
+
+  emeus_assert_almost_equals (variable_get_value (a), 2560.0);
+  emeus_assert_almost_equals (variable_get_value (b), 2570.0);
+  emeus_assert_almost_equals (variable_get_value (c), 2580.0);
+
+  simplex_solver_clear (&solver);
+}
+
+static void
+emeus_solver_degenerate_chain (void)
+{
+  SimplexSolver solver = SIMPLEX_SOLVER_INIT;
+  Variable *vars[16];
+  int i;
+
+  simplex_solver_init (&solver);
+
+  for (i = 0; i < G_N_ELEMENTS (vars); i++)
+    {
+      vars[i] = simplex_solver_create_variable (&solver, "x", 0.0);
+      simplex_solver_add_stay_variable (&solver, vars[i], STRENGTH_WEAK);
+    }
+
+  /* Aligned edges: every row has a zero constant */
+  for (i = 1; i < G_N_ELEMENTS (vars); i++)
+    simplex_solver_add_constraint (&solver,
+                                   vars[i - 1], OPERATOR_TYPE_LE, expression_new_from_variable (vars[i]),
+                                   STRENGTH_REQUIRED);
+
+  simplex_solver_add_constraint (&solver,
+                                 vars[0], OPERATOR_TYPE_GE, expression_new_from_constant (100.0),
+                                 STRENGTH_REQUIRED);
+
+  for (i = 0; i < G_N_ELEMENTS (vars); i++)
+    emeus_assert_almost_equals (variable_get_value (vars[i]), 100.0);
+
+  /* Pushing the chain moves each edge with a zero ratio pivot; the chain
+   * is long enough for the optimization to fall back to Bland's rule once,
+   * and the rule is dropped when the optimization completes
+   */
+  g_assert_cmpint (solver.degenerate_pivot_count, >=, G_N_ELEMENTS (vars) / 2);
+  g_assert_cmpint (solver.bland_fallback_count, ==, 1);
+  g_assert_false (solver.use_bland);
+  g_assert_cmpint (solver.n_degenerate_pivots, ==, 0);
+
+  if (g_test_verbose ())
+    {
+      char *stats = simplex_solver_get_statistics (&solver);
+      g_print ("%s\n", stats);
+      g_free (stats);
+    }
+
+  for (i = 0; i < G_N_ELEMENTS (vars); i++)
+    variable_unref (vars[i]);
+
+  simplex_solver_clear (&solver);
+
+  /* A short chain has a few degenerate pivots, but never falls back */
+  simplex_solver_init (&solver);
+
+  for (i = 0; i < 4; i++)
+    {
+      vars[i] = simplex_solver_create_variable (&solver, "x", 0.0);
+      simplex_solver_add_stay_variable (&solver, vars[i], STRENGTH_WEAK);
+    }
+
+  for (i = 1; i < 4; i++)
+    simplex_solver_add_constraint (&solver,
+                                   vars[i - 1], OPERATOR_TYPE_LE, expression_new_from_variable (vars[i]),
+                                   STRENGTH_REQUIRED);
+
+  simplex_solver_add_constraint (&solver,
+                                 vars[0], OPERATOR_TYPE_GE, expression_new_from_constant (100.0),
+                                 STRENGTH_REQUIRED);
+
+  for (i = 0; i < 4; i++)
+    emeus_assert_almost_equals (variable_get_value (vars[i]), 100.0);
+
+  g_assert_cmpint (solver.degenerate_pivot_count, >, 0);
+  g_assert_cmpint (solver.bland_fallback_count, ==, 0);
+
+  for (i = 0; i < 4; i++)
+    variable_unref (vars[i]);
+
+  simplex_solver_clear (&solver);
+}
+
+static void
+emeus_solver_add_remove_cycles (void)
+{
+  SimplexSolver solver = SIMPLEX_SOLVER_INIT;
+  Variable *left, *width, *right;
+  int i;
+
+  simplex_solver_init (&solver);
+
+  left = simplex_solver_create_variable (&solver, "left", 0.0);
+  width = simplex_solver_create_variable (&solver, "width", 0.0);
+  right = simplex_solver_create_variable (&solver, "right", 0.0);
+
+  simplex_solver_add_stay_variable (&solver, left, STRENGTH_WEAK);
+  simplex_solver_add_stay_variable (&solver, width, STRENGTH_WEAK);
+
+  simplex_solver_add_constraint (&solver,
+                                 right, OPERATOR_TYPE_EQ, expression_plus_variable (expression_new_from_variable (left), width),
+                                 STRENGTH_REQUIRED);
+
+  for (i = 0; i < 100; i++)
+    {
+      Constraint *c1, *c2;
+
+      c1 = simplex_solver_add_constraint (&solver,
+                                          width, OPERATOR_TYPE_GE, expression_new_from_constant (10.0 + i),
+                                          STRENGTH_REQUIRED);
+      c2 = simplex_solver_add_constraint (&solver,
+                                          left, OPERATOR_TYPE_EQ, expression_new_from_constant (i),
+                                          STRENGTH_MEDIUM);
+
+      emeus_assert_almost_equals (variable_get_value (left), i);
+      emeus_assert_almost_equals (variable_get_value (width), 10.0 + i);
+      emeus_assert_almost_equals (variable_get_value (right), 10.0 + 2 * i);
+
+      simplex_solver_remove_constraint (&solver, c2);
+      simplex_solver_remove_constraint (&solver, c1);
+    }
+
+  if (g_test_verbose ())
+    {
+      char *stats = simplex_solver_get_statistics (&solver);
+      g_print ("%s\n", stats);
+      g_free (stats);
+    }
+
+  variable_unref (left);
+  variable_unref (width);
+  variable_unref (right);
+
+  simplex_solver_clear (&solver);
+}
+
+static void
+emeus_solver_remove_batch (void)
+{
+  SimplexSolver solver = SIMPLEX_SOLVER_INIT;
+  Variable *left, *width, *right;
+  int i, n_constraints;
+
+  simplex_solver_init (&solver);
+
+  left = simplex_solver_create_variable (&solver, "left", 0.0);
+  width = simplex_solver_create_variable (&solver, "width", 0.0);
+  right = simplex_solver_create_variable (&solver, "right", 0.0);
+
+  simplex_solver_add_stay_variable (&solver, left, STRENGTH_WEAK);
+  simplex_solver_add_stay_variable (&solver, width, STRENGTH_WEAK);
+
+  simplex_solver_add_constraint (&solver,
+                                 right, OPERATOR_TYPE_EQ, expression_plus_variable (expression_new_from_variable (left), width),
+                                 STRENGTH_REQUIRED);
+
+  n_constraints = g_hash_table_size (solver.constraints);
+
+  for (i = 0; i < 50; i++)
+    {
+      Constraint *batch[4];
+      int optimize_count;
+
+      batch[0] = simplex_solver_add_constraint (&solver,
+                                                width, OPERATOR_TYPE_GE, expression_new_from_constant (10.0 + i),
+                                                STRENGTH_REQUIRED);
+      batch[1] = simplex_solver_add_constraint (&solver,
+                                                left, OPERATOR_TYPE_EQ, expression_new_from_constant (i),
+                                                STRENGTH_MEDIUM);
+      batch[2] = NULL;
+      batch[3] = simplex_solver_add_constraint (&solver,
+                                                right, OPERATOR_TYPE_LE, expression_new_from_variable (width),
+                                                STRENGTH_WEAK);
+
+      emeus_assert_almost_equals (variable_get_value (left), i);
+      emeus_assert_almost_equals (variable_get_value (width), 10.0 + i);
+
+      optimize_count = solver.optimize_count;
+
+      simplex_solver_remove_constraints (&solver, batch, G_N_ELEMENTS (batch));
+
+      /* The remaining constraints are solved once, and the stays keep
+       * the values from before the removal
+       */
+      g_assert_cmpint (solver.optimize_count, <=, optimize_count + 1);
+      g_assert_cmpint (g_hash_table_size (solver.constraints), ==, n_constraints);
+
+      emeus_assert_almost_equals (variable_get_value (left), i);
+      emeus_assert_almost_equals (variable_get_value (width), 10.0 + i);
+      emeus_assert_almost_equals (variable_get_value (right), 10.0 + 2 * i);
+    }
+
+  variable_unref (left);
+  variable_unref (width);
+  variable_unref (right);
+
+  simplex_solver_clear (&solver);
+}
+
+static void
+emeus_solver_disable_constraints (void)
+{
+  SimplexSolver solver = SIMPLEX_SOLVER_INIT;
+
+  simplex_solver_init (&solver);
+
+  Variable *x = simplex_solver_create_variable (&solver, "x", 0.0);
+  Variable *y = simplex_solver_create_variable (&solver, "y", 0.0);
+  Variable *z = simplex_solver_create_variable (&solver, "z", 0.0);
+
+  simplex_solver_add_stay_variable (&solver, x, STRENGTH_WEAK);
+  simplex_solver_add_stay_variable (&solver, y, STRENGTH_WEAK);
+  simplex_solver_add_stay_variable (&solver, z, STRENGTH_WEAK);
+
+  Constraint *c1 = simplex_solver_add_constraint (&solver,
+                                                  x, OPERATOR_TYPE_EQ,
+                                                  expression_plus (expression_plus_variable (expression_new_from_variable (y), z), 50.0),
+                                                  STRENGTH_REQUIRED);
+  Constraint *c2 = simplex_solver_add_constraint (&solver,
+                                                  y, OPERATOR_TYPE_EQ, expression_new_from_constant (10.0),
+                                                  STRENGTH_STRONG);
+
+  emeus_assert_almost_equals (variable_get_value (x), 60.0);
+
+  int n_constraints = g_hash_table_size (solver.constraints);
+
+  /* A disabled constraint does not affect the solution */
+  simplex_solver_disable_constraints (&solver, &c2, 1);
+
+  g_assert_true (simplex_solver_is_constraint_disabled (&solver, c2));
+  g_assert_cmpint (g_hash_table_size (solver.constraints), ==, n_constraints - 1);
+
+  Constraint *c3 = simplex_solver_add_constraint (&solver,
+                                                  y, OPERATOR_TYPE_EQ, expression_new_from_constant (20.0),
+                                                  STRENGTH_MEDIUM);
+
+  emeus_assert_almost_equals (variable_get_value (y), 20.0);
+  emeus_assert_almost_equals (variable_get_value (x), 70.0);
+
+  /* Enabling it brings it back, with its strength */
+  simplex_solver_enable_constraints (&solver, &c2, 1);
+
+  g_assert_false (simplex_solver_is_constraint_disabled (&solver, c2));
+
+  emeus_assert_almost_equals (variable_get_value (y), 10.0);
+  emeus_assert_almost_equals (variable_get_value (x), 60.0);
+
+  /* Disabled constraints can be removed */
+  Constraint *batch[] = { c1, c2 };
+
+  simplex_solver_disable_constraints (&solver, batch, G_N_ELEMENTS (batch));
+  simplex_solver_remove_constraint (&solver, c2);
+  simplex_solver_remove_constraint (&solver, c3);
+
+  simplex_solver_add_constraint (&solver,
+                                 x, OPERATOR_TYPE_EQ, expression_new_from_constant (5.0),
+                                 STRENGTH_REQUIRED);
+
+  emeus_assert_almost_equals (variable_get_value (x), 5.0);
+
+  simplex_solver_enable_constraints (&solver, &c1, 1);
+
+  emeus_assert_almost_equals (variable_get_value (x), 5.0);
+  emeus_assert_almost_equals (variable_get_value (y) + variable_get_value (z), -45.0);
+
+  variable_unref (x);
+  variable_unref (y);
+  variable_unref (z);
+
+  simplex_solver_clear (&solver);
+}
+
+static void
+emeus_solver_enable_constraints_batch (void)
+{
+  SimplexSolver solver = SIMPLEX_SOLVER_INIT;
+  Variable *vars[8];
+  Constraint *constraints[G_N_ELEMENTS (vars) - 1];
+  int artificial_counter, optimize_count;
+  int i;
+
+  simplex_solver_init (&solver);
+
+  for (i = 0; i < G_N_ELEMENTS (vars); i++)
+    {
+      vars[i] = simplex_solver_create_variable (&solver, "v", 0.0);
+      simplex_solver_add_stay_variable (&solver, vars[i], STRENGTH_WEAK);
+    }
+
+  /* A chain of required spacings between the variables */
+  for (i = 0; i < G_N_ELEMENTS (constraints); i++)
+    constraints[i] = simplex_solver_add_constraint (&solver,
+                                                    vars[i + 1], OPERATOR_TYPE_EQ,
+                                                    expression_plus (expression_new_from_variable (vars[i]), 10.0),
+                                                    STRENGTH_REQUIRED);
+
+  emeus_assert_almost_equals (variable_get_value (vars[G_N_ELEMENTS (vars) - 1]) - variable_get_value (vars[0]),
+                              10.0 * G_N_ELEMENTS (constraints));
+
+  simplex_solver_disable_constraints (&solver, constraints, G_N_ELEMENTS (constraints));
+
+  simplex_solver_add_constraint (&solver,
+                                 vars[0], OPERATOR_TYPE_EQ, expression_new_from_constant (100.0),
+                                 STRENGTH_STRONG);
+
+  emeus_assert_almost_equals (variable_get_value (vars[0]), 100.0);
+
+  artificial_counter = solver.artificial_counter;
+  optimize_count = solver.optimize_count;
+
+  simplex_solver_enable_constraints (&solver, constraints, G_N_ELEMENTS (constraints));
+
+  /* None of the spacings can be added directly, but the tableau is
+   * optimized once to remove their artificial variables, and once more
+   * to solve it
+   */
+  g_assert_cmpint (solver.artificial_counter, ==, artificial_counter + G_N_ELEMENTS (constraints));
+  g_assert_cmpint (solver.optimize_count, <=, optimize_count + 2);
+
+  for (i = 0; i < G_N_ELEMENTS (vars); i++)
+    {
+      emeus_assert_almost_equals (variable_get_value (vars[i]), 100.0 + 10.0 * i);
+      variable_unref (vars[i]);
+    }
+
+  simplex_solver_clear (&solver);
+}
+
+static void
+emeus_solver_equality_alias (void)
+{
+  SimplexSolver solver = SIMPLEX_SOLVER_INIT;
+
+  simplex_solver_init (&solver);
+
+  Variable *x = simplex_solver_create_variable (&solver, "x", 0.0);
+  Variable *y = simplex_solver_create_variable (&solver, "y", 0.0);
+  Variable *z = simplex_solver_create_variable (&solver, "z", 0.0);
+
+  /* x = y * 2 + 10, z = x + 5 */
+  Constraint *c1 =
+    simplex_solver_add_constraint (&solver,
+                                   x, OPERATOR_TYPE_EQ, expression_plus (expression_times (expression_new_from_variable (y), 2.0), 10.0),
+                                   STRENGTH_REQUIRED);
+  simplex_solver_add_constraint (&solver,
+                                 z, OPERATOR_TYPE_EQ, expression_plus (expression_new_from_variable (x), 5.0),
+                                 STRENGTH_REQUIRED);
+  simplex_solver_add_constraint (&solver,
+                                 z, OPERATOR_TYPE_GE, expression_new_from_constant (75.0),
+                                 STRENGTH_REQUIRED);
+  simplex_solver_add_stay_variable (&solver, y, STRENGTH_WEAK);
+
+  emeus_assert_almost_equals (variable_get_value (y), 30.0);
+  emeus_assert_almost_equals (variable_get_value (x), 70.0);
+  emeus_assert_almost_equals (variable_get_value (z), 75.0);
+
+  /* Removing the alias detaches x from y, but keeps z tied to x */
+  simplex_solver_remove_constraint (&solver, c1);
+  simplex_solver_add_constraint (&solver,
+                                 y, OPERATOR_TYPE_EQ, expression_new_from_constant (0.0),
+                                 STRENGTH_REQUIRED);
+
+  emeus_assert_almost_equals (variable_get_value (y), 0.0);
+  emeus_assert_almost_equals (variable_get_value (z), variable_get_value (x) + 5.0);
+  g_assert_true (variable_get_value (z) >= 75.0);
+
+  variable_unref (x);
+  variable_unref (y);
+  variable_unref (z);
+
+  simplex_solver_clear (&solver);
+}
+
+static void
+emeus_solver_difference_system (void)
+{
+  SimplexSolver solver = SIMPLEX_SOLVER_INIT;
+
+  simplex_solver_init (&solver);
+
+  Variable *a = simplex_solver_create_variable (&solver, "a", 0.0);
+  Variable *b = simplex_solver_create_variable (&solver, "b", 0.0);
+  Variable *c = simplex_solver_create_variable (&solver, "c", 0.0);
+
+  simplex_solver_add_edit_variable (&solver, a, STRENGTH_REQUIRED);
+  simplex_solver_add_constraint (&solver,
+                                 b, OPERATOR_TYPE_EQ, expression_plus (expression_new_from_variable (a), 10.0),
+                                 STRENGTH_REQUIRED);
+  simplex_solver_add_constraint (&solver,
+                                 c, OPERATOR_TYPE_EQ, expression_plus (expression_new_from_variable (b), 5.0),
+                                 STRENGTH_REQUIRED);
+
+  emeus_assert_almost_equals (variable_get_value (b), 10.0);
+  emeus_assert_almost_equals (variable_get_value (c), 15.0);
+
+  simplex_solver_begin_edit (&solver);
+  simplex_solver_suggest_value (&solver, a, 2.0);
+  simplex_solver_resolve (&solver);
+  simplex_solver_suggest_value (&solver, a, 10.0);
+  simplex_solver_resolve (&solver);
+  simplex_solver_suggest_value (&solver, a, 5.0);
+  simplex_solver_resolve (&solver);
+
+  emeus_assert_almost_equals (variable_get_value (a), 5.0);
+  emeus_assert_almost_equals (variable_get_value (b), 15.0);
+  emeus_assert_almost_equals (variable_get_value (c), 20.0);
+
+  /* Nothing went through the tableau */
+  g_assert_true (solver.difference_mode);
+
+  /* The required constraints pin every variable, so a weaker stay does
+   * not need the tableau, even when it cannot be satisfied
+   */
+  simplex_solver_add_stay_variable (&solver, c, STRENGTH_WEAK);
+
+  simplex_solver_suggest_value (&solver, a, 7.0);
+  simplex_solver_resolve (&solver);
+
+  g_assert_true (solver.difference_mode);
+
+  emeus_assert_almost_equals (variable_get_value (a), 7.0);
+  emeus_assert_almost_equals (variable_get_value (b), 17.0);
+  emeus_assert_almost_equals (variable_get_value (c), 22.0);
+
+  /* The stay keeps the values once the edit is done */
+  simplex_solver_end_edit (&solver);
+
+  g_assert_true (solver.difference_mode);
+
+  emeus_assert_almost_equals (variable_get_value (a), 7.0);
+  emeus_assert_almost_equals (variable_get_value (c), 22.0);
+
+  /* A separate component */
+  Variable *e = simplex_solver_create_variable (&solver, "e", 0.0);
+  Variable *f = simplex_solver_create_variable (&solver, "f", 0.0);
+
+  simplex_solver_add_constraint (&solver,
+                                 e, OPERATOR_TYPE_EQ, expression_new_from_constant (100.0),
+                                 STRENGTH_REQUIRED);
+  simplex_solver_add_constraint (&solver,
+                                 f, OPERATOR_TYPE_EQ, expression_plus (expression_new_from_variable (e), 20.0),
+                                 STRENGTH_REQUIRED);
+
+  /* A constraint with other coefficients moves the component of its
+   * variables into the tableau, and leaves the other one in the graph
+   */
+  Variable *d = simplex_solver_create_variable (&solver, "d", 0.0);
+
+  simplex_solver_add_constraint (&solver,
+                                 d, OPERATOR_TYPE_EQ, expression_times (expression_new_from_variable (a), 2.0),
+                                 STRENGTH_REQUIRED);
+
+  g_assert_true (simplex_solver_has_differences (&solver));
+  g_assert_cmpint (solver.difference_constraints->len, ==, 2);
+
+  emeus_assert_almost_equals (variable_get_value (a), 7.0);
+  emeus_assert_almost_equals (variable_get_value (c), 22.0);
+  emeus_assert_almost_equals (variable_get_value (d), 14.0);
+  emeus_assert_almost_equals (variable_get_value (f), 120.0);
+
+  /* Both parts are solved when editing */
+  simplex_solver_begin_edit (&solver);
+  simplex_solver_suggest_value (&solver, a, 3.0);
+  simplex_solver_end_edit (&solver);
+
+  emeus_assert_almost_equals (variable_get_value (c), 18.0);
+  emeus_assert_almost_equals (variable_get_value (d), 6.0);
+  emeus_assert_almost_equals (variable_get_value (f), 120.0);
+
+  /* A difference constraint on a variable of the tableau goes into the
+   * tableau, along with the component of its other variable
+   */
+  simplex_solver_add_constraint (&solver,
+                                 f, OPERATOR_TYPE_GE, expression_plus (expression_new_from_variable (c), 200.0),
+                                 STRENGTH_WEAK);
+
+  g_assert_false (simplex_solver_has_differences (&solver));
+
+  emeus_assert_almost_equals (variable_get_value (c), 18.0);
+  emeus_assert_almost_equals (variable_get_value (f), 120.0);
+
+  variable_unref (a);
+  variable_unref (b);
+  variable_unref (c);
+  variable_unref (d);
+  variable_unref (e);
+  variable_unref (f);
+
+  simplex_solver_clear (&solver);
+}
+
+/* Compares the variables that are in the graph of @solver with the ones
+ * of @reference, which only uses the tableau; the graph only keeps the
+ * components with a single optimal solution, so they must be the same.
+ * Returns the number of compared variables
+ */
+static int
+compare_difference_values (SimplexSolver *solver,
+                           Variable **vars,
+                           Variable **reference,
+                           int n_vars)
+{
+  int i, j, n_compared = 0;
+
+  for (i = 0; i < solver->difference_constraints->len; i++)
+    {
+      Constraint *constraint = g_ptr_array_index (solver->difference_constraints, i);
+      GList *l;
+
+      for (l = constraint->expression->ordered_terms; l != NULL; l = l->next)
+        {
+          Variable *v = term_get_variable (l->data);
+
+          for (j = 0; j < n_vars; j++)
+            {
+              if (vars[j] == v)
+                {
+                  emeus_assert_almost_equals (variable_get_value (v), variable_get_value (reference[j]));
+                  n_compared += 1;
+                }
+            }
+        }
+    }
+
+  return n_compared;
+}
+
+/* Builds the same random difference systems with and without the
+ * difference engine, and checks that the graph finds the solution of the
+ * tableau for the components it keeps
+ */
+static void
+emeus_solver_difference_layers (void)
+{
+  static const StrengthType strengths[] = {
+    STRENGTH_REQUIRED, STRENGTH_STRONG, STRENGTH_MEDIUM, STRENGTH_WEAK,
+  };
+  guint32 state = 1;
+  int seed, n_checks = 0;
+
+#define NEXT_RANDOM(n) ((state = state * 1103515245u + 12345u), (int) ((state >> 16) % (n)))
+
+  for (seed = 0; seed < 100; seed++)
+    {
+      SimplexSolver solvers[2] = { SIMPLEX_SOLVER_INIT, SIMPLEX_SOLVER_INIT };
+      Variable *vars[2][6];
+      double reference[6];
+      int i, j, k, n_constraints, edit;
+      StrengthType edit_strength;
+
+      for (k = 0; k < 2; k++)
+        simplex_solver_init (&solvers[k]);
+
+      /* The second solver only uses the tableau */
+      solvers[1].difference_mode = false;
+
+      for (i = 0; i < 6; i++)
+        {
+          double value = NEXT_RANDOM (100);
+          StrengthType stay = NEXT_RANDOM (3) == 0 ? 0 : (NEXT_RANDOM (2) ? STRENGTH_WEAK : STRENGTH_MEDIUM);
+
+          reference[i] = NEXT_RANDOM (200);
+
+          for (k = 0; k < 2; k++)
+            {
+              vars[k][i] = simplex_solver_create_variable (&solvers[k], "x", value);
+              if (stay != 0)
+                simplex_solver_add_stay_variable (&solvers[k], vars[k][i], stay);
+            }
+        }
+
+      /* The required constraints hold for the reference values, so they
+       * can always be satisfied
+       */
+      n_constraints = 4 + NEXT_RANDOM (8);
+      for (j = 0; j < n_constraints; j++)
+        {
+          int a = NEXT_RANDOM (6), b = NEXT_RANDOM (6);
+          StrengthType strength = strengths[NEXT_RANDOM (4)];
+          OperatorType op = NEXT_RANDOM (3);
+          double constant;
+
+          if (a == b)
+            continue;
+
+          if (strength != STRENGTH_REQUIRED)
+            constant = NEXT_RANDOM (200) - 100;
+          else if (op == OPERATOR_TYPE_EQ)
+            constant = reference[a] - reference[b];
+          else if (op == OPERATOR_TYPE_GE)
+            constant = reference[a] - reference[b] - NEXT_RANDOM (20);
+          else
+            constant = reference[a] - reference[b] + NEXT_RANDOM (20);
+
+          for (k = 0; k < 2; k++)
+            simplex_solver_add_constraint (&solvers[k],
+                                           vars[k][a], op,
+                                           expression_plus (expression_new_from_variable (vars[k][b]), constant),
+                                           strength);
+
+          n_checks += compare_difference_values (&solvers[0], vars[0], vars[1], 6);
+        }
+
+      edit = NEXT_RANDOM (6);
+      edit_strength = NEXT_RANDOM (2) ? STRENGTH_STRONG : STRENGTH_REQUIRED;
+
+      for (k = 0; k < 2; k++)
+        {
+          simplex_solver_add_edit_variable (&solvers[k], vars[k][edit], edit_strength);
+          simplex_solver_begin_edit (&solvers[k]);
+        }
+
+      for (j = 0; j < 3; j++)
+        {
+          double value = NEXT_RANDOM (300);
+
+          for (k = 0; k < 2; k++)
+            {
+              simplex_solver_suggest_value (&solvers[k], vars[k][edit], value);
+              simplex_solver_resolve (&solvers[k]);
+            }
+
+          n_checks += compare_difference_values (&solvers[0], vars[0], vars[1], 6);
+        }
+
+      for (k = 0; k < 2; k++)
+        {
+          simplex_solver_end_edit (&solvers[k]);
+
+          for (i = 0; i < 6; i++)
+            variable_unref (vars[k][i]);
+
+          simplex_solver_clear (&solvers[k]);
+        }
+    }
+
+#undef NEXT_RANDOM
+
+  /* Stays and non-required constraints keep some systems in the graph */
+  g_assert_cmpint (n_checks, >, 0);
+
+  if (g_test_verbose ())
+    g_print ("Compared %d values of the difference engine\n", n_checks);
+}
+
+/* Builds the same random systems with and without the difference engine,
+ * where the strong constraints pin every variable and the weaker ones
+ * conflict with them; the required constraints alone do not pin anything,
+ * so the graph needs to solve the strong layer, and it keeps the whole
+ * system as long as the weaker constraints weigh less than half of it
+ */
+static void
+emeus_solver_difference_strengths (void)
+{
+  static const StrengthType weaker[] = { STRENGTH_MEDIUM, STRENGTH_WEAK };
+  guint32 state = 7;
+  int seed;
+
+#define NEXT_RANDOM(n) ((state = state * 1103515245u + 12345u), (int) ((state >> 16) % (n)))
+
+  for (seed = 0; seed < 50; seed++)
+    {
+      SimplexSolver solvers[2] = { SIMPLEX_SOLVER_INIT, SIMPLEX_SOLVER_INIT };
+      Variable *vars[2][6];
+      double reference[6];
+      int i, j, k, edit;
+
+      for (k = 0; k < 2; k++)
+        {
+          simplex_solver_init (&solvers[k]);
+          simplex_solver_set_auto_solve (&solvers[k], false);
+        }
+
+      /* The second solver only uses the tableau */
+      solvers[1].difference_mode = false;
+
+      for (i = 0; i < 6; i++)
+        {
+          double value = NEXT_RANDOM (100);
+
+          reference[i] = NEXT_RANDOM (200);
+
+          for (k = 0; k < 2; k++)
+            {
+              vars[k][i] = simplex_solver_create_variable (&solvers[k], "x", value);
+              simplex_solver_add_stay_variable (&solvers[k], vars[k][i], weaker[NEXT_RANDOM (2)]);
+            }
+        }
+
+      /* A tree of strong equalities, tied to the origin, pins every
+       * variable to its reference value
+       */
+      for (i = 0; i < 6; i++)
+        {
+          int b = i > 0 ? NEXT_RANDOM (i) : -1;
+
+          for (k = 0; k < 2; k++)
+            simplex_solver_add_constraint (&solvers[k],
+                                           vars[k][i], OPERATOR_TYPE_EQ,
+                                           b < 0
+                                             ? expression_new_from_constant (reference[i])
+                                             : expression_plus (expression_new_from_variable (vars[k][b]),
+                                                                reference[i] - reference[b]),
+                                           STRENGTH_STRONG);
+        }
+
+      /* Required inequalities that hold for the reference values, and
+       * weaker constraints that conflict with them
+       */
+      for (j = 0; j < 10; j++)
+        {
+          int a = NEXT_RANDOM (6), b = NEXT_RANDOM (6);
+          bool required = j < 3;
+          OperatorType op = required ? OPERATOR_TYPE_GE : NEXT_RANDOM (3);
+          StrengthType strength = required ? STRENGTH_REQUIRED : weaker[NEXT_RANDOM (2)];
+          double constant;
+
+          if (a == b)
+            continue;
+
+          if (required)
+            constant = reference[a] - reference[b] - NEXT_RANDOM (20);
+          else
+            constant = NEXT_RANDOM (200) - 100;
+
+          for (k = 0; k < 2; k++)
+            simplex_solver_add_constraint (&solvers[k],
+                                           vars[k][a], op,
+                                           expression_plus (expression_new_from_variable (vars[k][b]), constant),
+                                           strength);
+        }
+
+      for (k = 0; k < 2; k++)
+        simplex_solver_set_auto_solve (&solvers[k], true);
+
+      /* Nothing went through the tableau */
+      g_assert_cmpint (solvers[0].difference_constraints->len, ==, g_hash_table_size (solvers[0].constraints));
+
+      for (i = 0; i < 6; i++)
+        {
+          emeus_assert_almost_equals (variable_get_value (vars[0][i]), reference[i]);
+          emeus_assert_almost_equals (variable_get_value (vars[0][i]), variable_get_value (vars[1][i]));
+        }
+
+      /* An edit that is weaker than the strong layer does not move the
+       * solution, nor the constraints
+       */
+      edit = NEXT_RANDOM (6);
+
+      for (k = 0; k < 2; k++)
+        {
+          simplex_solver_add_edit_variable (&solvers[k], vars[k][edit], STRENGTH_MEDIUM);
+          simplex_solver_begin_edit (&solvers[k]);
+          simplex_solver_suggest_value (&solvers[k], vars[k][edit], NEXT_RANDOM (300));
+          simplex_solver_end_edit (&solvers[k]);
+        }
+
+      g_assert_cmpint (solvers[0].difference_constraints->len, ==, g_hash_table_size (solvers[0].constraints));
+
+      for (i = 0; i < 6; i++)
+        {
+          emeus_assert_almost_equals (variable_get_value (vars[0][i]), reference[i]);
+          emeus_assert_almost_equals (variable_get_value (vars[0][i]), variable_get_value (vars[1][i]));
+        }
+
+      for (k = 0; k < 2; k++)
+        {
+          for (i = 0; i < 6; i++)
+            variable_unref (vars[k][i]);
+
+          simplex_solver_clear (&solvers[k]);
+        }
+    }
+
+#undef NEXT_RANDOM
+}
+
+static void
+emeus_solver_difference_chain (void)
+{
+  SimplexSolver solver = SIMPLEX_SOLVER_INIT;
+  Variable *vars[400];
+  int i;
+
+  simplex_solver_init (&solver);
+
+  /* Each new constraint is satisfied by moving the new variable, so the
+   * graph never solves the whole chain again
+   */
+  for (i = 0; i < G_N_ELEMENTS (vars); i++)
+    {
+      vars[i] = simplex_solver_create_variable (&solver, "x", 0.0);
+
+      if (i == 0)
+        simplex_solver_add_constraint (&solver,
+                                       vars[i], OPERATOR_TYPE_EQ, expression_new_from_constant (0.0),
+                                       STRENGTH_REQUIRED);
+      else
+        simplex_solver_add_constraint (&solver,
+                                       vars[i], OPERATOR_TYPE_EQ, expression_plus (expression_new_from_variable (vars[i - 1]), 10.0),
+                                       STRENGTH_REQUIRED);
+    }
+
+  g_assert_true (solver.difference_mode);
+
+  for (i = 0; i < G_N_ELEMENTS (vars); i++)
+    emeus_assert_almost_equals (variable_get_value (vars[i]), i * 10.0);
+
+  /* Weak stays that agree with the solution stay in the graph */
+  for (i = 0; i < G_N_ELEMENTS (vars); i++)
+    simplex_solver_add_stay_variable (&solver, vars[i], STRENGTH_WEAK);
+
+  g_assert_true (solver.difference_mode);
+
+  /* Removing the first constraint leaves the stays to pin the chain; the
+   * edges of the constraint are removed from the graph in place
+   */
+  gpointer graph = solver.difference_graph;
+
+  simplex_solver_remove_constraint (&solver, g_ptr_array_index (solver.difference_constraints, 0));
+
+  g_assert_true (solver.difference_graph == graph);
+  g_assert_cmpint (solver.difference_constraints->len, ==, 2 * G_N_ELEMENTS (vars) - 1);
+
+  for (i = 0; i < G_N_ELEMENTS (vars); i++)
+    emeus_assert_almost_equals (variable_get_value (vars[i]), i * 10.0);
+
+  for (i = 0; i < G_N_ELEMENTS (vars); i++)
+    variable_unref (vars[i]);
+
+  simplex_solver_clear (&solver);
+}
+
+static void
+emeus_solver_bounds (void)
+{
+  SimplexSolver solver = SIMPLEX_SOLVER_INIT;
+
+  simplex_solver_init (&solver);
+
+  Variable *x = simplex_solver_create_variable (&solver, "x", 0.0);
+  Variable *y = simplex_solver_create_variable (&solver, "y", 0.0);
+
+  Constraint *c1 =
+    simplex_solver_add_constraint (&solver,
+                                   x, OPERATOR_TYPE_GE, expression_new_from_constant (10.0),
+                                   STRENGTH_REQUIRED);
+
+  emeus_assert_almost_equals (variable_get_value (x), 10.0);
+
+  simplex_solver_add_stay_variable (&solver, x, STRENGTH_WEAK);
+
+  /* Only the first bound on x is substituted; the second one adds a row */
+  guint n_rows = g_hash_table_size (solver.rows);
+
+  Constraint *c3 =
+    simplex_solver_add_constraint (&solver,
+                                   x, OPERATOR_TYPE_LE, expression_new_from_constant (90.0),
+                                   STRENGTH_REQUIRED);
+
+  g_assert_cmpint (g_hash_table_size (solver.rows), ==, n_rows + 1);
+  emeus_assert_almost_equals (variable_get_value (x), 10.0);
+
+  /* y = 100 - x */
+  simplex_solver_add_constraint (&solver,
+                                 y, OPERATOR_TYPE_EQ, expression_plus (expression_times (expression_new_from_variable (x), -1.0), 100.0),
+                                 STRENGTH_REQUIRED);
+  Constraint *c2 =
+    simplex_solver_add_constraint (&solver,
+                                   y, OPERATOR_TYPE_LE, expression_new_from_constant (50.0),
+                                   STRENGTH_REQUIRED);
+
+  emeus_assert_almost_equals (variable_get_value (x), 50.0);
+  emeus_assert_almost_equals (variable_get_value (y), 50.0);
+
+  if (g_test_verbose ())
+    {
+      char *stats = simplex_solver_get_statistics (&solver);
+      g_print ("%s\n", stats);
+      g_free (stats);
+    }
+
+  simplex_solver_remove_constraint (&solver, c2);
+
+  g_assert_true (variable_get_value (x) >= 10.0);
+  emeus_assert_almost_equals (variable_get_value (x) + variable_get_value (y), 100.0);
+
+  /* Removing the bounds puts x back into the tableau */
+  simplex_solver_remove_constraint (&solver, c3);
+  simplex_solver_remove_constraint (&solver, c1);
+  simplex_solver_add_constraint (&solver,
+                                 x, OPERATOR_TYPE_LE, expression_new_from_constant (-20.0),
+                                 STRENGTH_REQUIRED);
+
+  emeus_assert_almost_equals (variable_get_value (x), -20.0);
+  emeus_assert_almost_equals (variable_get_value (y), 120.0);
+
+  variable_unref (x);
+  variable_unref (y);
+
+  simplex_solver_clear (&solver);
+}
+
+static void
+emeus_solver_parametric_solution (void)
+{
+  SimplexSolver solver = SIMPLEX_SOLVER_INIT;
+  ParametricSolution *solution;
+  double value;
+
+  simplex_solver_init (&solver);
+
+  Variable *width = simplex_solver_create_variable (&solver, "width", 400.0);
+  Variable *child = simplex_solver_create_variable (&solver, "child", 0.0);
+
+  simplex_solver_add_edit_variable (&solver, width, STRENGTH_REQUIRED);
+
+  /* child <= width - 20, and child wants to be 300 */
+  simplex_solver_add_constraint (&solver,
+                                 child, OPERATOR_TYPE_LE, expression_plus (expression_new_from_variable (width), -20.0),
+                                 STRENGTH_REQUIRED);
+  simplex_solver_add_constraint (&solver,
+                                 child, OPERATOR_TYPE_EQ, expression_new_from_constant (300.0),
+                                 STRENGTH_MEDIUM);
+
+  simplex_solver_begin_edit (&solver);
+  simplex_solver_suggest_value (&solver, width, 400.0);
+  simplex_solver_resolve (&solver);
+
+  emeus_assert_almost_equals (variable_get_value (child), 300.0);
+
+  solution = simplex_solver_get_parametric_solution (&solver, &width, 1);
+  g_assert_nonnull (solution);
+
+  /* The child does not depend on the width as long as it fits */
+  value = 500.0;
+  g_assert_true (parametric_solution_apply (solution, &value));
+  emeus_assert_almost_equals (variable_get_value (width), 500.0);
+  emeus_assert_almost_equals (variable_get_value (child), 300.0);
+
+  value = 320.0;
+  g_assert_true (parametric_solution_contains (solution, &value));
+
+  value = 310.0;
+  g_assert_false (parametric_solution_contains (solution, &value));
+
+  parametric_solution_free (solution);
+
+  simplex_solver_suggest_value (&solver, width, 310.0);
+  simplex_solver_resolve (&solver);
+
+  emeus_assert_almost_equals (variable_get_value (child), 290.0);
+
+  solution = simplex_solver_get_parametric_solution (&solver, &width, 1);
+  g_assert_nonnull (solution);
+
+  value = 100.0;
+  g_assert_true (parametric_solution_apply (solution, &value));
+  emeus_assert_almost_equals (variable_get_value (child), 80.0);
+
+  value = 330.0;
+  g_assert_false (parametric_solution_contains (solution, &value));
+
+  /* Changing the constraints invalidates the solution */
+  simplex_solver_add_constraint (&solver,
+                                 child, OPERATOR_TYPE_GE, expression_new_from_constant (0.0),
+                                 STRENGTH_REQUIRED);
+
+  value = 310.0;
+  g_assert_false (parametric_solution_contains (solution, &value));
+
+  parametric_solution_free (solution);
+
+  variable_unref (width);
+  variable_unref (child);
+
+  simplex_solver_clear (&solver);
+}
+
+static void
+emeus_solver_fast_resolve (void)
+{
+  SimplexSolver solver = SIMPLEX_SOLVER_INIT;
+
+  simplex_solver_init (&solver);
+
+  Variable *width = simplex_solver_create_variable (&solver, "width", 400.0);
+  Variable *left = simplex_solver_create_variable (&solver, "left", 0.0);
+  Variable *child = simplex_solver_create_variable (&solver, "child", 0.0);
+
+  simplex_solver_add_stay_variable (&solver, left, STRENGTH_STRONG);
+  simplex_solver_add_edit_variable (&solver, width, STRENGTH_REQUIRED);
+
+  /* left + child <= width - 20, and child wants to be 300 */
+  simplex_solver_add_constraint (&solver,
+                                 child, OPERATOR_TYPE_LE,
+                                 expression_plus (expression_plus_variable (expression_times (expression_new_from_variable (left), -1.0), width), -20.0),
+                                 STRENGTH_REQUIRED);
+  simplex_solver_add_constraint (&solver,
+                                 child, OPERATOR_TYPE_EQ, expression_new_from_constant (300.0),
+                                 STRENGTH_MEDIUM);
+
+  simplex_solver_begin_edit (&solver);
+  simplex_solver_suggest_value (&solver, width, 250.0);
+  simplex_solver_resolve (&solver);
+
+  emeus_assert_almost_equals (variable_get_value (child), 230.0);
+
+  int fast_resolve_count = solver.fast_resolve_count;
+  int row_lookup_count = solver.row_lookup_count;
+
+  /* The basis does not change while the child is too large */
+  simplex_solver_suggest_value (&solver, width, 200.0);
+  simplex_solver_resolve (&solver);
+  simplex_solver_suggest_value (&solver, width, 300.0);
+  simplex_solver_resolve (&solver);
+
+  emeus_assert_almost_equals (variable_get_value (width), 300.0);
+  emeus_assert_almost_equals (variable_get_value (child), 280.0);
+
+  /* The fast resolves update the rows cached in the basis, instead of
+   * looking them up in the tableau
+   */
+  g_assert_cmpint (solver.fast_resolve_count, ==, fast_resolve_count + 2);
+  g_assert_cmpint (solver.row_lookup_count, ==, row_lookup_count);
+
+  /* Crossing into the region where the child fits */
+  simplex_solver_suggest_value (&solver, width, 500.0);
+  simplex_solver_resolve (&solver);
+
+  emeus_assert_almost_equals (variable_get_value (child), 300.0);
+
+  simplex_solver_suggest_value (&solver, width, 320.0);
+  simplex_solver_resolve (&solver);
+
+  emeus_assert_almost_equals (variable_get_value (child), 300.0);
+
+  /* Adding a constraint brings the tableau up to date first */
+  simplex_solver_suggest_value (&solver, width, 250.0);
+  simplex_solver_add_constraint (&solver,
+                                 child, OPERATOR_TYPE_GE, expression_new_from_constant (100.0),
+                                 STRENGTH_REQUIRED);
+  simplex_solver_resolve (&solver);
+
+  emeus_assert_almost_equals (variable_get_value (left), 0.0);
+  emeus_assert_almost_equals (variable_get_value (child), 230.0);
+
+  simplex_solver_end_edit (&solver);
+
+  variable_unref (width);
+  variable_unref (left);
+  variable_unref (child);
+
+  simplex_solver_clear (&solver);
+}
+
+/* The fast path must give the same values as the dual simplex, over
+ * many steps; the stays move to the solution of each step
+ */
+static void
+emeus_solver_fast_resolve_stays (void)
+{
+  static const double widths[] = { 480.0, 520.0, 410.0, 450.0, 560.0, 300.0, 350.0 };
+  SimplexSolver solvers[2] = { SIMPLEX_SOLVER_INIT, SIMPLEX_SOLVER_INIT };
+  Variable *width[2], *a[2], *b[2];
+  int i, k;
+
+  for (k = 0; k < 2; k++)
+    {
+      simplex_solver_init (&solvers[k]);
+
+      width[k] = simplex_solver_create_variable (&solvers[k], "width", 400.0);
+      a[k] = simplex_solver_create_variable (&solvers[k], "a", 300.0);
+      b[k] = simplex_solver_create_variable (&solvers[k], "b", 300.0);
+
+      simplex_solver_add_stay_variable (&solvers[k], b[k], STRENGTH_WEAK);
+      simplex_solver_add_edit_variable (&solvers[k], width[k], STRENGTH_STRONG);
+
+      /* a = width - 100, and b >= a */
+      simplex_solver_add_constraint (&solvers[k],
+                                     a[k], OPERATOR_TYPE_EQ,
+                                     expression_plus (expression_new_from_variable (width[k]), -100.0),
+                                     STRENGTH_REQUIRED);
+      simplex_solver_add_constraint (&solvers[k],
+                                     b[k], OPERATOR_TYPE_GE, expression_new_from_variable (a[k]),
+                                     STRENGTH_REQUIRED);
+
+      simplex_solver_begin_edit (&solvers[k]);
+    }
+
+  for (i = 0; i < G_N_ELEMENTS (widths); i++)
+    {
+      for (k = 0; k < 2; k++)
+        {
+          simplex_solver_suggest_value (&solvers[k], width[k], widths[i]);
+
+          /* The second solver always goes through the dual simplex */
+          if (k == 1)
+            g_clear_pointer (&solvers[k].compiled_basis, parametric_solution_free);
+
+          simplex_solver_resolve (&solvers[k]);
+        }
+
+      emeus_assert_almost_equals (variable_get_value (width[0]), variable_get_value (width[1]));
+      emeus_assert_almost_equals (variable_get_value (a[0]), variable_get_value (a[1]));
+      emeus_assert_almost_equals (variable_get_value (b[0]), variable_get_value (b[1]));
+    }
+
+  /* b stays where the widest step pushed it */
+  emeus_assert_almost_equals (variable_get_value (b[0]), 460.0);
+
+  g_assert_cmpint (solvers[0].fast_resolve_count, >, 0);
+  g_assert_cmpint (solvers[1].fast_resolve_count, ==, 0);
+
+  for (k = 0; k < 2; k++)
+    {
+      simplex_solver_end_edit (&solvers[k]);
+
+      variable_unref (width[k]);
+      variable_unref (a[k]);
+      variable_unref (b[k]);
+
+      simplex_solver_clear (&solvers[k]);
+    }
+}
+
+static void
+emeus_solver_kept_edit_variable (void)
+{
+  SimplexSolver solver = SIMPLEX_SOLVER_INIT;
+
+  simplex_solver_init (&solver);
+
+  Variable *width = simplex_solver_create_variable (&solver, "width", 0.0);
+  Variable *child = simplex_solver_create_variable (&solver, "child", 0.0);
+
+  /* Like the size of a layout, the edit variable is kept between
+   * allocations, and required constraints added later win over it
+   */
+  simplex_solver_add_edit_variable (&solver, width, STRENGTH_REQUIRED - 1);
+  simplex_solver_add_constraint (&solver,
+                                 child, OPERATOR_TYPE_LE, expression_new_from_variable (width),
+                                 STRENGTH_REQUIRED);
+
+  simplex_solver_begin_edit (&solver);
+  simplex_solver_suggest_value (&solver, width, 400.0);
+  simplex_solver_resolve (&solver);
+
+  emeus_assert_almost_equals (variable_get_value (width), 400.0);
+
+  simplex_solver_add_constraint (&solver,
+                                 child, OPERATOR_TYPE_GE, expression_new_from_constant (500.0),
+                                 STRENGTH_REQUIRED);
+
+  emeus_assert_almost_equals (variable_get_value (width), 500.0);
+  emeus_assert_almost_equals (variable_get_value (child), 500.0);
+
+  simplex_solver_suggest_value (&solver, width, 600.0);
+  simplex_solver_resolve (&solver);
+
+  emeus_assert_almost_equals (variable_get_value (width), 600.0);
+
+  simplex_solver_suggest_value (&solver, width, 450.0);
+  simplex_solver_resolve (&solver);
+
+  emeus_assert_almost_equals (variable_get_value (width), 500.0);
+
+  simplex_solver_end_edit (&solver);
+
+  variable_unref (width);
+  variable_unref (child);
+
+  simplex_solver_clear (&solver);
+}
+
+static void
+emeus_solver_fork (void)
+{
+  SimplexSolver solver = SIMPLEX_SOLVER_INIT;
+  SimplexSolver fork = SIMPLEX_SOLVER_INIT;
+
+  simplex_solver_init (&solver);
+
+  Variable *width = simplex_solver_create_variable (&solver, "width", 400.0);
+  Variable *left = simplex_solver_create_variable (&solver, "left", 0.0);
+  Variable *child = simplex_solver_create_variable (&solver, "child", 0.0);
+
+  simplex_solver_add_stay_variable (&solver, left, STRENGTH_STRONG);
+  simplex_solver_add_stay_variable (&solver, width, STRENGTH_WEAK);
+
+  /* left + child <= width - 20, and child wants to be 300 */
+  simplex_solver_add_constraint (&solver,
+                                 child, OPERATOR_TYPE_LE,
+                                 expression_plus (expression_plus_variable (expression_times (expression_new_from_variable (left), -1.0), width), -20.0),
+                                 STRENGTH_REQUIRED);
+  Constraint *size = simplex_solver_add_constraint (&solver,
+                                                    child, OPERATOR_TYPE_EQ, expression_new_from_constant (300.0),
+                                                    STRENGTH_MEDIUM);
+
+  emeus_assert_almost_equals (variable_get_value (child), 300.0);
+
+  simplex_solver_fork (&solver, &fork);
+
+  Variable *fork_width = simplex_solver_get_forked_variable (&fork, width);
+  Variable *fork_child = simplex_solver_get_forked_variable (&fork, child);
+
+  g_assert (fork_width != width);
+  emeus_assert_almost_equals (variable_get_value (fork_child), 300.0);
+
+  /* Changing the fork does not affect the parent */
+  simplex_solver_remove_constraint (&fork, simplex_solver_get_forked_constraint (&fork, size));
+  simplex_solver_add_edit_variable (&fork, fork_width, STRENGTH_REQUIRED);
+
+  simplex_solver_begin_edit (&fork);
+  simplex_solver_suggest_value (&fork, fork_width, 100.0);
+  simplex_solver_resolve (&fork);
+  simplex_solver_end_edit (&fork);
+
+  emeus_assert_almost_equals (variable_get_value (fork_width), 100.0);
+  g_assert_cmpfloat (variable_get_value (fork_child), <=, 80.0 + 0.001);
+
+  emeus_assert_almost_equals (variable_get_value (width), 400.0);
+  emeus_assert_almost_equals (variable_get_value (child), 300.0);
+
+  simplex_solver_clear (&fork);
+
+  /* The parent keeps working after the fork is gone */
+  simplex_solver_add_constraint (&solver,
+                                 width, OPERATOR_TYPE_LE, expression_new_from_constant (250.0),
+                                 STRENGTH_REQUIRED);
+
+  emeus_assert_almost_equals (variable_get_value (width), 250.0);
+  emeus_assert_almost_equals (variable_get_value (child), 230.0);
+
+  variable_unref (width);
+  variable_unref (left);
+  variable_unref (child);
+
+  simplex_solver_clear (&solver);
+}
+
+static void
+emeus_solver_fork_pending_edits (void)
+{
+  SimplexSolver solver = SIMPLEX_SOLVER_INIT;
+  SimplexSolver fork = SIMPLEX_SOLVER_INIT;
+
+  simplex_solver_init (&solver);
+
+  Variable *width = simplex_solver_create_variable (&solver, "width", 400.0);
+  Variable *child = simplex_solver_create_variable (&solver, "child", 0.0);
+
+  simplex_solver_add_edit_variable (&solver, width, STRENGTH_STRONG);
+  simplex_solver_add_constraint (&solver,
+                                 child, OPERATOR_TYPE_LE,
+                                 expression_plus (expression_new_from_variable (width), -20.0),
+                                 STRENGTH_REQUIRED);
+  simplex_solver_add_constraint (&solver,
+                                 child, OPERATOR_TYPE_EQ, expression_new_from_constant (300.0),
+                                 STRENGTH_MEDIUM);
+
+  simplex_solver_begin_edit (&solver);
+  simplex_solver_suggest_value (&solver, width, 250.0);
+  simplex_solver_resolve (&solver);
+
+  /* The suggestion is still pending when the solver is forked */
+  simplex_solver_suggest_value (&solver, width, 280.0);
+  g_assert_true (solver.has_pending_edits);
+
+  simplex_solver_fork (&solver, &fork);
+
+  g_assert_true (fork.has_pending_edits);
+  g_assert_nonnull (fork.compiled_basis);
+
+  /* Both solvers take the same path to the same solution */
+  simplex_solver_resolve (&solver);
+  simplex_solver_resolve (&fork);
+
+  g_assert_cmpint (fork.fast_resolve_count, ==, 1);
+  g_assert_cmpint (solver.fast_resolve_count, >, 0);
+
+  emeus_assert_almost_equals (variable_get_value (child), 260.0);
+  emeus_assert_almost_equals (variable_get_value (simplex_solver_get_forked_variable (&fork, child)),
+                              variable_get_value (child));
+
+  simplex_solver_clear (&fork);
+
+  simplex_solver_end_edit (&solver);
+
+  variable_unref (width);
+  variable_unref (child);
+
+  simplex_solver_clear (&solver);
+}
+
+static void
+emeus_solver_transaction (void)
+{
+  SimplexSolver solver = SIMPLEX_SOLVER_INIT;
+
+  simplex_solver_init (&solver);
+
+  Variable *width = simplex_solver_create_variable (&solver, "width", 400.0);
+  Variable *left = simplex_solver_create_variable (&solver, "left", 0.0);
+  Variable *child = simplex_solver_create_variable (&solver, "child", 0.0);
+
+  simplex_solver_add_stay_variable (&solver, left, STRENGTH_STRONG);
+  simplex_solver_add_stay_variable (&solver, width, STRENGTH_WEAK);
+
+  /* left + child <= width - 20, and child wants to be 300 */
+  simplex_solver_add_constraint (&solver,
+                                 child, OPERATOR_TYPE_LE,
+                                 expression_plus (expression_plus_variable (expression_times (expression_new_from_variable (left), -1.0), width), -20.0),
+                                 STRENGTH_REQUIRED);
+  Constraint *size = simplex_solver_add_constraint (&solver,
+                                                    child, OPERATOR_TYPE_EQ, expression_new_from_constant (300.0),
+                                                    STRENGTH_MEDIUM);
+
+  int n_rows = g_hash_table_size (solver.rows);
+  int n_columns = g_hash_table_size (solver.columns);
+
+  emeus_assert_almost_equals (variable_get_value (child), 300.0);
+
+  /* Drag the width around, then throw everything away */
+  simplex_solver_begin_transaction (&solver);
+
+  simplex_solver_remove_constraint (&solver, size);
+  simplex_solver_add_constraint (&solver,
+                                 child, OPERATOR_TYPE_EQ, expression_new_from_constant (50.0),
+                                 STRENGTH_STRONG);
+  simplex_solver_add_edit_variable (&solver, width, STRENGTH_REQUIRED);
+
+  simplex_solver_begin_edit (&solver);
+  simplex_solver_suggest_value (&solver, width, 100.0);
+  simplex_solver_resolve (&solver);
+  simplex_solver_end_edit (&solver);
+
+  emeus_assert_almost_equals (variable_get_value (width), 100.0);
+  emeus_assert_almost_equals (variable_get_value (child), 50.0);
+
+  simplex_solver_rollback_transaction (&solver);
+
+  emeus_assert_almost_equals (variable_get_value (width), 400.0);
+  emeus_assert_almost_equals (variable_get_value (child), 300.0);
+  g_assert_cmpint (g_hash_table_size (solver.rows), ==, n_rows);
+  g_assert_cmpint (g_hash_table_size (solver.columns), ==, n_columns);
+  g_assert_cmpint (g_hash_table_size (solver.edit_var_map), ==, 0);
+
+  /* The changes made in a committed transaction stay */
+  simplex_solver_begin_transaction (&solver);
+  simplex_solver_add_constraint (&solver,
+                                 width, OPERATOR_TYPE_LE, expression_new_from_constant (250.0),
+                                 STRENGTH_REQUIRED);
+  simplex_solver_commit_transaction (&solver);
+
+  emeus_assert_almost_equals (variable_get_value (width), 250.0);
+  emeus_assert_almost_equals (variable_get_value (child), 230.0);
+
+  /* The constraint removed by the rolled back transaction is still there */
+  simplex_solver_remove_constraint (&solver, size);
+
+  variable_unref (width);
+  variable_unref (left);
+  variable_unref (child);
+
+  simplex_solver_clear (&solver);
+}
+
+static void
+emeus_solver_serialize (void)
+{
+  SimplexSolver solver = SIMPLEX_SOLVER_INIT;
+  SimplexSolver copy = SIMPLEX_SOLVER_INIT;
+
+  simplex_solver_init (&solver);
+
+  Variable *width = simplex_solver_create_variable (&solver, "width", 400.0);
+  Variable *left = simplex_solver_create_variable (&solver, "left", 0.0);
+  Variable *child = simplex_solver_create_variable (&solver, "child", 0.0);
+
+  simplex_solver_add_stay_variable (&solver, left, STRENGTH_STRONG);
+  simplex_solver_add_stay_variable (&solver, width, STRENGTH_WEAK);
+
+  /* left + child <= width - 20, and child wants to be 300 */
+  simplex_solver_add_constraint (&solver,
+                                 child, OPERATOR_TYPE_LE,
+                                 expression_plus (expression_plus_variable (expression_times (expression_new_from_variable (left), -1.0), width), -20.0),
+                                 STRENGTH_REQUIRED);
+  Constraint *size = simplex_solver_add_constraint (&solver,
+                                                    child, OPERATOR_TYPE_EQ, expression_new_from_constant (300.0),
+                                                    STRENGTH_MEDIUM);
+
+  Variable *variables[] = { width, child };
+  GBytes *image = simplex_solver_serialize (&solver, 42, variables, 2, &size, 1);
+
+  g_assert (image != NULL);
+
+  variable_unref (width);
+  variable_unref (left);
+  variable_unref (child);
+
+  simplex_solver_clear (&solver);
+
+  /* An image created for a different set of constraints is rejected */
+  Variable *loaded_variables[2];
+  Constraint *loaded_size;
+
+  g_assert_false (simplex_solver_deserialize (&copy, image, 23, loaded_variables, 2, &loaded_size, 1));
+  g_assert_false (copy.initialized);
+
+  g_assert_true (simplex_solver_deserialize (&copy, image, 42, loaded_variables, 2, &loaded_size, 1));
+  g_bytes_unref (image);
+
+  width = loaded_variables[0];
+  child = loaded_variables[1];
+
+  emeus_assert_almost_equals (variable_get_value (width), 400.0);
+  emeus_assert_almost_equals (variable_get_value (child), 300.0);
+  g_assert_cmpstr (width->name, ==, "width");
+
+  /* The loaded solver can be changed like the original one */
+  simplex_solver_remove_constraint (&copy, loaded_size);
+  simplex_solver_add_edit_variable (&copy, width, STRENGTH_REQUIRED);
+
+  simplex_solver_begin_edit (&copy);
+  simplex_solver_suggest_value (&copy, width, 100.0);
+  simplex_solver_resolve (&copy);
+  simplex_solver_end_edit (&copy);
+
+  emeus_assert_almost_equals (variable_get_value (width), 100.0);
+  g_assert_cmpfloat (variable_get_value (child), <=, 80.0 + 0.001);
+
+  variable_unref (width);
+  variable_unref (child);
+
+  simplex_solver_clear (&copy);
+}
+
+static void
+emeus_solver_compact (void)
+{
+  SimplexSolver solver = SIMPLEX_SOLVER_INIT;
+
+  simplex_solver_init (&solver);
+
+  Variable *width = simplex_solver_create_variable (&solver, "width", 400.0);
+  Variable *left = simplex_solver_create_variable (&solver, "left", 0.0);
+  Variable *child = simplex_solver_create_variable (&solver, "child", 0.0);
+  Variable *right = simplex_solver_create_variable (&solver, "right", 0.0);
+
+  simplex_solver_add_stay_variable (&solver, left, STRENGTH_STRONG);
+  simplex_solver_add_stay_variable (&solver, width, STRENGTH_WEAK);
+
+  /* left + child <= width - 20, and child wants to be 300 */
+  simplex_solver_add_constraint (&solver,
+                                 child, OPERATOR_TYPE_LE,
+                                 expression_plus (expression_plus_variable (expression_times (expression_new_from_variable (left), -1.0), width), -20.0),
+                                 STRENGTH_REQUIRED);
+  simplex_solver_add_constraint (&solver,
+                                 child, OPERATOR_TYPE_EQ, expression_new_from_constant (300.0),
+                                 STRENGTH_MEDIUM);
+
+  /* right = left + child, and right >= 10 */
+  Constraint *c1 = simplex_solver_add_constraint (&solver,
+                                                  right, OPERATOR_TYPE_EQ,
+                                                  expression_plus_variable (expression_new_from_variable (left), child),
+                                                  STRENGTH_REQUIRED);
+  Constraint *c2 = simplex_solver_add_constraint (&solver,
+                                                  right, OPERATOR_TYPE_GE,
+                                                  expression_plus_variable (expression_new_from_constant (10.0), left),
+                                                  STRENGTH_MEDIUM);
+
+  emeus_assert_almost_equals (variable_get_value (right), 300.0);
+
+  simplex_solver_remove_constraint (&solver, c2);
+  simplex_solver_remove_constraint (&solver, c1);
+
+  int n_rows = g_hash_table_size (solver.rows);
+  int n_columns = g_hash_table_size (solver.columns);
+
+  simplex_solver_compact (&solver);
+
+  /* Nothing refers to right any more */
+  g_assert_false (g_hash_table_contains (solver.rows, right));
+  g_assert_false (g_hash_table_contains (solver.columns, right));
+  g_assert_cmpint (g_hash_table_size (solver.rows), <=, n_rows);
+  g_assert_cmpint (g_hash_table_size (solver.columns), <, n_columns);
+
+  emeus_assert_almost_equals (variable_get_value (child), 300.0);
+
+  /* The remaining constraints keep working */
+  simplex_solver_add_constraint (&solver,
+                                 width, OPERATOR_TYPE_LE, expression_new_from_constant (250.0),
+                                 STRENGTH_REQUIRED);
+
+  emeus_assert_almost_equals (variable_get_value (width), 250.0);
+  emeus_assert_almost_equals (variable_get_value (child), 230.0);
+
+  /* And the removed variable can be used again */
+  simplex_solver_add_constraint (&solver,
+                                 right, OPERATOR_TYPE_EQ,
+                                 expression_plus_variable (expression_new_from_variable (left), child),
+                                 STRENGTH_REQUIRED);
+
+  emeus_assert_almost_equals (variable_get_value (right), 230.0);
+
+  variable_unref (width);
+  variable_unref (left);
+  variable_unref (child);
+  variable_unref (right);
+
+  simplex_solver_clear (&solver);
+}
+
+static void
+emeus_solver_reset (void)
+{
+  SimplexSolver solver = SIMPLEX_SOLVER_INIT;
+
+  simplex_solver_init (&solver);
+
+  Variable *width = simplex_solver_create_variable (&solver, "width", 400.0);
+  Variable *left = simplex_solver_create_variable (&solver, "left", 0.0);
+  Variable *child = simplex_solver_create_variable (&solver, "child", 0.0);
+
+  simplex_solver_add_stay_variable (&solver, left, STRENGTH_STRONG);
+  simplex_solver_add_stay_variable (&solver, width, STRENGTH_WEAK);
+  simplex_solver_add_constraint (&solver,
+                                 child, OPERATOR_TYPE_LE,
+                                 expression_plus (expression_plus_variable (expression_times (expression_new_from_variable (left), -1.0), width), -20.0),
+                                 STRENGTH_REQUIRED);
+  simplex_solver_add_constraint (&solver,
+                                 child, OPERATOR_TYPE_EQ, expression_new_from_constant (300.0),
+                                 STRENGTH_MEDIUM);
+
+  emeus_assert_almost_equals (variable_get_value (child), 300.0);
+
+  GHashTable *rows = solver.rows;
+
+  simplex_solver_reset (&solver);
+
+  /* The tables are emptied, not replaced */
+  g_assert_true (solver.rows == rows);
+  g_assert_cmpint (g_hash_table_size (solver.rows), ==, 1);
+  g_assert_cmpint (g_hash_table_size (solver.columns), ==, 0);
+  g_assert_cmpint (g_hash_table_size (solver.constraints), ==, 0);
+  g_assert_true (solver.difference_mode);
+
+  /* The solver can be filled again, with old and new variables */
+  Variable *right = simplex_solver_create_variable (&solver, "right", 0.0);
+
+  simplex_solver_add_stay_variable (&solver, left, STRENGTH_STRONG);
+  simplex_solver_add_constraint (&solver,
+                                 width, OPERATOR_TYPE_EQ, expression_new_from_constant (100.0),
+                                 STRENGTH_REQUIRED);
+  simplex_solver_add_constraint (&solver,
+                                 right, OPERATOR_TYPE_EQ,
+                                 expression_plus_variable (expression_new_from_variable (left), width),
+                                 STRENGTH_REQUIRED);
+
+  emeus_assert_almost_equals (variable_get_value (width), 100.0);
+  emeus_assert_almost_equals (variable_get_value (right), 100.0);
+
+  variable_unref (width);
+  variable_unref (left);
+  variable_unref (child);
+  variable_unref (right);
+
+  simplex_solver_clear (&solver);
+}
+
+static void
+emeus_solver_auto_solve (void)
+{
+  SimplexSolver solver = SIMPLEX_SOLVER_INIT;
+
+  simplex_solver_init (&solver);
+  simplex_solver_set_auto_solve (&solver, false);
+
+  Variable *width = simplex_solver_create_variable (&solver, "width", 400.0);
+  Variable *left = simplex_solver_create_variable (&solver, "left", 0.0);
+  Variable *child = simplex_solver_create_variable (&solver, "child", 0.0);
+
+  simplex_solver_add_stay_variable (&solver, left, STRENGTH_STRONG);
+  simplex_solver_add_stay_variable (&solver, width, STRENGTH_WEAK);
+  simplex_solver_add_constraint (&solver,
+                                 child, OPERATOR_TYPE_LE,
+                                 expression_plus (expression_plus_variable (expression_times (expression_new_from_variable (left), -1.0), width), -20.0),
+                                 STRENGTH_REQUIRED);
+  simplex_solver_add_constraint (&solver,
+                                 child, OPERATOR_TYPE_EQ, expression_new_from_constant (300.0),
+                                 STRENGTH_MEDIUM);
+
+  simplex_solver_solve (&solver);
+
+  emeus_assert_almost_equals (variable_get_value (child), 300.0);
+
+  /* Enabling automatic solving solves the pending constraints */
+  simplex_solver_set_auto_solve (&solver, false);
+  simplex_solver_add_constraint (&solver,
+                                 child, OPERATOR_TYPE_LE, expression_new_from_constant (200.0),
+                                 STRENGTH_REQUIRED);
+  simplex_solver_set_auto_solve (&solver, true);
+
+  emeus_assert_almost_equals (variable_get_value (child), 200.0);
+
+  /* Suggesting a value solves the pending constraints first */
+  simplex_solver_set_auto_solve (&solver, false);
+  simplex_solver_add_edit_variable (&solver, width, STRENGTH_REQUIRED);
+
+  simplex_solver_begin_edit (&solver);
+  simplex_solver_suggest_value (&solver, width, 150.0);
+  simplex_solver_resolve (&solver);
+
+  emeus_assert_almost_equals (variable_get_value (width), 150.0);
+  emeus_assert_almost_equals (variable_get_value (child), 130.0);
+
+  simplex_solver_end_edit (&solver);
+
+  variable_unref (width);
+  variable_unref (left);
+  variable_unref (child);
+
+  simplex_solver_clear (&solver);
+}
+
+static void
+emeus_solver_merge_fork (void)
+{
+  SimplexSolver solver = SIMPLEX_SOLVER_INIT;
+  SimplexSolver fork = SIMPLEX_SOLVER_INIT;
+
+  simplex_solver_init (&solver);
+
+  Variable *width = simplex_solver_create_variable (&solver, "width", 400.0);
+  Variable *left = simplex_solver_create_variable (&solver, "left", 0.0);
+  Variable *child = simplex_solver_create_variable (&solver, "child", 0.0);
+
+  simplex_solver_add_stay_variable (&solver, left, STRENGTH_STRONG);
+  simplex_solver_add_constraint (&solver,
+                                 child, OPERATOR_TYPE_LE,
+                                 expression_plus (expression_plus_variable (expression_times (expression_new_from_variable (left), -1.0), width), -20.0),
+                                 STRENGTH_REQUIRED);
+  simplex_solver_add_constraint (&solver,
+                                 child, OPERATOR_TYPE_EQ, expression_new_from_constant (300.0),
+                                 STRENGTH_MEDIUM);
+  simplex_solver_add_edit_variable (&solver, width, STRENGTH_REQUIRED);
+
+  emeus_assert_almost_equals (variable_get_value (child), 300.0);
+
+  /* Solve the pending constraints on a fork */
+  simplex_solver_set_auto_solve (&solver, false);
+  simplex_solver_add_constraint (&solver,
+                                 child, OPERATOR_TYPE_LE, expression_new_from_constant (200.0),
+                                 STRENGTH_REQUIRED);
+
+  simplex_solver_fork (&solver, &fork);
+
+  Variable *fork_width = simplex_solver_get_forked_variable (&fork, width);
+
+  simplex_solver_begin_edit (&fork);
+  simplex_solver_suggest_value (&fork, fork_width, 150.0);
+  simplex_solver_resolve (&fork);
+
+  emeus_assert_almost_equals (variable_get_value (child), 300.0);
+
+  g_assert_true (simplex_solver_merge_fork (&solver, &fork));
+  simplex_solver_clear (&fork);
+
+  g_assert_false (solver.needs_solving);
+  emeus_assert_almost_equals (variable_get_value (width), 150.0);
+  emeus_assert_almost_equals (variable_get_value (child), 130.0);
+
+  /* The parent keeps working with the merged tableau */
+  simplex_solver_set_auto_solve (&solver, true);
+
+  simplex_solver_begin_edit (&solver);
+  simplex_solver_suggest_value (&solver, width, 100.0);
+  simplex_solver_resolve (&solver);
+  simplex_solver_end_edit (&solver);
+
+  emeus_assert_almost_equals (variable_get_value (width), 100.0);
+  emeus_assert_almost_equals (variable_get_value (child), 80.0);
+
+  simplex_solver_add_constraint (&solver,
+                                 child, OPERATOR_TYPE_LE, expression_new_from_constant (50.0),
+                                 STRENGTH_REQUIRED);
+
+  emeus_assert_almost_equals (variable_get_value (child), 50.0);
+
+  /* A fork of an older set of constraints is rejected */
+  simplex_solver_fork (&solver, &fork);
+  simplex_solver_add_constraint (&solver,
+                                 child, OPERATOR_TYPE_LE, expression_new_from_constant (40.0),
+                                 STRENGTH_REQUIRED);
+
+  g_assert_false (simplex_solver_merge_fork (&solver, &fork));
+  simplex_solver_clear (&fork);
+
+  emeus_assert_almost_equals (variable_get_value (child), 40.0);
+
+  variable_unref (width);
+  variable_unref (left);
+  variable_unref (child);
+
+  simplex_solver_clear (&solver);
+}
+
+static void
+emeus_solver_resolve_budget (void)
+{
+  SimplexSolver solver = SIMPLEX_SOLVER_INIT;
+  Variable *vars[20];
+  Constraint *limit;
+  int i, n_calls;
+
+  simplex_solver_init (&solver);
+
+  Variable *width = simplex_solver_create_variable (&solver, "width", 300.0);
+
+  simplex_solver_add_edit_variable (&solver, width, STRENGTH_REQUIRED);
+
+  /* A row of children, each one at least 10 wide, that want to be 30 wide
+   * and have to fit in the width
+   */
+  for (i = 0; i < G_N_ELEMENTS (vars); i++)
+    {
+      vars[i] = simplex_solver_create_variable (&solver, "child", 0.0);
+
+      simplex_solver_add_constraint (&solver,
+                                     vars[i], OPERATOR_TYPE_GE,
+                                     i == 0
+                                       ? expression_new_from_constant (10.0)
+                                       : expression_plus (expression_new_from_variable (vars[i - 1]), 10.0),
+                                     STRENGTH_REQUIRED);
+      simplex_solver_add_constraint (&solver,
+                                     vars[i], OPERATOR_TYPE_EQ,
+                                     i == 0
+                                       ? expression_new_from_constant (30.0)
+                                       : expression_plus (expression_new_from_variable (vars[i - 1]), 30.0),
+                                     STRENGTH_MEDIUM);
+    }
+
+  /* Not a difference constraint, so that the tableau is used */
+  simplex_solver_add_constraint (&solver,
+                                 vars[1], OPERATOR_TYPE_GE,
+                                 expression_times (expression_new_from_variable (vars[0]), -1.0),
+                                 STRENGTH_REQUIRED);
+
+  limit = simplex_solver_add_constraint (&solver,
+                                         vars[G_N_ELEMENTS (vars) - 1], OPERATOR_TYPE_LE,
+                                         expression_new_from_variable (width),
+                                         STRENGTH_REQUIRED);
+
+  emeus_assert_almost_equals (variable_get_value (vars[G_N_ELEMENTS (vars) - 1]), 300.0);
+
+  /* Removing the limit leaves a feasible tableau that is not optimal;
+   * each call does a single pivot, and the values always satisfy the
+   * required constraints
+   */
+  simplex_solver_set_auto_solve (&solver, false);
+  simplex_solver_remove_constraint (&solver, limit);
+
+  n_calls = 1;
+  while (!simplex_solver_resolve_with_budget (&solver, 1, 0))
+    {
+      for (i = 1; i < G_N_ELEMENTS (vars); i++)
+        g_assert_cmpfloat (variable_get_value (vars[i]), >=, variable_get_value (vars[i - 1]) + 10.0 - 0.001);
+
+      n_calls += 1;
+    }
+
+  g_assert_cmpint (n_calls, >, 1);
+  g_assert_false (solver.needs_solving);
+
+  for (i = 0; i < G_N_ELEMENTS (vars); i++)
+    emeus_assert_almost_equals (variable_get_value (vars[i]), 30.0 * (i + 1));
+
+  /* Shrinking the width keeps the previous values until the new solution
+   * is found
+   */
+  limit = simplex_solver_add_constraint (&solver,
+                                         vars[G_N_ELEMENTS (vars) - 1], OPERATOR_TYPE_LE,
+                                         expression_new_from_variable (width),
+                                         STRENGTH_REQUIRED);
+  simplex_solver_set_auto_solve (&solver, true);
+
+  simplex_solver_begin_edit (&solver);
+  simplex_solver_suggest_value (&solver, width, 700.0);
+  simplex_solver_resolve (&solver);
+
+  emeus_assert_almost_equals (variable_get_value (vars[G_N_ELEMENTS (vars) - 1]), 600.0);
+
+  simplex_solver_suggest_value (&solver, width, 200.0);
+
+  n_calls = 1;
+  while (!simplex_solver_resolve_with_budget (&solver, 1, 0))
+    {
+      emeus_assert_almost_equals (variable_get_value (vars[G_N_ELEMENTS (vars) - 1]), 600.0);
+
+      n_calls += 1;
+    }
+
+  simplex_solver_end_edit (&solver);
+
+  g_assert_cmpint (n_calls, >, 1);
+  emeus_assert_almost_equals (variable_get_value (width), 200.0);
+  emeus_assert_almost_equals (variable_get_value (vars[G_N_ELEMENTS (vars) - 1]), 200.0);
+
+  /* Other changes finish the pending work first */
+  simplex_solver_begin_edit (&solver);
+  simplex_solver_suggest_value (&solver, width, 600.0);
+  g_assert_false (simplex_solver_resolve_with_budget (&solver, 1, 0));
+  simplex_solver_remove_constraint (&solver, limit);
+  simplex_solver_end_edit (&solver);
+
+  emeus_assert_almost_equals (variable_get_value (vars[G_N_ELEMENTS (vars) - 1]), 600.0);
+
+  variable_unref (width);
+  for (i = 0; i < G_N_ELEMENTS (vars); i++)
+    variable_unref (vars[i]);
+
+  simplex_solver_clear (&solver);
+}
+
+static void
+emeus_solver_solve_batch (void)
+{
+  SimplexSolver solvers[32];
+  SolverBatchItem items[G_N_ELEMENTS (solvers)];
+  Variable *vars[G_N_ELEMENTS (solvers)][3];
+  Variable *widths[G_N_ELEMENTS (solvers)];
+  double sizes[G_N_ELEMENTS (solvers)];
+  double values[G_N_ELEMENTS (solvers)][3];
+  int i, j;
+
+  /* Each system is a row of three children, each one at least 10 wide,
+   * filling a different width
+   */
+  for (i = 0; i < G_N_ELEMENTS (solvers); i++)
+    {
+      SimplexSolver *solver = &solvers[i];
+
+      *solver = (SimplexSolver) SIMPLEX_SOLVER_INIT;
+      simplex_solver_init (solver);
+      simplex_solver_set_auto_solve (solver, false);
+
+      widths[i] = simplex_solver_create_variable (solver, "width", 100.0);
+      sizes[i] = 100.0 + 10.0 * i;
+
+      for (j = 0; j < 3; j++)
+        {
+          vars[i][j] = simplex_solver_create_variable (solver, "child", 0.0);
+
+          simplex_solver_add_constraint (solver,
+                                         vars[i][j], OPERATOR_TYPE_GE,
+                                         j == 0
+                                           ? expression_new_from_constant (10.0)
+                                           : expression_plus (expression_new_from_variable (vars[i][j - 1]), 10.0),
+                                         STRENGTH_REQUIRED);
+        }
+
+      simplex_solver_add_constraint (solver,
+                                     vars[i][2], OPERATOR_TYPE_EQ,
+                                     expression_new_from_variable (widths[i]),
+                                     STRENGTH_REQUIRED);
+      simplex_solver_add_constraint (solver,
+                                     vars[i][1], OPERATOR_TYPE_EQ,
+                                     expression_times (expression_new_from_variable (vars[i][2]), 0.5),
+                                     STRENGTH_STRONG);
+      simplex_solver_add_edit_variable (solver, widths[i], STRENGTH_REQUIRED);
+
+      items[i].solver = solver;
+      items[i].n_edits = 1;
+      items[i].edit_variables = &widths[i];
+      items[i].edit_values = &sizes[i];
+      items[i].n_variables = 3;
+      items[i].variables = vars[i];
+      items[i].values = values[i];
+      items[i].solve_time = -1;
+    }
+
+  simplex_solver_solve_batch (items, G_N_ELEMENTS (items), 4);
+
+  for (i = 0; i < G_N_ELEMENTS (solvers); i++)
+    {
+      g_assert_false (solvers[i].needs_solving);
+      g_assert_cmpint (items[i].solve_time, >=, 0);
+
+      emeus_assert_almost_equals (values[i][2], sizes[i]);
+      emeus_assert_almost_equals (values[i][1], sizes[i] / 2.0);
+      g_assert_cmpfloat (values[i][0], >=, 10.0 - 0.001);
+      g_assert_cmpfloat (values[i][1], >=, values[i][0] + 10.0 - 0.001);
+
+      for (j = 0; j < 3; j++)
+        {
+          emeus_assert_almost_equals (variable_get_value (vars[i][j]), values[i][j]);
+          variable_unref (vars[i][j]);
+        }
+
+      variable_unref (widths[i]);
+      simplex_solver_clear (&solvers[i]);
+    }
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -253,11 +2190,37 @@ main (int argc, char *argv[])
   g_test_add_func ("/emeus/solver/stay", emeus_solver_stay);
   g_test_add_func ("/emeus/solver/edit-var-required", emeus_solver_edit_var_required);
   g_test_add_func ("/emeus/solver/edit-var-suggest", emeus_solver_edit_var_suggest);
+  g_test_add_func ("/emeus/solver/edit-var-large-delta", emeus_solver_edit_var_large_delta);
   g_test_add_func ("/emeus/solver/variable-geq-constant", emeus_solver_variable_geq_constant);
   g_test_add_func ("/emeus/solver/variable-leq-constant", emeus_solver_variable_leq_constant);
   g_test_add_func ("/emeus/solver/variable-eq-constant", emeus_solver_variable_eq_constant);
   g_test_add_func ("/emeus/solver/eq-with-stay", emeus_solver_eq_with_stay);
   g_test_add_func ("/emeus/solver/cassowary", emeus_solver_cassowary);
+  g_test_add_func ("/emeus/solver/degenerate-chain", emeus_solver_degenerate_chain);
+  g_test_add_func ("/emeus/solver/add-remove-cycles", emeus_solver_add_remove_cycles);
+  g_test_add_func ("/emeus/solver/remove-batch", emeus_solver_remove_batch);
+  g_test_add_func ("/emeus/solver/disable-constraints", emeus_solver_disable_constraints);
+  g_test_add_func ("/emeus/solver/enable-constraints-batch", emeus_solver_enable_constraints_batch);
+  g_test_add_func ("/emeus/solver/equality-alias", emeus_solver_equality_alias);
+  g_test_add_func ("/emeus/solver/difference-system", emeus_solver_difference_system);
+  g_test_add_func ("/emeus/solver/difference-layers", emeus_solver_difference_layers);
+  g_test_add_func ("/emeus/solver/difference-strengths", emeus_solver_difference_strengths);
+  g_test_add_func ("/emeus/solver/difference-chain", emeus_solver_difference_chain);
+  g_test_add_func ("/emeus/solver/bounds", emeus_solver_bounds);
+  g_test_add_func ("/emeus/solver/parametric-solution", emeus_solver_parametric_solution);
+  g_test_add_func ("/emeus/solver/fast-resolve", emeus_solver_fast_resolve);
+  g_test_add_func ("/emeus/solver/fast-resolve-stays", emeus_solver_fast_resolve_stays);
+  g_test_add_func ("/emeus/solver/kept-edit-variable", emeus_solver_kept_edit_variable);
+  g_test_add_func ("/emeus/solver/fork", emeus_solver_fork);
+  g_test_add_func ("/emeus/solver/fork-pending-edits", emeus_solver_fork_pending_edits);
+  g_test_add_func ("/emeus/solver/transaction", emeus_solver_transaction);
+  g_test_add_func ("/emeus/solver/serialize", emeus_solver_serialize);
+  g_test_add_func ("/emeus/solver/compact", emeus_solver_compact);
+  g_test_add_func ("/emeus/solver/reset", emeus_solver_reset);
+  g_test_add_func ("/emeus/solver/auto-solve", emeus_solver_auto_solve);
+  g_test_add_func ("/emeus/solver/merge-fork", emeus_solver_merge_fork);
+  g_test_add_func ("/emeus/solver/resolve-budget", emeus_solver_resolve_budget);
+  g_test_add_func ("/emeus/solver/solve-batch", emeus_solver_solve_batch);
 
   return g_test_run ();
 }
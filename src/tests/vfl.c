@@ -0,0 +1,316 @@
+#include "emeus-vfl-parser-private.h"
+
+#include "emeus-constraint-layout.h"
+
+#include "emeus-test-utils.h"
+
+/* The parser only uses the views as keys, so any pointer will do */
+#define VIEW_A  GINT_TO_POINTER (1)
+#define VIEW_B  GINT_TO_POINTER (2)
+#define VIEW_C  GINT_TO_POINTER (3)
+
+static GHashTable *
+create_views (void)
+{
+  GHashTable *views = g_hash_table_new (g_str_hash, g_str_equal);
+
+  g_hash_table_insert (views, (gpointer) "a", VIEW_A);
+  g_hash_table_insert (views, (gpointer) "b", VIEW_B);
+  g_hash_table_insert (views, (gpointer) "c", VIEW_C);
+
+  return views;
+}
+
+static GArray *
+parse (const char *text,
+       GError **error)
+{
+  GHashTable *views = create_views ();
+  GArray *descriptors = g_array_new (FALSE, FALSE, sizeof (EmeusConstraintDescriptor));
+  bool res;
+
+  /* The default horizontal spacing is 8, and the vertical one is 6 */
+  res = vfl_parser_parse (text, -1, 8, 6, views, descriptors, error);
+  g_assert_true (res == (*error == NULL));
+
+  g_hash_table_unref (views);
+
+  return descriptors;
+}
+
+static void
+assert_descriptor (GArray *descriptors,
+                   guint index_,
+                   gpointer target_object,
+                   EmeusConstraintAttribute target_attribute,
+                   EmeusConstraintRelation relation,
+                   gpointer source_object,
+                   EmeusConstraintAttribute source_attribute,
+                   double constant,
+                   EmeusConstraintStrength strength)
+{
+  const EmeusConstraintDescriptor *d;
+
+  g_assert_cmpuint (index_, <, descriptors->len);
+
+  d = &g_array_index (descriptors, EmeusConstraintDescriptor, index_);
+
+  g_assert_true (d->target_object == target_object);
+  g_assert_cmpint (d->target_attribute, ==, target_attribute);
+  g_assert_cmpint (d->relation, ==, relation);
+  g_assert_true (d->source_object == source_object);
+  g_assert_cmpint (d->source_attribute, ==, source_attribute);
+  emeus_assert_almost_equals (d->multiplier, 1.0);
+  emeus_assert_almost_equals (d->constant, constant);
+  g_assert_cmpint (d->strength, ==, strength);
+}
+
+static void
+assert_parse_error (const char *text,
+                    EmeusConstraintLayoutError code,
+                    const char *message)
+{
+  GError *error = NULL;
+  GArray *descriptors = parse (text, &error);
+
+  g_assert_error (error, EMEUS_CONSTRAINT_LAYOUT_ERROR, code);
+  g_assert_cmpstr (error->message, ==, message);
+
+  g_error_free (error);
+  g_array_unref (descriptors);
+}
+
+static void
+emeus_vfl_superview (void)
+{
+  GError *error = NULL;
+  GArray *descriptors = parse ("H:|-[a]-|", &error);
+
+  g_assert_no_error (error);
+  g_assert_cmpuint (descriptors->len, ==, 2);
+
+  /* The default spacing is used next to the layout */
+  assert_descriptor (descriptors, 0,
+                     VIEW_A, EMEUS_CONSTRAINT_ATTRIBUTE_START,
+                     EMEUS_CONSTRAINT_RELATION_EQ,
+                     NULL, EMEUS_CONSTRAINT_ATTRIBUTE_START,
+                     8.0, EMEUS_CONSTRAINT_STRENGTH_REQUIRED);
+  assert_descriptor (descriptors, 1,
+                     NULL, EMEUS_CONSTRAINT_ATTRIBUTE_END,
+                     EMEUS_CONSTRAINT_RELATION_EQ,
+                     VIEW_A, EMEUS_CONSTRAINT_ATTRIBUTE_END,
+                     8.0, EMEUS_CONSTRAINT_STRENGTH_REQUIRED);
+
+  g_array_unref (descriptors);
+
+  /* Adjacent edges, without a spacing */
+  descriptors = parse ("|[a][b]|", &error);
+
+  g_assert_no_error (error);
+  g_assert_cmpuint (descriptors->len, ==, 3);
+
+  assert_descriptor (descriptors, 0,
+                     VIEW_A, EMEUS_CONSTRAINT_ATTRIBUTE_START,
+                     EMEUS_CONSTRAINT_RELATION_EQ,
+                     NULL, EMEUS_CONSTRAINT_ATTRIBUTE_START,
+                     0.0, EMEUS_CONSTRAINT_STRENGTH_REQUIRED);
+  assert_descriptor (descriptors, 1,
+                     VIEW_B, EMEUS_CONSTRAINT_ATTRIBUTE_START,
+                     EMEUS_CONSTRAINT_RELATION_EQ,
+                     VIEW_A, EMEUS_CONSTRAINT_ATTRIBUTE_END,
+                     0.0, EMEUS_CONSTRAINT_STRENGTH_REQUIRED);
+  assert_descriptor (descriptors, 2,
+                     NULL, EMEUS_CONSTRAINT_ATTRIBUTE_END,
+                     EMEUS_CONSTRAINT_RELATION_EQ,
+                     VIEW_B, EMEUS_CONSTRAINT_ATTRIBUTE_END,
+                     0.0, EMEUS_CONSTRAINT_STRENGTH_REQUIRED);
+
+  g_array_unref (descriptors);
+}
+
+static void
+emeus_vfl_metrics (void)
+{
+  GError *error = NULL;
+  GArray *descriptors = parse ("V:|-[a]-20-[b]-0.5-|", &error);
+
+  g_assert_no_error (error);
+  g_assert_cmpuint (descriptors->len, ==, 3);
+
+  /* The vertical lines use the vertical spacing and edges */
+  assert_descriptor (descriptors, 0,
+                     VIEW_A, EMEUS_CONSTRAINT_ATTRIBUTE_TOP,
+                     EMEUS_CONSTRAINT_RELATION_EQ,
+                     NULL, EMEUS_CONSTRAINT_ATTRIBUTE_TOP,
+                     6.0, EMEUS_CONSTRAINT_STRENGTH_REQUIRED);
+  assert_descriptor (descriptors, 1,
+                     VIEW_B, EMEUS_CONSTRAINT_ATTRIBUTE_TOP,
+                     EMEUS_CONSTRAINT_RELATION_EQ,
+                     VIEW_A, EMEUS_CONSTRAINT_ATTRIBUTE_BOTTOM,
+                     20.0, EMEUS_CONSTRAINT_STRENGTH_REQUIRED);
+  assert_descriptor (descriptors, 2,
+                     NULL, EMEUS_CONSTRAINT_ATTRIBUTE_BOTTOM,
+                     EMEUS_CONSTRAINT_RELATION_EQ,
+                     VIEW_B, EMEUS_CONSTRAINT_ATTRIBUTE_BOTTOM,
+                     0.5, EMEUS_CONSTRAINT_STRENGTH_REQUIRED);
+
+  g_array_unref (descriptors);
+}
+
+static void
+emeus_vfl_predicates (void)
+{
+  GError *error = NULL;
+  GArray *descriptors = parse ("[a(>=50@strong, ==b@weak)]-(>=8,<=20@medium)-[c(<=100)]", &error);
+
+  g_assert_no_error (error);
+  g_assert_cmpuint (descriptors->len, ==, 5);
+
+  /* The predicates of a view constrain its size */
+  assert_descriptor (descriptors, 0,
+                     VIEW_A, EMEUS_CONSTRAINT_ATTRIBUTE_WIDTH,
+                     EMEUS_CONSTRAINT_RELATION_GE,
+                     NULL, EMEUS_CONSTRAINT_ATTRIBUTE_INVALID,
+                     50.0, EMEUS_CONSTRAINT_STRENGTH_STRONG);
+  assert_descriptor (descriptors, 1,
+                     VIEW_A, EMEUS_CONSTRAINT_ATTRIBUTE_WIDTH,
+                     EMEUS_CONSTRAINT_RELATION_EQ,
+                     VIEW_B, EMEUS_CONSTRAINT_ATTRIBUTE_WIDTH,
+                     0.0, EMEUS_CONSTRAINT_STRENGTH_WEAK);
+  assert_descriptor (descriptors, 2,
+                     VIEW_C, EMEUS_CONSTRAINT_ATTRIBUTE_WIDTH,
+                     EMEUS_CONSTRAINT_RELATION_LE,
+                     NULL, EMEUS_CONSTRAINT_ATTRIBUTE_INVALID,
+                     100.0, EMEUS_CONSTRAINT_STRENGTH_REQUIRED);
+
+  /* The predicates of a connection constrain the spacing; they are
+   * added once the view after the connection is parsed
+   */
+  assert_descriptor (descriptors, 3,
+                     VIEW_C, EMEUS_CONSTRAINT_ATTRIBUTE_START,
+                     EMEUS_CONSTRAINT_RELATION_GE,
+                     VIEW_A, EMEUS_CONSTRAINT_ATTRIBUTE_END,
+                     8.0, EMEUS_CONSTRAINT_STRENGTH_REQUIRED);
+  assert_descriptor (descriptors, 4,
+                     VIEW_C, EMEUS_CONSTRAINT_ATTRIBUTE_START,
+                     EMEUS_CONSTRAINT_RELATION_LE,
+                     VIEW_A, EMEUS_CONSTRAINT_ATTRIBUTE_END,
+                     20.0, EMEUS_CONSTRAINT_STRENGTH_MEDIUM);
+
+  g_array_unref (descriptors);
+}
+
+static void
+emeus_vfl_parallel (void)
+{
+  GError *error = NULL;
+  GArray *descriptors = parse ("|-[a,b]-[c]", &error);
+
+  g_assert_no_error (error);
+  g_assert_cmpuint (descriptors->len, ==, 4);
+
+  /* Each view in the brackets is connected on both sides */
+  assert_descriptor (descriptors, 0,
+                     VIEW_A, EMEUS_CONSTRAINT_ATTRIBUTE_START,
+                     EMEUS_CONSTRAINT_RELATION_EQ,
+                     NULL, EMEUS_CONSTRAINT_ATTRIBUTE_START,
+                     8.0, EMEUS_CONSTRAINT_STRENGTH_REQUIRED);
+  assert_descriptor (descriptors, 1,
+                     VIEW_B, EMEUS_CONSTRAINT_ATTRIBUTE_START,
+                     EMEUS_CONSTRAINT_RELATION_EQ,
+                     NULL, EMEUS_CONSTRAINT_ATTRIBUTE_START,
+                     8.0, EMEUS_CONSTRAINT_STRENGTH_REQUIRED);
+  assert_descriptor (descriptors, 2,
+                     VIEW_C, EMEUS_CONSTRAINT_ATTRIBUTE_START,
+                     EMEUS_CONSTRAINT_RELATION_EQ,
+                     VIEW_A, EMEUS_CONSTRAINT_ATTRIBUTE_END,
+                     8.0, EMEUS_CONSTRAINT_STRENGTH_REQUIRED);
+  assert_descriptor (descriptors, 3,
+                     VIEW_C, EMEUS_CONSTRAINT_ATTRIBUTE_START,
+                     EMEUS_CONSTRAINT_RELATION_EQ,
+                     VIEW_B, EMEUS_CONSTRAINT_ATTRIBUTE_END,
+                     8.0, EMEUS_CONSTRAINT_STRENGTH_REQUIRED);
+
+  g_array_unref (descriptors);
+}
+
+static void
+emeus_vfl_lines (void)
+{
+  GError *error = NULL;
+  GArray *descriptors = parse ("H:|[a]|\n\n  V:[a][b]\n", &error);
+
+  g_assert_no_error (error);
+  g_assert_cmpuint (descriptors->len, ==, 3);
+
+  assert_descriptor (descriptors, 2,
+                     VIEW_B, EMEUS_CONSTRAINT_ATTRIBUTE_TOP,
+                     EMEUS_CONSTRAINT_RELATION_EQ,
+                     VIEW_A, EMEUS_CONSTRAINT_ATTRIBUTE_BOTTOM,
+                     0.0, EMEUS_CONSTRAINT_STRENGTH_REQUIRED);
+
+  g_array_unref (descriptors);
+
+  /* The lines before an error are kept */
+  descriptors = parse ("H:|[a]|\n[d]", &error);
+
+  g_assert_error (error, EMEUS_CONSTRAINT_LAYOUT_ERROR, EMEUS_CONSTRAINT_LAYOUT_ERROR_INVALID_VIEW);
+  g_assert_cmpstr (error->message, ==, "Line 2, column 2: Unknown view 'd'");
+  g_assert_cmpuint (descriptors->len, ==, 2);
+
+  g_clear_error (&error);
+  g_array_unref (descriptors);
+}
+
+static void
+emeus_vfl_errors (void)
+{
+  assert_parse_error ("H[a]",
+                      EMEUS_CONSTRAINT_LAYOUT_ERROR_INVALID_SYMBOL,
+                      "Line 1, column 2: Expected ':' after the orientation");
+  assert_parse_error ("|-|",
+                      EMEUS_CONSTRAINT_LAYOUT_ERROR_INVALID_SYMBOL,
+                      "Line 1, column 3: Expected a view");
+  assert_parse_error ("[a]-[b",
+                      EMEUS_CONSTRAINT_LAYOUT_ERROR_INVALID_SYMBOL,
+                      "Line 1, column 7: Expected ']'");
+  assert_parse_error ("[a]-10[b]",
+                      EMEUS_CONSTRAINT_LAYOUT_ERROR_INVALID_SYMBOL,
+                      "Line 1, column 7: Expected '-'");
+  assert_parse_error ("[a]-[b]|x",
+                      EMEUS_CONSTRAINT_LAYOUT_ERROR_INVALID_SYMBOL,
+                      "Line 1, column 9: Unexpected 'x'");
+  assert_parse_error ("[a]-[c] - [missing]",
+                      EMEUS_CONSTRAINT_LAYOUT_ERROR_INVALID_VIEW,
+                      "Line 1, column 12: Unknown view 'missing'");
+  assert_parse_error ("[a]-(@weak)-[b]",
+                      EMEUS_CONSTRAINT_LAYOUT_ERROR_INVALID_PREDICATE,
+                      "Line 1, column 6: Expected a number");
+  assert_parse_error ("[a]-(b)-[c]",
+                      EMEUS_CONSTRAINT_LAYOUT_ERROR_INVALID_PREDICATE,
+                      "Line 1, column 6: Spacings cannot refer to views");
+  assert_parse_error ("[a(=50)]",
+                      EMEUS_CONSTRAINT_LAYOUT_ERROR_INVALID_PREDICATE,
+                      "Line 1, column 4: Expected '==', '<=' or '>='");
+  assert_parse_error ("[a(==50@loud)]",
+                      EMEUS_CONSTRAINT_LAYOUT_ERROR_INVALID_PREDICATE,
+                      "Line 1, column 9: Unknown strength 'loud'");
+  assert_parse_error ("[a(>=50]",
+                      EMEUS_CONSTRAINT_LAYOUT_ERROR_INVALID_SYMBOL,
+                      "Line 1, column 8: Expected ')'");
+}
+
+int
+main (int argc, char *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/emeus/vfl/superview", emeus_vfl_superview);
+  g_test_add_func ("/emeus/vfl/metrics", emeus_vfl_metrics);
+  g_test_add_func ("/emeus/vfl/predicates", emeus_vfl_predicates);
+  g_test_add_func ("/emeus/vfl/parallel", emeus_vfl_parallel);
+  g_test_add_func ("/emeus/vfl/lines", emeus_vfl_lines);
+  g_test_add_func ("/emeus/vfl/errors", emeus_vfl_errors);
+
+  return g_test_run ();
+}
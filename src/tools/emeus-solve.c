@@ -0,0 +1,1017 @@
+/* emeus-solve.c: Solves a constraint system described in a text file
+ *
+ * Copyright 2016  Endless
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* The input is a list of statements, one per line; everything after a
+ * '#' is a comment:
+ *
+ *   var NAME [= VALUE]           declares a variable, with its initial value
+ *   stay NAME [@STRENGTH]        adds a stay, weak by default
+ *   edit NAME [@STRENGTH]        makes a variable editable, strong by default
+ *   suggest NAME VALUE           suggests a value for an edit variable
+ *   EXPR OP EXPR [@STRENGTH]     adds a constraint, required by default
+ *
+ * The expressions are linear combinations of variables, e.g.:
+ *
+ *   child1.right + 12 == child2.left
+ *   child1.width == 0.5 * (super.width - 24) @strong
+ *
+ * The operators are "==", "<=" and ">="; the strengths are "required",
+ * "strong", "medium" and "weak".
+ *
+ * The constraints are solved once all the statements are read; then the
+ * suggested values are applied, and the value of each variable is printed
+ * in the order they were declared.
+ */
+
+#include "config.h"
+
+#include "emeus-simplex-solver-private.h"
+#include "emeus-expression-private.h"
+#include "emeus-variable-private.h"
+#include "emeus-utils-private.h"
+
+#include <glib.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+typedef enum {
+  TOKEN_EOF,
+  TOKEN_IDENTIFIER,
+  TOKEN_NUMBER,
+  TOKEN_STRENGTH,
+  TOKEN_PLUS,
+  TOKEN_MINUS,
+  TOKEN_STAR,
+  TOKEN_SLASH,
+  TOKEN_LEFT_PAREN,
+  TOKEN_RIGHT_PAREN,
+  TOKEN_ASSIGN,
+  TOKEN_EQ,
+  TOKEN_LE,
+  TOKEN_GE
+} TokenType;
+
+typedef struct {
+  TokenType type;
+
+  /* The text of identifiers and strengths, not NUL-terminated */
+  const char *start;
+  int len;
+
+  double value;
+} Token;
+
+typedef struct {
+  SimplexSolver solver;
+
+  /* Maps names to variables, and keeps the names alive */
+  GHashTable *variables_by_name;
+
+  /* The variables, in the order they were declared */
+  GPtrArray *variables;
+
+  /* The edit variables, and the values suggested for them */
+  GPtrArray *edit_variables;
+  GArray *edit_values;
+
+  const char *filename;
+  int line_number;
+
+  /* The current line, and the position of the next token */
+  const char *line;
+  const char *cursor;
+
+  Token token;
+} Parser;
+
+#define EMEUS_SOLVE_ERROR (emeus_solve_error_quark ())
+
+static G_DEFINE_QUARK (emeus-solve-error, emeus_solve_error)
+
+static void
+parser_set_error (Parser *parser,
+                  GError **error,
+                  const char *format,
+                  ...) G_GNUC_PRINTF (3, 4);
+
+static void
+parser_set_error (Parser *parser,
+                  GError **error,
+                  const char *format,
+                  ...)
+{
+  va_list args;
+  char *message;
+
+  va_start (args, format);
+  message = g_strdup_vprintf (format, args);
+  va_end (args);
+
+  g_set_error (error, EMEUS_SOLVE_ERROR, 0, "%s:%d:%d: %s",
+               parser->filename,
+               parser->line_number,
+               (int) (parser->token.start - parser->line) + 1,
+               message);
+
+  g_free (message);
+}
+
+static bool
+is_identifier_start (char c)
+{
+  return g_ascii_isalpha (c) || c == '_';
+}
+
+static bool
+is_identifier_char (char c)
+{
+  return g_ascii_isalnum (c) || c == '_' || c == '.';
+}
+
+static bool
+parser_next_token (Parser *parser,
+                   GError **error)
+{
+  const char *p = parser->cursor;
+  Token *token = &parser->token;
+
+  while (*p == ' ' || *p == '\t' || *p == '\r')
+    p++;
+
+  token->start = p;
+  token->len = 0;
+
+  switch (*p)
+    {
+    case '\0':
+    case '#':
+      token->type = TOKEN_EOF;
+      parser->cursor = p;
+      return true;
+
+    case '+':
+      token->type = TOKEN_PLUS;
+      p += 1;
+      break;
+
+    case '-':
+      token->type = TOKEN_MINUS;
+      p += 1;
+      break;
+
+    case '*':
+      token->type = TOKEN_STAR;
+      p += 1;
+      break;
+
+    case '/':
+      token->type = TOKEN_SLASH;
+      p += 1;
+      break;
+
+    case '(':
+      token->type = TOKEN_LEFT_PAREN;
+      p += 1;
+      break;
+
+    case ')':
+      token->type = TOKEN_RIGHT_PAREN;
+      p += 1;
+      break;
+
+    case '=':
+      if (p[1] == '=')
+        {
+          token->type = TOKEN_EQ;
+          p += 2;
+        }
+      else
+        {
+          token->type = TOKEN_ASSIGN;
+          p += 1;
+        }
+      break;
+
+    case '<':
+    case '>':
+      if (p[1] != '=')
+        {
+          parser_set_error (parser, error, "Expected '%c=' operator", *p);
+          return false;
+        }
+
+      token->type = *p == '<' ? TOKEN_LE : TOKEN_GE;
+      p += 2;
+      break;
+
+    case '@':
+      token->type = TOKEN_STRENGTH;
+      token->start = ++p;
+      while (g_ascii_isalpha (*p))
+        p++;
+      token->len = p - token->start;
+      break;
+
+    default:
+      if (is_identifier_start (*p))
+        {
+          token->type = TOKEN_IDENTIFIER;
+          while (is_identifier_char (*p))
+            p++;
+          token->len = p - token->start;
+        }
+      else if (g_ascii_isdigit (*p) || *p == '.')
+        {
+          char *end;
+
+          token->type = TOKEN_NUMBER;
+          token->value = g_ascii_strtod (p, &end);
+          if (end == p)
+            {
+              parser_set_error (parser, error, "Invalid number");
+              return false;
+            }
+
+          p = end;
+        }
+      else
+        {
+          parser_set_error (parser, error, "Unexpected character '%c'", *p);
+          return false;
+        }
+      break;
+    }
+
+  parser->cursor = p;
+
+  return true;
+}
+
+static bool
+token_is (const Token *token,
+          const char *keyword)
+{
+  return token->type == TOKEN_IDENTIFIER &&
+         strlen (keyword) == token->len &&
+         strncmp (token->start, keyword, token->len) == 0;
+}
+
+static Variable *
+parser_lookup_variable (Parser *parser,
+                        GError **error)
+{
+  char *name = g_strndup (parser->token.start, parser->token.len);
+  Variable *res = g_hash_table_lookup (parser->variables_by_name, name);
+
+  if (res == NULL)
+    parser_set_error (parser, error, "Unknown variable '%s'", name);
+
+  g_free (name);
+
+  return res;
+}
+
+static bool
+parser_parse_strength (Parser *parser,
+                       StrengthType *strength,
+                       GError **error)
+{
+  static const struct {
+    const char *name;
+    StrengthType strength;
+  } strengths[] = {
+    { "required", STRENGTH_REQUIRED },
+    { "strong", STRENGTH_STRONG },
+    { "medium", STRENGTH_MEDIUM },
+    { "weak", STRENGTH_WEAK },
+  };
+  int i;
+
+  if (parser->token.type == TOKEN_EOF)
+    return true;
+
+  if (parser->token.type != TOKEN_STRENGTH)
+    {
+      parser_set_error (parser, error, "Expected a strength");
+      return false;
+    }
+
+  for (i = 0; i < G_N_ELEMENTS (strengths); i++)
+    {
+      if (strlen (strengths[i].name) == parser->token.len &&
+          strncmp (parser->token.start, strengths[i].name, parser->token.len) == 0)
+        {
+          *strength = strengths[i].strength;
+          return parser_next_token (parser, error);
+        }
+    }
+
+  parser_set_error (parser, error, "Unknown strength '%.*s'",
+                    parser->token.len, parser->token.start);
+
+  return false;
+}
+
+static bool
+parser_expect_end (Parser *parser,
+                   GError **error)
+{
+  if (parser->token.type != TOKEN_EOF)
+    {
+      parser_set_error (parser, error, "Unexpected text at the end of the statement");
+      return false;
+    }
+
+  return true;
+}
+
+static Expression *parser_parse_expression (Parser *parser,
+                                            GError **error);
+
+/* primary := NUMBER | IDENTIFIER | '(' expression ')' | '-' primary */
+static Expression *
+parser_parse_primary (Parser *parser,
+                      GError **error)
+{
+  Expression *res = NULL;
+  Variable *variable;
+
+  switch (parser->token.type)
+    {
+    case TOKEN_NUMBER:
+      res = expression_new_from_constant (parser->token.value);
+      break;
+
+    case TOKEN_IDENTIFIER:
+      variable = parser_lookup_variable (parser, error);
+      if (variable == NULL)
+        return NULL;
+
+      res = expression_new_from_variable (variable);
+      break;
+
+    case TOKEN_MINUS:
+      if (!parser_next_token (parser, error))
+        return NULL;
+
+      res = parser_parse_primary (parser, error);
+
+      return res != NULL ? expression_times (res, -1.0) : NULL;
+
+    case TOKEN_LEFT_PAREN:
+      if (!parser_next_token (parser, error))
+        return NULL;
+
+      res = parser_parse_expression (parser, error);
+      if (res == NULL)
+        return NULL;
+
+      if (parser->token.type != TOKEN_RIGHT_PAREN)
+        {
+          parser_set_error (parser, error, "Expected ')'");
+          expression_unref (res);
+          return NULL;
+        }
+      break;
+
+    default:
+      parser_set_error (parser, error, "Expected a number or a variable");
+      return NULL;
+    }
+
+  if (!parser_next_token (parser, error))
+    {
+      expression_unref (res);
+      return NULL;
+    }
+
+  return res;
+}
+
+/* term := primary (('*' | '/') primary)* */
+static Expression *
+parser_parse_term (Parser *parser,
+                   GError **error)
+{
+  Expression *res = parser_parse_primary (parser, error);
+
+  while (res != NULL &&
+         (parser->token.type == TOKEN_STAR || parser->token.type == TOKEN_SLASH))
+    {
+      TokenType op = parser->token.type;
+      Expression *factor;
+
+      if (!parser_next_token (parser, error))
+        goto error;
+
+      factor = parser_parse_primary (parser, error);
+      if (factor == NULL)
+        goto error;
+
+      /* The constraints are linear: one of the factors is a constant */
+      if (op == TOKEN_STAR && expression_is_constant (res))
+        {
+          Expression *tmp = res;
+
+          res = expression_times (factor, expression_get_constant (tmp));
+          expression_unref (tmp);
+        }
+      else if (expression_is_constant (factor) &&
+               (op == TOKEN_STAR || !approx_val (expression_get_constant (factor), 0.0)))
+        {
+          if (op == TOKEN_STAR)
+            expression_times (res, expression_get_constant (factor));
+          else
+            expression_divide (res, expression_get_constant (factor));
+
+          expression_unref (factor);
+        }
+      else
+        {
+          parser_set_error (parser, error,
+                            op == TOKEN_STAR
+                              ? "Only multiplications by a constant are allowed"
+                              : "Only divisions by a non-zero constant are allowed");
+          expression_unref (factor);
+          goto error;
+        }
+    }
+
+  return res;
+
+error:
+  expression_unref (res);
+  return NULL;
+}
+
+/* expression := term (('+' | '-') term)* */
+static Expression *
+parser_parse_expression (Parser *parser,
+                         GError **error)
+{
+  Expression *res = parser_parse_term (parser, error);
+
+  while (res != NULL &&
+         (parser->token.type == TOKEN_PLUS || parser->token.type == TOKEN_MINUS))
+    {
+      double n = parser->token.type == TOKEN_PLUS ? 1.0 : -1.0;
+      Expression *term;
+
+      if (!parser_next_token (parser, error))
+        goto error;
+
+      term = parser_parse_term (parser, error);
+      if (term == NULL)
+        goto error;
+
+      expression_add_expression (res, term, n, NULL);
+      expression_unref (term);
+    }
+
+  return res;
+
+error:
+  expression_unref (res);
+  return NULL;
+}
+
+static bool
+find_first_variable (Term *term,
+                     gpointer data)
+{
+  Variable **first = data;
+
+  if (*first == NULL || term_get_variable (term)->id_ < (*first)->id_)
+    *first = term_get_variable (term);
+
+  return true;
+}
+
+/* constraint := expression ('==' | '<=' | '>=') expression [strength] */
+static bool
+parser_parse_constraint (Parser *parser,
+                         GError **error)
+{
+  StrengthType strength = STRENGTH_REQUIRED;
+  Expression *lhs, *rhs = NULL;
+  Variable *subject = NULL;
+  OperatorType op;
+  double coefficient;
+
+  lhs = parser_parse_expression (parser, error);
+  if (lhs == NULL)
+    return false;
+
+  switch (parser->token.type)
+    {
+    case TOKEN_EQ:
+      op = OPERATOR_TYPE_EQ;
+      break;
+
+    case TOKEN_LE:
+      op = OPERATOR_TYPE_LE;
+      break;
+
+    case TOKEN_GE:
+      op = OPERATOR_TYPE_GE;
+      break;
+
+    default:
+      parser_set_error (parser, error, "Expected '==', '<=' or '>='");
+      goto error;
+    }
+
+  if (!parser_next_token (parser, error))
+    goto error;
+
+  rhs = parser_parse_expression (parser, error);
+  if (rhs == NULL)
+    goto error;
+
+  if (!parser_parse_strength (parser, &strength, error) ||
+      !parser_expect_end (parser, error))
+    goto error;
+
+  /* The solver takes constraints in the form: variable op expression;
+   * we move everything to the right hand side, and solve for the
+   * variable that was declared first, so that the same input always
+   * results in the same tableau
+   */
+  expression_add_expression (rhs, lhs, -1.0, NULL);
+  expression_terms_foreach (rhs, find_first_variable, &subject);
+
+  if (subject == NULL)
+    {
+      parser_set_error (parser, error, "The constraint does not have any variable");
+      goto error;
+    }
+
+  /* 0 op rhs, where rhs = coefficient * subject + rest */
+  coefficient = expression_get_coefficient (rhs, subject);
+  expression_remove_variable (rhs, subject, NULL);
+  expression_times (rhs, -1.0 / coefficient);
+
+  /* Now: subject op' rhs, flipping the operator if needed */
+  if (op != OPERATOR_TYPE_EQ && coefficient > 0)
+    op = op == OPERATOR_TYPE_LE ? OPERATOR_TYPE_GE : OPERATOR_TYPE_LE;
+
+  simplex_solver_add_constraint (&parser->solver, subject, op, rhs, strength);
+
+  expression_unref (lhs);
+  expression_unref (rhs);
+
+  return true;
+
+error:
+  expression_unref (lhs);
+  if (rhs != NULL)
+    expression_unref (rhs);
+
+  return false;
+}
+
+/* var := 'var' IDENTIFIER ['=' number] */
+static bool
+parser_parse_var (Parser *parser,
+                  GError **error)
+{
+  double value = 0.0, sign = 1.0;
+  Variable *variable;
+  char *name;
+
+  if (parser->token.type != TOKEN_IDENTIFIER)
+    {
+      parser_set_error (parser, error, "Expected a variable name");
+      return false;
+    }
+
+  name = g_strndup (parser->token.start, parser->token.len);
+  if (g_hash_table_contains (parser->variables_by_name, name))
+    {
+      parser_set_error (parser, error, "Variable '%s' already declared", name);
+      g_free (name);
+      return false;
+    }
+
+  if (!parser_next_token (parser, error))
+    goto error;
+
+  if (parser->token.type == TOKEN_ASSIGN)
+    {
+      if (!parser_next_token (parser, error))
+        goto error;
+
+      if (parser->token.type == TOKEN_MINUS)
+        {
+          sign = -1.0;
+          if (!parser_next_token (parser, error))
+            goto error;
+        }
+
+      if (parser->token.type != TOKEN_NUMBER)
+        {
+          parser_set_error (parser, error, "Expected a number");
+          goto error;
+        }
+
+      value = sign * parser->token.value;
+
+      if (!parser_next_token (parser, error))
+        goto error;
+    }
+
+  if (!parser_expect_end (parser, error))
+    goto error;
+
+  /* The table owns the name */
+  variable = simplex_solver_create_variable (&parser->solver, name, value);
+  g_hash_table_insert (parser->variables_by_name, name, variable);
+  g_ptr_array_add (parser->variables, variable);
+
+  return true;
+
+error:
+  g_free (name);
+  return false;
+}
+
+/* stay := 'stay' IDENTIFIER [strength]
+ * edit := 'edit' IDENTIFIER [strength]
+ */
+static bool
+parser_parse_stay_or_edit (Parser *parser,
+                           bool is_edit,
+                           GError **error)
+{
+  StrengthType strength = is_edit ? STRENGTH_STRONG : STRENGTH_WEAK;
+  Variable *variable;
+
+  if (parser->token.type != TOKEN_IDENTIFIER)
+    {
+      parser_set_error (parser, error, "Expected a variable name");
+      return false;
+    }
+
+  variable = parser_lookup_variable (parser, error);
+  if (variable == NULL)
+    return false;
+
+  if (!parser_next_token (parser, error) ||
+      !parser_parse_strength (parser, &strength, error) ||
+      !parser_expect_end (parser, error))
+    return false;
+
+  if (is_edit)
+    {
+      if (!simplex_solver_has_edit_variable (&parser->solver, variable))
+        simplex_solver_add_edit_variable (&parser->solver, variable, strength);
+    }
+  else
+    {
+      if (!simplex_solver_has_stay_variable (&parser->solver, variable))
+        simplex_solver_add_stay_variable (&parser->solver, variable, strength);
+    }
+
+  return true;
+}
+
+/* suggest := 'suggest' IDENTIFIER number */
+static bool
+parser_parse_suggest (Parser *parser,
+                      GError **error)
+{
+  Variable *variable;
+  double value, sign = 1.0;
+  int i;
+
+  if (parser->token.type != TOKEN_IDENTIFIER)
+    {
+      parser_set_error (parser, error, "Expected a variable name");
+      return false;
+    }
+
+  variable = parser_lookup_variable (parser, error);
+  if (variable == NULL)
+    return false;
+
+  if (!simplex_solver_has_edit_variable (&parser->solver, variable))
+    {
+      parser_set_error (parser, error, "Variable '%s' is not editable", variable->name);
+      return false;
+    }
+
+  if (!parser_next_token (parser, error))
+    return false;
+
+  if (parser->token.type == TOKEN_MINUS)
+    {
+      sign = -1.0;
+      if (!parser_next_token (parser, error))
+        return false;
+    }
+
+  if (parser->token.type != TOKEN_NUMBER)
+    {
+      parser_set_error (parser, error, "Expected a number");
+      return false;
+    }
+
+  value = sign * parser->token.value;
+
+  if (!parser_next_token (parser, error) ||
+      !parser_expect_end (parser, error))
+    return false;
+
+  /* The last suggestion for a variable wins */
+  for (i = 0; i < parser->edit_variables->len; i++)
+    {
+      if (g_ptr_array_index (parser->edit_variables, i) == variable)
+        {
+          g_array_index (parser->edit_values, double, i) = value;
+          return true;
+        }
+    }
+
+  g_ptr_array_add (parser->edit_variables, variable);
+  g_array_append_val (parser->edit_values, value);
+
+  return true;
+}
+
+static bool
+parser_parse_line (Parser *parser,
+                   const char *line,
+                   GError **error)
+{
+  Token first;
+
+  parser->line = line;
+  parser->cursor = line;
+
+  if (!parser_next_token (parser, error))
+    return false;
+
+  if (parser->token.type == TOKEN_EOF)
+    return true;
+
+  /* The keywords are only special at the start of a statement, and only
+   * if they are followed by a name
+   */
+  first = parser->token;
+  if (token_is (&first, "var") ||
+      token_is (&first, "stay") ||
+      token_is (&first, "edit") ||
+      token_is (&first, "suggest"))
+    {
+      const char *cursor = parser->cursor;
+
+      if (!parser_next_token (parser, error))
+        return false;
+
+      if (parser->token.type == TOKEN_IDENTIFIER)
+        {
+          if (token_is (&first, "var"))
+            return parser_parse_var (parser, error);
+
+          if (token_is (&first, "suggest"))
+            return parser_parse_suggest (parser, error);
+
+          return parser_parse_stay_or_edit (parser, token_is (&first, "edit"), error);
+        }
+
+      parser->cursor = cursor;
+      parser->token = first;
+    }
+
+  return parser_parse_constraint (parser, error);
+}
+
+static bool
+parser_parse (Parser *parser,
+              char *contents,
+              GError **error)
+{
+  char *line = contents;
+
+  parser->line_number = 0;
+
+  while (line != NULL)
+    {
+      char *end = strchr (line, '\n');
+
+      if (end != NULL)
+        *end = '\0';
+
+      parser->line_number += 1;
+
+      if (!parser_parse_line (parser, line, error))
+        return false;
+
+      line = end != NULL ? end + 1 : NULL;
+    }
+
+  return true;
+}
+
+static char *
+read_stdin (GError **error)
+{
+  GString *buf = g_string_new (NULL);
+  char chunk[4096];
+  size_t len;
+
+  while ((len = fread (chunk, 1, sizeof (chunk), stdin)) > 0)
+    g_string_append_len (buf, chunk, len);
+
+  if (ferror (stdin))
+    {
+      g_set_error (error, EMEUS_SOLVE_ERROR, 0, "Unable to read the standard input");
+      g_string_free (buf, TRUE);
+      return NULL;
+    }
+
+  return g_string_free (buf, FALSE);
+}
+
+static double
+elapsed_ms (gint64 start_time)
+{
+  return (double) (g_get_monotonic_time () - start_time) / 1000.0;
+}
+
+/* The solver reports the constraints it cannot satisfy as criticals, so
+ * we count them to know whether the system was solved
+ */
+static GLogWriterOutput
+count_criticals_writer (GLogLevelFlags log_level,
+                        const GLogField *fields,
+                        gsize n_fields,
+                        gpointer user_data)
+{
+  int *n_criticals = user_data;
+
+  if ((log_level & (G_LOG_LEVEL_ERROR | G_LOG_LEVEL_CRITICAL)) != 0)
+    *n_criticals += 1;
+
+  return g_log_writer_default (log_level, fields, n_fields, NULL);
+}
+
+int
+main (int argc,
+      char *argv[])
+{
+  gboolean show_timing = FALSE, show_statistics = FALSE, quiet = FALSE;
+  const GOptionEntry entries[] = {
+    { "timing", 't', 0, G_OPTION_ARG_NONE, &show_timing, "Print the time spent in each phase", NULL },
+    { "statistics", 's', 0, G_OPTION_ARG_NONE, &show_statistics, "Print the statistics of the solver", NULL },
+    { "quiet", 'q', 0, G_OPTION_ARG_NONE, &quiet, "Do not print the values of the variables", NULL },
+    { NULL },
+  };
+  Parser parser = { SIMPLEX_SOLVER_INIT, };
+  double parse_time, solve_time, resolve_time = 0.0;
+  GOptionContext *context;
+  GError *error = NULL;
+  char *contents;
+  gint64 start_time;
+  int i, n_criticals = 0, res = EXIT_FAILURE;
+
+  context = g_option_context_new ("[FILE] - solve a constraint system");
+  g_option_context_set_summary (context,
+                                "Reads a constraint system from FILE, or from the standard input,\n"
+                                "solves it, and prints the value of each variable.");
+  g_option_context_add_main_entries (context, entries, NULL);
+  if (!g_option_context_parse (context, &argc, &argv, &error))
+    {
+      g_printerr ("emeus-solve: %s\n", error->message);
+      g_error_free (error);
+      g_option_context_free (context);
+      return EXIT_FAILURE;
+    }
+
+  g_option_context_free (context);
+
+  if (argc > 2)
+    {
+      g_printerr ("emeus-solve: Too many arguments\n");
+      return EXIT_FAILURE;
+    }
+
+  if (argc < 2 || strcmp (argv[1], "-") == 0)
+    {
+      parser.filename = "<stdin>";
+      contents = read_stdin (&error);
+    }
+  else
+    {
+      parser.filename = argv[1];
+      if (!g_file_get_contents (argv[1], &contents, NULL, &error))
+        contents = NULL;
+    }
+
+  if (contents == NULL)
+    {
+      g_printerr ("emeus-solve: %s\n", error->message);
+      g_error_free (error);
+      return EXIT_FAILURE;
+    }
+
+  g_log_set_writer_func (count_criticals_writer, &n_criticals, NULL);
+
+  simplex_solver_init (&parser.solver);
+  parser.variables_by_name = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+  parser.variables = g_ptr_array_new_with_free_func ((GDestroyNotify) variable_unref);
+  parser.edit_variables = g_ptr_array_new ();
+  parser.edit_values = g_array_new (FALSE, FALSE, sizeof (double));
+
+  /* Solve all the constraints at once, after reading them */
+  simplex_solver_set_auto_solve (&parser.solver, false);
+
+  start_time = g_get_monotonic_time ();
+  if (!parser_parse (&parser, contents, &error))
+    {
+      g_printerr ("emeus-solve: %s\n", error->message);
+      g_error_free (error);
+      goto out;
+    }
+  parse_time = elapsed_ms (start_time);
+
+  start_time = g_get_monotonic_time ();
+  simplex_solver_set_auto_solve (&parser.solver, true);
+  solve_time = elapsed_ms (start_time);
+
+  if (parser.edit_variables->len > 0)
+    {
+      start_time = g_get_monotonic_time ();
+
+      simplex_solver_begin_edit (&parser.solver);
+      for (i = 0; i < parser.edit_variables->len; i++)
+        simplex_solver_suggest_value (&parser.solver,
+                                      g_ptr_array_index (parser.edit_variables, i),
+                                      g_array_index (parser.edit_values, double, i));
+      simplex_solver_resolve (&parser.solver);
+
+      resolve_time = elapsed_ms (start_time);
+    }
+
+  if (!quiet)
+    {
+      for (i = 0; i < parser.variables->len; i++)
+        {
+          Variable *variable = g_ptr_array_index (parser.variables, i);
+
+          g_print ("%s = %g\n", variable->name, variable_get_value (variable));
+        }
+    }
+
+  if (show_timing)
+    {
+      g_print ("# Parse: %.3f ms\n", parse_time);
+      g_print ("# Solve: %.3f ms\n", solve_time);
+      g_print ("# Resolve: %.3f ms\n", resolve_time);
+    }
+
+  if (show_statistics)
+    {
+      char *stats = simplex_solver_get_statistics (&parser.solver);
+
+      g_print ("# Statistics:\n%s\n", stats);
+      g_free (stats);
+    }
+
+  if (n_criticals > 0)
+    {
+      g_printerr ("emeus-solve: %s: Unable to solve the constraint system\n",
+                  parser.filename);
+      goto out;
+    }
+
+  res = EXIT_SUCCESS;
+
+out:
+  simplex_solver_clear (&parser.solver);
+
+  g_ptr_array_unref (parser.variables);
+  g_ptr_array_unref (parser.edit_variables);
+  g_array_unref (parser.edit_values);
+  g_hash_table_unref (parser.variables_by_name);
+  g_free (contents);
+
+  return res;
+}